@@ -7,6 +7,7 @@
 #include "Assignment.h"
 #include <stdlib.h> 
 #include <time.h>  
+#include "sampler.h"
 
 void Assignment::createTetrahedron(float y_offset, bool unique_color, float R, float G, float B)
 {
@@ -85,6 +86,7 @@ Assignment::~Assignment()
 	glDisableVertexAttribArray(shaderProgram.getColorAttribLocation());
 	glDeleteBuffers(1, &vbo); // Allocated vertex data
 	glDeleteVertexArrays(1, &vao); // Allocated object data
+	delete frameUniforms;
 }
 
 bool Assignment::init()
@@ -92,6 +94,10 @@ bool Assignment::init()
 	// Load shader program used in this example
 	if (!shaderProgram.load("data/Assignment.vs", "data/Assignment.fs"))
 		return false;
+	modelMatrixUniform = shaderProgram.getUniform("modelMatrix");
+
+	// View and projection are given to the shaders through a uniform buffer
+	frameUniforms = new UniformBuffer(UniformBuffer::FRAME_BINDING, sizeof(FrameUniforms));
 
 	// Create 3 tetrahedron along y axis
 	tetrahedron.clear();
@@ -199,7 +205,12 @@ void Assignment::render()
 	// Clear background
 	glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
-	
+	// Camera matrices are the same for every object
+	FrameUniforms frame = FrameUniforms();
+	frame.view = viewMat;
+	frame.projection = projectionMat;
+	frameUniforms->update(&frame);
+
 	for (int i = 0; i < obj_number; i++) 
 	{
 		// Calculate model transformation
@@ -208,9 +219,7 @@ void Assignment::render()
 		modelMat = glm::rotate(modelMat, rotation, glm::vec3(0.0, 1.0, 0.0)); // Rotate object around y-axis
 		modelMat = glm::scale(modelMat, glm::vec3(0.6f - i * 0.1, 0.6f - i * 0.1, 0.6f - i * 0.1));
 
-		// Precalculate transformation matrix for the shader and use it
-		mvpMat = projectionMat * viewMat * modelMat;
-		glUniformMatrix4fv(glGetUniformLocation(shaderProgram.getShaderProgram(), "mvpmatrix"), 1, GL_FALSE, glm::value_ptr(mvpMat));
+		shaderProgram.setUniform(modelMatrixUniform, modelMat);
 
 		// Draw individual triangles when we have correct VBO in use
 		// We are not using tetrahedron vector data here at all. We need to just know the number of vertices to draw!
@@ -226,7 +235,11 @@ int Assignment::findobject(int x, int y)
 	glBindFramebuffer(GL_FRAMEBUFFER, frameBufferName);
 
 	glGenTextures(1, &renderedTexture);
+	glActiveTexture(GL_TEXTURE0);
 	glBindTexture(GL_TEXTURE_2D, renderedTexture);
+	// The picking texture relies on its own filtering parameters, not a sampler left on the unit
+	if (Sampler::isSupported())
+		glBindSampler(0, 0);
 
 	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, windowWidth, windowHeight, 0, GL_RGB, GL_FLOAT, 0);
 	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
@@ -12,6 +12,7 @@
 #include <glm/gtc/type_ptr.hpp>         // Needed for glm::value_ptr(x). You can use &x[0] instead of that.
 #include "scene.h"                      // Abstract scene class
 #include "shaderprogram.h"              // For shader management
+#include "uniformbuffer.h"              // For the FrameData uniform block
 
 /**
 * \brief Draws a vertex-colored tetrahedron
@@ -36,7 +37,8 @@ class Assignment : public Scene
 	};
 
 	ShaderProgram shaderProgram;
-	glm::mat4 mvpMat;
+	int modelMatrixUniform; // Handle of the modelMatrix uniform in shaderProgram
+	UniformBuffer *frameUniforms = 0; // FrameData written once per frame
 
 	glm::mat4 projectionMat;
 	glm::mat4 viewMat;
@@ -7,6 +7,12 @@
 #include "Assignment1.h"
 #include <stdlib.h> 
 #include <time.h>  
+#include "sceneregistry.h"
+#include "glvalidation.h"
+#include "log.h"
+#include "sampler.h"
+
+static SceneRegistry::Registration<Assignment> registration("assignment1", "Tetrahedrons picked with the mouse", "objects=3");
 
 void Assignment::createTetrahedron(float y_offset, bool unique_color, float R, float G, float B)
 {
@@ -54,7 +60,8 @@ void Assignment::createTetrahedron(float y_offset, bool unique_color, float R, f
 }
 
 
-Assignment::Assignment()
+Assignment::Assignment(const SceneParameters &parameters) :
+	objectCount(glm::clamp(parameters.getInt("objects", 3), 1, 10))
 {
 	// These OpenGL functions must be defined by the OpenGL (or through GLEW) for this example to work..
 	assert(glBindBuffer != 0);
@@ -85,6 +92,7 @@ Assignment::~Assignment()
 	glDisableVertexAttribArray(shaderProgram.getColorAttribLocation());
 	glDeleteBuffers(1, &vbo); // Allocated vertex data
 	glDeleteVertexArrays(1, &vao); // Allocated object data
+	delete frameUniforms;
 }
 
 bool Assignment::init()
@@ -92,12 +100,15 @@ bool Assignment::init()
 	// Load shader program used in this example
 	if (!shaderProgram.load("data/Assignment.vs", "data/Assignment.fs"))
 		return false;
+	modelMatrixUniform = shaderProgram.getUniform("modelMatrix");
+
+	// View and projection are given to the shaders through a uniform buffer
+	frameUniforms = new UniformBuffer(UniformBuffer::FRAME_BINDING, sizeof(FrameUniforms));
 
-	// Create 3 tetrahedron along y axis
+	// Create tetrahedrons along x axis
 	tetrahedron.clear();
-	createTetrahedron(0.0f, false, 1.0f, 0.0f, 0.0f);
-	createTetrahedron(0.0f, false, 1.0f, 0.0f, 0.0f);
-	createTetrahedron(0.0f, false, 1.0f, 0.0f, 0.0f);
+	for (int i = 0; i < objectCount; i++)
+		createTetrahedron(0.0f, false, 1.0f, 0.0f, 0.0f);
 
 	tetrahedron_backend.clear();
 	for (int i = 0; i < obj_number; i++) 
@@ -161,6 +172,8 @@ bool Assignment::init()
 
 	// Reset object rotation
 	rotation = 0;
+	previousRotation = 0;
+	renderRotation = 0;
 
 	return true;
 }
@@ -189,9 +202,15 @@ void Assignment::resize(GLsizei width, GLsizei height)
 void Assignment::update(float timestep)
 {
 	// Rotate object (one rotation / 10 seconds)
+	previousRotation = rotation;
 	rotation += glm::two_pi<float>() * 0.1f * timestep;
 }
 
+void Assignment::interpolate(float alpha)
+{
+	renderRotation = glm::mix(previousRotation, rotation, alpha);
+}
+
 // Render view
 void Assignment::render()
 {
@@ -199,22 +218,26 @@ void Assignment::render()
 	// Clear background
 	glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
-	
+	// Camera matrices are the same for every object
+	FrameUniforms frame = FrameUniforms();
+	frame.view = viewMat;
+	frame.projection = projectionMat;
+	frameUniforms->update(&frame);
+
 	for (int i = 0; i < obj_number; i++) 
 	{
 		// Calculate model transformation
 		modelMat = glm::mat4(1.0f);
 		modelMat = glm::translate(modelMat, glm::vec3(0.0 + i * 2.0, 0.0, 0.0)); //  no translate object 
-		modelMat = glm::rotate(modelMat, rotation, glm::vec3(0.0, 1.0, 0.0)); // Rotate object around y-axis
+		modelMat = glm::rotate(modelMat, renderRotation, glm::vec3(0.0, 1.0, 0.0)); // Rotate object around y-axis
 		modelMat = glm::scale(modelMat, glm::vec3(0.6f - i * 0.1, 0.6f - i * 0.1, 0.6f - i * 0.1));
 
-		// Precalculate transformation matrix for the shader and use it
-		mvpMat = projectionMat * viewMat * modelMat;
-		glUniformMatrix4fv(glGetUniformLocation(shaderProgram.getShaderProgram(), "mvpmatrix"), 1, GL_FALSE, glm::value_ptr(mvpMat));
+		shaderProgram.setUniform(modelMatrixUniform, modelMat);
 
 		// Draw individual triangles when we have correct VBO in use
 		// We are not using tetrahedron vector data here at all. We need to just know the number of vertices to draw!
 		glDrawArrays(GL_TRIANGLES, i * static_cast<GLsizei>(tetrahedron.size() / obj_number), static_cast<GLsizei>(tetrahedron.size() / obj_number));
+		CHECK_GL_DRAW();
 	}
 
 }
@@ -226,7 +249,11 @@ int Assignment::findobject(int x, int y)
 	glBindFramebuffer(GL_FRAMEBUFFER, frameBufferName);
 
 	glGenTextures(1, &renderedTexture);
+	glActiveTexture(GL_TEXTURE0);
 	glBindTexture(GL_TEXTURE_2D, renderedTexture);
+	// The picking texture relies on its own filtering parameters, not a sampler left on the unit
+	if (Sampler::isSupported())
+		glBindSampler(0, 0);
 
 	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, windowWidth, windowHeight, 0, GL_RGB, GL_FLOAT, 0);
 	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
@@ -264,15 +291,15 @@ int Assignment::findobject(int x, int y)
 			break;
 		}
 	}
-	std::cout << "Unique color:" << pixels[0] << "," << pixels[1] << "," << pixels[2] << std::endl;
-	std::cout << obj_index << std::endl;
+	LOG_DEBUG(SCENE, "Unique color:" << pixels[0] << "," << pixels[1] << "," << pixels[2]);
+	LOG_DEBUG(SCENE, obj_index);
 	return obj_index;
 }
 
 void Assignment::updatecolor(int index)
 {
 	srand(time(0));
-	std::cout << "seed: " << time(0) << std::endl;
+	LOG_DEBUG(SCENE, "seed: " << time(0));
 	for (int i = 0; i < 12; i++)
 	{
 		tetrahedron[index * 12 + i].color[0] = rand() / float(RAND_MAX);
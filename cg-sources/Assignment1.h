@@ -12,6 +12,8 @@
 #include <glm/gtc/type_ptr.hpp>         // Needed for glm::value_ptr(x). You can use &x[0] instead of that.
 #include "scene.h"                      // Abstract scene class
 #include "shaderprogram.h"              // For shader management
+#include "uniformbuffer.h"              // For the FrameData uniform block
+#include "sceneregistry.h"              // For scene parameters
 
 /**
 * \brief Draws a vertex-colored tetrahedron
@@ -19,6 +21,7 @@
 class Assignment : public Scene
 {
 	int obj_number = 0;
+	int objectCount; // Tetrahedrons to create, parameter "objects". Picking tells apart up to 10.
 	struct Vertex
 	{
 		GLfloat position[3];
@@ -36,7 +39,8 @@ class Assignment : public Scene
 	};
 
 	ShaderProgram shaderProgram;
-	glm::mat4 mvpMat;
+	int modelMatrixUniform; // Handle of the modelMatrix uniform in shaderProgram
+	UniformBuffer *frameUniforms = 0; // FrameData written once per frame
 
 	glm::mat4 projectionMat;
 	glm::mat4 viewMat;
@@ -50,12 +54,14 @@ class Assignment : public Scene
 
 
 	float rotation; // Current rotation position
+	float previousRotation; // Rotation before the latest update()
+	float renderRotation; // Rotation interpolated for render()
 	std::vector<Vertex> tetrahedron; // Source data for our model
 	std::vector<Vertex> tetrahedron_backend; // Source data for our model
 
 	void createTetrahedron(float offset = 0.0f, bool unique_color = false, float R = 0.0f, float G = 0.0f, float B = 0.0f);
 public:
-	Assignment();
+	explicit Assignment(const SceneParameters &parameters = SceneParameters());
 	virtual ~Assignment();
 
 	// Initialize scene
@@ -67,6 +73,9 @@ public:
 	// Update scene
 	virtual void update(float timestep);
 
+	// Blend the rotation of the two latest updates
+	virtual void interpolate(float alpha);
+
 	// Render view
 	virtual void render();
 
@@ -4,6 +4,12 @@
 */
 #include <cassert>
 #include "Assignment2.h"
+#include "sceneregistry.h"
+#include "profiler.h"
+#include "glvalidation.h"
+#include "log.h"
+
+static SceneRegistry::Registration<Assignment2> registration("assignment2", "Waving flag");
 
 
 Assignment2::Assignment2() 
@@ -38,13 +44,11 @@ Assignment2::~Assignment2()
 	glDeleteBuffers(1, &vbo_flag);
 	glDeleteBuffers(1, &vbo_pole);
 
-	glDeleteProgram(flag_shader_ID);
-	glDeleteProgram(pole_shader_ID);
-
 	glDeleteVertexArrays(1, &vao);
 
 	if (flagTexture)
 		delete flagTexture;
+	delete frameUniforms;
 
 }
 
@@ -128,26 +132,34 @@ void Assignment2::createPole(GLfloat poleHeight, GLfloat poleWidth) {
 bool Assignment2::init()
 {
 	// Vertex Shader for Animated Flag
-	if (!shaderProgram.load("data/waving_flag.vs", "data/waving_flag.fs"))
+	if (!flagProgram.load("data/waving_flag.vs", "data/waving_flag.fs"))
 		return false;
 
-	flag_shader_ID = shaderProgram.getShaderProgram();
+	flag_shader_ID = flagProgram.getShaderProgram();
+	flagModelMatrixUniform = flagProgram.getUniform("modelMatrix");
 
 	// Vertex Shader for Static Pole
-	if (!shaderProgram.load("data/static_pole.vs", "data/static_pole.fs"))
+	if (!poleProgram.load("data/static_pole.vs", "data/static_pole.fs"))
 		return false;
 
-	pole_shader_ID = shaderProgram.getShaderProgram();
+	pole_shader_ID = poleProgram.getShaderProgram();
+	poleModelMatrixUniform = poleProgram.getUniform("modelMatrix");
+
+	// Camera and time are given to both programs through a uniform buffer
+	frameUniforms = new UniformBuffer(UniformBuffer::FRAME_BINDING, sizeof(FrameUniforms));
 
 	//create models
 	createPole(0.9f, 0.1f);			//create a pole with fixed height and width
 	createFlag(0.6f, 0.9f, 0.9f);
 
-	// Load  texture image
-	flagTexture = new Texture("data/flag-texture.png");
+	// Load  texture image, small mipmaps first if loaded before
+	flagTexture = new Texture("data/flag-texture.png", Texture::UNCOMPRESSED, BlockCompressor::NORMAL, Texture::PROGRESSIVE);
 	if (flagTexture->getTextureId() == 0)
 		return false;
-	std::cout << "Loaded flag texture as texture " << flagTexture->getTextureId() << std::endl;
+	LOG_INFO(SCENE, "Loaded flag texture as texture " << flagTexture->getTextureId());
+
+	// Texture is not edited after loading so keep only the OpenGL copy
+	flagTexture->setResidency(Texture::GPU_ONLY);
 
 	
 	//use flag shader here
@@ -160,7 +172,7 @@ bool Assignment2::init()
 		std::cerr << "Unable to locate uniform variable texture0 from the shader" << std::endl;
 		return false;
 	}
-	std::cout << "texture0 uniform id: " << uniform_flagShader_texture << std::endl;
+	LOG_INFO(SCENE, "texture0 uniform id: " << uniform_flagShader_texture);
 
 	// Welect what texture unit is used for
 	usedTextureUnit = 0;
@@ -218,15 +230,22 @@ void Assignment2::resize(GLsizei width, GLsizei height)
 void Assignment2::update(float timestep) 
 {
 
+	previousTime = gtime;
 	gtime += timestep;
 }
 
+void Assignment2::interpolate(float alpha)
+{
+	renderTime = glm::mix(previousTime, gtime, alpha);
+}
+
 void Assignment2::render() 
 {
 	// Clear background
 	glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
 	computemvpMat();
+	updateUniforms();
 	render_flag();
 	render_pole();
 
@@ -234,6 +253,8 @@ void Assignment2::render()
 
 void Assignment2::render_flag()
 {
+	PROFILE_GPU_SCOPE("flag");
+
 	glUseProgram(flag_shader_ID);
 	
 	glDisable(GL_CULL_FACE);			//both side of flag can be seen
@@ -246,13 +267,16 @@ void Assignment2::render_flag()
 	glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 2 * sizeof(glm::vec3) + sizeof(glm::vec2), (void*)(2 * sizeof(glm::vec3)));
 	glEnableVertexAttribArray(1);
 
-	glUniform1f(glGetUniformLocation(flag_shader_ID, "gtime"), gtime);
+	flagProgram.setUniform(flagModelMatrixUniform, modelMat);
 
 	glDrawElements(GL_TRIANGLES, static_cast<GLsizei>(flagIndices.size()), GL_UNSIGNED_INT, 0);
+	CHECK_GL_DRAW();
 }
 
 void Assignment2::render_pole()
 {
+	PROFILE_GPU_SCOPE("pole");
+
 	glUseProgram(pole_shader_ID);
 
 	glEnable(GL_CULL_FACE);
@@ -266,7 +290,10 @@ void Assignment2::render_pole()
 	glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 2 * sizeof(glm::vec3) + sizeof(glm::vec2), (void*)(1 * sizeof(glm::vec3)));
 	glEnableVertexAttribArray(1);
 
+	poleProgram.setUniform(poleModelMatrixUniform, modelMat);
+
 	glDrawElements(GL_TRIANGLES, static_cast<GLsizei>(poleIndices.size()), GL_UNSIGNED_INT, 0);
+	CHECK_GL_DRAW();
 }
 
 
@@ -275,14 +302,18 @@ void Assignment2::computemvpMat()
 
 	projectionMat = glm::perspective(fovy, aspectRatio, 0.1f, 100.0f);
 	viewMat = glm::lookAt(position, direction, up);
-	mvpMat = projectionMat * viewMat * modelMat;
-
-	glUseProgram(flag_shader_ID);
-	glUniformMatrix4fv(glGetUniformLocation(flag_shader_ID, "mvpmatrix"), 1, GL_FALSE, &mvpMat[0][0]);
-
-	glUseProgram(pole_shader_ID);
-	glUniformMatrix4fv(glGetUniformLocation(pole_shader_ID, "mvpmatrix"), 1, GL_FALSE, &mvpMat[0][0]);
+}
 
+/**
+ * \brief Write camera and time of the frame for both programs with one upload
+ */
+void Assignment2::updateUniforms()
+{
+	FrameUniforms frame = FrameUniforms();
+	frame.view = viewMat;
+	frame.projection = projectionMat;
+	frame.time = renderTime;
+	frameUniforms->update(&frame);
 }
 
 
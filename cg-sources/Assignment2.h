@@ -12,6 +12,7 @@
 #include <glm/gtc/type_ptr.hpp>         // Needed for glm::value_ptr(x). You can use &x[0] instead of that.
 #include "scene.h"                      // Abstract scene class
 #include "shaderprogram.h"              // For shader management
+#include "uniformbuffer.h"              // For the FrameData uniform block
 #include "texture.h"
 
 class Assignment2 : public Scene
@@ -30,9 +31,10 @@ class Assignment2 : public Scene
 
 	};
 
-	ShaderProgram shaderProgram;
-	glm::mat4 mvpMat;
-	
+	ShaderProgram flagProgram;
+	ShaderProgram poleProgram;
+	UniformBuffer *frameUniforms = 0; // FrameData written once per frame, read by both programs
+
 	glm::mat4 modelMat;
 	glm::mat4 viewMat;	
 	glm::mat4 projectionMat;
@@ -48,6 +50,10 @@ class Assignment2 : public Scene
 	GLuint flag_shader_ID;
 	GLuint pole_shader_ID;
 
+	// Uniform handles in flagProgram and poleProgram
+	int flagModelMatrixUniform;
+	int poleModelMatrixUniform;
+
 
 	float camera_distance = 3.0f;
 	glm::vec3 position = glm::vec3(0.0, 0.0, camera_distance);
@@ -70,6 +76,8 @@ class Assignment2 : public Scene
 
 
 	GLfloat gtime = 0;
+	GLfloat previousTime = 0; // gtime before the latest update()
+	GLfloat renderTime = 0;   // gtime interpolated for render()
 
 	//initial view angle of camera
 	int h_rotation = 0; 
@@ -84,6 +92,7 @@ class Assignment2 : public Scene
 	void render_flag();
 	void render_pole();
 	void computemvpMat();
+	void updateUniforms();
 
 
 public:
@@ -101,6 +110,9 @@ public:
 	// Update scene
 	virtual void update(float timestep);
 
+	// Blend the animation time of the two latest updates
+	virtual void interpolate(float alpha);
+
 	// Render view
 	virtual void render();
 
@@ -4,6 +4,12 @@
 */
 #include <cassert>
 #include "Assignment3.h"
+#include "sceneregistry.h"
+#include "profiler.h"
+#include "glvalidation.h"
+#include "log.h"
+
+static SceneRegistry::Registration<Assignment3> registration("assignment3", "Shaded waving flag on a pole over textured land");
 
 
 Assignment3::Assignment3() 
@@ -24,6 +30,7 @@ Assignment3::Assignment3()
 	assert(glGenBuffers != 0);
 	assert(glUseProgram != 0);
 	assert(glUniformMatrix4fv != 0);
+	assert(glBindBufferRange != 0);
 	assert(glVertexAttribPointer != 0);
 	assert(glViewport != 0);
 }
@@ -31,6 +38,8 @@ Assignment3::Assignment3()
 Assignment3::~Assignment3() 
 {
 	glUseProgram(0); // Shader state
+	if (usePipelines)
+		glBindProgramPipeline(0);
 	
 	glDeleteBuffers(1, &ebo_flag);
 	glDeleteBuffers(1, &ebo_pole);
@@ -38,14 +47,10 @@ Assignment3::~Assignment3()
 	glDeleteBuffers(1, &vbo_flag);
 	glDeleteBuffers(1, &vbo_pole);
 
-	glDeleteProgram(flag_shader_ID);
-	glDeleteProgram(pole_shader_ID);
-
 	glDeleteVertexArrays(1, &vao);
 
-	if (flagTexture)
-		delete flagTexture;
-
+	delete frameUniforms;
+	delete objectUniforms;
 }
 
 void Assignment3::createLand(GLfloat x_len, GLfloat z_len, GLfloat y_offset)
@@ -185,45 +190,55 @@ void Assignment3::createPole(GLfloat poleHeight, GLfloat poleWidth) {
 
 bool Assignment3::init()
 {
-	// Vertex Shader for Animated Flag
-	if (!shaderProgram.load("data/shadingflag.vs", "data/shadingflag.fs"))
-		return false;
-
-	flag_shader_ID = shaderProgram.getShaderProgram();
-
-	// Vertex Shader for Static Pole
-	if (!shaderProgram.load("data/colorshader.vs", "data/colorshader.fs"))
+	if (!loadShaders())
 		return false;
 
-	pole_shader_ID = shaderProgram.getShaderProgram();
-	land_shader_ID = pole_shader_ID;
+	// Camera, light and object transformations are given to all programs through uniform buffers
+	frameUniforms = new UniformBuffer(UniformBuffer::FRAME_BINDING, sizeof(FrameUniforms));
+	objectUniforms = new UniformBufferRing(UniformBuffer::OBJECT_BINDING, 16 * 1024);
 
 	//create models
 	createPole(0.9f, 0.1f);			//create a pole with fixed height and width
 	createFlag(0.6f, 0.9f, 0.9f);
 	createLand(5.0f, 5.0f, -0.9f);
 
-	// Load  texture image
-	flagTexture = new Texture("data/flag-texture.png");
-	if (flagTexture->getTextureId() == 0)
+	// Load texture images as layers of one texture array. Sand is resampled to the flag size
+	// so both objects are drawn with a single texture bind per frame.
+	if (!textures.add("data/flag-texture.png", flagLayer, true) ||
+		!textures.add("data/sand-texture.png", landLayer, true))
 		return false;
-	std::cout << "Loaded flag texture as texture " << flagTexture->getTextureId() << std::endl;
-	
-	//use flag shader here
-	glUseProgram(flag_shader_ID);
+	textures.updateGLTextures();
+	LOG_INFO(SCENE, "Loaded flag and land textures into " << textures.getArrayCount() << " texture array(s)");
+
+	// Welect what texture unit is used for
+	usedTextureUnit = 0;
 
-	// Get uniform location for the shader's texture sampler
-	GLint uniform_flagShader_texture = glGetUniformLocation(flag_shader_ID, "texture0");
-	if (uniform_flagShader_texture < 0)
+	// Point texture samplers of both textured shaders to the texture unit and select their layers
+	ShaderProgram *texturedPrograms[2] = { &flagProgram, &landProgram };
+	if (usePipelines)
 	{
-		std::cerr << "Unable to locate uniform variable texture0 from the shader" << std::endl;
-		return false;
+		texturedPrograms[0] = &flagFragmentStage;
+		texturedPrograms[1] = &landFragmentStage;
 	}
-	std::cout << "texture0 uniform id: " << uniform_flagShader_texture << std::endl;
+	GLint layers[2] = { flagLayer.layer, landLayer.layer };
+	for (int i = 0; i < 2; ++i)
+	{
+		// Stages are set with glProgramUniform*() and don't need to be in use
+		if (!usePipelines)
+			glUseProgram(texturedPrograms[i]->getShaderProgram());
 
-	// Welect what texture unit is used for
-	usedTextureUnit = 0;
-	glUniform1i(uniform_flagShader_texture, usedTextureUnit);
+		// Get uniform handle for the shader's texture sampler
+		int uniform_texture = texturedPrograms[i]->getUniform("texture0");
+		if (uniform_texture < 0)
+		{
+			std::cerr << "Unable to locate uniform variable texture0 from the shader" << std::endl;
+			return false;
+		}
+		LOG_INFO(SCENE, "texture0 uniform location: " << texturedPrograms[i]->getUniformLocation("texture0"));
+
+		texturedPrograms[i]->setUniform(uniform_texture, static_cast<GLint>(usedTextureUnit));
+		texturedPrograms[i]->setUniform(texturedPrograms[i]->getUniform("layer"), layers[i]);
+	}
 
 	//Initialize clear color for glClear()
 	glClearColor(0.0f, 0.0f, 0.0f, 1.f);
@@ -274,6 +289,64 @@ bool Assignment3::init()
 	return true;
 }
 
+/**
+ * \brief Compile and link shaders, as stages of program pipelines if the driver supports them
+ */
+bool Assignment3::loadShaders()
+{
+	// Material of the flag, folded into the flag shader at compile time
+	ShaderProgram::Defines flagMaterial;
+	flagMaterial["DIFFUSE"] = "vec4(0.9, 0.0, 0.0, 1.0)";
+	flagMaterial["SPECULAR"] = "vec4(0.7, 0.7, 0.7, 1.0)";
+	flagMaterial["SHININESS"] = "80.0";
+
+	usePipelines = ProgramPipeline::isSupported();
+	if (!usePipelines)
+	{
+		LOG_INFO(SCENE, "ARB_separate_shader_objects not supported, linking complete programs");
+
+		// Issue compiling of all programs before waiting for any, so that the driver can compile them in parallel.
+		// Shader for Animated Flag, Textured Land and Static Pole
+		if (!flagProgram.startLoad("data/shadingflag.vs", "data/shadingflag.fs", flagMaterial) ||
+			!landProgram.startLoad("data/object.vs", "data/land.fs") ||
+			!poleProgram.startLoad("data/object.vs", "data/colorshader.fs"))
+			return false;
+
+		return flagProgram.finishLoad() && landProgram.finishLoad() && poleProgram.finishLoad();
+	}
+
+	// Every stage is compiled and linked once, the object vertex stage serves both the pole and the land
+	if (!flagVertexStage.startLoadStage(GL_VERTEX_SHADER, "data/shadingflag.vs", flagMaterial) ||
+		!objectVertexStage.startLoadStage(GL_VERTEX_SHADER, "data/object.vs") ||
+		!flagFragmentStage.startLoadStage(GL_FRAGMENT_SHADER, "data/shadingflag.fs") ||
+		!poleFragmentStage.startLoadStage(GL_FRAGMENT_SHADER, "data/colorshader.fs") ||
+		!landFragmentStage.startLoadStage(GL_FRAGMENT_SHADER, "data/land.fs"))
+		return false;
+
+	if (!flagVertexStage.finishLoad() || !objectVertexStage.finishLoad() ||
+		!flagFragmentStage.finishLoad() || !poleFragmentStage.finishLoad() || !landFragmentStage.finishLoad())
+		return false;
+
+	flagPipeline.setStage(flagVertexStage);
+	flagPipeline.setStage(flagFragmentStage);
+	polePipeline.setStage(objectVertexStage);
+	polePipeline.setStage(poleFragmentStage);
+	landPipeline.setStage(objectVertexStage);
+	landPipeline.setStage(landFragmentStage);
+	return true;
+}
+
+/**
+ * \brief Draw with a pipeline, or with the matching complete program without pipeline support
+ */
+void Assignment3::useShaders(const ProgramPipeline &pipeline, const ShaderProgram &program) const
+{
+	if (usePipelines)
+		pipeline.bind();
+	else
+		glUseProgram(program.getShaderProgram());
+}
+
 void Assignment3::resize(GLsizei width, GLsizei height) 
 {
 
@@ -285,27 +358,43 @@ void Assignment3::resize(GLsizei width, GLsizei height)
 void Assignment3::update(float timestep) 
 {
 
+	previousTime = gtime;
 	gtime += timestep;
 }
 
+void Assignment3::interpolate(float alpha)
+{
+	renderTime = glm::mix(previousTime, gtime, alpha);
+}
+
 void Assignment3::render() 
 {
 	// Clear background
 	glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
 	computemvpMat();
+	updateUniforms();
+
+	// Texture bindings do not survive between frames if other code uses the same unit
+	boundArray = 0;
+
 	render_flag();
 	render_pole();
 	render_land();
 
+	objectUniforms->endFrame();
 }
 
 void Assignment3::render_flag()
 {
-	glUseProgram(flag_shader_ID);
+	PROFILE_GPU_SCOPE("flag");
+
+	useShaders(flagPipeline, flagProgram);
 	
 	glDisable(GL_CULL_FACE);			//both side of flag can be seen
 
+	bindLayer(flagLayer);
+
 	glBindBuffer(GL_ARRAY_BUFFER, vbo_flag);
 	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ebo_flag);
 
@@ -316,23 +405,17 @@ void Assignment3::render_flag()
 	glVertexAttribPointer(3, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(glm::vec3) + sizeof(glm::vec2), (void*)(2 * sizeof(glm::vec3) + sizeof(glm::vec2)));
 	glEnableVertexAttribArray(3);
 
-	glUniform1f(glGetUniformLocation(flag_shader_ID, "gtime"), gtime);
-	glUseProgram(flag_shader_ID);
-	//glUniformMatrix4fv(glGetUniformLocation(flag_shader_ID, "mvpmatrix"), 1, GL_FALSE, &mvpMat[0][0]);
-	glUniformMatrix4fv(glGetUniformLocation(flag_shader_ID, "mvmatrix"), 1, GL_FALSE, &modelViewMat[0][0]);
-	glUniformMatrix4fv(glGetUniformLocation(flag_shader_ID, "pmatrix"), 1, GL_FALSE, &projectionMat[0][0]);
-	glm::vec4 lightPos(0.0f, 0.0f, 3.0f, 1.0f);
-
-	// Precalculate transformation matrix for the shader and use it
-	glm::vec4 lightInViewPos = viewMat * modelMat * lightPos; // Light tied to object transformation
-	glUniform4fv(glGetUniformLocation(flag_shader_ID, "lightPosition"), 1, glm::value_ptr(lightInViewPos));
+	objectUniforms->bind(flagUniformOffset, sizeof(ObjectUniforms));
 
 	glDrawElements(GL_TRIANGLES, static_cast<GLsizei>(flagIndices.size()), GL_UNSIGNED_INT, 0);
+	CHECK_GL_DRAW();
 }
 
 void Assignment3::render_pole()
 {
-	glUseProgram(pole_shader_ID);
+	PROFILE_GPU_SCOPE("pole");
+
+	useShaders(polePipeline, poleProgram);
 
 	glEnable(GL_CULL_FACE);
 	glCullFace(GL_BACK);
@@ -344,34 +427,53 @@ void Assignment3::render_pole()
 	glEnableVertexAttribArray(0);
 	glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(glm::vec3) + sizeof(glm::vec2), (void*)(1 * sizeof(glm::vec3)));
 	glEnableVertexAttribArray(1);
+	glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, 3 * sizeof(glm::vec3) + sizeof(glm::vec2), (void*)(2 * sizeof(glm::vec3)));
+	glEnableVertexAttribArray(2);
 
-	glUseProgram(pole_shader_ID);
-	glUniformMatrix4fv(glGetUniformLocation(pole_shader_ID, "mvpmatrix"), 1, GL_FALSE, &mvpMat[0][0]);
+	objectUniforms->bind(poleUniformOffset, sizeof(ObjectUniforms));
 
 	glDrawElements(GL_TRIANGLES, static_cast<GLsizei>(poleIndices.size()), GL_UNSIGNED_INT, 0);
+	CHECK_GL_DRAW();
 }
 
 void Assignment3::render_land()
 {
-	glUseProgram(land_shader_ID);
+	PROFILE_GPU_SCOPE("land");
+
+	useShaders(landPipeline, landProgram);
 
 	glDisable(GL_CULL_FACE);
 
+	bindLayer(landLayer);
+
 	glBindBuffer(GL_ARRAY_BUFFER, vbo_land);
 	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ebo_land);
 
+	// Vertex stage is shared with the pole and reads colors too
 	glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(glm::vec3) + sizeof(glm::vec2), (void*)0);
 	glEnableVertexAttribArray(0);
 	glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(glm::vec3) + sizeof(glm::vec2), (void*)(1 * sizeof(glm::vec3)));
 	glEnableVertexAttribArray(1);
+	glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, 3 * sizeof(glm::vec3) + sizeof(glm::vec2), (void*)(2 * sizeof(glm::vec3)));
+	glEnableVertexAttribArray(2);
 
-	glUseProgram(land_shader_ID);
-	glUniformMatrix4fv(glGetUniformLocation(land_shader_ID, "mvpmatrix"), 1, GL_FALSE, &mvpMat[0][0]);
+	objectUniforms->bind(landUniformOffset, sizeof(ObjectUniforms));
 
 	glDrawElements(GL_TRIANGLES, static_cast<GLsizei>(landIndices.size()), GL_UNSIGNED_INT, 0);
+	CHECK_GL_DRAW();
 }
 
 
+void Assignment3::bindLayer(const TextureArraySet::Layer &layer)
+{
+	// Objects whose layers live in the same array share the bind
+	if (layer.array == boundArray && !bindPerObject)
+		return;
+
+	layer.array->bind(usedTextureUnit);
+	boundArray = layer.array;
+}
+
 void Assignment3::computemvpMat() 
 {
 	projectionMat = glm::perspective(fovy, aspectRatio, 0.1f, 100.0f);
@@ -381,6 +483,41 @@ void Assignment3::computemvpMat()
 	mvpMat = projectionMat * viewMat * modelMat;
 }
 
+/**
+ * \brief Transformations of an object for the ObjectData uniform block
+ */
+ObjectUniforms Assignment3::getObjectUniforms(const glm::mat4 &model) const
+{
+	ObjectUniforms object;
+	object.model = model;
+	object.modelView = viewMat * model;
+	object.mvp = projectionMat * object.modelView;
+	return object;
+}
+
+/**
+ * \brief Write uniform data of the whole frame with one upload per uniform buffer
+ */
+void Assignment3::updateUniforms()
+{
+	FrameUniforms frame = FrameUniforms();
+	frame.view = viewMat;
+	frame.projection = projectionMat;
+	frame.lightPosition[0] = viewMat * modelMat * glm::vec4(0.0f, 0.0f, 3.0f, 1.0f); // Light tied to object transformation
+	frame.lightColor[0] = glm::vec4(1.0f);
+	frame.lightCount = 1;
+	frame.time = renderTime;
+	frameUniforms->update(&frame);
+
+	// All objects share the model transformation for now
+	ObjectUniforms object = getObjectUniforms(modelMat);
+	objectUniforms->beginFrame();
+	flagUniformOffset = objectUniforms->push(&object, sizeof(object));
+	poleUniformOffset = objectUniforms->push(&object, sizeof(object));
+	landUniformOffset = objectUniforms->push(&object, sizeof(object));
+	objectUniforms->flush();
+}
+
 
 
 bool Assignment3::handleEvent(const SDL_Event &e)
@@ -407,6 +544,10 @@ bool Assignment3::handleEvent(const SDL_Event &e)
 			if (v_rotation < 90)
 				v_rotation += 15;
 			break;
+		case SDL_SCANCODE_B:
+			bindPerObject = !bindPerObject;
+			LOG_INFO(SCENE, "Texture bind per object: " << (bindPerObject ? "on" : "off"));
+			break;
 		}
 		h_rotation_radians = (float)h_rotation * 3.14f / 180.0f;
 		v_rotation_radians = (float)v_rotation * 3.14f / 180.0f;
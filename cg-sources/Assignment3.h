@@ -12,7 +12,10 @@
 #include <glm/gtc/type_ptr.hpp>         // Needed for glm::value_ptr(x). You can use &x[0] instead of that.
 #include "scene.h"                      // Abstract scene class
 #include "shaderprogram.h"              // For shader management
+#include "programpipeline.h"            // Separately linked shader stages
 #include "texture.h"
+#include "texturearray.h"
+#include "uniformbuffer.h"               // Per-frame and per-object uniform blocks
 
 class Assignment3 : public Scene
 {
@@ -36,7 +39,24 @@ private:
 
 	};
 
-	ShaderProgram shaderProgram;
+	//shader stages combined in program pipelines. Pole and land share one vertex stage.
+	bool usePipelines = false;
+	ShaderProgram flagVertexStage;
+	ShaderProgram objectVertexStage;
+	ShaderProgram flagFragmentStage;
+	ShaderProgram poleFragmentStage;
+	ShaderProgram landFragmentStage;
+	ProgramPipeline flagPipeline;
+	ProgramPipeline polePipeline;
+	ProgramPipeline landPipeline;
+
+	//the same shaders linked into complete programs without ARB_separate_shader_objects
+	ShaderProgram flagProgram;
+	ShaderProgram poleProgram;
+	ShaderProgram landProgram;
+
+	bool loadShaders();
+	void useShaders(const ProgramPipeline &pipeline, const ShaderProgram &program) const;
 	
 	
 	glm::mat4 mvpMat;
@@ -52,18 +72,20 @@ private:
 	std::vector<GLuint> flagIndices;
 	GLuint vbo_flag;
 	GLuint ebo_flag;
-	GLuint flag_shader_ID;
+	GLintptr flagUniformOffset;   // ObjectData of the current frame in objectUniforms
 	void createFlag(GLfloat flagHeight, GLfloat flagWidth, GLfloat poleHeight);
 	void render_flag();
 	GLfloat gtime = 0;
-	Texture *flagTexture;
+	GLfloat previousTime = 0; // gtime before the latest update()
+	GLfloat renderTime = 0;   // gtime interpolated for render()
+	TextureArraySet::Layer flagLayer;
 
 	//pole
 	std::vector<Vertex> pole;
 	std::vector<GLuint> poleIndices;
 	GLuint vbo_pole;
 	GLuint ebo_pole;
-	GLuint pole_shader_ID;
+	GLintptr poleUniformOffset;
 	void createPole(GLfloat poleHeight, GLfloat poleWidth);
 	void render_pole();
 
@@ -72,10 +94,10 @@ private:
 	std::vector<GLuint> landIndices;
 	GLuint vbo_land;
 	GLuint ebo_land;
-	GLuint land_shader_ID;
+	GLintptr landUniformOffset;
 	void createLand(GLfloat x_len, GLfloat z_len, GLfloat y_offset);
 	void render_land();
-	Texture *landTexture;
+	TextureArraySet::Layer landLayer;
 
 
 	//camera
@@ -90,10 +112,20 @@ private:
 
 	//texture 
 	GLuint usedTextureUnit;
+	TextureArraySet textures;		//flag and land textures as layers of shared texture arrays
+	TextureArray *boundArray = 0;	//array bound to usedTextureUnit during this frame
+	bool bindPerObject = false;		//bind texture before every draw (no sharing between objects) for comparison
+	void bindLayer(const TextureArraySet::Layer &layer);
 
 
+	//uniform blocks shared by all programs
+	UniformBuffer *frameUniforms = 0;         //FrameData written once per frame
+	UniformBufferRing *objectUniforms = 0;    //ObjectData of every object drawn during a frame
+
 	//private computation functions
 	void computemvpMat();
+	void updateUniforms();
+	ObjectUniforms getObjectUniforms(const glm::mat4 &model) const;
 
 
 public:
@@ -111,6 +143,9 @@ public:
 	// Update scene
 	virtual void update(float timestep);
 
+	// Blend the animation time of the two latest updates
+	virtual void interpolate(float alpha);
+
 	// Render view
 	virtual void render();
 
@@ -0,0 +1,272 @@
+/**
+ * \brief Offscreen frame time measurement implementation
+ * \file
+ */
+#include <iostream>
+#include <iomanip>
+#include <algorithm>
+#include <SDL.h>
+#include "benchmark.h"
+#include "texture.h"
+#include "profiler.h"
+#include "glvalidation.h"
+#include "fixedtimestep.h"
+
+namespace
+{
+	/**
+	 * \brief Write text as a JSON string
+	 */
+	void writeJsonString(std::ostream &os, const std::string &text)
+	{
+		os << '"';
+		for (size_t i = 0; i < text.size(); ++i)
+		{
+			unsigned char c = static_cast<unsigned char>(text[i]);
+			if (c == '"' || c == '\\')
+				os << '\\' << c;
+			else
+			if (c < 32)
+				os << "\\u" << std::hex << std::setw(4) << std::setfill('0') << static_cast<int>(c) << std::dec << std::setfill(' ');
+			else
+				os << c;
+		}
+		os << '"';
+	}
+
+	std::string getString(GLenum name)
+	{
+		const GLubyte *value = glGetString(name);
+		return value ? reinterpret_cast<const char *>(value) : "";
+	}
+
+	/**
+	 * \brief Nearest-rank index ceil(percent / 100 * count) - 1 of a sorted sample vector
+	 */
+	size_t getRank(size_t count, size_t percent)
+	{
+		size_t rank = (count * percent + 99) / 100;
+		return rank > 0 ? rank - 1 : 0;
+	}
+
+	void writeStatistics(std::ostream &os, const Benchmark::Statistics &statistics)
+	{
+		os << "{\"mean\": " << statistics.mean << ", \"p50\": " << statistics.p50 << ", \"p95\": " << statistics.p95 << ", \"p99\": " << statistics.p99 << "}";
+	}
+}
+
+/**
+ * \brief Create the offscreen framebuffer. Needs a current OpenGL context.
+ * \param frames Number of frames rendered of every scene
+ */
+Benchmark::Benchmark(GLsizei width, GLsizei height, int frames) :
+	width(width),
+	height(height),
+	frames(frames < 1 ? 1 : frames),
+	framebuffer(0),
+	colorRenderbuffer(0),
+	depthRenderbuffer(0),
+	ok(false),
+	timerQueries(GLEW_VERSION_3_3 || GLEW_ARB_timer_query)
+{
+	glGenRenderbuffers(1, &colorRenderbuffer);
+	glBindRenderbuffer(GL_RENDERBUFFER, colorRenderbuffer);
+	glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, width, height);
+
+	glGenRenderbuffers(1, &depthRenderbuffer);
+	glBindRenderbuffer(GL_RENDERBUFFER, depthRenderbuffer);
+	glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH24_STENCIL8, width, height);
+	glBindRenderbuffer(GL_RENDERBUFFER, 0);
+
+	glGenFramebuffers(1, &framebuffer);
+	glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+	glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, colorRenderbuffer);
+	glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_RENDERBUFFER, depthRenderbuffer);
+	ok = glCheckFramebufferStatus(GL_FRAMEBUFFER) == GL_FRAMEBUFFER_COMPLETE;
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+	if (!ok)
+		std::cerr << "Benchmark: Offscreen framebuffer of " << width << " x " << height << " is not complete" << std::endl;
+
+	if (timerQueries)
+		glGenQueries(QUERIES_IN_FLIGHT, queries);
+	else
+		std::cerr << "Benchmark: Timer queries not supported, measuring CPU time only" << std::endl;
+}
+
+Benchmark::~Benchmark()
+{
+	if (timerQueries)
+		glDeleteQueries(QUERIES_IN_FLIGHT, queries);
+	glDeleteFramebuffers(1, &framebuffer);
+	glDeleteRenderbuffers(1, &depthRenderbuffer);
+	glDeleteRenderbuffers(1, &colorRenderbuffer);
+}
+
+/**
+ * \brief True if the offscreen framebuffer could be created
+ */
+bool Benchmark::isOk() const
+{
+	return ok;
+}
+
+/**
+ * \brief Mean and nearest-rank percentiles. Sorts samples.
+ */
+Benchmark::Statistics Benchmark::getStatistics(std::vector<double> &samples)
+{
+	Statistics statistics = {0.0, 0.0, 0.0, 0.0};
+	if (samples.empty())
+		return statistics;
+
+	std::sort(samples.begin(), samples.end());
+	double sum = 0.0;
+	for (size_t i = 0; i < samples.size(); ++i)
+		sum += samples[i];
+	statistics.mean = sum / samples.size();
+
+	statistics.p50 = samples[getRank(samples.size(), 50)];
+	statistics.p95 = samples[getRank(samples.size(), 95)];
+	statistics.p99 = samples[getRank(samples.size(), 99)];
+	return statistics;
+}
+
+/**
+ * \brief Render frames of an initialized scene into the offscreen framebuffer and store the statistics
+ *
+ * Simulated time advances a fixed FRAME_TIME every frame, split into FixedTimestep updates like in the window,
+ * so that every run renders the same images.
+ * \param name Name of the scene in the results
+ * \return false if an OpenGL error was found. How often errors are checked depends on GLValidation.
+ */
+bool Benchmark::run(const std::string &name, Scene &scene)
+{
+	if (!ok)
+		return false;
+
+	FixedTimestep clock;
+	const double frequency = static_cast<double>(SDL_GetPerformanceFrequency());
+	std::vector<double> cpuTimes;
+	std::vector<double> gpuTimes;
+	cpuTimes.reserve(frames);
+	gpuTimes.reserve(frames);
+
+	glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+	scene.resize(width, height);
+	Texture::resetBindCount();
+
+	bool allOk = true;
+	Uint64 start = SDL_GetPerformanceCounter();
+	for (int frame = 0; frame < frames && allOk; ++frame)
+	{
+		GLuint query = queries[frame % QUERIES_IN_FLIGHT];
+		if (timerQueries)
+		{
+			// Waits for the GPU to finish the frame rendered QUERIES_IN_FLIGHT frames ago
+			if (frame >= static_cast<int>(QUERIES_IN_FLIGHT))
+			{
+				GLuint64 elapsed = 0;
+				glGetQueryObjectui64v(query, GL_QUERY_RESULT, &elapsed);
+				gpuTimes.push_back(elapsed * 1e-6);
+			}
+			glBeginQuery(GL_TIME_ELAPSED, query);
+		}
+
+		Profiler::beginFrame();
+		Uint64 frameStart = SDL_GetPerformanceCounter();
+		{
+			PROFILE_SCOPE("update");
+			int steps = clock.advance(FRAME_TIME);
+			for (int step = 0; step < steps; ++step)
+				scene.update(clock.getStep());
+			scene.interpolate(clock.getAlpha());
+		}
+		{
+			PROFILE_GPU_SCOPE("streaming");
+			Texture::updateStreaming();
+		}
+		{
+			PROFILE_GPU_SCOPE("render");
+			scene.render();
+		}
+		cpuTimes.push_back((SDL_GetPerformanceCounter() - frameStart) * 1000.0 / frequency);
+		Profiler::endFrame();
+
+		if (timerQueries)
+			glEndQuery(GL_TIME_ELAPSED);
+
+		if (!GLValidation::checkFrame())
+		{
+			std::cerr << "Benchmark: OpenGL error by frame " << frame << " of scene '" << name << "'" << std::endl;
+			allOk = false;
+		}
+	}
+
+	// Results of the last frames
+	int rendered = static_cast<int>(cpuTimes.size());
+	if (timerQueries)
+	{
+		for (int frame = std::max(0, rendered - static_cast<int>(QUERIES_IN_FLIGHT)); frame < rendered; ++frame)
+		{
+			GLuint64 elapsed = 0;
+			glGetQueryObjectui64v(queries[frame % QUERIES_IN_FLIGHT], GL_QUERY_RESULT, &elapsed);
+			gpuTimes.push_back(elapsed * 1e-6);
+		}
+	}
+	glFinish();
+	Uint64 end = SDL_GetPerformanceCounter();
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+	Result result;
+	result.scene = name;
+	result.frames = rendered;
+	result.cpu = getStatistics(cpuTimes);
+	result.gpu = getStatistics(gpuTimes);
+	result.hasGpu = timerQueries;
+	result.seconds = (end - start) / frequency;
+	result.framesPerSecond = result.seconds > 0.0 ? rendered / result.seconds : 0.0;
+	result.textureBinds = rendered > 0 ? static_cast<double>(Texture::getBindCount()) / rendered : 0.0;
+	results.push_back(result);
+
+	return allOk;
+}
+
+/**
+ * \brief Write the results of every run() as JSON
+ */
+void Benchmark::writeJson(std::ostream &os) const
+{
+	std::ios::fmtflags flags = os.flags();
+	os << std::fixed << std::setprecision(4);
+
+	os << "{\n";
+	os << "  \"renderer\": ";
+	writeJsonString(os, getString(GL_RENDERER));
+	os << ",\n  \"version\": ";
+	writeJsonString(os, getString(GL_VERSION));
+	os << ",\n  \"gl_validation\": ";
+	writeJsonString(os, GLValidation::getLevelName(GLValidation::getLevel()));
+	os << ",\n  \"update_rate\": " << FixedTimestep::DEFAULT_RATE;
+	os << ",\n  \"width\": " << width << ",\n  \"height\": " << height << ",\n";
+	os << "  \"scenes\": [";
+	for (size_t i = 0; i < results.size(); ++i)
+	{
+		const Result &result = results[i];
+		os << (i ? ",\n" : "\n") << "    {\"name\": ";
+		writeJsonString(os, result.scene);
+		os << ", \"frames\": " << result.frames << ", \"seconds\": " << result.seconds << ", \"fps\": " << result.framesPerSecond;
+		os << ", \"texture_binds_per_frame\": " << result.textureBinds;
+		os << ",\n     \"cpu_ms\": ";
+		writeStatistics(os, result.cpu);
+		os << ",\n     \"gpu_ms\": ";
+		if (result.hasGpu)
+			writeStatistics(os, result.gpu);
+		else
+			os << "null";
+		os << "}";
+	}
+	os << "\n  ]\n}\n";
+
+	os.flags(flags);
+}
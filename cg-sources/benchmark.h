@@ -0,0 +1,88 @@
+/**
+ * \brief Offscreen frame time measurement of scenes
+ * \file
+ */
+#ifndef BENCHMARK_H_
+#define BENCHMARK_H_
+
+#include <string>
+#include <vector>
+#include <ostream>
+#include <GL/glew.h>
+#include "scene.h"
+
+/**
+ * \brief Renders scenes into a framebuffer object and collects frame time statistics
+ *
+ * Used by the --headless mode of main.cpp. Nothing is shown on screen and nothing waits for vertical sync, so the
+ * frame times are those of the scene itself. Without a display, SDL can create the context with
+ * SDL_VIDEODRIVER=offscreen, or the program can run under Xvfb with Mesa llvmpipe.
+ *
+ * CPU time of a frame covers update(), Texture::updateStreaming() and render(). GPU time is measured with
+ * GL_TIME_ELAPSED queries. Results of a query are read a few frames later, which also keeps the CPU from running
+ * more than that many frames ahead of the GPU, as swapping buffers would.
+ */
+class Benchmark
+{
+public:
+	/**
+	 * \brief Milliseconds per frame
+	 */
+	struct Statistics
+	{
+		double mean;
+		double p50;
+		double p95;
+		double p99;
+	};
+
+	/**
+	 * \brief Measurements of one scene
+	 */
+	struct Result
+	{
+		std::string scene;
+		int frames;
+		Statistics cpu;
+		Statistics gpu;
+		bool hasGpu;            ///< False if timer queries are not supported
+		double seconds;         ///< Time of all frames until the GPU finished the last one
+		double framesPerSecond;
+		double textureBinds;    ///< Texture binds per frame
+	};
+
+	Benchmark(GLsizei width, GLsizei height, int frames);
+	~Benchmark();
+
+	bool isOk() const;
+	bool run(const std::string &name, Scene &scene);
+
+	const std::vector<Result> &getResults() const
+	{
+		return results;
+	}
+
+	void writeJson(std::ostream &os) const;
+
+private:
+	static const unsigned int QUERIES_IN_FLIGHT = 4;
+	static constexpr double FRAME_TIME = 1.0 / 60.0; // Simulated seconds per frame
+
+	GLsizei width;
+	GLsizei height;
+	int frames;
+	GLuint framebuffer;
+	GLuint colorRenderbuffer;
+	GLuint depthRenderbuffer;
+	bool ok;
+	GLuint queries[QUERIES_IN_FLIGHT];
+	bool timerQueries;
+	std::vector<Result> results;
+
+	Benchmark(const Benchmark &);
+	Benchmark &operator=(const Benchmark &);
+
+	static Statistics getStatistics(std::vector<double> &samples);
+};
+
+#endif
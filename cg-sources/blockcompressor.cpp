@@ -0,0 +1,478 @@
+/**
+ * \brief S3TC (BC1/BC3) block compression implementation
+ * \file
+ */
+#include <algorithm>
+#include <cmath>
+#include <thread>
+#include "blockcompressor.h"
+
+// SSE2 is always available on x86-64 and used for palette index search when the compiler allows it
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define BLOCKCOMPRESSOR_SSE2
+#endif
+
+// Anonymous namespace for local helper functions
+namespace
+{
+	/**
+	 * \brief Quantize 8-bit RGB color to 16-bit 5:6:5 color
+	 */
+	Uint16 packColor565(int r, int g, int b)
+	{
+		return static_cast<Uint16>((((r * 31 + 127) / 255) << 11) | (((g * 63 + 127) / 255) << 5) | ((b * 31 + 127) / 255));
+	}
+
+	/**
+	 * \brief Expand 16-bit 5:6:5 color back to 8-bit RGB the same way decoders do it
+	 */
+	void unpackColor565(Uint16 c, int *rgb)
+	{
+		int r = (c >> 11) & 31;
+		int g = (c >> 5) & 63;
+		int b = c & 31;
+		rgb[0] = (r << 3) | (r >> 2);
+		rgb[1] = (g << 2) | (g >> 4);
+		rgb[2] = (b << 3) | (b >> 2);
+	}
+
+	/**
+	 * \brief Build the 4-color palette used when the first endpoint is greater than the second one
+	 */
+	void buildPalette(Uint16 c0, Uint16 c1, int palette[4][3])
+	{
+		unpackColor565(c0, palette[0]);
+		unpackColor565(c1, palette[1]);
+		for (int i = 0; i < 3; ++i)
+		{
+			palette[2][i] = (2 * palette[0][i] + palette[1][i]) / 3;
+			palette[3][i] = (palette[0][i] + 2 * palette[1][i]) / 3;
+		}
+	}
+
+	/**
+	 * \brief Select the closest palette entry for each of the 16 block pixels
+	 * \param rgba Block pixels as 16 r, g, b, a byte quadruplets
+	 * \param palette Block palette
+	 * \param[out] error Sum of squared RGB distances of the selected entries
+	 * \return 2-bit indices packed in the BC1 bit order
+	 */
+	Uint32 findColorIndices(const Uint8 *rgba, const int palette[4][3], int &error)
+	{
+		Uint32 indices = 0;
+		error = 0;
+
+#ifdef BLOCKCOMPRESSOR_SSE2
+		const __m128i zero = _mm_setzero_si128();
+		const __m128i rgbMask = _mm_setr_epi16(-1, -1, -1, 0, -1, -1, -1, 0);
+		__m128i pal[4];
+		for (int k = 0; k < 4; ++k)
+			pal[k] = _mm_setr_epi16(
+				static_cast<short>(palette[k][0]), static_cast<short>(palette[k][1]), static_cast<short>(palette[k][2]), 0,
+				static_cast<short>(palette[k][0]), static_cast<short>(palette[k][1]), static_cast<short>(palette[k][2]), 0);
+
+		// Four pixels per iteration. Each pixel is expanded to four 16-bit lanes and the squared distance
+		// is collected with multiply-add, giving one 32-bit distance per pixel.
+		for (int i = 0; i < 4; ++i)
+		{
+			__m128i px = _mm_loadu_si128(reinterpret_cast<const __m128i *>(rgba + 16 * i));
+			__m128i lo = _mm_and_si128(_mm_unpacklo_epi8(px, zero), rgbMask);
+			__m128i hi = _mm_and_si128(_mm_unpackhi_epi8(px, zero), rgbMask);
+
+			__m128i best = _mm_setzero_si128();
+			__m128i bestIndex = _mm_setzero_si128();
+			for (int k = 0; k < 4; ++k)
+			{
+				__m128i dlo = _mm_sub_epi16(lo, pal[k]);
+				__m128i dhi = _mm_sub_epi16(hi, pal[k]);
+				__m128 slo = _mm_castsi128_ps(_mm_madd_epi16(dlo, dlo));
+				__m128 shi = _mm_castsi128_ps(_mm_madd_epi16(dhi, dhi));
+				__m128i dist = _mm_add_epi32(
+					_mm_castps_si128(_mm_shuffle_ps(slo, shi, _MM_SHUFFLE(2, 0, 2, 0))),
+					_mm_castps_si128(_mm_shuffle_ps(slo, shi, _MM_SHUFFLE(3, 1, 3, 1))));
+
+				if (k == 0)
+				{
+					best = dist;
+					continue;
+				}
+
+				__m128i closer = _mm_cmplt_epi32(dist, best);
+				best = _mm_or_si128(_mm_and_si128(closer, dist), _mm_andnot_si128(closer, best));
+				bestIndex = _mm_or_si128(_mm_and_si128(closer, _mm_set1_epi32(k)), _mm_andnot_si128(closer, bestIndex));
+			}
+
+			int bestArr[4], indexArr[4];
+			_mm_storeu_si128(reinterpret_cast<__m128i *>(bestArr), best);
+			_mm_storeu_si128(reinterpret_cast<__m128i *>(indexArr), bestIndex);
+			for (int j = 0; j < 4; ++j)
+			{
+				error += bestArr[j];
+				indices |= static_cast<Uint32>(indexArr[j]) << (2 * (4 * i + j));
+			}
+		}
+#else
+		for (int i = 0; i < 16; ++i)
+		{
+			const Uint8 *p = rgba + 4 * i;
+			int best = 0, bestIndex = 0;
+			for (int k = 0; k < 4; ++k)
+			{
+				int dr = p[0] - palette[k][0];
+				int dg = p[1] - palette[k][1];
+				int db = p[2] - palette[k][2];
+				int dist = dr * dr + dg * dg + db * db;
+				if (k == 0 || dist < best)
+				{
+					best = dist;
+					bestIndex = k;
+				}
+			}
+			error += best;
+			indices |= static_cast<Uint32>(bestIndex) << (2 * i);
+		}
+#endif
+
+		return indices;
+	}
+
+	/**
+	 * \brief Encode endpoints and select indices for them
+	 * \return Squared error of the encoded block
+	 */
+	int encodeEndpoints(const Uint8 *rgba, const float *e0, const float *e1, Uint16 &c0, Uint16 &c1, Uint32 &indices)
+	{
+		c0 = packColor565(static_cast<int>(e0[0] + 0.5f), static_cast<int>(e0[1] + 0.5f), static_cast<int>(e0[2] + 0.5f));
+		c1 = packColor565(static_cast<int>(e1[0] + 0.5f), static_cast<int>(e1[1] + 0.5f), static_cast<int>(e1[2] + 0.5f));
+
+		// Endpoint order selects 4-color mode (c0 > c1). Swapping endpoints mirrors indices 0 <-> 1 and 2 <-> 3.
+		if (c0 < c1)
+			std::swap(c0, c1);
+
+		int palette[4][3];
+		buildPalette(c0, c1, palette);
+
+		int error;
+		indices = findColorIndices(rgba, palette, error);
+
+		// Identical endpoints are decoded in 3-color mode. Index 0 is still the endpoint itself.
+		if (c0 == c1)
+			indices = 0;
+
+		return error;
+	}
+
+	/**
+	 * \brief Clamp color channel into the valid 8-bit range
+	 */
+	float clampChannel(float v)
+	{
+		return std::min(255.0f, std::max(0.0f, v));
+	}
+}
+
+/**
+ * \brief Size of a single 4x4 block in bytes
+ */
+size_t BlockCompressor::getBlockSize(Format format)
+{
+	return format == BC1 ? 8 : 16;
+}
+
+/**
+ * \brief Size of a compressed image in bytes
+ *
+ * Partial blocks at the right and top edges take a full block.
+ */
+size_t BlockCompressor::getCompressedSize(Format format, int width, int height)
+{
+	return static_cast<size_t>((width + 3) / 4) * static_cast<size_t>((height + 3) / 4) * getBlockSize(format);
+}
+
+/**
+ * \brief Compress an image
+ *
+ * Image is split to horizontal bands of block rows that are encoded in parallel.
+ *
+ * \param format Output block format
+ * \param quality Endpoint search quality
+ * \param pixels Source image in SDL_PIXELFORMAT_RGBA8888 layout
+ * \param width Image width in pixels
+ * \param height Image height in pixels
+ * \param pitch Distance between rows in bytes
+ * \param[out] out Compressed blocks. Resized to getCompressedSize()
+ * \param threads Number of worker threads. 0 uses all hardware threads.
+ */
+void BlockCompressor::compress(Format format, Quality quality, const Uint32 *pixels, int width, int height, int pitch, std::vector<Uint8> &out, unsigned int threads)
+{
+	out.resize(getCompressedSize(format, width, height));
+	if (out.empty())
+		return;
+
+	int blockRows = (height + 3) / 4;
+
+	if (threads == 0)
+		threads = std::max(1u, std::thread::hardware_concurrency());
+
+	// Starting threads is not free. Give each worker a reasonable amount of blocks.
+	const int minBlocksPerThread = 1024;
+	int blocksPerRow = (width + 3) / 4;
+	threads = std::min(threads, static_cast<unsigned int>(std::max(1, blockRows * blocksPerRow / minBlocksPerThread)));
+
+	if (threads <= 1)
+	{
+		compressRows(format, quality, pixels, width, height, pitch, 0, blockRows, &out[0]);
+		return;
+	}
+
+	std::vector<std::thread> workers;
+	for (unsigned int t = 0; t < threads; ++t)
+	{
+		int first = static_cast<int>(blockRows * t / threads);
+		int last = static_cast<int>(blockRows * (t + 1) / threads);
+		Uint8 *dst = &out[0] + static_cast<size_t>(first) * blocksPerRow * getBlockSize(format);
+		workers.push_back(std::thread(&BlockCompressor::compressRows, format, quality, pixels, width, height, pitch, first, last, dst));
+	}
+
+	for (size_t t = 0; t < workers.size(); ++t)
+		workers[t].join();
+}
+
+/**
+ * \brief Compress a band of block rows
+ * \param out Destination for the first block of firstBlockRow
+ */
+void BlockCompressor::compressRows(Format format, Quality quality, const Uint32 *pixels, int width, int height, int pitch, int firstBlockRow, int lastBlockRow, Uint8 *out)
+{
+	Uint8 rgba[64];
+
+	for (int by = firstBlockRow; by < lastBlockRow; ++by)
+	{
+		for (int bx = 0; bx < (width + 3) / 4; ++bx)
+		{
+			// Gather block. Pixels outside the image repeat the last row/column so they don't affect endpoints.
+			for (int y = 0; y < 4; ++y)
+			{
+				int sy = std::min(by * 4 + y, height - 1);
+				const Uint32 *row = reinterpret_cast<const Uint32 *>(reinterpret_cast<const Uint8 *>(pixels) + sy * pitch);
+				for (int x = 0; x < 4; ++x)
+				{
+					Uint32 p = row[std::min(bx * 4 + x, width - 1)];
+					Uint8 *dst = rgba + 4 * (4 * y + x);
+					dst[0] = static_cast<Uint8>(p >> 24);
+					dst[1] = static_cast<Uint8>(p >> 16);
+					dst[2] = static_cast<Uint8>(p >> 8);
+					dst[3] = static_cast<Uint8>(p);
+				}
+			}
+
+			// BC3 block is an alpha block followed by a BC1 color block
+			if (format == BC3)
+			{
+				compressAlphaBlock(rgba, out);
+				out += 8;
+			}
+
+			compressColorBlock(rgba, quality, out);
+			out += 8;
+		}
+	}
+}
+
+/**
+ * \brief Compress color part of a block
+ * \param rgba 16 pixels as r, g, b, a bytes
+ * \param quality Endpoint search quality
+ * \param[out] out 8 bytes of BC1 block data
+ */
+void BlockCompressor::compressColorBlock(const Uint8 *rgba, Quality quality, Uint8 *out)
+{
+	float minColor[3] = { 255.0f, 255.0f, 255.0f };
+	float maxColor[3] = { 0.0f, 0.0f, 0.0f };
+	float mean[3] = { 0.0f, 0.0f, 0.0f };
+
+	for (int i = 0; i < 16; ++i)
+	{
+		for (int c = 0; c < 3; ++c)
+		{
+			float v = rgba[4 * i + c];
+			minColor[c] = std::min(minColor[c], v);
+			maxColor[c] = std::max(maxColor[c], v);
+			mean[c] += v;
+		}
+	}
+
+	float e0[3], e1[3];
+
+	if (quality == FAST)
+	{
+		// Bounding box diagonal, inset slightly as the extreme colors are rarely hit exactly
+		for (int c = 0; c < 3; ++c)
+		{
+			float inset = (maxColor[c] - minColor[c]) / 16.0f;
+			e0[c] = maxColor[c] - inset;
+			e1[c] = minColor[c] + inset;
+		}
+	} else
+	{
+		// Principal axis of the color distribution by power iteration on the covariance matrix
+		for (int c = 0; c < 3; ++c)
+			mean[c] /= 16.0f;
+
+		float cov[6] = { 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f };
+		for (int i = 0; i < 16; ++i)
+		{
+			float r = rgba[4 * i + 0] - mean[0];
+			float g = rgba[4 * i + 1] - mean[1];
+			float b = rgba[4 * i + 2] - mean[2];
+			cov[0] += r * r;
+			cov[1] += r * g;
+			cov[2] += r * b;
+			cov[3] += g * g;
+			cov[4] += g * b;
+			cov[5] += b * b;
+		}
+
+		float axis[3] = { maxColor[0] - minColor[0], maxColor[1] - minColor[1], maxColor[2] - minColor[2] };
+		for (int iter = 0; iter < 4; ++iter)
+		{
+			float x = cov[0] * axis[0] + cov[1] * axis[1] + cov[2] * axis[2];
+			float y = cov[1] * axis[0] + cov[3] * axis[1] + cov[4] * axis[2];
+			float z = cov[2] * axis[0] + cov[4] * axis[1] + cov[5] * axis[2];
+			float len = std::max(std::max(std::fabs(x), std::fabs(y)), std::fabs(z));
+			if (len <= 0.0f)
+				break;
+			axis[0] = x / len;
+			axis[1] = y / len;
+			axis[2] = z / len;
+		}
+
+		// Extreme projections along the axis become endpoints
+		float minDot = 0.0f, maxDot = 0.0f;
+		for (int i = 0; i < 16; ++i)
+		{
+			float d = (rgba[4 * i + 0] - mean[0]) * axis[0] + (rgba[4 * i + 1] - mean[1]) * axis[1] + (rgba[4 * i + 2] - mean[2]) * axis[2];
+			minDot = std::min(minDot, d);
+			maxDot = std::max(maxDot, d);
+		}
+
+		float len2 = axis[0] * axis[0] + axis[1] * axis[1] + axis[2] * axis[2];
+		if (len2 <= 0.0f)
+			len2 = 1.0f;
+		for (int c = 0; c < 3; ++c)
+		{
+			e0[c] = clampChannel(mean[c] + axis[c] * maxDot / len2);
+			e1[c] = clampChannel(mean[c] + axis[c] * minDot / len2);
+		}
+	}
+
+	Uint16 c0, c1;
+	Uint32 indices;
+	int error = encodeEndpoints(rgba, e0, e1, c0, c1, indices);
+
+	if (quality == HIGH)
+	{
+		// Least squares refinement: keep the selected indices and solve the endpoints that minimize the error for them
+		static const float weights[4] = { 1.0f, 0.0f, 2.0f / 3.0f, 1.0f / 3.0f };
+
+		for (int iter = 0; iter < 2 && error > 0 && c0 != c1; ++iter)
+		{
+			float aa = 0.0f, ab = 0.0f, bb = 0.0f;
+			float ax[3] = { 0.0f, 0.0f, 0.0f };
+			float bx[3] = { 0.0f, 0.0f, 0.0f };
+
+			for (int i = 0; i < 16; ++i)
+			{
+				float a = weights[(indices >> (2 * i)) & 3];
+				float b = 1.0f - a;
+				aa += a * a;
+				ab += a * b;
+				bb += b * b;
+				for (int c = 0; c < 3; ++c)
+				{
+					ax[c] += a * rgba[4 * i + c];
+					bx[c] += b * rgba[4 * i + c];
+				}
+			}
+
+			float det = aa * bb - ab * ab;
+			if (std::fabs(det) < 1e-6f)
+				break;
+
+			float n0[3], n1[3];
+			for (int c = 0; c < 3; ++c)
+			{
+				n0[c] = clampChannel((ax[c] * bb - bx[c] * ab) / det);
+				n1[c] = clampChannel((bx[c] * aa - ax[c] * ab) / det);
+			}
+
+			Uint16 nc0, nc1;
+			Uint32 nindices;
+			int nerror = encodeEndpoints(rgba, n0, n1, nc0, nc1, nindices);
+			if (nerror >= error)
+				break;
+
+			c0 = nc0;
+			c1 = nc1;
+			indices = nindices;
+			error = nerror;
+		}
+	}
+
+	out[0] = static_cast<Uint8>(c0 & 0xff);
+	out[1] = static_cast<Uint8>(c0 >> 8);
+	out[2] = static_cast<Uint8>(c1 & 0xff);
+	out[3] = static_cast<Uint8>(c1 >> 8);
+	out[4] = static_cast<Uint8>(indices & 0xff);
+	out[5] = static_cast<Uint8>((indices >> 8) & 0xff);
+	out[6] = static_cast<Uint8>((indices >> 16) & 0xff);
+	out[7] = static_cast<Uint8>(indices >> 24);
+}
+
+/**
+ * \brief Compress alpha part of a BC3 block
+ * \param rgba 16 pixels as r, g, b, a bytes
+ * \param[out] out 8 bytes of BC3 alpha block data
+ */
+void BlockCompressor::compressAlphaBlock(const Uint8 *rgba, Uint8 *out)
+{
+	int a0 = 0, a1 = 255;
+	for (int i = 0; i < 16; ++i)
+	{
+		a0 = std::max(a0, static_cast<int>(rgba[4 * i + 3]));
+		a1 = std::min(a1, static_cast<int>(rgba[4 * i + 3]));
+	}
+
+	// 8-value mode (a0 > a1): two endpoints and six interpolated values
+	int palette[8];
+	palette[0] = a0;
+	palette[1] = a1;
+	for (int i = 1; i < 7; ++i)
+		palette[i + 1] = ((7 - i) * a0 + i * a1) / 7;
+
+	Uint64 indices = 0;
+	if (a0 != a1)
+	{
+		for (int i = 0; i < 16; ++i)
+		{
+			int a = rgba[4 * i + 3];
+			int best = 256, bestIndex = 0;
+			for (int k = 0; k < 8; ++k)
+			{
+				int dist = std::abs(a - palette[k]);
+				if (dist < best)
+				{
+					best = dist;
+					bestIndex = k;
+				}
+			}
+			indices |= static_cast<Uint64>(bestIndex) << (3 * i);
+		}
+	}
+
+	out[0] = static_cast<Uint8>(a0);
+	out[1] = static_cast<Uint8>(a1);
+	for (int i = 0; i < 6; ++i)
+		out[2 + i] = static_cast<Uint8>((indices >> (8 * i)) & 0xff);
+}
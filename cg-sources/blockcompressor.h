@@ -0,0 +1,53 @@
+/**
+ * \brief S3TC (BC1/BC3) block compression interface
+ * \file
+ */
+#ifndef BLOCKCOMPRESSOR_H_
+#define BLOCKCOMPRESSOR_H_
+
+#include <vector>
+#include <SDL.h>
+
+/**
+ * \brief CPU encoder for S3TC/DXT block compressed textures
+ *
+ * Input images are arrays of 32-bit pixels in the same format Texture uses internally (SDL_PIXELFORMAT_RGBA8888,
+ * red in the most significant byte). Output is a tightly packed sequence of 4x4 blocks in row order that can be passed
+ * to glCompressedTexImage2D() as GL_COMPRESSED_RGB_S3TC_DXT1_EXT (BC1) or GL_COMPRESSED_RGBA_S3TC_DXT5_EXT (BC3).
+ *
+ * Class does not depend on OpenGL so it can be used for both offline conversion and compression at load time.
+ */
+class BlockCompressor
+{
+public:
+	/**
+	 * \brief Output block format
+	 */
+	enum Format
+	{
+		BC1, ///< 8 bytes per block, RGB only (DXT1)
+		BC3  ///< 16 bytes per block, RGB + interpolated alpha (DXT5)
+	};
+
+	/**
+	 * \brief Quality and speed trade-off for endpoint selection
+	 */
+	enum Quality
+	{
+		FAST,   ///< Bounding box endpoints. Fastest, visible banding on gradients
+		NORMAL, ///< Endpoints along the principal axis of the block colors
+		HIGH    ///< Principal axis followed by least squares endpoint refinement
+	};
+
+	static size_t getBlockSize(Format format);
+	static size_t getCompressedSize(Format format, int width, int height);
+
+	static void compress(Format format, Quality quality, const Uint32 *pixels, int width, int height, int pitch, std::vector<Uint8> &out, unsigned int threads = 0);
+
+private:
+	static void compressRows(Format format, Quality quality, const Uint32 *pixels, int width, int height, int pitch, int firstBlockRow, int lastBlockRow, Uint8 *out);
+	static void compressColorBlock(const Uint8 *rgba, Quality quality, Uint8 *out);
+	static void compressAlphaBlock(const Uint8 *rgba, Uint8 *out);
+};
+
+#endif
@@ -2,16 +2,18 @@
 layout(location = 0) in vec3 in_Position;
 layout(location = 1) in vec3 in_Color;
 
-// mvpmatrix is the result of multiplying the model, view, and projection matrices
-uniform mat4 mvpmatrix;
+#include "framedata.glsl"
+
+// Transformation of the object being drawn, view and projection come from FrameData
+uniform mat4 modelMatrix;
 
 out vec3 ex_Color;
 
 void main(void)
 {
-	// Multiply the mvp matrix by the vertex to obtain our final vertex position
+	// Multiply the model, view and projection matrices by the vertex to obtain our final vertex position
 	// gl_Position is an output variable defined by standards
-	gl_Position = mvpmatrix * vec4(in_Position, 1.0);
+	gl_Position = projectionMatrix * viewMatrix * modelMatrix * vec4(in_Position, 1.0);
     
 	ex_Color = in_Color;
 }
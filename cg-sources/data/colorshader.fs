@@ -1,5 +1,7 @@
 #version 330 core
-in  vec3 ex_Color;
+#extension GL_ARB_separate_shader_objects : enable
+#include "varyings.glsl"
+VARYING(VARYING_COLOR) in  vec3 ex_Color;
 layout (location = 0) out vec4 fragColor;
 
 void main(void) {
@@ -0,0 +1,10 @@
+// Camera, lights and time shared by all programs, written once per frame. Matches FrameUniforms in uniformbuffer.h.
+layout(std140) uniform FrameData
+{
+	mat4 viewMatrix;
+	mat4 projectionMatrix;
+	vec4 lightPosition[4]; // In view coordinate frame!
+	vec4 lightColor[4];
+	int lightCount;
+	float time;
+};
@@ -0,0 +1,11 @@
+#version 330 core
+#extension GL_ARB_separate_shader_objects : enable
+#include "varyings.glsl"
+uniform sampler2DArray texture0;
+uniform int layer;        // Texture array layer of the land texture
+VARYING(VARYING_TEXCOORD0) in vec2 f_TexCoord0;
+layout (location = 0) out vec4 fragColor;
+
+void main(void) {
+    fragColor = texture(texture0, vec3(f_TexCoord0, layer));
+}
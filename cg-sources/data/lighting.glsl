@@ -0,0 +1,36 @@
+// Blinn-Phong shading of one point light, all vectors in view coordinates.
+// Material constants are defines so that each material is compiled into its own program variant.
+
+#ifndef AMBIENT
+#define AMBIENT vec4(0.1, 0.1, 0.1, 1.0)
+#endif
+#ifndef DIFFUSE
+#define DIFFUSE vec4(0.5, 0.3, 0.2, 1.0)
+#endif
+#ifndef SPECULAR
+#define SPECULAR vec4(0.9, 0.9, 0.9, 1.0)
+#endif
+#ifndef SHININESS
+#define SHININESS 100.0
+#endif
+
+vec3 shade(vec3 pos, vec3 N, vec3 light)
+{
+	vec3 L = normalize(light - pos);
+	vec3 E = normalize(-pos);
+	vec3 H = normalize(L + E);
+
+	vec4 ambient = AMBIENT;
+
+	float Kd = max(dot(L, N), 0.0);
+	vec4 diffuse = Kd * DIFFUSE;
+
+	float Ks = pow(max(dot(N, H), 0.0), SHININESS);
+	vec4 specular = Ks * SPECULAR;
+
+	if (dot(L, N) < 0.0) {
+		specular = vec4(0.0, 0.0, 0.0, 1.0);
+	}
+
+	return (ambient + diffuse + specular).rgb;
+}
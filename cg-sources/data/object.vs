@@ -0,0 +1,35 @@
+#version 330 core
+#extension GL_ARB_separate_shader_objects : enable
+
+// Vertex stage shared by static objects. Each object's fragment stage uses the outputs it needs.
+layout(location = 0) in vec3 in_Position;
+layout(location = 1) in vec3 in_Color;
+layout(location = 2) in vec2 in_TexCoord0;
+
+// Transformations of the object being drawn
+layout(std140) uniform ObjectData
+{
+	mat4 modelMatrix;
+	mat4 modelViewMatrix;
+	mat4 mvpMatrix;
+};
+
+// Separable programs must declare the built-in outputs they write
+#ifdef GL_ARB_separate_shader_objects
+out gl_PerVertex
+{
+	vec4 gl_Position;
+};
+#endif
+
+#include "varyings.glsl"
+VARYING(VARYING_COLOR) out vec3 ex_Color;
+VARYING(VARYING_TEXCOORD0) out vec2 f_TexCoord0;
+
+void main(){
+
+gl_Position = mvpMatrix * vec4(in_Position , 1.0);
+ex_Color = in_Color;
+f_TexCoord0 = in_TexCoord0;
+
+}
@@ -1,10 +1,13 @@
 #version 330 core
-uniform sampler2D texture0;
-in vec2 f_TexCoord0;
-in vec3 ex_Color;
+#extension GL_ARB_separate_shader_objects : enable
+#include "varyings.glsl"
+uniform sampler2DArray texture0;
+uniform int layer;        // Texture array layer of the flag texture
+VARYING(VARYING_TEXCOORD0) in vec2 f_TexCoord0;
+VARYING(VARYING_COLOR) in vec3 ex_Color;
 layout (location=0) out vec4 fragColor;
 
 void main(void)
 {
-    fragColor = texture2D(texture0, vec2(f_TexCoord0.x, f_TexCoord0.y)) + vec4(ex_Color, 0.0);
+    fragColor = texture(texture0, vec3(f_TexCoord0.x, f_TexCoord0.y, layer)) + vec4(ex_Color, 0.0);
 }
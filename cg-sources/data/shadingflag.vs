@@ -1,63 +1,45 @@
 #version 330 core
+#extension GL_ARB_separate_shader_objects : enable
 layout(location = 0) in vec3 in_Position;
 layout(location = 2) in vec2 in_TexCoord0;
 layout(location = 3) in vec3 in_Normal;
 
-// mvpmatrix is the result of multiplying the model, view, and projection matrices
-uniform float gtime;
-//uniform mat4 mvpmatrix;
-
-
-// model-view and projection matrices
-uniform mat4 mvmatrix;
-uniform mat4 pmatrix;
-uniform vec4 lightPosition; // In view coordinate frame!
+#include "framedata.glsl"
 
+// Transformations of the object being drawn
+layout(std140) uniform ObjectData
+{
+	mat4 modelMatrix;
+	mat4 modelViewMatrix;
+	mat4 mvpMatrix;
+};
 
-const vec4 ambientProduct = vec4(0.1, 0.1, 0.1, 1.0);
-const vec4 diffuseProduct = vec4(0.9, 0.0, 0.0, 1.0);
-const vec4 specularProduct = vec4(0.7, 0.7, 0.7, 1.0);
-const float shininess = 80.0;
 
+// Separable programs must declare the built-in outputs they write
+#ifdef GL_ARB_separate_shader_objects
+out gl_PerVertex
+{
+	vec4 gl_Position;
+};
+#endif
 
+// Material of the flag is given as defines by the scene
+#include "lighting.glsl"
+#include "wave.glsl"
+#include "varyings.glsl"
 
-out vec2 f_TexCoord0;
-out vec3 ex_Color;      //result of shading
+VARYING(VARYING_TEXCOORD0) out vec2 f_TexCoord0;
+VARYING(VARYING_COLOR) out vec3 ex_Color;      //result of shading
 void main()
 {
-    float pi = 3.14;
-    
-    float Z_newpos = 0.8 * in_Position.x * sin(pi * in_Position.x - pi * gtime);
-
-    gl_Position = pmatrix * mvmatrix * vec4(in_Position.x, in_Position.y, Z_newpos, 1.0);
-
-
-
-
-    vec3 pos = (mvmatrix * vec4(in_Position.x, in_Position.y, Z_newpos, 1.0)).xyz;
-	vec3 light = lightPosition.xyz;
-	vec3 L = normalize(light - pos);
-	vec3 E = normalize(-pos);
-	vec3 H = normalize(L + E);
-	
-    vec3 N = normalize((mvmatrix * vec4(in_Normal, 0.0)).xyz);
-
-	vec4 ambient = ambientProduct;
-
-	float Kd = max(dot(L, N), 0.0);
-	vec4 diffuse = Kd * diffuseProduct;
-
-	float Ks = pow(max(dot(N, H), 0.0), shininess);
-	vec4 specular = Ks * specularProduct;
-
-	if (dot(L, N) < 0.0) {
-		specular = vec4(0.0, 0.0, 0.0, 1.0);
-	}
+    float Z_newpos = waveOffset(in_Position, time);
 
+    gl_Position = mvpMatrix * vec4(in_Position.x, in_Position.y, Z_newpos, 1.0);
 
+    vec3 pos = (modelViewMatrix * vec4(in_Position.x, in_Position.y, Z_newpos, 1.0)).xyz;
+    vec3 N = normalize((modelViewMatrix * vec4(in_Normal, 0.0)).xyz);
 
-	ex_Color = (ambient + diffuse + specular).rgb;
-    //ex_Color = vec3(0.0f,0.0f,0.5f);
+    ex_Color = shade(pos, N, lightPosition[0].xyz);
     f_TexCoord0 = in_TexCoord0;
     
 }
@@ -4,13 +4,16 @@
 layout(location = 0) in vec3 in_Position;
 layout(location = 1) in vec3 in_Color;
 
-uniform mat4 mvpmatrix;
+#include "framedata.glsl"
+
+// Transformation of the object being drawn, view and projection come from FrameData
+uniform mat4 modelMatrix;
 
 out vec3 ex_Color;
 
 void main(){
 
-gl_Position = mvpmatrix * vec4(in_Position , 1.0);
+gl_Position = projectionMatrix * viewMatrix * modelMatrix * vec4(in_Position , 1.0);
 ex_Color = in_Color;
 
 }
\ No newline at end of file
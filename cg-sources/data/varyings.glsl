@@ -0,0 +1,11 @@
+// Explicit locations of the values passed from vertex to fragment stages. Separable programs are linked on their
+// own, and if a vertex stage writes outputs that the fragment stage does not read, matching them by name is undefined.
+// Every stage including this must enable GL_ARB_separate_shader_objects. Complete programs match by name as usual.
+#ifdef GL_ARB_separate_shader_objects
+#define VARYING(n) layout(location = n)
+#else
+#define VARYING(n)
+#endif
+
+#define VARYING_COLOR 0
+#define VARYING_TEXCOORD0 1
@@ -0,0 +1,38 @@
+#version 330 core
+// Virtual texture lookup, see virtualtexture.h. Uniforms are set by VirtualTexture::setUniforms().
+uniform sampler2D vt_cache;        // Physical tile cache
+uniform usampler2D vt_indirection; // Cache slot (rg) and level (b) of each tile
+uniform vec2 vt_levelSize[16];     // Size of each level in texels
+uniform int vt_levelRow[16];       // First row of each level in vt_indirection
+uniform int vt_levelCount;
+uniform float vt_tileSize;
+uniform float vt_border;
+uniform float vt_cacheSize;        // Cache size in texels
+uniform float vt_lodBias;
+
+in vec2 f_TexCoord0;
+layout (location=0) out vec4 fragColor;
+
+void main(void)
+{
+	vec2 uv = clamp(f_TexCoord0, 0.0, 1.0);
+
+	// Select the level with about one texel per pixel
+	vec2 texel = uv * vt_levelSize[0];
+	vec2 dx = dFdx(texel);
+	vec2 dy = dFdy(texel);
+	float lod = 0.5 * log2(max(max(dot(dx, dx), dot(dy, dy)), 1e-8)) + vt_lodBias;
+	int level = clamp(int(floor(lod)), 0, vt_levelCount - 1);
+
+	ivec2 tileCount = ivec2(ceil(vt_levelSize[level] / vt_tileSize));
+	ivec2 tile = min(ivec2(uv * vt_levelSize[level] / vt_tileSize), tileCount - 1);
+	uvec4 entry = texelFetch(vt_indirection, ivec2(tile.x, vt_levelRow[level] + tile.y), 0);
+
+	// Entry may point to a coarser ancestor of the tile if the tile itself is not loaded yet
+	int mapped = int(entry.b);
+	ivec2 mappedTile = tile >> (mapped - level);
+	vec2 offset = uv * vt_levelSize[mapped] - vec2(mappedTile) * vt_tileSize;
+
+	vec2 physical = vec2(entry.rg) * (vt_tileSize + 2.0 * vt_border) + vt_border + offset;
+	fragColor = textureLod(vt_cache, physical / vt_cacheSize, 0.0);
+}
@@ -0,0 +1,16 @@
+#version 330 core
+layout (location=0) in vec3 in_Position;
+layout (location=3) in vec2 in_TexCoord0;
+
+// The ground plane is in world coordinates, so only view and projection are needed
+#include "framedata.glsl"
+
+// Virtual texture coordinate for the fragment shader
+out vec2 f_TexCoord0;
+
+void main(void)
+{
+	gl_Position = projectionMatrix * viewMatrix * vec4(in_Position, 1.0);
+
+	f_TexCoord0 = in_TexCoord0;
+}
@@ -0,0 +1,26 @@
+#version 330 core
+// Virtual texture feedback pass, see virtualtexture.h. Writes the tile that virtualtexture.fs would sample.
+uniform vec2 vt_levelSize[16];
+uniform int vt_levelCount;
+uniform float vt_tileSize;
+uniform float vt_lodBias;         // Compensates for the smaller feedback buffer
+
+in vec2 f_TexCoord0;
+layout (location=0) out uvec4 feedback;
+
+void main(void)
+{
+	vec2 uv = clamp(f_TexCoord0, 0.0, 1.0);
+
+	vec2 texel = uv * vt_levelSize[0];
+	vec2 dx = dFdx(texel);
+	vec2 dy = dFdy(texel);
+	float lod = 0.5 * log2(max(max(dot(dx, dx), dot(dy, dy)), 1e-8)) + vt_lodBias;
+	int level = clamp(int(floor(lod)), 0, vt_levelCount - 1);
+
+	ivec2 tileCount = ivec2(ceil(vt_levelSize[level] / vt_tileSize));
+	ivec2 tile = min(ivec2(uv * vt_levelSize[level] / vt_tileSize), tileCount - 1);
+
+	// Alpha 1 marks a valid request
+	feedback = uvec4(uvec2(tile), uint(level), 1u);
+}
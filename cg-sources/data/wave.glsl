@@ -0,0 +1,6 @@
+// Displacement of the waving flag along z for a vertex of the flat flag
+float waveOffset(vec3 position, float time)
+{
+	float pi = 3.14;
+	return 0.8 * position.x * sin(pi * position.x - pi * time);
+}
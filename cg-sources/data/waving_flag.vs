@@ -2,9 +2,12 @@
 layout(location = 0) in vec3 in_Position;
 layout(location = 2) in vec2 in_TexCoord0;
 
-// mvpmatrix is the result of multiplying the model, view, and projection matrices
-uniform float gtime;
-uniform mat4 mvpmatrix;
+#include "framedata.glsl"
+
+// Transformation of the object being drawn, view, projection and time come from FrameData
+uniform mat4 modelMatrix;
+
+#include "wave.glsl"
 
 out vec2 f_TexCoord0;
 out vec3 ex_Color;      //result of shading
@@ -12,11 +15,9 @@ void main()
 {
     
     
-    float pi = 3.14;
-    
-    float Z_newpos = 0.8 * in_Position.x * sin(pi * in_Position.x - pi * gtime);
+    float Z_newpos = waveOffset(in_Position, time);
 
-    gl_Position = mvpmatrix * vec4(in_Position.x, in_Position.y, Z_newpos, 1.0);
+    gl_Position = projectionMatrix * viewMatrix * modelMatrix * vec4(in_Position.x, in_Position.y, Z_newpos, 1.0);
     
     f_TexCoord0 = in_TexCoord0;
     
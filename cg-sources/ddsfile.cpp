@@ -0,0 +1,390 @@
+/**
+ * \brief DDS texture container implementation
+ * \file
+ */
+#include <iostream>
+#include <fstream>
+#include <algorithm>
+#include <iterator>
+#include <cctype>
+#include "ddsfile.h"
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+namespace
+{
+	// DDS_HEADER and DDS_PIXELFORMAT flags
+	const Uint32 DDSD_CAPS = 0x1;
+	const Uint32 DDSD_HEIGHT = 0x2;
+	const Uint32 DDSD_WIDTH = 0x4;
+	const Uint32 DDSD_PITCH = 0x8;
+	const Uint32 DDSD_PIXELFORMAT = 0x1000;
+	const Uint32 DDSD_MIPMAPCOUNT = 0x20000;
+	const Uint32 DDSD_LINEARSIZE = 0x80000;
+	const Uint32 DDPF_ALPHAPIXELS = 0x1;
+	const Uint32 DDPF_FOURCC = 0x4;
+	const Uint32 DDPF_RGB = 0x40;
+	const Uint32 DDSCAPS_COMPLEX = 0x8;
+	const Uint32 DDSCAPS_TEXTURE = 0x1000;
+	const Uint32 DDSCAPS_MIPMAP = 0x400000;
+	const Uint32 DDSCAPS2_CUBEMAP = 0x200;
+	const Uint32 DDSCAPS2_VOLUME = 0x200000;
+
+	const size_t HEADER_SIZE = 128; // Magic number and DDS_HEADER
+
+	// Reserved fields used for partial chains: marker, first level, base width and base height
+	const Uint32 PARTIAL_CHAIN_MARKER = 0x4c4d4743; // "CGML"
+
+	// Byte offsets of DDS_HEADER fields from the start of the file
+	enum
+	{
+		OFFSET_SIZE = 4,
+		OFFSET_FLAGS = 8,
+		OFFSET_HEIGHT = 12,
+		OFFSET_WIDTH = 16,
+		OFFSET_PITCH = 20,
+		OFFSET_MIPMAPCOUNT = 28,
+		OFFSET_RESERVED1 = 32,
+		OFFSET_PF_SIZE = 76,
+		OFFSET_PF_FLAGS = 80,
+		OFFSET_PF_FOURCC = 84,
+		OFFSET_PF_BITCOUNT = 88,
+		OFFSET_PF_RMASK = 92,
+		OFFSET_PF_GMASK = 96,
+		OFFSET_PF_BMASK = 100,
+		OFFSET_PF_AMASK = 104,
+		OFFSET_CAPS = 108,
+		OFFSET_CAPS2 = 112
+	};
+
+	Uint32 fourCC(char a, char b, char c, char d)
+	{
+		return static_cast<Uint32>(a) | (static_cast<Uint32>(b) << 8) | (static_cast<Uint32>(c) << 16) | (static_cast<Uint32>(d) << 24);
+	}
+
+	// Header fields are little endian
+	Uint32 read32(const Uint8 *data, size_t offset)
+	{
+		return static_cast<Uint32>(data[offset]) | (static_cast<Uint32>(data[offset + 1]) << 8) |
+			(static_cast<Uint32>(data[offset + 2]) << 16) | (static_cast<Uint32>(data[offset + 3]) << 24);
+	}
+
+	void write32(Uint8 *data, size_t offset, Uint32 value)
+	{
+		for (int i = 0; i < 4; ++i)
+			data[offset + i] = static_cast<Uint8>(value >> (8 * i));
+	}
+}
+
+DDSFile::DDSFile() :
+	format(UNKNOWN),
+	firstLevel(0),
+	baseWidth(0),
+	baseHeight(0),
+	mapping(0),
+	mappingSize(0)
+{
+}
+
+DDSFile::~DDSFile()
+{
+	close();
+}
+
+/**
+ * \brief Map a file into memory and read its header
+ *
+ * \param filename DDS file to open
+ * \return true if success
+ */
+bool DDSFile::open(const std::string &filename)
+{
+	close();
+
+#ifndef _WIN32
+	int fd = ::open(filename.c_str(), O_RDONLY);
+	if (fd < 0)
+	{
+		std::cerr << "DDSFile::open(): Unable to open " << filename << std::endl;
+		return false;
+	}
+
+	struct stat info;
+	if (fstat(fd, &info) == 0 && info.st_size > 0)
+	{
+		void *ptr = mmap(0, static_cast<size_t>(info.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+		if (ptr != MAP_FAILED)
+		{
+			mapping = static_cast<const Uint8 *>(ptr);
+			mappingSize = static_cast<size_t>(info.st_size);
+		}
+	}
+
+	// Mapping stays valid after the descriptor is closed
+	::close(fd);
+#endif
+
+	// Read the whole file if it could not be mapped
+	if (!mapping)
+	{
+		std::ifstream file(filename.c_str(), std::ios::in | std::ios::binary);
+		if (!file)
+		{
+			std::cerr << "DDSFile::open(): Unable to open " << filename << std::endl;
+			return false;
+		}
+
+		buffer.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+		if (buffer.empty())
+		{
+			std::cerr << "DDSFile::open(): " << filename << " is empty" << std::endl;
+			return false;
+		}
+		mapping = &buffer[0];
+		mappingSize = buffer.size();
+	}
+
+	if (!parse(filename))
+	{
+		close();
+		return false;
+	}
+
+	return true;
+}
+
+/**
+ * \brief Release file mapping
+ *
+ * Level pointers become invalid.
+ */
+void DDSFile::close()
+{
+#ifndef _WIN32
+	if (mapping && buffer.empty())
+		munmap(const_cast<Uint8 *>(mapping), mappingSize);
+#endif
+
+	// Swap with a temporary object to release memory completely
+	std::vector<Uint8> tmp;
+	buffer.swap(tmp);
+
+	mapping = 0;
+	mappingSize = 0;
+	format = UNKNOWN;
+	levels.clear();
+	firstLevel = 0;
+	baseWidth = 0;
+	baseHeight = 0;
+}
+
+/**
+ * \brief Validate the header and locate mipmap levels
+ */
+bool DDSFile::parse(const std::string &filename)
+{
+	if (mappingSize < HEADER_SIZE || read32(mapping, 0) != fourCC('D', 'D', 'S', ' ') || read32(mapping, OFFSET_SIZE) != 124 || read32(mapping, OFFSET_PF_SIZE) != 32)
+	{
+		std::cerr << "DDSFile::open(): " << filename << " is not a DDS file" << std::endl;
+		return false;
+	}
+
+	if (read32(mapping, OFFSET_CAPS2) & (DDSCAPS2_CUBEMAP | DDSCAPS2_VOLUME))
+	{
+		std::cerr << "DDSFile::open(): " << filename << ": Cube maps and volume textures are not supported" << std::endl;
+		return false;
+	}
+
+	Uint32 pfFlags = read32(mapping, OFFSET_PF_FLAGS);
+	if (pfFlags & DDPF_FOURCC)
+	{
+		Uint32 code = read32(mapping, OFFSET_PF_FOURCC);
+		if (code == fourCC('D', 'X', 'T', '1'))
+			format = BC1;
+		else
+		if (code == fourCC('D', 'X', 'T', '5'))
+			format = BC3;
+	} else
+	if ((pfFlags & DDPF_RGB) && read32(mapping, OFFSET_PF_BITCOUNT) == 32)
+	{
+		Uint32 rmask = read32(mapping, OFFSET_PF_RMASK);
+		Uint32 amask = (pfFlags & DDPF_ALPHAPIXELS) ? read32(mapping, OFFSET_PF_AMASK) : 0;
+		if (rmask == 0xff000000 && amask == 0x000000ff)
+			format = RGBA8888;
+		else
+		if (rmask == 0x000000ff && amask == 0xff000000)
+			format = ABGR8888;
+	}
+
+	if (format == UNKNOWN)
+	{
+		std::cerr << "DDSFile::open(): " << filename << ": Unsupported pixel format" << std::endl;
+		return false;
+	}
+
+	int width = static_cast<int>(read32(mapping, OFFSET_WIDTH));
+	int height = static_cast<int>(read32(mapping, OFFSET_HEIGHT));
+	int count = (read32(mapping, OFFSET_FLAGS) & DDSD_MIPMAPCOUNT) ? static_cast<int>(read32(mapping, OFFSET_MIPMAPCOUNT)) : 1;
+	if (width <= 0 || height <= 0)
+	{
+		std::cerr << "DDSFile::open(): " << filename << ": Invalid size" << std::endl;
+		return false;
+	}
+
+	baseWidth = width;
+	baseHeight = height;
+	if (read32(mapping, OFFSET_RESERVED1) == PARTIAL_CHAIN_MARKER)
+	{
+		firstLevel = static_cast<int>(read32(mapping, OFFSET_RESERVED1 + 4));
+		baseWidth = static_cast<int>(read32(mapping, OFFSET_RESERVED1 + 8));
+		baseHeight = static_cast<int>(read32(mapping, OFFSET_RESERVED1 + 12));
+		if (firstLevel < 0 || firstLevel > 31 || std::max(1, baseWidth >> firstLevel) != width || std::max(1, baseHeight >> firstLevel) != height)
+		{
+			std::cerr << "DDSFile::open(): " << filename << ": Invalid partial mipmap chain" << std::endl;
+			return false;
+		}
+	}
+
+	size_t offset = HEADER_SIZE;
+	for (int i = 0; i < std::max(count, 1); ++i)
+	{
+		Level level;
+		level.width = std::max(1, width >> i);
+		level.height = std::max(1, height >> i);
+		level.size = getLevelSize(format, level.width, level.height);
+		level.data = mapping + offset;
+
+		if (offset + level.size > mappingSize)
+		{
+			std::cerr << "DDSFile::open(): " << filename << " is truncated" << std::endl;
+			return false;
+		}
+
+		offset += level.size;
+		levels.push_back(level);
+
+		if (level.width == 1 && level.height == 1)
+			break;
+	}
+
+	return true;
+}
+
+/**
+ * \brief Bytes needed for one image in given format
+ */
+size_t DDSFile::getLevelSize(Format format, int width, int height)
+{
+	size_t blocks = static_cast<size_t>((width + 3) / 4) * ((height + 3) / 4);
+
+	switch (format)
+	{
+	case BC1:
+		return blocks * 8;
+	case BC3:
+		return blocks * 16;
+	case RGBA8888:
+	case ABGR8888:
+		return static_cast<size_t>(width) * height * 4;
+	default:
+		return 0;
+	}
+}
+
+/**
+ * \brief Check if filename has the .dds extension
+ */
+bool DDSFile::isDDSFile(const std::string &filename)
+{
+	if (filename.size() < 4)
+		return false;
+
+	std::string extension = filename.substr(filename.size() - 4);
+	std::transform(extension.begin(), extension.end(), extension.begin(), ::tolower);
+	return extension == ".dds";
+}
+
+/**
+ * \brief Write a mipmap chain into a DDS file
+ *
+ * Uncompressed levels are written as they are in memory, so RGBA8888 files are only portable between little endian systems.
+ * \param filename File to create
+ * \param format Format of the level data
+ * \param width Width of level 0 of the chain
+ * \param height Height of level 0 of the chain
+ * \param levels Level data starting from level firstLevel, each getLevelSize() bytes
+ * \param firstLevel Index of the first level in levels. Non-zero values write only the tail of the chain.
+ * \return true if success
+ */
+bool DDSFile::write(const std::string &filename, Format format, int width, int height, const std::vector<std::vector<Uint8> > &levels, int firstLevel)
+{
+	if (format == UNKNOWN || levels.empty())
+		return false;
+
+	int baseWidth = width;
+	int baseHeight = height;
+	width = std::max(1, baseWidth >> firstLevel);
+	height = std::max(1, baseHeight >> firstLevel);
+
+	for (size_t i = 0; i < levels.size(); ++i)
+	{
+		if (levels[i].size() != getLevelSize(format, std::max(1, width >> i), std::max(1, height >> i)))
+		{
+			std::cerr << "DDSFile::write(): Level " << i << " has a wrong size" << std::endl;
+			return false;
+		}
+	}
+
+	bool compressed = format == BC1 || format == BC3;
+
+	Uint8 header[HEADER_SIZE] = { 0 };
+	write32(header, 0, fourCC('D', 'D', 'S', ' '));
+	write32(header, OFFSET_SIZE, 124);
+	write32(header, OFFSET_FLAGS, DDSD_CAPS | DDSD_HEIGHT | DDSD_WIDTH | DDSD_PIXELFORMAT | DDSD_MIPMAPCOUNT | (compressed ? DDSD_LINEARSIZE : DDSD_PITCH));
+	write32(header, OFFSET_HEIGHT, static_cast<Uint32>(height));
+	write32(header, OFFSET_WIDTH, static_cast<Uint32>(width));
+	write32(header, OFFSET_PITCH, static_cast<Uint32>(compressed ? levels[0].size() : static_cast<size_t>(width) * 4));
+	write32(header, OFFSET_MIPMAPCOUNT, static_cast<Uint32>(levels.size()));
+	write32(header, OFFSET_PF_SIZE, 32);
+
+	if (firstLevel)
+	{
+		write32(header, OFFSET_RESERVED1, PARTIAL_CHAIN_MARKER);
+		write32(header, OFFSET_RESERVED1 + 4, static_cast<Uint32>(firstLevel));
+		write32(header, OFFSET_RESERVED1 + 8, static_cast<Uint32>(baseWidth));
+		write32(header, OFFSET_RESERVED1 + 12, static_cast<Uint32>(baseHeight));
+	}
+	write32(header, OFFSET_CAPS, DDSCAPS_TEXTURE | (levels.size() > 1 ? DDSCAPS_COMPLEX | DDSCAPS_MIPMAP : 0));
+
+	if (compressed)
+	{
+		write32(header, OFFSET_PF_FLAGS, DDPF_FOURCC);
+		write32(header, OFFSET_PF_FOURCC, format == BC1 ? fourCC('D', 'X', 'T', '1') : fourCC('D', 'X', 'T', '5'));
+	} else
+	{
+		write32(header, OFFSET_PF_FLAGS, DDPF_RGB | DDPF_ALPHAPIXELS);
+		write32(header, OFFSET_PF_BITCOUNT, 32);
+		write32(header, OFFSET_PF_RMASK, format == RGBA8888 ? 0xff000000 : 0x000000ff);
+		write32(header, OFFSET_PF_GMASK, format == RGBA8888 ? 0x00ff0000 : 0x0000ff00);
+		write32(header, OFFSET_PF_BMASK, format == RGBA8888 ? 0x0000ff00 : 0x00ff0000);
+		write32(header, OFFSET_PF_AMASK, format == RGBA8888 ? 0x000000ff : 0xff000000);
+	}
+
+	std::ofstream file(filename.c_str(), std::ios::out | std::ios::binary | std::ios::trunc);
+	if (!file)
+	{
+		std::cerr << "DDSFile::write(): Unable to create " << filename << std::endl;
+		return false;
+	}
+
+	file.write(reinterpret_cast<const char *>(header), HEADER_SIZE);
+	for (size_t i = 0; i < levels.size(); ++i)
+		file.write(reinterpret_cast<const char *>(&levels[i][0]), static_cast<std::streamsize>(levels[i].size()));
+
+	return file.good();
+}
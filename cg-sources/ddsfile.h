@@ -0,0 +1,113 @@
+/**
+ * \brief DDS texture container interface
+ * \file
+ */
+#ifndef DDSFILE_H_
+#define DDSFILE_H_
+
+#include <string>
+#include <vector>
+#include <SDL.h>
+
+/**
+ * \brief Memory mapped DirectDraw Surface (DDS) file
+ *
+ * DDS stores a complete mipmap chain in the format it is uploaded to the GPU, so loading needs no decoding,
+ * conversion or mipmap generation. Level data can be passed directly to glTexSubImage2D() or glCompressedTexSubImage2D().
+ * See https://msdn.microsoft.com/en-us/library/windows/desktop/bb943991.aspx
+ *
+ * Supported formats are 32-bit RGBA and DXT1/DXT5 (BC1/BC3). Cube maps, volume textures and DX10 headers are not.
+ *
+ * Files written by write() store rows in OpenGL order, i.e. the first row is the bottom of the image.
+ * DDS files from other tools store the top row first and show up vertically flipped.
+ *
+ * A file can also hold only the tail of a mipmap chain. The full image size and the index of the first stored level
+ * are then kept in reserved header fields and returned by getBaseWidth(), getBaseHeight() and getFirstLevel().
+ */
+class DDSFile
+{
+public:
+	/**
+	 * \brief Texel format of the file
+	 */
+	enum Format
+	{
+		UNKNOWN,
+		RGBA8888, ///< 32-bit pixels with red in the most significant byte, like Texture surfaces
+		ABGR8888, ///< Bytes in R, G, B, A order
+		BC1,      ///< DXT1, 8 bytes per 4x4 block
+		BC3       ///< DXT5, 16 bytes per 4x4 block
+	};
+
+	/**
+	 * \brief One mipmap level in the file
+	 */
+	struct Level
+	{
+		int width;
+		int height;
+		const Uint8 *data; ///< Points into the mapped file
+		size_t size;       ///< Bytes of data
+	};
+
+private:
+	Format format;
+	std::vector<Level> levels;
+	int firstLevel; // Mipmap level of the first stored image
+	int baseWidth;  // Size of level 0 of the chain
+	int baseHeight;
+	const Uint8 *mapping; // Start of the file in memory
+	size_t mappingSize;   // Size of the file
+	std::vector<Uint8> buffer; // File contents when memory mapping is not available
+
+	bool parse(const std::string &filename);
+
+	DDSFile(const DDSFile &);
+	DDSFile &operator=(const DDSFile &);
+public:
+	DDSFile();
+	~DDSFile();
+
+	bool open(const std::string &filename);
+	void close();
+
+	static size_t getLevelSize(Format format, int width, int height);
+	static bool write(const std::string &filename, Format format, int width, int height, const std::vector<std::vector<Uint8> > &levels, int firstLevel = 0);
+	static bool isDDSFile(const std::string &filename);
+
+	Format getFormat() const
+	{
+		return format;
+	}
+
+	bool isCompressed() const
+	{
+		return format == BC1 || format == BC3;
+	}
+
+	/**
+	 * \brief Number of mipmap levels. 0 if no file is open.
+	 */
+	int getLevelCount() const
+	{
+		return static_cast<int>(levels.size());
+	}
+
+	const Level &getLevel(int level) const
+	{
+		return levels[level];
+	}
+
+	/**
+	 * \brief Mipmap level of getLevel(0) in the full chain. 0 unless the file holds only the tail of the chain.
+	 */
+	int getFirstLevel() const
+	{
+		return firstLevel;
+	}
+
+	int getBaseWidth() const { return baseWidth; }
+	int getBaseHeight() const { return baseHeight; }
+};
+
+#endif
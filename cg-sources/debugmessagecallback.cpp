@@ -1,11 +1,293 @@
 #include <GL/glew.h>
+#include <SDL.h>
 #include <iostream>
+#include <sstream>
 #include <string>
+#include <cstring>
+#include <cstdlib>
+#include <cctype>
+#include <vector>
+#include <algorithm>
+#include <atomic>
 #include "debugmessagecallback.h"
+#include "log.h"
 
 // Anonymous namespace for local callback function
 namespace
 {
+	/**
+	 * \brief One glDebugMessageControl() call: messages of a severity, a type or an ID are enabled or disabled
+	 */
+	struct FilterRule
+	{
+		GLenum severity;
+		GLenum type;
+		GLuint id;
+		bool hasId;
+		GLboolean enabled;
+	};
+
+	const size_t MAX_TEXT = 160; // Characters kept of the first message of every ID
+
+	/**
+	 * \brief Occurrences of one message ID. Slots are claimed by setting key and never released while the callback is installed.
+	 */
+	struct Counter
+	{
+		std::atomic<unsigned long long> key;               // getKey() of the message, 0 while the slot is free
+		GLenum source;
+		GLenum type;
+		GLenum severity;
+		GLuint id;
+		char text[MAX_TEXT];                               // First message with this ID
+		std::atomic<unsigned long long> total;             // All occurrences
+		std::atomic<unsigned long long> suppressed;        // Occurrences not printed due to the rate limit
+		std::atomic<unsigned int> pending;                 // Suppressed since the last logged message
+		std::atomic<Uint32> windowStart;                   // SDL_GetTicks() at the start of the current rate limit window
+		std::atomic<unsigned int> windowCount;             // Messages in the current window
+	};
+
+	const unsigned int MAX_COUNTERS = 256; // Must be a power of two
+	const GLenum SOURCES[] = {GL_DEBUG_SOURCE_API, GL_DEBUG_SOURCE_WINDOW_SYSTEM, GL_DEBUG_SOURCE_SHADER_COMPILER, GL_DEBUG_SOURCE_THIRD_PARTY, GL_DEBUG_SOURCE_APPLICATION, GL_DEBUG_SOURCE_OTHER};
+	const GLenum TYPES[] = {GL_DEBUG_TYPE_ERROR, GL_DEBUG_TYPE_DEPRECATED_BEHAVIOR, GL_DEBUG_TYPE_UNDEFINED_BEHAVIOR, GL_DEBUG_TYPE_PORTABILITY, GL_DEBUG_TYPE_PERFORMANCE,
+	                        GL_DEBUG_TYPE_MARKER, GL_DEBUG_TYPE_PUSH_GROUP, GL_DEBUG_TYPE_POP_GROUP, GL_DEBUG_TYPE_OTHER};
+
+	std::vector<FilterRule> rules;
+	unsigned int rateLimit = 5; // Messages per second with the same ID
+	bool installed = false;
+	bool synchronous = false;
+
+	Counter counters[MAX_COUNTERS];
+	std::atomic<unsigned int> untracked(0); // Messages of IDs that did not fit into counters
+
+	/**
+	 * \brief Copy at most MAX_TEXT - 1 characters of a message
+	 */
+	void copyText(char *text, GLsizei length, const GLchar *message)
+	{
+		size_t bytes = std::min(static_cast<size_t>(length >= 0 ? length : std::strlen(message)), MAX_TEXT - 1);
+		std::memcpy(text, message, bytes);
+		text[bytes] = '\0';
+	}
+
+	/**
+	 * \brief Find or claim the counter of a message without locking or allocating
+	 * \return 0 if every counter is taken by other IDs
+	 */
+	Counter *findCounter(GLenum source, GLenum type, GLuint id, GLenum severity, GLsizei length, const GLchar *message, Uint32 now)
+	{
+		// IDs are unique within a source and type. Sources are never 0, so neither is the key.
+		unsigned long long key = (static_cast<unsigned long long>(source) << 48) ^ (static_cast<unsigned long long>(type) << 32) ^ id;
+		unsigned int slot = static_cast<unsigned int>((key * 0x9e3779b97f4a7c15ULL) >> 32);
+
+		for (unsigned int probe = 0; probe < MAX_COUNTERS; ++probe)
+		{
+			Counter &counter = counters[(slot + probe) & (MAX_COUNTERS - 1)];
+			unsigned long long current = counter.key.load(std::memory_order_acquire);
+			if (current == 0)
+			{
+				if (counter.key.compare_exchange_strong(current, key, std::memory_order_acq_rel))
+				{
+					counter.source = source;
+					counter.type = type;
+					counter.severity = severity;
+					counter.id = id;
+					copyText(counter.text, length, message);
+					counter.windowStart.store(now, std::memory_order_relaxed);
+					return &counter;
+				}
+			}
+			if (current == key)
+				return &counter;
+		}
+		return 0;
+	}
+
+	const char *getSourceName(GLenum source)
+	{
+		switch (source)
+		{
+		case GL_DEBUG_SOURCE_API: return "API";
+		case GL_DEBUG_SOURCE_WINDOW_SYSTEM: return "Window system";
+		case GL_DEBUG_SOURCE_SHADER_COMPILER: return "Shader compiler";
+		case GL_DEBUG_SOURCE_THIRD_PARTY: return "3rd party";
+		case GL_DEBUG_SOURCE_APPLICATION: return "Application";
+		default: return "Other";
+		}
+	}
+
+	const char *getTypeName(GLenum type)
+	{
+		switch (type)
+		{
+		case GL_DEBUG_TYPE_ERROR: return "Error";
+		case GL_DEBUG_TYPE_DEPRECATED_BEHAVIOR: return "Deprecated behavior";
+		case GL_DEBUG_TYPE_UNDEFINED_BEHAVIOR: return "Undefined behavior";
+		case GL_DEBUG_TYPE_PORTABILITY: return "Portability";
+		case GL_DEBUG_TYPE_PERFORMANCE: return "Performance";
+		case GL_DEBUG_TYPE_MARKER: return "Marker";
+		case GL_DEBUG_TYPE_PUSH_GROUP: return "Push group";
+		case GL_DEBUG_TYPE_POP_GROUP: return "Pop group";
+		default: return "Other";
+		}
+	}
+
+	const char *getSeverityName(GLenum severity)
+	{
+		switch (severity)
+		{
+		case GL_DEBUG_SEVERITY_HIGH: return "HIGH!";
+		case GL_DEBUG_SEVERITY_MEDIUM: return "Medium";
+		case GL_DEBUG_SEVERITY_LOW: return "Low";
+		case GL_DEBUG_SEVERITY_NOTIFICATION: return "Note";
+		default: return "Unknown";
+		}
+	}
+
+	/**
+	 * \brief Parse one rule such as "-notification", "+performance" or "-131185"
+	 */
+	bool parseRule(const std::string &text, FilterRule &rule)
+	{
+		if (text.size() < 2 || (text[0] != '+' && text[0] != '-'))
+			return false;
+
+		rule.severity = GL_DONT_CARE;
+		rule.type = GL_DONT_CARE;
+		rule.id = 0;
+		rule.hasId = false;
+		rule.enabled = text[0] == '+' ? GL_TRUE : GL_FALSE;
+
+		std::string name = text.substr(1);
+		if (name == "high")
+			rule.severity = GL_DEBUG_SEVERITY_HIGH;
+		else
+		if (name == "medium")
+			rule.severity = GL_DEBUG_SEVERITY_MEDIUM;
+		else
+		if (name == "low")
+			rule.severity = GL_DEBUG_SEVERITY_LOW;
+		else
+		if (name == "notification")
+			rule.severity = GL_DEBUG_SEVERITY_NOTIFICATION;
+		else
+		if (name == "error")
+			rule.type = GL_DEBUG_TYPE_ERROR;
+		else
+		if (name == "deprecated")
+			rule.type = GL_DEBUG_TYPE_DEPRECATED_BEHAVIOR;
+		else
+		if (name == "undefined")
+			rule.type = GL_DEBUG_TYPE_UNDEFINED_BEHAVIOR;
+		else
+		if (name == "portability")
+			rule.type = GL_DEBUG_TYPE_PORTABILITY;
+		else
+		if (name == "performance")
+			rule.type = GL_DEBUG_TYPE_PERFORMANCE;
+		else
+		if (name == "marker")
+			rule.type = GL_DEBUG_TYPE_MARKER;
+		else
+		if (name == "group")
+			rule.type = GL_DEBUG_TYPE_PUSH_GROUP; // Pop group is added by addDebugMessageFilter()
+		else
+		if (name == "other")
+			rule.type = GL_DEBUG_TYPE_OTHER;
+		else
+		{
+			char *end = 0;
+			unsigned long id = std::strtoul(name.c_str(), &end, 0);
+			if (*end != '\0' || !std::isdigit(static_cast<unsigned char>(name[0])))
+				return false;
+			rule.id = static_cast<GLuint>(id);
+			rule.hasId = true;
+		}
+		return true;
+	}
+
+	/**
+	 * \brief Pass the filter rules to the driver, so that rejected messages never reach the callback
+	 * \param control glDebugMessageControl or glDebugMessageControlARB
+	 */
+	template <typename T>
+	void applyRules(T control)
+	{
+		for (size_t i = 0; i < rules.size(); ++i)
+		{
+			const FilterRule &rule = rules[i];
+			if (!rule.hasId)
+			{
+				control(GL_DONT_CARE, rule.type, rule.severity, 0, 0, rule.enabled);
+				continue;
+			}
+
+			// IDs are only unique within a source and type, which then can't be GL_DONT_CARE
+			for (size_t s = 0; s < sizeof(SOURCES) / sizeof(SOURCES[0]); ++s)
+			{
+				for (size_t t = 0; t < sizeof(TYPES) / sizeof(TYPES[0]); ++t)
+					control(SOURCES[s], TYPES[t], GL_DONT_CARE, 1, &rule.id, rule.enabled);
+			}
+		}
+	}
+
+	/**
+	 * \brief Log level of a message severity
+	 */
+	Log::Level getLevel(GLenum severity)
+	{
+		switch (severity)
+		{
+		case GL_DEBUG_SEVERITY_HIGH: return Log::LEVEL_ERROR;
+		case GL_DEBUG_SEVERITY_MEDIUM: return Log::LEVEL_WARNING;
+		case GL_DEBUG_SEVERITY_LOW: return Log::LEVEL_INFO;
+		default: return Log::LEVEL_DEBUG;
+		}
+	}
+
+	/**
+	 * \brief Count a message and log it unless its ID is over the rate limit
+	 *
+	 * May be called from several driver threads at once. Neither locks nor allocates.
+	 */
+	void receive(GLenum source, GLenum type, GLuint id, GLenum severity, GLsizei length, const GLchar *message)
+	{
+		Uint32 now = SDL_GetTicks();
+		unsigned int repeats = 0;
+
+		Counter *counter = findCounter(source, type, id, severity, length, message, now);
+		if (counter)
+		{
+			counter->total.fetch_add(1, std::memory_order_relaxed);
+
+			Uint32 start = counter->windowStart.load(std::memory_order_relaxed);
+			if (now - start >= 1000 && counter->windowStart.compare_exchange_strong(start, now, std::memory_order_relaxed))
+				counter->windowCount.store(0, std::memory_order_relaxed);
+
+			if (rateLimit > 0 && counter->windowCount.fetch_add(1, std::memory_order_relaxed) >= rateLimit)
+			{
+				counter->suppressed.fetch_add(1, std::memory_order_relaxed);
+				counter->pending.fetch_add(1, std::memory_order_relaxed);
+				return;
+			}
+			repeats = counter->pending.exchange(0, std::memory_order_relaxed);
+		} else
+			untracked.fetch_add(1, std::memory_order_relaxed);
+
+		Log::Level level = getLevel(severity);
+		if (level < CG_LOG_MIN_LEVEL || !Log::isEnabled(level, Log::GL))
+			return;
+
+		Log::Record record(level, Log::GL);
+		record << getSourceName(source) << " " << getTypeName(type) << " (" << getSeverityName(severity) << "): " << id << " ";
+		char text[MAX_TEXT];
+		copyText(text, length, message);
+		record << text;
+		if (repeats > 0)
+			record << " (" << repeats << " repeats suppressed)";
+		Log::push(record);
+	}
+
 	// Callback function to be called with various messages
 	// Should match both GLDEBUGPROCARB and GLDEBUGPROC definitions
 
@@ -27,80 +309,57 @@ namespace
 		const GLchar *message,
 		T userParam) // void *userParam for older GLEW versions (At least 1.10.0). const void *userParam for new GLEW version (At least 1.13.0).
 	{
-		std::string sourcestr;
-		switch (source)
-		{
-		case GL_DEBUG_SOURCE_API:
-			sourcestr = "API";
-			break;
-		case GL_DEBUG_SOURCE_WINDOW_SYSTEM:
-			sourcestr = "Window system";
-			break;
-		case GL_DEBUG_SOURCE_THIRD_PARTY:
-			sourcestr = "3rd party";
-			break;
-		case GL_DEBUG_SOURCE_APPLICATION:
-			sourcestr = "Application";
-			break;
-		default:
-			sourcestr = "Other";
-			break;
-		}
+		receive(source, type, id, severity, length, message);
+	}
+}
 
-		std::string typestr;
-		switch (type)
+/**
+ * \brief Add comma separated filter rules, e.g. "-performance,+131185"
+ *
+ * Each rule starts with + to enable or - to disable messages and names a severity (high, medium, low, notification),
+ * a type (error, deprecated, undefined, portability, performance, marker, group, other) or a message ID.
+ * Later rules override earlier ones. Notifications and debug group messages are disabled by default.
+ * Call before installDebugMessageCallback().
+ * \return false if a rule is malformed
+ */
+bool addDebugMessageFilter(const std::string &text)
+{
+	std::istringstream is(text);
+	std::string item;
+	while (std::getline(is, item, ','))
+	{
+		FilterRule rule;
+		if (!parseRule(item, rule))
 		{
-		case GL_DEBUG_TYPE_ERROR:
-			typestr = "Error";
-			break;
-		case GL_DEBUG_TYPE_DEPRECATED_BEHAVIOR:
-			typestr = "Deprecated behavior";
-			break;
-		case GL_DEBUG_TYPE_UNDEFINED_BEHAVIOR:
-			typestr = "Undefined behavior";
-			break;
-		case GL_DEBUG_TYPE_PORTABILITY:
-			typestr = "Portability";
-			break;
-		case GL_DEBUG_TYPE_PERFORMANCE:
-			typestr = "Performance";
-			break;
-		case GL_DEBUG_TYPE_MARKER:
-			typestr = "Marker";
-			break;
-		case GL_DEBUG_TYPE_PUSH_GROUP:
-			typestr = "Push group";
-			break;
-		case GL_DEBUG_TYPE_POP_GROUP:
-			typestr = "Pop group";
-			break;
-		default:
-			typestr = "Other";
-			break;
+			std::cerr << "addDebugMessageFilter(): Malformed rule '" << item << "'" << std::endl;
+			return false;
 		}
 
-		std::string severitystr;
-		switch (severity)
+		rules.push_back(rule);
+		if (rule.type == GL_DEBUG_TYPE_PUSH_GROUP)
 		{
-		case GL_DEBUG_SEVERITY_HIGH:
-			severitystr = "HIGH!";
-			break;
-		case GL_DEBUG_SEVERITY_MEDIUM:
-			severitystr = "Medium";
-			break;
-		case GL_DEBUG_SEVERITY_LOW:
-			severitystr = "Low";
-			break;
-		case GL_DEBUG_SEVERITY_NOTIFICATION:
-			severitystr = "Note";
-			break;
-		default:
-			severitystr = "Unknown";
-			break;
+			rule.type = GL_DEBUG_TYPE_POP_GROUP;
+			rules.push_back(rule);
 		}
-
-		std::cout << "GL_Debug: " << sourcestr << " " << typestr << " (" << severitystr << "): " << id << " " << message << std::endl;
 	}
+	return true;
+}
+
+/**
+ * \brief Print at most messagesPerSecond messages with the same ID, others are only counted. 0 prints everything. Default is 5.
+ */
+void setDebugMessageRateLimit(unsigned int messagesPerSecond)
+{
+	rateLimit = messagesPerSecond;
+}
+
+/**
+ * \brief Ask for GL_DEBUG_OUTPUT_SYNCHRONOUS, so that messages arrive inside the call causing them. Off by default
+ * as it makes the driver validate on the render thread. Call before installDebugMessageCallback().
+ */
+void setDebugMessageSynchronous(bool enable)
+{
+	synchronous = enable;
 }
 
 /**
@@ -120,31 +379,101 @@ bool installDebugMessageCallback()
 		return false;
 	}
 
-	// Make sure that debug output is synchronous. This has some performance penalty but makes sure that
-	// debug message callback function is not called asynchronously from other threads.
-	glEnable(GL_DEBUG_OUTPUT_SYNCHRONOUS);
-	if (glGetError() != GL_NO_ERROR)
-		std::cout << "GL_DEBUG_OUTPUT_SYNCHRONOUS not supported." << std::endl;
+	// Synchronous output makes the driver validate on the render thread and call the callback before the offending
+	// call returns, which helps in a debugger but costs time. Asynchronous output may call the callback from driver
+	// threads, which receive() handles.
+	if (synchronous)
+	{
+		glEnable(GL_DEBUG_OUTPUT_SYNCHRONOUS);
+		if (glGetError() != GL_NO_ERROR)
+		{
+			std::cout << "GL_DEBUG_OUTPUT_SYNCHRONOUS not supported." << std::endl;
+			synchronous = false;
+		}
+	} else
+		glDisable(GL_DEBUG_OUTPUT_SYNCHRONOUS);
+
+	// Default rules go first so that rules from addDebugMessageFilter() can enable the messages again.
+	// Profiler labels every measured scope with a debug group, don't print those.
+	std::vector<FilterRule> userRules;
+	userRules.swap(rules);
+	addDebugMessageFilter("-notification,-group");
+	rules.insert(rules.end(), userRules.begin(), userRules.end());
 
 	// Initialize debugging
 	if (GLEW_KHR_debug)
 	{
 		// We could also check for GLEW_KHR_debug instead of function entry point directly
 		std::cout << "GL_KHR_debug defined (OpenGL 4.3 feature)." << std::endl;
+		applyRules(glDebugMessageControl);
 		glDebugMessageCallback(&debugCallback, 0);
-		return true;
 	} else
 	if (GLEW_ARB_debug_output)
 	{
 		// We could also check for GLEW_ARB_debug_output instead of function entry points directly
 		std::cout << "ARB_debug_output defined." << std::endl;
+		applyRules(glDebugMessageControlARB);
 		glDebugMessageCallbackARB(&debugCallback, 0);
-		return true;
+	} else
+	{
+		std::cout << "No supported debug interfaces defined by OpenGL implementation." << std::endl; // Must use glGetError() to fetch information about invalid calls
+		return false;
 	}
 
-	std::cout << "No supported debug interfaces defined by OpenGL implementation." << std::endl; // Must use glGetError() to fetch information about invalid calls
+	installed = true;
+	return true;
+}
+
+/**
+ * \brief Remove the callback, print remaining messages and how many times each message was received
+ *
+ * Call while the OpenGL context is still current.
+ */
+void releaseDebugMessageCallback()
+{
+	if (!installed)
+		return;
+	installed = false;
+
+	// Asynchronous messages of commands already issued arrive before the callback is removed
+	glFinish();
+	if (GLEW_KHR_debug)
+		glDebugMessageCallback(0, 0);
+	else
+		glDebugMessageCallbackARB(0, 0);
+
+	std::vector<Counter *> sorted;
+	for (unsigned int i = 0; i < MAX_COUNTERS; ++i)
+	{
+		if (counters[i].key.load() != 0)
+			sorted.push_back(&counters[i]);
+	}
+	std::sort(sorted.begin(), sorted.end(), [](const Counter *a, const Counter *b) { return a->total.load() > b->total.load(); });
+
+	if (!sorted.empty())
+		LOG_INFO(GL, "Message counts");
+	for (size_t i = 0; i < sorted.size(); ++i)
+	{
+		Counter &counter = *sorted[i];
+		if (Log::isEnabled(Log::LEVEL_INFO, Log::GL))
+		{
+			Log::Record record(Log::LEVEL_INFO, Log::GL);
+			record << "  " << counter.total.load() << " x " << getSourceName(counter.source) << " " << getTypeName(counter.type) << " ("
+			       << getSeverityName(counter.severity) << "): " << counter.id << " " << counter.text;
+			if (counter.suppressed.load() > 0)
+				record << " (" << counter.suppressed.load() << " suppressed)";
+			Log::push(record);
+		}
+
+		// Counters are reset even if not logged, a later installDebugMessageCallback() starts from zero
+		counter.total.store(0);
+		counter.suppressed.store(0);
+		counter.pending.store(0);
+		counter.windowCount.store(0);
+		counter.key.store(0);
+	}
 
-	// You can filter messages using
-	// void glDebugMessageControl​(GLenum source​, GLenum type​, GLenum severity​, GLsizei count​, const GLuint *ids​, GLboolean enabled​);
-	return false;
+	unsigned int lost = untracked.exchange(0);
+	if (lost > 0)
+		LOG_INFO(GL, "  " << lost << " x messages with IDs beyond the first " << MAX_COUNTERS);
 }
@@ -3,11 +3,24 @@
  *
  * This functionality is available as standard starting from OpenGL 4.3 but may be available as an extension in older OpenGL contexts as well if
  * hardware and drivers can support that.
+ *
+ * Drivers can send thousands of messages per frame, so the callback only formats the message into a Log record in the
+ * gl category, which the log writer thread prints. Severity selects the level: high is an error, medium a warning, low
+ * info and notifications debug, so e.g. --log-level gl=warning hides the rest. Output is asynchronous unless
+ * setDebugMessageSynchronous() is used, so the callback may run on driver threads. Messages are filtered by the driver
+ * with glDebugMessageControl() according to the rules given to addDebugMessageFilter(), and repeats of the same
+ * message are rate limited and counted. releaseDebugMessageCallback() logs how many times each message was received.
  * \file
  */
 #ifndef DEBUGMESSAGECALLBACK_H_
 #define DEBUGMESSAGECALLBACK_H_
 
+#include <string>
+
+bool addDebugMessageFilter(const std::string &rules);
+void setDebugMessageRateLimit(unsigned int messagesPerSecond);
+void setDebugMessageSynchronous(bool enable);
 bool installDebugMessageCallback();
+void releaseDebugMessageCallback();
 
-#endif
\ No newline at end of file
+#endif
@@ -0,0 +1,72 @@
+/**
+ * \brief Embedded shader table lookup
+ * \file
+ */
+#include <cstring>
+#include "embeddedshaders.h"
+
+namespace
+{
+#ifdef CG_EMBEDDED_SHADERS
+	// Defines EMBEDDED_SHADERS sorted by name and EMBEDDED_SHADER_COUNT
+	#include "embeddedshaders.inc"
+#else
+	constexpr EmbeddedShader EMBEDDED_SHADERS[] = { { "", "", 0, 0 } };
+	constexpr size_t EMBEDDED_SHADER_COUNT = 0;
+#endif
+}
+
+bool EmbeddedShaders::diskOverride = false;
+
+/**
+ * \brief Find an embedded file
+ * \param name Path relative to cg-sources as given to ShaderProgram::load(), e.g. "data/land.fs"
+ * \return 0 if the file is not embedded or the disk override is on
+ */
+const EmbeddedShader *EmbeddedShaders::find(const std::string &name)
+{
+	if (diskOverride)
+		return 0;
+
+	// Accept Windows separators and a leading "./"
+	std::string key = name;
+	for (size_t i = 0; i < key.size(); ++i)
+	{
+		if (key[i] == '\\')
+			key[i] = '/';
+	}
+	if (key.compare(0, 2, "./") == 0)
+		key.erase(0, 2);
+
+	// Binary search, the generator sorts the table
+	size_t first = 0;
+	size_t last = EMBEDDED_SHADER_COUNT;
+	while (first < last)
+	{
+		size_t middle = (first + last) / 2;
+		int order = std::strcmp(EMBEDDED_SHADERS[middle].name, key.c_str());
+		if (order == 0)
+			return &EMBEDDED_SHADERS[middle];
+		if (order < 0)
+			first = middle + 1;
+		else
+			last = middle;
+	}
+	return 0;
+}
+
+/**
+ * \brief Number of embedded files, 0 if the build has no generated table
+ */
+size_t EmbeddedShaders::getCount()
+{
+	return EMBEDDED_SHADER_COUNT;
+}
+
+/**
+ * \brief Read shaders from disk instead of the embedded table, e.g. while editing them
+ */
+void EmbeddedShaders::setDiskOverride(bool enable)
+{
+	diskOverride = enable;
+}
@@ -0,0 +1,50 @@
+/**
+ * \brief GLSL sources compiled into the executable
+ * \file
+ */
+#ifndef EMBEDDEDSHADERS_H_
+#define EMBEDDEDSHADERS_H_
+
+#include <cstddef>
+#include <string>
+
+/**
+ * \brief One shader file embedded by tools/embedshaders.cpp
+ */
+struct EmbeddedShader
+{
+	const char *name;        ///< Path relative to cg-sources, e.g. "data/land.fs"
+	const char *source;
+	size_t length;           ///< Bytes in source without the terminating zero
+	unsigned long long hash; ///< 64-bit FNV-1a hash of source
+};
+
+/**
+ * \brief Table of shader files embedded at build time
+ *
+ * The Makefile runs tools/embedshaders.cpp on every .vs, .fs and .glsl file in data/ and compiles the result into
+ * embeddedshaders.cpp with CG_EMBEDDED_SHADERS defined. ShaderProgram looks files up here before opening them, so
+ * shaders cost no file I/O and the program finds them whatever the working directory is. Builds without the
+ * generated table, such as ones from IDE projects, read every shader from disk.
+ *
+ * Run with --shaders-from-disk or call setDiskOverride() to edit shaders without rebuilding.
+ */
+class EmbeddedShaders
+{
+	static bool diskOverride;
+public:
+	static const EmbeddedShader *find(const std::string &name);
+	static size_t getCount();
+
+	static void setDiskOverride(bool enable);
+
+	/**
+	 * \brief True if find() ignores the embedded table
+	 */
+	static bool isDiskOverride()
+	{
+		return diskOverride;
+	}
+};
+
+#endif
@@ -5,6 +5,10 @@
 #include <cassert>
 #include <iostream>
 #include "examplescene1.h"
+#include "sceneregistry.h"
+#include "glvalidation.h"
+
+static SceneRegistry::Registration<ExampleScene1> registration("example1", "A tetrahedron with vertex colors");
 
 void ExampleScene1::createTetrahedron()
 {
@@ -60,6 +64,7 @@ ExampleScene1::~ExampleScene1()
 	glDisableVertexAttribArray(shaderProgram.getColorAttribLocation());
 	glDeleteBuffers(1, &vbo); // Allocated vertex data
 	glDeleteVertexArrays(1, &vao); // Allocated object data
+	delete frameUniforms;
 }
 
 bool ExampleScene1::init()
@@ -67,6 +72,10 @@ bool ExampleScene1::init()
 	// Load shader program used in this example
 	if (!shaderProgram.load("data/examplescene1.vs", "data/examplescene1.fs"))
 		return false;
+	modelMatrixUniform = shaderProgram.getUniform("modelMatrix");
+
+	// View and projection are given to the shaders through a uniform buffer
+	frameUniforms = new UniformBuffer(UniformBuffer::FRAME_BINDING, sizeof(FrameUniforms));
 
 	// Create object geometry
 	createTetrahedron();
@@ -122,6 +131,8 @@ bool ExampleScene1::init()
 
 	// Reset object rotation
 	rotation = 0;
+	previousRotation = 0;
+	renderRotation = 0;
 
 	return true;
 }
@@ -142,9 +153,15 @@ void ExampleScene1::resize(GLsizei width, GLsizei height)
 void ExampleScene1::update(float timestep)
 {
 	// Rotate object (one rotation / 10 seconds)
+	previousRotation = rotation;
 	rotation += glm::two_pi<float>() * 0.1f * timestep;
 }
 
+void ExampleScene1::interpolate(float alpha)
+{
+	renderRotation = glm::mix(previousRotation, rotation, alpha);
+}
+
 // Render view
 void ExampleScene1::render()
 {
@@ -154,16 +171,20 @@ void ExampleScene1::render()
 	// Calculate model transformation
 	modelMat = glm::mat4(1.0f);
 	modelMat = glm::translate(modelMat, glm::vec3(1.0, 0.0, 0.0)); // Translate object +1 on x-axis after rotation
-	modelMat = glm::rotate(modelMat, rotation, glm::vec3(0.0, 1.0, 0.0)); // Rotate object around y-axis
+	modelMat = glm::rotate(modelMat, renderRotation, glm::vec3(0.0, 1.0, 0.0)); // Rotate object around y-axis
 	modelMat = glm::scale(modelMat, glm::vec3(0.5f, 0.5f, 0.5f));
 
-	// Precalculate transformation matrix for the shader and use it
-	mvpMat = projectionMat * viewMat * modelMat;
-	glUniformMatrix4fv(glGetUniformLocation(shaderProgram.getShaderProgram(), "mvpmatrix"), 1, GL_FALSE, glm::value_ptr(mvpMat));
+	// Camera matrices for every program, then the transformation of this object
+	FrameUniforms frame = FrameUniforms();
+	frame.view = viewMat;
+	frame.projection = projectionMat;
+	frameUniforms->update(&frame);
+	shaderProgram.setUniform(modelMatrixUniform, modelMat);
 
 	// Draw individual triangles when we have correct VBO in use
 	// We are not using tetrahedron vector data here at all. We need to just know the number of vertices to draw!
 	glDrawArrays(GL_TRIANGLES, 0, static_cast<GLsizei>(tetrahedron.size())); 
+	CHECK_GL_DRAW();
 }
 
 bool ExampleScene1::handleEvent(const SDL_Event &e)
@@ -12,6 +12,7 @@
 #include <glm/gtc/type_ptr.hpp>         // Needed for glm::value_ptr(x). You can use &x[0] instead of that.
 #include "scene.h"                      // Abstract scene class
 #include "shaderprogram.h"              // For shader management
+#include "uniformbuffer.h"              // For the FrameData uniform block
 
 /**
  * \brief Draws a vertex-colored tetrahedron
@@ -35,7 +36,8 @@ class ExampleScene1 : public Scene
 	};
 
 	ShaderProgram shaderProgram;
-	glm::mat4 mvpMat;
+	int modelMatrixUniform; // Handle of the modelMatrix uniform in shaderProgram
+	UniformBuffer *frameUniforms = 0; // FrameData written once per frame
 
 	glm::mat4 projectionMat;
 	glm::mat4 viewMat;
@@ -45,6 +47,8 @@ class ExampleScene1 : public Scene
 	GLuint vao, vbo;
 
 	float rotation; // Current rotation position
+	float previousRotation; // Rotation before the latest update()
+	float renderRotation; // Rotation interpolated for render()
 	std::vector<Vertex> tetrahedron; // Source data for our model
 
 	void createTetrahedron();
@@ -61,6 +65,9 @@ public:
 	// Update scene
 	virtual void update(float timestep);
 
+	// Blend the rotation of the two latest updates
+	virtual void interpolate(float alpha);
+
 	// Render view
 	virtual void render();
 
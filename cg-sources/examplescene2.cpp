@@ -3,7 +3,16 @@
 * \file
 */
 #include <cassert>
+#include <cmath>
+#include <algorithm>
 #include "examplescene2.h"
+#include "proceduraltexture.h"
+#include "sceneregistry.h"
+#include "profiler.h"
+#include "glvalidation.h"
+#include "log.h"
+
+static SceneRegistry::Registration<ExampleScene2> registration("example2", "A texturemapped cube");
 
 /**
  * \brief Create cube with texture coordinates and face indices.
@@ -140,6 +149,7 @@ ExampleScene2::~ExampleScene2()
 	glDeleteBuffers(1, &ibo); // Allocated index data
 	glDeleteBuffers(1, &vbo); // Allocated vertex data
 	glDeleteVertexArrays(1, &vao); // Allocated object data
+	delete frameUniforms;
 
 	if (cubeTexture)
 		delete cubeTexture;
@@ -150,6 +160,10 @@ bool ExampleScene2::init()
 	// Load shader program used in this example
 	if (!shaderProgram.load("data/examplescene2.vs", "data/examplescene2.fs"))
 		return false;
+	modelMatrixUniform = shaderProgram.getUniform("modelMatrix");
+
+	// View and projection are given to the shaders through a uniform buffer
+	frameUniforms = new UniformBuffer(UniformBuffer::FRAME_BINDING, sizeof(FrameUniforms));
 
 	// Create cube geometry
 	createCube();
@@ -162,10 +176,23 @@ bool ExampleScene2::init()
 		cubeTexture->setPixel(x, 150, 0, 255, 0, 0);
 	cubeTexture->updateGLTexture();
 	*/
+	/*
+	// Generated wood texture instead. Setting many pixels is much faster with ProceduralTexture than with setPixel().
+	delete cubeTexture;
+	cubeTexture = new Texture(1024, 1024);
+	ProceduralTexture::generate(*cubeTexture,
+		ProceduralTexture::sine(ProceduralTexture::warp(ProceduralTexture::radialGradient(glm::vec2(0.5f), 0.05f),
+			ProceduralTexture::fbm(4, 4.0f), ProceduralTexture::perlin(8.0f, true, glm::vec2(3.7f, 1.3f)), 0.1f)),
+		glm::vec4(0.45f, 0.25f, 0.1f, 1.0f), glm::vec4(0.75f, 0.5f, 0.25f, 1.0f));
+	*/
 	// Something failed?
 	if (cubeTexture->getTextureId() == 0)
 		return false;
-	std::cout << "Loaded cube texture as texture " << cubeTexture->getTextureId() << std::endl;
+	LOG_INFO(SCENE, "Loaded cube texture as texture " << cubeTexture->getTextureId());
+
+	// A scan line is drawn over the texture every frame so upload it through pixel buffer objects
+	cubeTexture->setStreaming(true);
+	scanRow = -1;
 
 	// Use shader program to render everything
 	glUseProgram(shaderProgram.getShaderProgram());
@@ -178,7 +205,7 @@ bool ExampleScene2::init()
 		std::cerr << "Unable to locate uniform variable texture0 from the shader" << std::endl;
 		return false;
 	}
-	std::cout << "texture0 uniform id: " << uniform_cubeShader_texture << std::endl;
+	LOG_INFO(SCENE, "texture0 uniform id: " << uniform_cubeShader_texture);
 
 	// Welect what texture unit is used for
 	usedTextureUnit = 0;
@@ -244,6 +271,8 @@ bool ExampleScene2::init()
 
 	// Reset object rotation
 	rotation = 0;
+	previousRotation = 0;
+	renderRotation = 0;
 
 	// Our generated VAO is now ready and enabled for use
 	// We could disable by calling glBindVertexArray(0) if we want to work with multiple objects and not use created VAO at the moment.
@@ -268,9 +297,15 @@ void ExampleScene2::resize(GLsizei width, GLsizei height)
 void ExampleScene2::update(float timestep)
 {
 	// Rotate object
+	previousRotation = rotation;
 	rotation += glm::two_pi<float>() * 0.1f * timestep;
 }
 
+void ExampleScene2::interpolate(float alpha)
+{
+	renderRotation = glm::mix(previousRotation, rotation, alpha);
+}
+
 // Render view
 void ExampleScene2::render()
 {
@@ -278,20 +313,27 @@ void ExampleScene2::render()
 	glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
 	// Calculate model transformation
-	modelMat = glm::rotate(glm::mat4(), rotation, glm::vec3(0.0, 1.0, 0.0)); // Rotate object around y-axis
+	modelMat = glm::rotate(glm::mat4(), renderRotation, glm::vec3(0.0, 1.0, 0.0)); // Rotate object around y-axis
 
 	// Select correct shader program for this object (we never selected anything else to replace that state after init())
 	glUseProgram(shaderProgram.getShaderProgram());
 
-	// Precalculate transformation matrix for the shader and use it
-	mvpMat = projectionMat * viewMat * modelMat;
-	glUniformMatrix4fv(glGetUniformLocation(shaderProgram.getShaderProgram(), "mvpmatrix"), 1, GL_FALSE, glm::value_ptr(mvpMat));
+	// Camera matrices for every program, then the transformation of this object
+	FrameUniforms frame = FrameUniforms();
+	frame.view = viewMat;
+	frame.projection = projectionMat;
+	frameUniforms->update(&frame);
+	shaderProgram.setUniform(modelMatrixUniform, modelMat);
+
+	// Move the scan line before the texture is bound for drawing
+	updateScanLine();
 
 	// Turn on texture mapping on texture unit 0 and select our texture
 	// It is redundant to set the same values all the time but texture settings are included here for clarity
 	// glUniform1i(uniform_cubeShader_texture, usedTextureUnit); <- In init code
-	glActiveTexture(GL_TEXTURE0 + usedTextureUnit); // Other textures are GL_TEXTURE0 + i (where i is the texture unit index up to GL_MAX_COMBINED_TEXTURE_IMAGE_UNITS - 1)
-	glBindTexture(GL_TEXTURE_2D, cubeTexture->getTextureId());
+	// Texture::bind() does glActiveTexture(GL_TEXTURE0 + usedTextureUnit) and glBindTexture(GL_TEXTURE_2D, ...)
+	// Other textures are GL_TEXTURE0 + i (where i is the texture unit index up to GL_MAX_COMBINED_TEXTURE_IMAGE_UNITS - 1)
+	cubeTexture->bind(usedTextureUnit);
 
 	// For drawing the cube it needs to be bound using (we never bound anything else to replace that state after init())
 	glBindVertexArray(vao);
@@ -300,6 +342,40 @@ void ExampleScene2::render()
 	// When VBOs are in use and GL_ELEMENT_ARRAY_BUFFER is bound, the last parameter (pointer to data) is interpreted as an offset within IBO instead of
 	// actual program memory address.
 	glDrawElements(GL_TRIANGLES, static_cast<GLsizei>(cubeIndices.size()), GL_UNSIGNED_SHORT, 0);
+	CHECK_GL_DRAW();
+}
+
+/**
+ * \brief Draw a line across the cube texture at a height that follows the rotation
+ *
+ * The texels under the previous line are restored first, so the whole texture is uploaded again every frame.
+ */
+void ExampleScene2::updateScanLine()
+{
+	PROFILE_GPU_SCOPE("scanline");
+
+	int pitch = 0;
+	Uint32 *pixels = cubeTexture->lockPixels(pitch);
+	if (!pixels)
+		return;
+
+	int width = static_cast<int>(cubeTexture->getWidth());
+	int height = static_cast<int>(cubeTexture->getHeight());
+	int rowLength = pitch / 4;
+
+	if (scanRow >= 0)
+		std::copy(scanRowPixels.begin(), scanRowPixels.end(), pixels + scanRow * rowLength);
+
+	// One sweep from bottom to top per revolution
+	float turns = renderRotation / glm::two_pi<float>();
+	scanRow = std::min(static_cast<int>((turns - std::floor(turns)) * height), height - 1);
+
+	Uint32 *row = pixels + scanRow * rowLength;
+	scanRowPixels.assign(row, row + width);
+	std::fill(row, row + width, 0x00ff00ffu); // Opaque green, red is the most significant byte
+
+	cubeTexture->unlockPixels();
+	cubeTexture->updateGLTexture();
 }
 
 bool ExampleScene2::handleEvent(const SDL_Event &e)
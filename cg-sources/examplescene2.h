@@ -12,6 +12,7 @@
 #include <glm/gtc/type_ptr.hpp>         // Needed for glm::value_ptr(x). You can use &x[0] instead of that.
 #include "scene.h"                      // Abstract scene class
 #include "shaderprogram.h"              // For shader management
+#include "uniformbuffer.h"              // For the FrameData uniform block
 #include "texture.h"
 
 /**
@@ -35,7 +36,8 @@ class ExampleScene2 : public Scene
 	};
 
 	ShaderProgram shaderProgram;
-	glm::mat4 mvpMat;
+	int modelMatrixUniform; // Handle of the modelMatrix uniform in shaderProgram
+	UniformBuffer *frameUniforms = 0; // FrameData written once per frame
 
 	glm::mat4 projectionMat;
 	glm::mat4 viewMat;
@@ -45,12 +47,17 @@ class ExampleScene2 : public Scene
 	GLuint vao, vbo, ibo;
 
 	float rotation; // Current rotation position
+	float previousRotation; // Rotation before the latest update()
+	float renderRotation; // Rotation interpolated for render()
 	std::vector<Vertex> cube; // Source data for our model
 	std::vector<GLushort> cubeIndices; // Index values for cube
 	Texture *cubeTexture;
 	GLuint usedTextureUnit;
+	int scanRow; // Texture row covered by the scan line or -1 before the first frame
+	std::vector<Uint32> scanRowPixels; // Original texels under the scan line
 
 	void createCube();
+	void updateScanLine();
 public:
 	ExampleScene2();
 	virtual ~ExampleScene2();
@@ -64,6 +71,9 @@ public:
 	// Update scene
 	virtual void update(float timestep);
 
+	// Blend the rotation of the two latest updates
+	virtual void interpolate(float alpha);
+
 	// Render view
 	virtual void render();
 
@@ -5,6 +5,11 @@
 #include <cassert>
 #include <iostream>
 #include "examplescene3.h"
+#include "sceneregistry.h"
+#include "glvalidation.h"
+#include "log.h"
+
+static SceneRegistry::Registration<ExampleScene3> registration("example3", "A shaded sphere (shading calculated to vertex colors)", "tessellation=4");
 
 void ExampleScene3::createIcosahedron(std::vector<Vertex> &icosahedron, std::vector<GLushort> &icosahedronIndices) const
 {
@@ -60,7 +65,7 @@ void ExampleScene3::createSphere(std::vector<Vertex> &sphere, std::vector<GLusho
 		// Get number of triangles at previous tesselation level
 		size_t origTriangles = sphereIndices.size() / 3;
 
-		std::cout << "Tesselation " << tesselation + 1 << " with " << origTriangles << " triangles" << std::endl;
+		LOG_INFO(SCENE, "Tesselation " << tesselation + 1 << " with " << origTriangles << " triangles");
 
 		// Split each existing triangle v0, v1, v2 into four parts using a new vertices v3, v4 and v5
 		//        *v2         //
@@ -125,7 +130,7 @@ void ExampleScene3::createSphere(std::vector<Vertex> &sphere, std::vector<GLusho
 	}
 
 	// Note that some (half) of new vertices are duplicates after tesselation as edges are shared with another triangle!
-	std::cout << "Created sphere with " << sphere.size() << " vertices and " << sphereIndices.size() / 3 << " faces" << std::endl;
+	LOG_INFO(SCENE, "Created sphere with " << sphere.size() << " vertices and " << sphereIndices.size() / 3 << " faces");
 
 	// Verify that we don't have too many vertices (over 65535)
 	assert(sphere.size() <= (GLushort)-1);
@@ -194,7 +199,8 @@ void ExampleScene3::updateShading(std::vector<Vertex> &mesh, const glm::mat4 &mo
 	}
 }
 
-ExampleScene3::ExampleScene3()
+ExampleScene3::ExampleScene3(const SceneParameters &parameters) :
+	tessellation(glm::clamp(parameters.getInt("tessellation", 4), 0, static_cast<int>(MAX_TESSELLATION)))
 {
 	// These OpenGL functions must be defined by the OpenGL (or through GLEW) for this example to work..
 	assert(glBindBuffer != 0);
@@ -226,20 +232,26 @@ ExampleScene3::~ExampleScene3()
 	glDeleteBuffers(1, &ibo); // Allocated index data
 	glDeleteBuffers(1, &vbo); // Allocated vertex data
 	glDeleteVertexArrays(1, &vao); // Allocated object data
+	delete frameUniforms;
 }
 
 bool ExampleScene3::init()
 {
 	// Reset object rotation
 	rotation = 0;
+	previousRotation = 0;
+	renderRotation = 0;
 
 	// Load shader program used in this example
 	if (!shaderProgram.load("data/examplescene3.vs", "data/examplescene3.fs"))
 		return false;
+	modelMatrixUniform = shaderProgram.getUniform("modelMatrix");
+
+	// View and projection are given to the shaders through a uniform buffer
+	frameUniforms = new UniformBuffer(UniformBuffer::FRAME_BINDING, sizeof(FrameUniforms));
 
 	// Create object geometry
-	int numTesselations = 4;
-	createSphere(sphere, sphereIndices, numTesselations);
+	createSphere(sphere, sphereIndices, tessellation);
 
 	// Calculate model transformation
 	modelMat = glm::rotate(glm::mat4(), rotation, glm::vec3(0.0, 1.0, 0.0)); // Rotate object around y-axis
@@ -328,9 +340,15 @@ void ExampleScene3::resize(GLsizei width, GLsizei height)
 void ExampleScene3::update(float timestep)
 {
 	// Rotate object
+	previousRotation = rotation;
 	rotation += glm::two_pi<float>() * 0.1f * timestep;
 }
 
+void ExampleScene3::interpolate(float alpha)
+{
+	renderRotation = glm::mix(previousRotation, rotation, alpha);
+}
+
 // Render view
 void ExampleScene3::render()
 {
@@ -338,20 +356,24 @@ void ExampleScene3::render()
 	glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
 	// Calculate model transformation
-	modelMat = glm::rotate(glm::mat4(), rotation, glm::vec3(0.0, 1.0, 0.0)); // Rotate object around y-axis
+	modelMat = glm::rotate(glm::mat4(), renderRotation, glm::vec3(0.0, 1.0, 0.0)); // Rotate object around y-axis
 
 	// Update our model's shading with new orientation with the camera
 	glm::vec4 lightPos(2.0f, 2.0f, 1.0f, 1.0f);
 	updateShading(sphere, modelMat, lightPos);
 
-	// Precalculate transformation matrix for the shader and use it
-	mvpMat = projectionMat * viewMat * modelMat;
-	glUniformMatrix4fv(glGetUniformLocation(shaderProgram.getShaderProgram(), "mvpmatrix"), 1, GL_FALSE, glm::value_ptr(mvpMat));
+	// Camera matrices for every program, then the transformation of this object
+	FrameUniforms frame = FrameUniforms();
+	frame.view = viewMat;
+	frame.projection = projectionMat;
+	frameUniforms->update(&frame);
+	shaderProgram.setUniform(modelMatrixUniform, modelMat);
 
 	// Count is the number of elements in the array that will form triangles. It is not the number of triangles defined by the array.
 	// When VBOs are in use and GL_ELEMENT_ARRAY_BUFFER is bound, the last parameter (pointer to data) is interpreted as an offset within IBO instead of
 	// actual program memory address.
 	glDrawElements(GL_TRIANGLES, static_cast<GLsizei>(sphereIndices.size()), GL_UNSIGNED_SHORT, 0);
+	CHECK_GL_DRAW();
 }
 
 bool ExampleScene3::handleEvent(const SDL_Event &e)
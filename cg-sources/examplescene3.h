@@ -12,6 +12,8 @@
 #include <glm/gtc/type_ptr.hpp>         // Needed for glm::value_ptr(x). You can use &x[0] instead of that.
 #include "scene.h"                      // Abstract scene class
 #include "shaderprogram.h"              // For shader management
+#include "uniformbuffer.h"              // For the FrameData uniform block
+#include "sceneregistry.h"              // For scene parameters
 
 /**
  * \brief Draws a vertex-colored tetrahedron
@@ -35,7 +37,8 @@ class ExampleScene3 : public Scene
 	};
 
 	ShaderProgram shaderProgram;
-	glm::mat4 mvpMat;
+	int modelMatrixUniform; // Handle of the modelMatrix uniform in shaderProgram
+	UniformBuffer *frameUniforms = 0; // FrameData written once per frame
 
 	glm::mat4 projectionMat;
 	glm::mat4 viewMat;
@@ -45,8 +48,12 @@ class ExampleScene3 : public Scene
 	GLuint vao, vbo, ibo;
 
 	float rotation; // Current rotation position
+	float previousRotation; // Rotation before the latest update()
+	float renderRotation; // Rotation interpolated for render()
 	std::vector<Vertex> sphere;
 	std::vector<GLushort> sphereIndices;
+	static const int MAX_TESSELLATION = 5; // More vertices than GLushort indices can address
+	int tessellation; // Subdivisions of the icosahedron, parameter "tessellation"
 
 	void createIcosahedron(std::vector<Vertex> &tetrahedron, std::vector<GLushort> &tetrahedronIndices) const;
 	void createSphere(std::vector<Vertex> &sphere, std::vector<GLushort> &sphereIndices, int numTesselations) const;
@@ -54,7 +61,7 @@ class ExampleScene3 : public Scene
 	void updateShading(std::vector<Vertex> &mesh, const glm::mat4 &modelMat, const glm::vec4 lightPos) const;
 
 public:
-	ExampleScene3();
+	explicit ExampleScene3(const SceneParameters &parameters = SceneParameters());
 	virtual ~ExampleScene3();
 
 	// Initialize scene
@@ -66,6 +73,9 @@ public:
 	// Update scene
 	virtual void update(float timestep);
 
+	// Blend the rotation of the two latest updates
+	virtual void interpolate(float alpha);
+
 	// Render view
 	virtual void render();
 
@@ -5,6 +5,11 @@
 #include <cassert>
 #include <iostream>
 #include "examplescene4.h"
+#include "sceneregistry.h"
+#include "glvalidation.h"
+#include "log.h"
+
+static SceneRegistry::Registration<ExampleScene4> registration("example4", "Gouraud-shaded sphere (shading calculated in vertex shader)", "tessellation=3");
 
 void ExampleScene4::createIcosahedron(std::vector<Vertex> &icosahedron, std::vector<GLushort> &icosahedronIndices) const
 {
@@ -60,7 +65,7 @@ void ExampleScene4::createSphere(std::vector<Vertex> &sphere, std::vector<GLusho
 		// Get number of triangles at previous tesselation level
 		size_t origTriangles = sphereIndices.size() / 3;
 
-		std::cout << "Tesselation " << tesselation + 1 << " with " << origTriangles << " triangles" << std::endl;
+		LOG_INFO(SCENE, "Tesselation " << tesselation + 1 << " with " << origTriangles << " triangles");
 
 		// Split each existing triangle v0, v1, v2 into four parts using a new vertices v3, v4 and v5
 		//         *v2       //
@@ -125,7 +130,7 @@ void ExampleScene4::createSphere(std::vector<Vertex> &sphere, std::vector<GLusho
 	}
 
 	// Note that some (half) of new vertices are duplicates after tesselation as edges are shared with another triangle!
-	std::cout << "Created sphere with " << sphere.size() << " vertices and " << sphereIndices.size() / 3 << " faces" << std::endl;
+	LOG_INFO(SCENE, "Created sphere with " << sphere.size() << " vertices and " << sphereIndices.size() / 3 << " faces");
 
 	// Verify that we don't have too many vertices (over 65535)
 	assert(sphere.size() <= (GLushort)-1);
@@ -194,7 +199,11 @@ void ExampleScene4::updateShading(std::vector<Vertex> &mesh, const glm::mat4 &mo
 	}
 }
 
-ExampleScene4::ExampleScene4()
+ExampleScene4::ExampleScene4(const SceneParameters &parameters) :
+	materialPrograms("data/examplescene4.vs", "data/examplescene4.fs"),
+	currentMaterial(0),
+	shaderProgram(0),
+	tessellation(glm::clamp(parameters.getInt("tessellation", 3), 0, static_cast<int>(MAX_TESSELLATION)))
 {
 	// These OpenGL functions must be defined by the OpenGL (or through GLEW) for this example to work..
 	assert(glBindBuffer != 0);
@@ -221,25 +230,54 @@ ExampleScene4::~ExampleScene4()
 {
 	// Clean up everything
 	glUseProgram(0); // Shader state
-	glDisableVertexAttribArray(shaderProgram.getPositionAttribLocation()); // VBO state
-	glDisableVertexAttribArray(shaderProgram.getColorAttribLocation());
+	if (shaderProgram)
+	{
+		glDisableVertexAttribArray(shaderProgram->getPositionAttribLocation()); // VBO state
+		glDisableVertexAttribArray(shaderProgram->getColorAttribLocation());
+	}
 	glDeleteBuffers(1, &ibo); // Allocated index data
 	glDeleteBuffers(1, &vbo); // Allocated vertex data
 	glDeleteVertexArrays(1, &vao); // Allocated object data
+	delete frameUniforms;
 }
 
 bool ExampleScene4::init()
 {
 	// Reset object rotation
 	rotation = 0;
+	previousRotation = 0;
+	renderRotation = 0;
+
+	// Materials differ only in constants, so each one is compiled into its own shader variant
+	ShaderProgram::Defines material;
+	material["DIFFUSE"] = "vec4(0.5, 0.3, 0.2, 1.0)";
+	material["SPECULAR"] = "vec4(0.9, 0.9, 0.9, 1.0)";
+	material["SHININESS"] = "100.0";
+	materials.push_back(material); // Copper
+
+	material["DIFFUSE"] = "vec4(0.6, 0.35, 0.25, 1.0)";
+	material["SPECULAR"] = "vec4(0.1, 0.1, 0.1, 1.0)";
+	material["SHININESS"] = "10.0";
+	materials.push_back(material); // Clay
+
+	material["DIFFUSE"] = "vec4(0.1, 0.3, 0.8, 1.0)";
+	material["SPECULAR"] = "vec4(1.0, 1.0, 1.0, 1.0)";
+	material["SHININESS"] = "200.0";
+	materials.push_back(material); // Plastic
+
+	// Start compiling all of them at once, so that drivers with parallel compiling can overlap the work
+	for (size_t i = 0; i < materials.size(); ++i)
+		materialPrograms.request(materials[i]);
 
 	// Load shader program used in this example
-	if (!shaderProgram.load("data/examplescene4.vs", "data/examplescene4.fs"))
+	if (!selectMaterial(0))
 		return false;
 
+	// View, projection and light are given to the programs of every material through a uniform buffer
+	frameUniforms = new UniformBuffer(UniformBuffer::FRAME_BINDING, sizeof(FrameUniforms));
+
 	// Create object geometry
-	int numTesselations = 3;
-	createSphere(sphere, sphereIndices, numTesselations);
+	createSphere(sphere, sphereIndices, tessellation);
 
 	// Calculate model transformation
 	modelMat = glm::rotate(glm::mat4(), rotation, glm::vec3(0.0, 1.0, 0.0)); // Rotate object around y-axis
@@ -248,9 +286,6 @@ bool ExampleScene4::init()
 	glm::vec4 lightPos(2.0f, 4.0f, 3.0f, 1.0f);
 	updateShading(sphere, modelMat, lightPos);
 
-	// Use shader program to render everything
-	glUseProgram(shaderProgram.getShaderProgram());
-
 	//Initialize clear color for glClear()
 	glClearColor(0.2f, 0.3f, 0.1f, 1.f);
 
@@ -287,23 +322,23 @@ bool ExampleScene4::init()
 
 	// Note: The following attribute indexes must match what is defined in shader (in shaderprogram.cpp) for glBindAttribLocation() calls!
 
-	// Specify that our coordinate data is going into attribute index 0 (shaderProgram.getPositionAttribLocation()), and contains three floats per vertex
-	glVertexAttribPointer(shaderProgram.getPositionAttribLocation(), 3, GL_FLOAT, GL_FALSE, sizeof (struct Vertex), (const GLvoid*)offsetof(struct Vertex, position));
+	// Specify that our coordinate data is going into attribute index 0 (shaderProgram->getPositionAttribLocation()), and contains three floats per vertex
+	glVertexAttribPointer(shaderProgram->getPositionAttribLocation(), 3, GL_FLOAT, GL_FALSE, sizeof (struct Vertex), (const GLvoid*)offsetof(struct Vertex, position));
 
 	// Enable attribute index 0 as being used
-	glEnableVertexAttribArray(shaderProgram.getPositionAttribLocation());
+	glEnableVertexAttribArray(shaderProgram->getPositionAttribLocation());
 
-	// Specify that our color data is going into attribute index 1 (shaderProgram.getColorAttribLocation()), and contains three floats per vertex
-	glVertexAttribPointer(shaderProgram.getColorAttribLocation(), 3, GL_FLOAT, GL_FALSE, sizeof (struct Vertex), (const GLvoid*)offsetof(struct Vertex, color));
+	// Specify that our color data is going into attribute index 1 (shaderProgram->getColorAttribLocation()), and contains three floats per vertex
+	glVertexAttribPointer(shaderProgram->getColorAttribLocation(), 3, GL_FLOAT, GL_FALSE, sizeof (struct Vertex), (const GLvoid*)offsetof(struct Vertex, color));
 
 	// Enable attribute index 1 as being used
-	glEnableVertexAttribArray(shaderProgram.getColorAttribLocation()); // Bind our second VBO as being the active buffer and storing vertex attributes (colors)
+	glEnableVertexAttribArray(shaderProgram->getColorAttribLocation()); // Bind our second VBO as being the active buffer and storing vertex attributes (colors)
 
-	// Specify that our vertex normals are going into attribute index 2 (shaderProgram.getNormalAttribLocation()), and contains three floats per vertex
-	glVertexAttribPointer(shaderProgram.getNormalAttribLocation(), 3, GL_FLOAT, GL_FALSE, sizeof(struct Vertex), (const GLvoid*)offsetof(struct Vertex, normal));
+	// Specify that our vertex normals are going into attribute index 2 (shaderProgram->getNormalAttribLocation()), and contains three floats per vertex
+	glVertexAttribPointer(shaderProgram->getNormalAttribLocation(), 3, GL_FLOAT, GL_FALSE, sizeof(struct Vertex), (const GLvoid*)offsetof(struct Vertex, normal));
 
 	// Enable attribute index 2 as being used
-	glEnableVertexAttribArray(shaderProgram.getNormalAttribLocation()); // Bind our second VBO as being the active buffer and storing vertex attributes (colors)
+	glEnableVertexAttribArray(shaderProgram->getNormalAttribLocation()); // Bind our second VBO as being the active buffer and storing vertex attributes (colors)
 
 	// Unbind buffer (not strictly necessary but it is a state in context instead of vbo
 	glBindBuffer(GL_ARRAY_BUFFER, 0);
@@ -328,9 +363,15 @@ void ExampleScene4::resize(GLsizei width, GLsizei height)
 void ExampleScene4::update(float timestep)
 {
 	// Rotate object
+	previousRotation = rotation;
 	rotation += glm::two_pi<float>() * 0.1f * timestep;
 }
 
+void ExampleScene4::interpolate(float alpha)
+{
+	renderRotation = glm::mix(previousRotation, rotation, alpha);
+}
+
 // Render view
 void ExampleScene4::render()
 {
@@ -338,7 +379,7 @@ void ExampleScene4::render()
 	glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
 	// Calculate model transformation
-	modelMat = glm::rotate(glm::mat4(), rotation, glm::vec3(0.0, 1.0, 0.0)); // Rotate object around y-axis
+	modelMat = glm::rotate(glm::mat4(), renderRotation, glm::vec3(0.0, 1.0, 0.0)); // Rotate object around y-axis
 	/*
 	std::cout << "model matrix: " << std::endl;
 	for (int i = 0; i < 4; ++i)
@@ -373,8 +414,8 @@ void ExampleScene4::render()
 
 //	std::cout << "Light in view pos: " << lightInViewPos.x << ", " << lightInViewPos.y << ", " << lightInViewPos.z << std::endl;
 
-	glm::mat4 modelViewMat = viewMat * modelMat;
 	/*
+	glm::mat4 modelViewMat = viewMat * modelMat;
 	glm::vec4 testVertexPos(0.0f, 0.0f, 0.1f, 1.0f);
 	glm::vec4 testVertexNormal = testVertexPos;
 	testVertexNormal.w = 0.0f;
@@ -400,14 +441,38 @@ void ExampleScene4::render()
 	float dK = glm::dot(glm::vec3(L.x, L.y, L.z), glm::vec3(normal.x, normal.y, normal.z));
 	std::cout << "dK: " << dK << std::endl;
 	*/
-	glUniformMatrix4fv(glGetUniformLocation(shaderProgram.getShaderProgram(), "mvmatrix"), 1, GL_FALSE, glm::value_ptr(modelViewMat));
-	glUniformMatrix4fv(glGetUniformLocation(shaderProgram.getShaderProgram(), "pmatrix"), 1, GL_FALSE, glm::value_ptr(projectionMat));
-	glUniform4fv(glGetUniformLocation(shaderProgram.getShaderProgram(), "lightPosition"), 1, glm::value_ptr(lightInViewPos));
+	FrameUniforms frame = FrameUniforms();
+	frame.view = viewMat;
+	frame.projection = projectionMat;
+	frame.lightPosition[0] = lightInViewPos;
+	frame.lightColor[0] = glm::vec4(1.0f);
+	frame.lightCount = 1;
+	frameUniforms->update(&frame);
+	shaderProgram->setUniform(modelMatrixUniform, modelMat);
 
 	// Count is the number of elements in the array that will form triangles. It is not the number of triangles defined by the array.
 	// When VBOs are in use and GL_ELEMENT_ARRAY_BUFFER is bound, the last parameter (pointer to data) is interpreted as an offset within IBO instead of
 	// actual program memory address.
 	glDrawElements(GL_TRIANGLES, static_cast<GLsizei>(sphereIndices.size()), GL_UNSIGNED_SHORT, 0);
+	CHECK_GL_DRAW();
+}
+
+/**
+ * \brief Switch to the shader variant of a material and look up its uniforms
+ */
+bool ExampleScene4::selectMaterial(size_t material)
+{
+	ShaderProgram *program = materialPrograms.get(materials[material]);
+	if (!program)
+		return false;
+
+	shaderProgram = program;
+	currentMaterial = material;
+	modelMatrixUniform = shaderProgram->getUniform("modelMatrix");
+
+	// Use shader program to render everything
+	glUseProgram(shaderProgram->getShaderProgram());
+	return true;
 }
 
 bool ExampleScene4::handleEvent(const SDL_Event &e)
@@ -415,6 +480,10 @@ bool ExampleScene4::handleEvent(const SDL_Event &e)
         // Put any event handling code here.
         // Window-resizing is handled in event loop already.
 
+	// M cycles through materials
+	if (e.type == SDL_KEYDOWN && e.key.keysym.scancode == SDL_SCANCODE_M)
+		selectMaterial((currentMaterial + 1) % materials.size());
+
 	// Return false if you want to stop the program
 	return true;
 }
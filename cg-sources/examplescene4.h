@@ -12,6 +12,9 @@
 #include <glm/gtc/type_ptr.hpp>         // Needed for glm::value_ptr(x). You can use &x[0] instead of that.
 #include "scene.h"                      // Abstract scene class
 #include "shaderprogram.h"              // For shader management
+#include "uniformbuffer.h"              // For the FrameData uniform block
+#include "sceneregistry.h"              // For scene parameters
+#include "shadervariants.h"             // Shader compiled separately for every material
 
 /**
  * \brief Draws a vertex-colored tetrahedron
@@ -34,8 +37,12 @@ class ExampleScene4 : public Scene
 		}
 	};
 
-	ShaderProgram shaderProgram;
-	glm::mat4 mvpMat;
+	ShaderVariants materialPrograms;                      // examplescene4 shaders for every material
+	std::vector<ShaderProgram::Defines> materials;        // Material constants as shader defines
+	size_t currentMaterial;
+	ShaderProgram *shaderProgram;                         // Program of the current material
+	int modelMatrixUniform; // Handle of the modelMatrix uniform in shaderProgram
+	UniformBuffer *frameUniforms = 0; // FrameData written once per frame, shared by the programs of all materials
 
 	glm::mat4 projectionMat;
 	glm::mat4 viewMat;
@@ -45,15 +52,20 @@ class ExampleScene4 : public Scene
 	GLuint vao, vbo, ibo;
 
 	float rotation; // Current rotation position
+	float previousRotation; // Rotation before the latest update()
+	float renderRotation; // Rotation interpolated for render()
 	std::vector<Vertex> sphere;
 	std::vector<GLushort> sphereIndices;
+	static const int MAX_TESSELLATION = 5; // More vertices than GLushort indices can address
+	int tessellation; // Subdivisions of the icosahedron, parameter "tessellation"
 
 	void createIcosahedron(std::vector<Vertex> &tetrahedron, std::vector<GLushort> &tetrahedronIndices) const;
 	void createSphere(std::vector<Vertex> &sphere, std::vector<GLushort> &sphereIndices, int numTesselations) const;
 
+	bool selectMaterial(size_t material);
 	void updateShading(std::vector<Vertex> &mesh, const glm::mat4 &modelMat, const glm::vec4 lightPos) const;
 public:
-	ExampleScene4();
+	explicit ExampleScene4(const SceneParameters &parameters = SceneParameters());
 	virtual ~ExampleScene4();
 
 	// Initialize scene
@@ -65,6 +77,9 @@ public:
 	// Update scene
 	virtual void update(float timestep);
 
+	// Blend the rotation of the two latest updates
+	virtual void interpolate(float alpha);
+
 	// Render view
 	virtual void render();
 
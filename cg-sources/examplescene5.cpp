@@ -0,0 +1,149 @@
+/**
+* \brief Example Scene 5 implementation
+* \file
+*/
+#include "examplescene5.h"
+#include "texture.h"
+#include "sceneregistry.h"
+#include "glvalidation.h"
+#include "log.h"
+
+static SceneRegistry::Registration<ExampleScene5> registration("example5", "Ground plane with a streamed virtual texture");
+
+ExampleScene5::ExampleScene5() :
+	vao(0),
+	vbo(0),
+	time(0.0f),
+	previousTime(0.0f)
+{
+}
+
+ExampleScene5::~ExampleScene5()
+{
+	// Clean up everything
+	glUseProgram(0);
+	glDeleteBuffers(1, &vbo);
+	glDeleteVertexArrays(1, &vao);
+	delete frameUniforms;
+}
+
+bool ExampleScene5::init()
+{
+	if (!shaderProgram.load("data/virtualtexture.vs", "data/virtualtexture.fs"))
+		return false;
+	if (!feedbackProgram.load("data/virtualtexture.vs", "data/virtualtexture_feedback.fs"))
+		return false;
+
+	// Both passes read the camera from the same uniform buffer
+	frameUniforms = new UniformBuffer(UniformBuffer::FRAME_BINDING, sizeof(FrameUniforms));
+
+	// Split the source image into tiles on the first run. Large images should be split offline with texconvert -tiles.
+	const std::string tiles = "data/sand-texture.tiles";
+	if (!virtualTexture.open(tiles))
+	{
+		LOG_INFO(SCENE, "Creating virtual texture tiles in " << tiles);
+		SDL_Surface *image = Texture::loadSurface("data/sand-texture.png");
+		bool ok = image && VirtualTexture::writeTiles(tiles, image);
+		if (image)
+			SDL_FreeSurface(image);
+		if (!ok || !virtualTexture.open(tiles))
+			return false;
+	}
+
+	// Plane keeps the aspect ratio of the image
+	float halfWidth = 50.0f;
+	float halfDepth = halfWidth * virtualTexture.getHeight() / virtualTexture.getWidth();
+	Vertex plane[4] = {
+		Vertex(-halfWidth, 0.0f, halfDepth, 0.0f, 0.0f),
+		Vertex(halfWidth, 0.0f, halfDepth, 1.0f, 0.0f),
+		Vertex(-halfWidth, 0.0f, -halfDepth, 0.0f, 1.0f),
+		Vertex(halfWidth, 0.0f, -halfDepth, 1.0f, 1.0f)
+	};
+
+	glGenVertexArrays(1, &vao);
+	glBindVertexArray(vao);
+	glGenBuffers(1, &vbo);
+	glBindBuffer(GL_ARRAY_BUFFER, vbo);
+	glBufferData(GL_ARRAY_BUFFER, sizeof(plane), plane, GL_STATIC_DRAW);
+	glVertexAttribPointer(shaderProgram.getPositionAttribLocation(), 3, GL_FLOAT, GL_FALSE, sizeof(struct Vertex), (const GLvoid*)offsetof(struct Vertex, position));
+	glEnableVertexAttribArray(shaderProgram.getPositionAttribLocation());
+	glVertexAttribPointer(shaderProgram.getTexture0AttribLocation(), 2, GL_FLOAT, GL_FALSE, sizeof(struct Vertex), (const GLvoid*)offsetof(struct Vertex, uv));
+	glEnableVertexAttribArray(shaderProgram.getTexture0AttribLocation());
+
+	// Texture units 0 and 1 hold the cache and the indirection texture
+	glUseProgram(shaderProgram.getShaderProgram());
+	virtualTexture.setUniforms(shaderProgram.getShaderProgram(), 0, 1, false);
+	glUseProgram(feedbackProgram.getShaderProgram());
+	virtualTexture.setUniforms(feedbackProgram.getShaderProgram(), 0, 1, true);
+
+	glClearColor(0.5f, 0.6f, 0.8f, 1.f);
+	glEnable(GL_DEPTH_TEST);
+	glDepthFunc(GL_LESS);
+	glDisable(GL_BLEND);
+
+	return true;
+}
+
+void ExampleScene5::resize(GLsizei width, GLsizei height)
+{
+	// Update OpenGL viewport to match window system's window size
+	glViewport(0, 0, width, height);
+
+	float fovy = 45.0f;
+	projectionMat = glm::perspective(fovy, static_cast<float>(width) / static_cast<float>(height), 0.1f, 1000.0f);
+
+	virtualTexture.resize(width, height);
+}
+
+void ExampleScene5::update(float timestep)
+{
+	previousTime = time;
+	time += timestep;
+}
+
+void ExampleScene5::interpolate(float alpha)
+{
+	float t = glm::mix(previousTime, time, alpha);
+
+	// Fly low over the plane so that both nearby detail and distant coarse levels are visible
+	glm::vec3 eye(30.0f * glm::sin(0.1f * t), 2.0f + 1.5f * glm::sin(0.3f * t), 20.0f * glm::cos(0.1f * t));
+	glm::vec3 target(30.0f * glm::sin(0.1f * t + 0.3f), 0.0f, 20.0f * glm::cos(0.1f * t + 0.3f));
+	viewMat = glm::lookAt(eye, target, glm::vec3(0.0f, 1.0f, 0.0f));
+}
+
+// Render view
+void ExampleScene5::render()
+{
+	FrameUniforms frame = FrameUniforms();
+	frame.view = viewMat;
+	frame.projection = projectionMat;
+	frameUniforms->update(&frame);
+
+	// Stream in tiles requested by the previous feedback pass
+	virtualTexture.update();
+
+	glBindVertexArray(vao);
+
+	// Feedback pass into the small offscreen buffer
+	virtualTexture.beginFeedback();
+	glUseProgram(feedbackProgram.getShaderProgram());
+	glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+	CHECK_GL_DRAW();
+	virtualTexture.endFeedback();
+
+	// Actual view
+	glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+	glUseProgram(shaderProgram.getShaderProgram());
+	virtualTexture.bind(0, 1);
+	glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+	CHECK_GL_DRAW();
+}
+
+bool ExampleScene5::handleEvent(const SDL_Event &e)
+{
+	if (e.type == SDL_KEYDOWN && e.key.keysym.sym == SDLK_t)
+		LOG_INFO(SCENE, "Virtual texture tiles in cache: " << virtualTexture.getResidentTileCount());
+
+	// Return false if you want to stop the program
+	return true;
+}
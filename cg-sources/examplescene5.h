@@ -0,0 +1,74 @@
+/**
+ * \brief Example Scene 5 interface
+ */
+#ifndef EXAMPLE_SCENE_5_H_
+#define EXAMPLE_SCENE_5_H_
+
+#include <GL/glew.h>                    // OpenGL extension wrangler library
+#include <SDL.h>                        // libSDL functionality
+#include <glm/glm.hpp>                  // Matrix library
+#include <glm/gtc/matrix_transform.hpp> // Needed for glm::perspective() and friends.
+#include <glm/gtc/type_ptr.hpp>         // Needed for glm::value_ptr(x). You can use &x[0] instead of that.
+#include "scene.h"                      // Abstract scene class
+#include "shaderprogram.h"              // For shader management
+#include "uniformbuffer.h"              // For the FrameData uniform block
+#include "virtualtexture.h"
+
+/**
+ * \brief Draws a ground plane with a virtual texture streamed from tiles on disk
+ */
+class ExampleScene5 : public Scene
+{
+	struct Vertex
+	{
+		GLfloat position[3];
+		GLfloat uv[2]; // Virtual texture coordinates
+
+		Vertex(GLfloat x = 0.0, GLfloat y = 0.0, GLfloat z = 0.0, GLfloat u = 0.0f, GLfloat v = 0.0f)
+		{
+			position[0] = x;
+			position[1] = y;
+			position[2] = z;
+			uv[0] = u;
+			uv[1] = v;
+		}
+	};
+
+	ShaderProgram shaderProgram;   // Draws the plane with the virtual texture
+	ShaderProgram feedbackProgram; // Writes tile requests into the feedback buffer
+	UniformBuffer *frameUniforms = 0; // FrameData written once per frame, read by both programs
+
+	glm::mat4 projectionMat;
+	glm::mat4 viewMat;
+
+	// Vertex Array Object and Vertex Buffer Object handlers
+	GLuint vao, vbo;
+
+	VirtualTexture virtualTexture;
+	float time; // Camera animation time in seconds
+	float previousTime; // time before the latest update()
+public:
+	ExampleScene5();
+	virtual ~ExampleScene5();
+
+	// Initialize scene
+	virtual bool init();
+
+	// Called on window resize
+	virtual void resize(GLsizei width, GLsizei height);
+
+	// Update scene
+	virtual void update(float timestep);
+
+	// Move the camera to a position between the two latest updates
+	virtual void interpolate(float alpha);
+
+	// Render view
+	virtual void render();
+
+	// Handle SDL event
+	virtual bool handleEvent(const SDL_Event &e);
+};
+
+
+#endif
@@ -0,0 +1,61 @@
+/**
+ * \brief Fixed time step simulation clock implementation
+ * \file
+ */
+#include "fixedtimestep.h"
+
+/**
+ * \param rate Updates per second
+ */
+FixedTimestep::FixedTimestep(int rate) :
+	step(1.0 / (rate > 0 ? rate : DEFAULT_RATE)),
+	accumulator(0.0),
+	previous(0),
+	started(false)
+{
+}
+
+/**
+ * \brief Forget elapsed time, e.g. after scene initialization. The next advance() runs no updates.
+ */
+void FixedTimestep::reset()
+{
+	accumulator = 0.0;
+	started = false;
+}
+
+/**
+ * \brief Add the real time elapsed since the previous call
+ * \return Number of updates to run this frame
+ */
+int FixedTimestep::advance()
+{
+	Uint64 now = SDL_GetPerformanceCounter();
+	double seconds = started ? static_cast<double>(now - previous) / SDL_GetPerformanceFrequency() : 0.0;
+	previous = now;
+	started = true;
+	return advance(seconds);
+}
+
+/**
+ * \brief Add a given amount of time instead of measuring it, for repeatable runs such as benchmarks
+ * \return Number of updates to run this frame
+ */
+int FixedTimestep::advance(double seconds)
+{
+	accumulator += seconds;
+
+	int steps = static_cast<int>(accumulator / step);
+	if (steps > MAX_STEPS)
+	{
+		steps = MAX_STEPS;
+		accumulator = 0.0;
+		return steps;
+	}
+
+	// Rounding must not leave a negative remainder
+	accumulator -= steps * step;
+	if (accumulator < 0.0)
+		accumulator = 0.0;
+	return steps;
+}
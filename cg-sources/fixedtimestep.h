@@ -0,0 +1,63 @@
+/**
+ * \brief Fixed time step simulation clock
+ * \file
+ */
+#ifndef FIXEDTIMESTEP_H_
+#define FIXEDTIMESTEP_H_
+
+#include <SDL.h>
+
+/**
+ * \brief Splits elapsed time into update steps of equal length
+ *
+ * Real time is measured with SDL_GetPerformanceCounter() and collected into an accumulator. Every frame runs as many
+ * whole steps as fit into it, possibly none or several, and the remainder is carried over. Scene::update() then always
+ * sees the same time step, which makes animation independent of the frame rate and repeatable. The fraction of a step
+ * left over is given to Scene::interpolate() so that rendering can blend the two latest simulation states.
+ *
+ * After a very long frame, e.g. a breakpoint or window drag, at most MAX_STEPS steps are run and the rest of the time
+ * is dropped, so that a slow simulation can not fall further and further behind.
+ *
+ * Usage for each frame:
+ * \code
+ * int steps = clock.advance();
+ * for (int i = 0; i < steps; ++i)
+ *     scene.update(clock.getStep());
+ * scene.interpolate(clock.getAlpha());
+ * scene.render();
+ * \endcode
+ */
+class FixedTimestep
+{
+	double step;         // Seconds per update
+	double accumulator;  // Seconds not simulated yet
+	Uint64 previous;     // SDL_GetPerformanceCounter() at the previous advance()
+	bool started;
+public:
+	static const int DEFAULT_RATE = 120; ///< Updates per second
+	static const int MAX_STEPS = 8;      ///< Updates per frame at most
+
+	explicit FixedTimestep(int rate = DEFAULT_RATE);
+
+	void reset();
+	int advance();
+	int advance(double seconds);
+
+	/**
+	 * \brief Seconds per update, the time step to give to Scene::update()
+	 */
+	float getStep() const
+	{
+		return static_cast<float>(step);
+	}
+
+	/**
+	 * \brief Fraction of a step elapsed after the latest update, 0 to 1
+	 */
+	float getAlpha() const
+	{
+		return static_cast<float>(accumulator / step);
+	}
+};
+
+#endif
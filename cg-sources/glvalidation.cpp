@@ -0,0 +1,120 @@
+/**
+ * \brief OpenGL error checking implementation
+ * \file
+ */
+#include <iostream>
+#include "glvalidation.h"
+
+#if defined(_DEBUG) || defined(CG_DEBUG)
+GLValidation::Level GLValidation::level = GLValidation::FRAME;
+#else
+GLValidation::Level GLValidation::level = GLValidation::SAMPLED;
+#endif
+unsigned int GLValidation::frame = 0;
+bool GLValidation::drawFailed = false;
+
+namespace
+{
+	const char *levelNames[] = {"off", "sampled", "frame", "draw", "debug"};
+}
+
+void GLValidation::setLevel(Level newLevel)
+{
+	level = newLevel;
+}
+
+/**
+ * \brief Level from its name: off, sampled, frame, draw or debug
+ * \return false if the name is unknown
+ */
+bool GLValidation::parseLevel(const std::string &name, Level &result)
+{
+	for (int i = OFF; i <= DEBUG_CONTEXT; ++i)
+	{
+		if (name == levelNames[i])
+		{
+			result = static_cast<Level>(i);
+			return true;
+		}
+	}
+	return false;
+}
+
+const char *GLValidation::getLevelName(Level value)
+{
+	return levelNames[value];
+}
+
+/**
+ * \brief Print every pending OpenGL error, whatever the level
+ * \param file Source file of the check for the messages, or 0
+ * \return true if there were no errors
+ */
+bool GLValidation::checkErrors(const char *file, int line)
+{
+	GLenum e;
+	bool allOk = true;
+	while ((e = glGetError()) != GL_NO_ERROR)
+	{
+		allOk = false;
+
+		if (file)
+			std::cerr << file << "(" << line << "): ";
+
+		switch (e)
+		{
+#ifdef GL_INVALID_ENUM
+		case GL_INVALID_ENUM:
+			std::cerr << "OpenGL error GL_INVALID_ENUM: An unacceptable value is specified for an enumerated argument." << std::endl;
+			break;
+#endif
+#ifdef GL_INVALID_VALUE
+		case GL_INVALID_VALUE:
+			std::cerr << "OpenGL error GL_INVALID_VALUE: A numeric argument is out of range." << std::endl;
+			break;
+#endif
+#ifdef GL_INVALID_OPERATION
+		case GL_INVALID_OPERATION:
+			std::cerr << "OpenGL error GL_INVALID_OPERATION: The specified operation is not allowed in the current state." << std::endl;
+			break;
+#endif
+#ifdef GL_INVALID_FRAMEBUFFER_OPERATION
+		case GL_INVALID_FRAMEBUFFER_OPERATION:
+			std::cerr << "OpenGL error GL_INVALID_FRAMEBUFFER_OPERATION: The framebuffer object is not complete." << std::endl;
+			break;
+#endif
+#ifdef GL_OUT_OF_MEMORY
+		case GL_OUT_OF_MEMORY:
+			std::cerr << "OpenGL error GL_OUT_OF_MEMORY: There is not enough memory left to execute the command. The state of the GL is undefined now!" << std::endl;
+			break;
+#endif
+#ifdef GL_STACK_UNDERFLOW
+		case GL_STACK_UNDERFLOW:
+			std::cerr << "OpenGL error GL_STACK_UNDERFLOW: An attempt has been made to perform an operation that would cause an internal stack to underflow." << std::endl;
+			break;
+#endif
+#ifdef GL_STACK_OVERFLOW
+		case GL_STACK_OVERFLOW:
+			std::cerr << "OpenGL error GL_STACK_OVERFLOW: An attempt has been made to perform an operation that would cause an internal stack to overflow." << std::endl;
+			break;
+#endif
+		}
+	}
+
+	return allOk;
+}
+
+/**
+ * \brief Check errors at the end of a frame, depending on the level
+ * \return false if there were errors, including those already found by checkDraw() during the frame
+ */
+bool GLValidation::checkFrame()
+{
+	bool drawOk = !drawFailed;
+	drawFailed = false;
+
+	++frame;
+	if (level == OFF || (level == SAMPLED && frame % SAMPLE_INTERVAL != 0))
+		return drawOk;
+	return checkErrors() && drawOk;
+}
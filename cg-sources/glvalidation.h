@@ -0,0 +1,77 @@
+/**
+ * \brief Selectable amount of OpenGL error checking
+ * \file
+ */
+#ifndef GLVALIDATION_H_
+#define GLVALIDATION_H_
+
+#include <string>
+#include <GL/glew.h>
+
+/**
+ * \brief Decides how often glGetError() is called
+ *
+ * glGetError() makes many drivers wait until the commands issued so far have been processed, so checking after
+ * every draw or even every frame changes the frame times being measured. Levels from cheapest to most thorough:
+ *
+ * - OFF: Only the checks after initialization.
+ * - SAMPLED: Once every SAMPLE_INTERVAL frames. Errors are sticky, so they are still found, without the location.
+ *   Default of release builds.
+ * - FRAME: After every frame. Default of debug builds (_DEBUG or CG_DEBUG defined).
+ * - DRAW: Also after every draw call marked with CHECK_GL_DRAW(), reporting the file and line.
+ * - DEBUG_CONTEXT: DRAW checks and a debug context with a debug message callback, see debugmessagecallback.h.
+ *
+ * The level is selected with --gl-validation before the OpenGL context is created, as the debug context can not be
+ * enabled afterwards.
+ */
+class GLValidation
+{
+public:
+	enum Level
+	{
+		OFF,
+		SAMPLED,
+		FRAME,
+		DRAW,
+		DEBUG_CONTEXT
+	};
+
+	static const unsigned int SAMPLE_INTERVAL = 60;
+
+	static void setLevel(Level level);
+	static bool parseLevel(const std::string &name, Level &level);
+	static const char *getLevelName(Level level);
+
+	static Level getLevel()
+	{
+		return level;
+	}
+
+	static bool checkErrors(const char *file = 0, int line = 0);
+	static bool checkFrame();
+
+	/**
+	 * \brief Check errors after a draw call at level DRAW and above, usually through CHECK_GL_DRAW()
+	 *
+	 * Errors found here are remembered and reported by the next checkFrame(), which empties the error queue.
+	 */
+	static bool checkDraw(const char *file, int line)
+	{
+		if (level < DRAW || checkErrors(file, line))
+			return true;
+		drawFailed = true;
+		return false;
+	}
+
+private:
+	static Level level;
+	static unsigned int frame;
+	static bool drawFailed; // An error was found by checkDraw() since the last checkFrame()
+};
+
+/**
+ * \brief Report OpenGL errors with the location at validation level DRAW and above
+ */
+#define CHECK_GL_DRAW() GLValidation::checkDraw(__FILE__, __LINE__)
+
+#endif
@@ -0,0 +1,358 @@
+/**
+ * \brief Direct PNG and JPEG decoding implementation
+ * \file
+ */
+#include <iostream>
+#include <cstdio>
+#include <csetjmp>
+#include <vector>
+#include <algorithm>
+#include "imagedecoder.h"
+
+#ifdef CG_HAVE_LIBPNG
+#include <png.h>
+#endif
+
+#ifdef CG_HAVE_LIBJPEG
+#include <jpeglib.h>
+#endif
+
+namespace
+{
+	enum FileType
+	{
+		TYPE_UNKNOWN,
+		TYPE_PNG,
+		TYPE_JPEG
+	};
+
+	/**
+	 * \brief Recognize file type from the first bytes of the file
+	 */
+	FileType getFileType(FILE *file)
+	{
+		unsigned char magic[8];
+		size_t bytes = fread(magic, 1, sizeof(magic), file);
+		rewind(file);
+
+		static const unsigned char PNG_MAGIC[8] = {0x89, 'P', 'N', 'G', '\r', '\n', 0x1a, '\n'};
+		if (bytes == 8 && std::equal(magic, magic + 8, PNG_MAGIC))
+			return TYPE_PNG;
+		if (bytes >= 3 && magic[0] == 0xff && magic[1] == 0xd8 && magic[2] == 0xff)
+			return TYPE_JPEG;
+		return TYPE_UNKNOWN;
+	}
+
+	/**
+	 * \brief Row y of the image counted from the top, stored in OpenGL order
+	 */
+	inline Uint8 *getRow(void *pixels, int pitch, int height, int y)
+	{
+		return static_cast<Uint8 *>(pixels) + static_cast<size_t>(height - 1 - y) * pitch;
+	}
+
+#ifdef CG_HAVE_LIBPNG
+	/**
+	 * \brief Set up libpng transformations to 32-bit RGBA8888 and read image size
+	 */
+	void setupPNG(png_structp png, png_infop info, int &width, int &height)
+	{
+		png_read_info(png, info);
+		width = png_get_image_width(png, info);
+		height = png_get_image_height(png, info);
+
+		int colorType = png_get_color_type(png, info);
+		int bitDepth = png_get_bit_depth(png, info);
+
+		// Palette, low bit depth gray and tRNS transparency to 8-bit RGB(A)
+		if (colorType == PNG_COLOR_TYPE_PALETTE)
+			png_set_palette_to_rgb(png);
+		if (colorType == PNG_COLOR_TYPE_GRAY && bitDepth < 8)
+			png_set_expand_gray_1_2_4_to_8(png);
+		if (png_get_valid(png, info, PNG_INFO_tRNS))
+			png_set_tRNS_to_alpha(png);
+		if (bitDepth == 16)
+			png_set_strip_16(png);
+		if (colorType == PNG_COLOR_TYPE_GRAY || colorType == PNG_COLOR_TYPE_GRAY_ALPHA)
+			png_set_gray_to_rgb(png);
+
+		// Uint32 pixels with red in the most significant byte are A, B, G, R in memory on little endian machines.
+		// libpng adds the filler after swapping, so it goes directly in front for images without alpha.
+		#if SDL_BYTEORDER == SDL_LIL_ENDIAN
+			png_set_bgr(png);
+			png_set_swap_alpha(png);
+			png_set_add_alpha(png, 0xff, PNG_FILLER_BEFORE);
+		#else
+			png_set_add_alpha(png, 0xff, PNG_FILLER_AFTER);
+		#endif
+	}
+
+	bool readPNGSize(FILE *file, int &width, int &height)
+	{
+		png_structp png = png_create_read_struct(PNG_LIBPNG_VER_STRING, 0, 0, 0);
+		png_infop info = png ? png_create_info_struct(png) : 0;
+		if (!info)
+		{
+			png_destroy_read_struct(&png, 0, 0);
+			return false;
+		}
+
+		if (setjmp(png_jmpbuf(png)))
+		{
+			png_destroy_read_struct(&png, &info, 0);
+			return false;
+		}
+
+		png_init_io(png, file);
+		setupPNG(png, info, width, height);
+		png_destroy_read_struct(&png, &info, 0);
+		return true;
+	}
+
+	bool decodePNG(FILE *file, void *pixels, int pitch, int width, int height)
+	{
+		png_structp png = png_create_read_struct(PNG_LIBPNG_VER_STRING, 0, 0, 0);
+		png_infop info = png ? png_create_info_struct(png) : 0;
+		if (!info)
+		{
+			png_destroy_read_struct(&png, 0, 0);
+			return false;
+		}
+
+		if (setjmp(png_jmpbuf(png)))
+		{
+			png_destroy_read_struct(&png, &info, 0);
+			return false;
+		}
+
+		png_init_io(png, file);
+
+		int fileWidth, fileHeight;
+		setupPNG(png, info, fileWidth, fileHeight);
+		if (fileWidth != width || fileHeight != height)
+		{
+			png_destroy_read_struct(&png, &info, 0);
+			return false;
+		}
+
+		// Interlaced images are read in several passes over the same rows
+		int passes = png_set_interlace_handling(png);
+		png_read_update_info(png, info);
+
+		for (int pass = 0; pass < passes; ++pass)
+		{
+			for (int y = 0; y < height; ++y)
+				png_read_row(png, getRow(pixels, pitch, height, y), 0);
+		}
+
+		png_read_end(png, 0);
+		png_destroy_read_struct(&png, &info, 0);
+		return true;
+	}
+#endif
+
+#ifdef CG_HAVE_LIBJPEG
+	/**
+	 * \brief libjpeg error manager that returns to the decoding function instead of exiting
+	 */
+	struct JPEGError
+	{
+		jpeg_error_mgr manager;
+		jmp_buf jump;
+	};
+
+	void jpegErrorExit(j_common_ptr info)
+	{
+		char message[JMSG_LENGTH_MAX];
+		(*info->err->format_message)(info, message);
+		std::cerr << "ImageDecoder: " << message << std::endl;
+
+		longjmp(reinterpret_cast<JPEGError *>(info->err)->jump, 1);
+	}
+
+	void jpegOutputMessage(j_common_ptr)
+	{
+		// Ignore warnings about corrupt data, libjpeg recovers from those
+	}
+
+	bool decodeJPEG(FILE *file, void *pixels, int pitch, int &width, int &height, bool sizeOnly)
+	{
+		jpeg_decompress_struct info;
+		JPEGError error;
+		info.err = jpeg_std_error(&error.manager);
+		error.manager.error_exit = jpegErrorExit;
+		error.manager.output_message = jpegOutputMessage;
+
+		// Row buffer for libjpeg versions without RGBA output, allocated before setjmp()
+		std::vector<Uint8> rgbRow;
+
+		if (setjmp(error.jump))
+		{
+			jpeg_destroy_decompress(&info);
+			return false;
+		}
+
+		jpeg_create_decompress(&info);
+		jpeg_stdio_src(&info, file);
+		jpeg_read_header(&info, TRUE);
+
+		if (sizeOnly)
+		{
+			width = info.image_width;
+			height = info.image_height;
+			jpeg_destroy_decompress(&info);
+			return true;
+		}
+
+		if (static_cast<int>(info.image_width) != width || static_cast<int>(info.image_height) != height)
+		{
+			jpeg_destroy_decompress(&info);
+			return false;
+		}
+
+		// libjpeg-turbo converts straight to 32-bit pixels with opaque alpha
+		#ifdef JCS_ALPHA_EXTENSIONS
+			#if SDL_BYTEORDER == SDL_LIL_ENDIAN
+				info.out_color_space = JCS_EXT_ABGR;
+			#else
+				info.out_color_space = JCS_EXT_RGBA;
+			#endif
+		#else
+			info.out_color_space = JCS_RGB;
+			rgbRow.resize(width * 3);
+		#endif
+
+		jpeg_start_decompress(&info);
+
+		while (info.output_scanline < info.output_height)
+		{
+			Uint8 *row = getRow(pixels, pitch, height, info.output_scanline);
+			if (rgbRow.empty())
+			{
+				JSAMPROW rows[1] = {row};
+				jpeg_read_scanlines(&info, rows, 1);
+			} else
+			{
+				JSAMPROW rows[1] = {&rgbRow[0]};
+				jpeg_read_scanlines(&info, rows, 1);
+
+				Uint32 *dst = reinterpret_cast<Uint32 *>(row);
+				for (int x = 0; x < width; ++x)
+					dst[x] = (static_cast<Uint32>(rgbRow[x * 3]) << 24) | (static_cast<Uint32>(rgbRow[x * 3 + 1]) << 16) | (static_cast<Uint32>(rgbRow[x * 3 + 2]) << 8) | 0xff;
+			}
+		}
+
+		jpeg_finish_decompress(&info);
+		jpeg_destroy_decompress(&info);
+		return true;
+	}
+#endif
+}
+
+/**
+ * \brief Check if a file can be decoded without SDL_image
+ */
+bool ImageDecoder::isSupported(const std::string &filename)
+{
+	int width, height;
+	return getSize(filename, width, height);
+}
+
+/**
+ * \brief Read image size from the file header
+ * \return false if the file is not a supported PNG or JPEG image
+ */
+bool ImageDecoder::getSize(const std::string &filename, int &width, int &height)
+{
+	FILE *file = fopen(filename.c_str(), "rb");
+	if (!file)
+		return false;
+
+	bool ok = false;
+	switch (getFileType(file))
+	{
+#ifdef CG_HAVE_LIBPNG
+	case TYPE_PNG:
+		ok = readPNGSize(file, width, height);
+		break;
+#endif
+#ifdef CG_HAVE_LIBJPEG
+	case TYPE_JPEG:
+		ok = decodeJPEG(file, 0, 0, width, height, true);
+		break;
+#endif
+	default:
+		break;
+	}
+
+	fclose(file);
+	return ok && width > 0 && height > 0;
+}
+
+/**
+ * \brief Decode an image into 32-bit RGBA8888 pixels in OpenGL row order
+ *
+ * Pixels are written exactly once, so pixels can point to write-only memory such as a mapped pixel buffer.
+ * \param pixels Destination for the bottom row of the image
+ * \param pitch Bytes from one row to the next
+ * \param width Image width from getSize()
+ * \param height Image height from getSize()
+ * \return false if decoding failed. Destination may be partially written.
+ */
+bool ImageDecoder::decode(const std::string &filename, void *pixels, int pitch, int width, int height)
+{
+	FILE *file = fopen(filename.c_str(), "rb");
+	if (!file)
+		return false;
+
+	bool ok = false;
+	switch (getFileType(file))
+	{
+#ifdef CG_HAVE_LIBPNG
+	case TYPE_PNG:
+		ok = decodePNG(file, pixels, pitch, width, height);
+		break;
+#endif
+#ifdef CG_HAVE_LIBJPEG
+	case TYPE_JPEG:
+		ok = decodeJPEG(file, pixels, pitch, width, height, false);
+		break;
+#endif
+	default:
+		break;
+	}
+
+	fclose(file);
+	return ok;
+}
+
+/**
+ * \brief Decode an image into a new SDL_PIXELFORMAT_RGBA8888 surface in OpenGL row order
+ * \return New surface or 0 if the file is not supported or decoding failed
+ */
+SDL_Surface *ImageDecoder::load(const std::string &filename)
+{
+	int width, height;
+	if (!getSize(filename, width, height))
+		return 0;
+
+	SDL_Surface *surface = SDL_CreateRGBSurface(0, width, height, 32, 0xff000000, 0x00ff0000, 0x0000ff00, 0x000000ff);
+	if (!surface)
+		return 0;
+
+	if (SDL_MUSTLOCK(surface))
+		SDL_LockSurface(surface);
+
+	bool ok = decode(filename, surface->pixels, surface->pitch, width, height);
+
+	if (SDL_MUSTLOCK(surface))
+		SDL_UnlockSurface(surface);
+
+	if (!ok)
+	{
+		SDL_FreeSurface(surface);
+		return 0;
+	}
+
+	return surface;
+}
@@ -0,0 +1,31 @@
+/**
+ * \brief Direct PNG and JPEG decoding interface
+ * \file
+ */
+#ifndef IMAGEDECODER_H_
+#define IMAGEDECODER_H_
+
+#include <string>
+#include <SDL.h>
+
+/**
+ * \brief Decodes PNG and JPEG images straight into 32-bit RGBA memory in OpenGL row order
+ *
+ * IMG_Load() returns the image in its file format, which then has to be converted to SDL_PIXELFORMAT_RGBA8888 and
+ * flipped vertically. That is three passes over the image and two full size allocations. ImageDecoder uses libpng and
+ * libjpeg directly and lets them write every row, already converted, to its final position in the destination
+ * buffer, which can also be a mapped pixel buffer object.
+ *
+ * Decoders are compiled in with CG_HAVE_LIBPNG and CG_HAVE_LIBJPEG. Without them, and for other file formats,
+ * the functions return false / 0 and callers should fall back to SDL_image.
+ */
+class ImageDecoder
+{
+public:
+	static bool isSupported(const std::string &filename);
+	static bool getSize(const std::string &filename, int &width, int &height);
+	static bool decode(const std::string &filename, void *pixels, int pitch, int width, int height);
+	static SDL_Surface *load(const std::string &filename);
+};
+
+#endif
@@ -0,0 +1,329 @@
+/**
+ * \brief Leveled logging implementation
+ * \file
+ */
+#include <iostream>
+#include <sstream>
+#include <cstdio>
+#include <cstddef>
+#include <cstring>
+#include <atomic>
+#include <thread>
+#include <chrono>
+#include "log.h"
+
+Log::Level Log::levels[Log::CATEGORY_COUNT] = {Log::LEVEL_INFO, Log::LEVEL_INFO, Log::LEVEL_INFO, Log::LEVEL_INFO, Log::LEVEL_INFO, Log::LEVEL_INFO};
+
+namespace
+{
+	const char *LEVEL_NAMES[] = {"trace", "debug", "info", "warning", "error", "off"};
+	const char *CATEGORY_NAMES[] = {"general", "input", "window", "render", "scene", "gl"};
+
+	/**
+	 * \brief Ring slot. sequence tells whether the slot is free for position p (== p) or holds the record of p (== p + 1).
+	 */
+	struct Slot
+	{
+		std::atomic<size_t> sequence;
+		Log::Record record;
+
+		Slot() : record(Log::LEVEL_INFO, Log::GENERAL) {}
+	};
+
+	// Bounded multiple producer ring with one consumer, see http://www.1024cores.net/home/lock-free-algorithms/queues/bounded-mpmc-queue
+	const size_t RING_SIZE = 1024; // Must be a power of two
+	Slot ring[RING_SIZE];
+	std::atomic<size_t> enqueuePosition(0);
+	size_t dequeuePosition = 0; // Writer thread only
+	std::atomic<unsigned int> dropped(0);
+	std::atomic<bool> running(false);
+	std::thread writer;
+
+	void write(const Log::Record &record)
+	{
+		std::ostream &os = record.level >= Log::LEVEL_WARNING ? std::cerr : std::cout;
+		os << "[" << LEVEL_NAMES[record.level] << "] " << CATEGORY_NAMES[record.category] << ": " << record.text << '\n';
+	}
+
+	/**
+	 * \brief Write every record pushed so far
+	 * \return false if there was nothing to write
+	 */
+	bool drain()
+	{
+		bool written = false;
+		for (;;)
+		{
+			Slot &slot = ring[dequeuePosition & (RING_SIZE - 1)];
+			if (slot.sequence.load(std::memory_order_acquire) != dequeuePosition + 1)
+				break;
+
+			write(slot.record);
+			slot.sequence.store(dequeuePosition + RING_SIZE, std::memory_order_release);
+			++dequeuePosition;
+			written = true;
+		}
+
+		unsigned int lost = dropped.exchange(0, std::memory_order_relaxed);
+		if (lost > 0)
+		{
+			std::cerr << "[warning] general: " << lost << " log messages dropped, ring full\n";
+			written = true;
+		}
+
+		if (written)
+		{
+			std::cout.flush();
+			std::cerr.flush();
+		}
+		return written;
+	}
+
+	void run()
+	{
+		for (;;)
+		{
+			// Records pushed before the stop request are still written
+			bool stop = !running.load(std::memory_order_acquire);
+			if (!drain() && stop)
+				return;
+			if (!stop)
+				std::this_thread::sleep_for(std::chrono::milliseconds(10));
+		}
+	}
+}
+
+void Log::Record::append(const char *value, size_t count)
+{
+	size_t room = MAX_TEXT - 1 - length;
+	if (count > room)
+		count = room;
+	std::memcpy(text + length, value, count);
+	length += static_cast<Uint32>(count);
+	text[length] = '\0';
+}
+
+Log::Record &Log::Record::operator<<(const char *value)
+{
+	if (!value)
+		value = "(null)";
+	append(value, std::strlen(value));
+	return *this;
+}
+
+/**
+ * \brief Text such as returned by glGetString(), instead of the bool conversion of a pointer
+ */
+Log::Record &Log::Record::operator<<(const unsigned char *value)
+{
+	return *this << reinterpret_cast<const char *>(value);
+}
+
+Log::Record &Log::Record::operator<<(const void *value)
+{
+	char buffer[32];
+	int count = std::snprintf(buffer, sizeof(buffer), "%p", value);
+	append(buffer, count);
+	return *this;
+}
+
+Log::Record &Log::Record::operator<<(const std::string &value)
+{
+	append(value.c_str(), value.size());
+	return *this;
+}
+
+Log::Record &Log::Record::operator<<(char value)
+{
+	append(&value, 1);
+	return *this;
+}
+
+Log::Record &Log::Record::operator<<(bool value)
+{
+	return *this << (value ? "true" : "false");
+}
+
+Log::Record &Log::Record::operator<<(int value)
+{
+	return *this << static_cast<long long>(value);
+}
+
+Log::Record &Log::Record::operator<<(unsigned int value)
+{
+	return *this << static_cast<unsigned long long>(value);
+}
+
+Log::Record &Log::Record::operator<<(long value)
+{
+	return *this << static_cast<long long>(value);
+}
+
+Log::Record &Log::Record::operator<<(unsigned long value)
+{
+	return *this << static_cast<unsigned long long>(value);
+}
+
+Log::Record &Log::Record::operator<<(long long value)
+{
+	char buffer[32];
+	int count = std::snprintf(buffer, sizeof(buffer), "%lld", value);
+	append(buffer, count);
+	return *this;
+}
+
+Log::Record &Log::Record::operator<<(unsigned long long value)
+{
+	char buffer[32];
+	int count = std::snprintf(buffer, sizeof(buffer), "%llu", value);
+	append(buffer, count);
+	return *this;
+}
+
+Log::Record &Log::Record::operator<<(double value)
+{
+	char buffer[32];
+	int count = std::snprintf(buffer, sizeof(buffer), "%g", value);
+	append(buffer, count);
+	return *this;
+}
+
+/**
+ * \brief Set the runtime level of every category
+ */
+void Log::setLevel(Level level)
+{
+	for (int i = 0; i < CATEGORY_COUNT; ++i)
+		levels[i] = level;
+}
+
+void Log::setLevel(Category category, Level level)
+{
+	levels[category] = level;
+}
+
+/**
+ * \brief Level from its name: trace, debug, info, warning, error or off
+ */
+bool Log::parseLevel(const std::string &name, Level &level)
+{
+	for (int i = 0; i <= LEVEL_OFF; ++i)
+	{
+		if (name == LEVEL_NAMES[i])
+		{
+			level = static_cast<Level>(i);
+			return true;
+		}
+	}
+	return false;
+}
+
+/**
+ * \brief Set runtime levels from a comma separated list
+ *
+ * A plain level applies to every category, CATEGORY=LEVEL to one category only. Categories are general, input,
+ * window, render, scene and gl. For example "warning,scene=debug".
+ * \return false if the list is malformed, earlier items are applied anyway
+ */
+bool Log::setLevels(const std::string &spec)
+{
+	std::istringstream is(spec);
+	std::string item;
+	while (std::getline(is, item, ','))
+	{
+		size_t separator = item.find('=');
+		Level level;
+		if (!parseLevel(separator == std::string::npos ? item : item.substr(separator + 1), level))
+		{
+			std::cerr << "Log::setLevels(): Unknown level in '" << item << "'" << std::endl;
+			return false;
+		}
+
+		if (separator == std::string::npos)
+		{
+			setLevel(level);
+			continue;
+		}
+
+		std::string name = item.substr(0, separator);
+		int category = 0;
+		while (category < CATEGORY_COUNT && name != CATEGORY_NAMES[category])
+			++category;
+		if (category == CATEGORY_COUNT)
+		{
+			std::cerr << "Log::setLevels(): Unknown category '" << name << "'" << std::endl;
+			return false;
+		}
+		setLevel(static_cast<Category>(category), level);
+	}
+	return true;
+}
+
+/**
+ * \brief Queue a record for the writer thread, or write it immediately if the writer is not running
+ *
+ * Safe to call from any thread. Never blocks: if the ring is full the record is dropped.
+ */
+void Log::push(const Record &record)
+{
+	if (!running.load(std::memory_order_acquire))
+	{
+		write(record);
+		return;
+	}
+
+	size_t position = enqueuePosition.load(std::memory_order_relaxed);
+	Slot *slot;
+	for (;;)
+	{
+		slot = &ring[position & (RING_SIZE - 1)];
+		size_t sequence = slot->sequence.load(std::memory_order_acquire);
+		std::ptrdiff_t difference = static_cast<std::ptrdiff_t>(sequence) - static_cast<std::ptrdiff_t>(position);
+		if (difference == 0)
+		{
+			if (enqueuePosition.compare_exchange_weak(position, position + 1, std::memory_order_relaxed))
+				break;
+		} else
+		if (difference < 0)
+		{
+			dropped.fetch_add(1, std::memory_order_relaxed);
+			return;
+		} else
+			position = enqueuePosition.load(std::memory_order_relaxed);
+	}
+
+	slot->record.level = record.level;
+	slot->record.category = record.category;
+	slot->record.length = record.length;
+	std::memcpy(slot->record.text, record.text, record.length + 1);
+	slot->sequence.store(position + 1, std::memory_order_release);
+}
+
+/**
+ * \brief Start the writer thread
+ */
+void Log::start()
+{
+	if (running.load())
+		return;
+
+	for (size_t i = 0; i < RING_SIZE; ++i)
+		ring[i].sequence.store(i, std::memory_order_relaxed);
+	enqueuePosition.store(0, std::memory_order_relaxed);
+	dequeuePosition = 0;
+
+	running.store(true, std::memory_order_release);
+	writer = std::thread(&run);
+}
+
+/**
+ * \brief Write remaining records and stop the writer thread. Later records are written immediately.
+ */
+void Log::stop()
+{
+	if (!running.load())
+		return;
+
+	running.store(false, std::memory_order_release);
+	writer.join();
+}
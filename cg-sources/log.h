@@ -0,0 +1,148 @@
+/**
+ * \brief Leveled logging written by a background thread
+ * \file
+ */
+#ifndef LOG_H_
+#define LOG_H_
+
+#include <string>
+#include <SDL.h>
+
+/**
+ * \brief Messages below this level are removed at compile time
+ *
+ * Values match Log::Level. Debug builds (CG_DEBUG) keep everything, release builds drop trace messages
+ * such as every mouse motion event.
+ */
+#ifndef CG_LOG_MIN_LEVEL
+#if defined(_DEBUG) || defined(CG_DEBUG)
+#define CG_LOG_MIN_LEVEL 0
+#else
+#define CG_LOG_MIN_LEVEL 1
+#endif
+#endif
+
+/**
+ * \brief Log a message, e.g. LOG(Log::LEVEL_INFO, Log::SCENE, "Loaded " << count << " textures")
+ *
+ * The message is formatted into a fixed size record on the calling thread only if the level passes the
+ * compile-time and runtime filters. Filtered messages cost one comparison and are not evaluated at all.
+ */
+#define LOG(level, category, message) \
+	do \
+	{ \
+		if ((level) >= CG_LOG_MIN_LEVEL && Log::isEnabled(level, category)) \
+		{ \
+			Log::Record cgLogRecord(level, category); \
+			cgLogRecord << message; \
+			Log::push(cgLogRecord); \
+		} \
+	} while (0)
+
+#define LOG_TRACE(category, message) LOG(Log::LEVEL_TRACE, Log::category, message)
+#define LOG_DEBUG(category, message) LOG(Log::LEVEL_DEBUG, Log::category, message)
+#define LOG_INFO(category, message) LOG(Log::LEVEL_INFO, Log::category, message)
+#define LOG_WARNING(category, message) LOG(Log::LEVEL_WARNING, Log::category, message)
+#define LOG_ERROR(category, message) LOG(Log::LEVEL_ERROR, Log::category, message)
+
+/**
+ * \brief Logging with compile-time and per-category runtime levels
+ *
+ * Records are pushed into a lock-free ring that any thread can write to. A writer thread started with a
+ * Log::Writer object drains the ring to std::cout, or std::cerr for warnings and errors, flushing once per batch
+ * instead of once per line. Without a running writer, records are written immediately. If the ring is full,
+ * records are dropped and counted rather than blocking the caller.
+ *
+ * Runtime levels are set with setLevels() before the writer is started, e.g. "debug" or "info,input=trace".
+ * The default is LEVEL_INFO for every category.
+ */
+class Log
+{
+public:
+	enum Level
+	{
+		LEVEL_TRACE = 0,  ///< Per-event details such as mouse motion
+		LEVEL_DEBUG,      ///< Key presses, values useful while developing
+		LEVEL_INFO,       ///< Progress and statistics
+		LEVEL_WARNING,
+		LEVEL_ERROR,
+		LEVEL_OFF
+	};
+
+	enum Category
+	{
+		GENERAL = 0,
+		INPUT,    ///< Keyboard and mouse events
+		WINDOW,   ///< Window system events
+		RENDER,   ///< Render loop statistics
+		SCENE,    ///< Messages of scenes
+		GL,       ///< OpenGL debug messages
+		CATEGORY_COUNT
+	};
+
+	/**
+	 * \brief Formatted message, truncated to MAX_TEXT - 1 characters
+	 */
+	class Record
+	{
+	public:
+		static const size_t MAX_TEXT = 240;
+
+		Level level;
+		Category category;
+		Uint32 length;
+		char text[MAX_TEXT];
+
+		Record(Level level, Category category) : level(level), category(category), length(0) { text[0] = '\0'; }
+
+		Record &operator<<(const char *value);
+		Record &operator<<(const unsigned char *value);
+		Record &operator<<(const void *value);
+		Record &operator<<(const std::string &value);
+		Record &operator<<(char value);
+		Record &operator<<(bool value);
+		Record &operator<<(int value);
+		Record &operator<<(unsigned int value);
+		Record &operator<<(long value);
+		Record &operator<<(unsigned long value);
+		Record &operator<<(long long value);
+		Record &operator<<(unsigned long long value);
+		Record &operator<<(double value);
+	private:
+		void append(const char *value, size_t count);
+	};
+
+	/**
+	 * \brief Runs the writer thread while in scope. Create one in main() after any stream redirection.
+	 */
+	class Writer
+	{
+		Writer(const Writer &);
+		Writer &operator=(const Writer &);
+	public:
+		Writer() { start(); }
+		~Writer() { stop(); }
+	};
+
+	/**
+	 * \brief True if messages of a level and category pass the runtime filter
+	 */
+	static bool isEnabled(Level level, Category category)
+	{
+		return level >= levels[category];
+	}
+
+	static void setLevel(Level level);
+	static void setLevel(Category category, Level level);
+	static bool setLevels(const std::string &spec);
+	static bool parseLevel(const std::string &name, Level &level);
+
+	static void push(const Record &record);
+	static void start();
+	static void stop();
+
+private:
+	static Level levels[CATEGORY_COUNT];
+};
+
+#endif
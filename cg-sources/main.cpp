@@ -2,17 +2,25 @@
 * \brief OpenGL sample selection application
 * \file
 */
+#include <memory>
+#include <fstream>
+#include <iomanip>
+#include <vector>
+#include <cstdlib>
+#include <algorithm>
 #include "sdlwrapper.h"                 // libSDL helper class to initialize library and OpenGL context
 #include "streamredirector.h"           // Redirects standard output and standard error to files to help debugging on Windows
-#include "examplescene1.h"
-#include "examplescene2.h"
-#include "examplescene3.h"
-#include "examplescene4.h"
+#include "sceneregistry.h"              // Scenes register themselves in their own source files
 #include "objparser.h"
-
-#include "Assignment1.h"
-#include "Assignment2.h"
-#include "Assignment3.h"
+#include "texture.h"
+#include "uploadformat.h"
+#include "embeddedshaders.h"
+#include "benchmark.h"
+#include "profiler.h"
+#include "glvalidation.h"
+#include "debugmessagecallback.h"
+#include "log.h"
+#include "fixedtimestep.h"
 
 /**
 * \brief Dump loaded object information to show how it can be accessed using ObjParser class
@@ -104,139 +112,104 @@ void dump_obj_info(const ObjParser &obj)
 }
 
 /**
-* \brief Check for any OpenGL errors that might have happened
-*/
-bool checkOpenGLErrors()
+ * \brief Name of a mouse button in SDL_MouseButtonEvent
+ */
+const char *getButtonName(Uint8 button)
 {
-	GLenum e;
-	bool allOk = true;
-	while ((e = glGetError()) != GL_NO_ERROR)
+	switch (button)
 	{
-		allOk = false;
-
-		switch (e)
-		{
-#ifdef GL_INVALID_ENUM
-		case GL_INVALID_ENUM:
-			std::cerr << "OpenGL error GL_INVALID_ENUM: An unacceptable value is specified for an enumerated argument." << std::endl;
-			break;
-#endif
-#ifdef GL_INVALID_VALUE
-		case GL_INVALID_VALUE:
-			std::cerr << "OpenGL error GL_INVALID_VALUE: A numeric argument is out of range." << std::endl;
-			break;
-#endif
-#ifdef GL_INVALID_OPERATION
-		case GL_INVALID_OPERATION:
-			std::cerr << "OpenGL error GL_INVALID_OPERATION: The specified operation is not allowed in the current state." << std::endl;
-			break;
-#endif
-#ifdef GL_INVALID_FRAMEBUFFER_OPERATION
-		case GL_INVALID_FRAMEBUFFER_OPERATION:
-			std::cerr << "OpenGL error GL_INVALID_FRAMEBUFFER_OPERATION: The framebuffer object is not complete." << std::endl;
-			break;
-#endif
-#ifdef GL_OUT_OF_MEMORY
-		case GL_OUT_OF_MEMORY:
-			std::cerr << "OpenGL error GL_OUT_OF_MEMORY: There is not enough memory left to execute the command. The state of the GL is undefined now!" << std::endl;
-			break;
-#endif
-#ifdef GL_STACK_UNDERFLOW
-		case GL_STACK_UNDERFLOW:
-			std::cerr << "OpenGL error GL_STACK_UNDERFLOW: An attempt has been made to perform an operation that would cause an internal stack to underflow." << std::endl;
-			break;
-#endif
-#ifdef GL_STACK_OVERFLOW
-		case GL_STACK_OVERFLOW:
-			std::cerr << "OpenGL error GL_STACK_OVERFLOW: An attempt has been made to perform an operation that would cause an internal stack to overflow." << std::endl;
-			break;
-#endif
-		}
+	case SDL_BUTTON_LEFT: return "Left";
+	case SDL_BUTTON_RIGHT: return "Right";
+	case SDL_BUTTON_MIDDLE: return "Middle";
+	case SDL_BUTTON_X1: return "X1";
+	case SDL_BUTTON_X2: return "X2";
+	default: return "Unknown";
 	}
-
-	return allOk;
 }
 
-int main(int argc, char **argv)
+/**
+ * \brief How runScene() ended
+ */
+enum RunResult
 {
-	// Redirect standard output and standard error streams to files.
-	// This is most useful on Windows as we don't have a console available
-#ifdef _WIN32
-	StreamRedirector streamRedirector("stdout.txt", "stderr.txt");
-#endif
-
-	// Initialize libSDL, create an application window and initialize it with OpenGL context
-	// See sdlwrapper.* for implementation details
-	bool enableOpenGLDebugging = true;                        // Enable OpenGL debug context and install debug message callback if available
-	int ogl_major_version = 3;                                // OpenGL major version to request. See https://www.opengl.org/wiki/History_of_OpenGL
-	int ogl_minor_version = 3;                                // OpenGL minor version to request.
-	Uint32 sdl_init_flags = SDL_INIT_TIMER | SDL_INIT_VIDEO;  // What SDL subsystems to initialize. See https://wiki.libsdl.org/SDL_Init
-	std::string window_name = "CG 2018 example";              // Created window name - should be UTF-8 string for libSDL
-	Uint32 window_width = 640;                                // Initial window width
-	Uint32 window_height = 480;                               // Initial window height
-	SDL sdl(enableOpenGLDebugging, ogl_major_version, ogl_minor_version, sdl_init_flags, window_name, window_width, window_height);
-
-	if (!sdl.isOk())
-	{
-		std::cerr << "Unable to initialize SDL" << std::endl;
-		return -1;
-	}
-
-	if (!checkOpenGLErrors())
-	{
-		std::cerr << "OpenGL Errors detected during SDL initialization" << std::endl;
-		return -1;
-	}
-
-	//	ExampleScene1 scene; // A tetrahedron with vertex colors
-	//	ExampleScene2 scene; // A texturemapped cube
-	//	ExampleScene3 scene; // A shaded sphere (shading calculated to vertex colors)
-	//	ExampleScene4 scene; // Gouraud-shaded sphere (shading calculated in vertex shader)
-
-	//	Assignment1 scene;
-	//	Assignment2 scene;
-		Assignment3 scene;
+	RUN_FINISHED, ///< Frame count reached or the scene asked to stop
+	RUN_QUIT,     ///< Window closed
+	RUN_ERROR     ///< OpenGL error
+};
 
-	// Test object loading
+/**
+ * \brief Run the render loop of an initialized scene in the window
+ * \param frames Frames to render, 0 to run until the window is closed or the scene asks to stop
+ * \param window_width Current window width, updated when the window is resized
+ * \param window_height Current window height, updated when the window is resized
+ */
+RunResult runScene(SDL_Window *window, Scene &scene, int frames, Uint32 &window_width, Uint32 &window_height)
+{
+	bool runRenderLoop = true;
+	RunResult result = RUN_FINISHED;
+	int frame = 0;
+	FixedTimestep clock;
+
+	// Texture bind statistics for comparing how well scenes share texture binds
+	Uint32 statsTicks = SDL_GetTicks();
+	unsigned int statsFrames = 0;
+	Texture::resetBindCount();
+	while (runRenderLoop)
 	{
-		ObjParser obj("data/cubescene.obj");
+		Profiler::beginFrame();
 
-		dump_obj_info(obj);
-	}
-
-	if (!scene.init())
-	{
-		std::cerr << "Unable to init scene." << std::endl;
-		return -1;
-	}
+		// Update the scene in fixed steps for the time elapsed since the previous frame and blend the last two steps for rendering
+		{
+			PROFILE_SCOPE("update");
+			int steps = clock.advance();
+			for (int step = 0; step < steps; ++step)
+				scene.update(clock.getStep()); // Parameter in seconds
+			scene.interpolate(clock.getAlpha());
+		}
 
-	if (!checkOpenGLErrors())
-	{
-		std::cerr << "OpenGL Errors detected during scene.init()" << std::endl;
-		return -1;
-	}
+		// Upload mipmaps of progressively loaded textures decoded in the background
+		{
+			PROFILE_GPU_SCOPE("streaming");
+			Texture::updateStreaming();
+		}
 
-	scene.resize(window_width, window_height);
-	std::cout << "Initial width and height: " << window_width << " x " << window_height << std::endl;
+		// Render the scene
+		{
+			PROFILE_GPU_SCOPE("render");
+			scene.render();
+		}
 
-	bool runRenderLoop = true;
-	Uint32 prevTicks = SDL_GetTicks();
-	while (runRenderLoop)
-	{
-		// Update the scene
+		// Report texture binds done through Texture and TextureArray and profiled scopes every few seconds
+		++statsFrames;
 		Uint32 curTicks = SDL_GetTicks();
-		scene.update(0.001f * (curTicks - prevTicks)); // Parameter in seconds
-		prevTicks = curTicks;
-
-		// Render the scene
-		scene.render();
+		if (curTicks - statsTicks >= 5000)
+		{
+			LOG_INFO(RENDER, "Texture binds per frame: " << static_cast<float>(Texture::getBindCount()) / statsFrames);
+			if (Profiler::isEnabled())
+				Profiler::logStatistics();
+			Texture::resetBindCount();
+			statsFrames = 0;
+			statsTicks = curTicks;
+		}
 
-		// Check for any errors that might have happened inside render call.
+		// Check for any errors that might have happened inside render call, as often as the validation level asks.
 		// Stop the loop if there has been an error.
-		runRenderLoop &= checkOpenGLErrors();
+		if (!GLValidation::checkFrame())
+		{
+			runRenderLoop = false;
+			result = RUN_ERROR;
+		}
 
 		// Display window
-		SDL_GL_SwapWindow(sdl.getWindow());
+		{
+			PROFILE_SCOPE("swap");
+			SDL_GL_SwapWindow(window);
+		}
+		Profiler::endFrame();
+
+		// Move on after the requested number of frames
+		if (frames > 0 && ++frame >= frames)
+			runRenderLoop = false;
 
 		// Process events
 		SDL_Event e;
@@ -251,46 +224,26 @@ int main(int argc, char **argv)
 				// Program window closed etc.
 			case SDL_QUIT:
 				runRenderLoop = false;
+				result = RUN_QUIT;
 				break;
 				// Keyboard key pressed down (scancode is the physical key on keyboard, keycode is the symbolic key meaning)
 			case SDL_KEYDOWN:
-				std::cout << "Key " << e.key.keysym.scancode << " (" << SDL_GetKeyName(e.key.keysym.sym) << ") pressed" << std::endl;
+				LOG_DEBUG(INPUT, "Key " << e.key.keysym.scancode << " (" << SDL_GetKeyName(e.key.keysym.sym) << ") pressed");
 				break;
 				// Keyboard key released
 			case SDL_KEYUP:
-				std::cout << "Key " << e.key.keysym.scancode << " (" << SDL_GetKeyName(e.key.keysym.sym) << ") released" << std::endl;
+				LOG_DEBUG(INPUT, "Key " << e.key.keysym.scancode << " (" << SDL_GetKeyName(e.key.keysym.sym) << ") released");
 				break;
 				// Mouse moved
 			case SDL_MOUSEMOTION:
-				std::cout << "Mouse motion: " << e.motion.x << ", " << e.motion.y << std::endl;
+				LOG_TRACE(INPUT, "Mouse motion: " << e.motion.x << ", " << e.motion.y);
 				break;
 				// Mouse button pressed
 			case SDL_MOUSEBUTTONDOWN:
 				// See https://wiki.libsdl.org/SDL_MouseButtonEvent
 				// Note: Mouse wheel has its own event
-				std::cout << "Mouse button down at : " << e.button.x << ", " << e.button.y << " button: ";
-				switch (e.button.button)
-				{
-				case SDL_BUTTON_LEFT:
-					std::cout << "Left";
-					break;
-				case SDL_BUTTON_RIGHT:
-					std::cout << "Right";
-					break;
-				case SDL_BUTTON_MIDDLE:
-					std::cout << "Middle";
-					break;
-				case SDL_BUTTON_X1:
-					std::cout << "X1";
-					break;
-				case SDL_BUTTON_X2:
-					std::cout << "X2";
-					break;
-				default:
-					std::cout << "Unknown (" << e.button.button << ")";
-				}
-				std::cout << " clicks: " << static_cast<int>
-					(e.button.clicks) << std::endl;
+				LOG_DEBUG(INPUT, "Mouse button down at : " << e.button.x << ", " << e.button.y << " button: " << getButtonName(e.button.button)
+					<< " clicks: " << static_cast<int>(e.button.clicks));
 				break;
 				// Mouse button released
 			case SDL_MOUSEBUTTONUP:
@@ -304,7 +257,7 @@ int main(int argc, char **argv)
 				case SDL_WINDOWEVENT_RESIZED:
 					window_width = e.window.data1;
 					window_height = e.window.data2;
-					std::cout << "Window Resized to : " << window_width << " x " << window_height << std::endl;
+					LOG_INFO(WINDOW, "Window Resized to : " << window_width << " x " << window_height);
 					scene.resize(window_width, window_height);
 					break;
 				}
@@ -317,5 +270,292 @@ int main(int argc, char **argv)
 		}
 	}
 
+	return result;
+}
+
+/**
+ * \brief Render frames of scenes offscreen and write frame time statistics as JSON
+ * \param outputFile File for the JSON results, std::cout if empty
+ */
+int runHeadless(const std::vector<std::string> &sceneNames, const SceneParameters &parameters, int frames, GLsizei width, GLsizei height, const std::string &outputFile)
+{
+	Benchmark benchmark(width, height, frames);
+	if (!benchmark.isOk())
+		return -1;
+
+	bool allOk = true;
+	for (size_t i = 0; i < sceneNames.size(); ++i)
+	{
+		std::cerr << "Benchmarking scene '" << sceneNames[i] << "'" << std::endl;
+		std::unique_ptr<Scene> scene(SceneRegistry::create(sceneNames[i], parameters));
+		Profiler::resetStatistics();
+		bool initOk;
+		{
+			PROFILE_SCOPE("init");
+			initOk = scene->init();
+		}
+		if (!initOk || !GLValidation::checkErrors())
+		{
+			std::cerr << "Unable to init scene '" << sceneNames[i] << "'" << std::endl;
+			allOk = false;
+			continue;
+		}
+
+		allOk &= benchmark.run(sceneNames[i], *scene);
+		if (Profiler::isEnabled())
+			Profiler::writeStatistics(std::cerr);
+	}
+
+	if (outputFile.empty())
+	{
+		benchmark.writeJson(std::cout);
+	} else
+	{
+		std::ofstream os(outputFile.c_str());
+		benchmark.writeJson(os);
+		if (!os.good())
+		{
+			std::cerr << "Unable to write benchmark results to '" << outputFile << "'" << std::endl;
+			return -1;
+		}
+	}
+
+	return allOk ? 0 : -1;
+}
+
+/**
+ * \brief Print registered scenes and their parameters
+ */
+void listScenes(std::ostream &os)
+{
+	const std::vector<SceneRegistry::Entry> &entries = SceneRegistry::getEntries();
+	for (size_t i = 0; i < entries.size(); ++i)
+	{
+		os << std::left << std::setw(14) << entries[i].name << entries[i].description;
+		if (!entries[i].parameters.empty())
+			os << " [" << entries[i].parameters << "]";
+		os << std::endl;
+	}
+}
+
+/**
+ * \brief Run scenes one after another in the application window
+ * \param frames Frames to render of each scene, 0 to run until the window is closed or the scene asks to stop
+ */
+int runWindowed(SDL &sdl, const std::vector<std::string> &sceneNames, const SceneParameters &parameters, int frames, Uint32 &window_width, Uint32 &window_height)
+{
+	// Test object loading
+	{
+		ObjParser obj("data/cubescene.obj");
+
+		dump_obj_info(obj);
+	}
+
+	for (size_t i = 0; i < sceneNames.size(); ++i)
+	{
+		std::unique_ptr<Scene> scene(SceneRegistry::create(sceneNames[i], parameters));
+		LOG_INFO(SCENE, "Running scene '" << sceneNames[i] << "'");
+		Profiler::resetStatistics();
+
+		bool initOk;
+		{
+			PROFILE_SCOPE("init");
+			initOk = scene->init();
+		}
+		if (!initOk)
+		{
+			std::cerr << "Unable to init scene." << std::endl;
+			return -1;
+		}
+
+		if (!GLValidation::checkErrors())
+		{
+			std::cerr << "OpenGL Errors detected during scene.init()" << std::endl;
+			return -1;
+		}
+
+		scene->resize(window_width, window_height);
+		LOG_INFO(WINDOW, "Initial width and height: " << window_width << " x " << window_height);
+
+		RunResult result = runScene(sdl.getWindow(), *scene, frames, window_width, window_height);
+		if (result == RUN_QUIT)
+			break;
+		if (result == RUN_ERROR)
+			return -1;
+	}
+
 	return 0;
 }
+
+int main(int argc, char **argv)
+{
+	// Redirect standard output and standard error streams to files.
+	// This is most useful on Windows as we don't have a console available
+#ifdef _WIN32
+	StreamRedirector streamRedirector("stdout.txt", "stderr.txt");
+#endif
+
+	// Write log messages in the background, so that printing never stalls the render loop
+	Log::Writer logWriter;
+
+	// Command line options
+	//   --scene NAME          Scene to run, see --list-scenes. Default is assignment3.
+	//   --all-scenes          Run every scene one after another. Default in headless mode.
+	//   --list-scenes         Print scene names, descriptions and parameters
+	//   --param NAME=VALUE    Scene parameter, e.g. tessellation=5, or example3.tessellation=5 for one scene only
+	//   --frames N            Frames to render of each scene. Default is until the window is closed, 1000 in headless mode.
+	//   --headless            Render frames into an offscreen framebuffer without vsync and print statistics as JSON
+	//   --output FILE         Write headless results to FILE instead of standard output
+	//   --gl-validation L     OpenGL error checking: off, sampled, frame, draw or debug (debug context). See glvalidation.h.
+	//   --gl-debug-filter R   Comma separated debug message rules such as -performance,+notification,-131185. See debugmessagecallback.cpp.
+	//   --gl-debug-sync       Synchronous debug output, messages arrive inside the offending call. Slower.
+	//   --gl-debug-rate N     Log at most N debug messages per second with the same ID, 0 for no limit. Default is 5.
+	//   --log-level SPEC      Log levels, e.g. debug or info,input=trace. Levels trace, debug, info, warning, error, off.
+	//                         Categories general, input, window, render, scene, gl (OpenGL debug messages).
+	//   --profile             Measure CPU and GPU time of profiled scopes and print statistics every few seconds
+	//   --trace FILE          Record every profiled scope and write them to FILE in Chrome trace format at exit
+	//   --shaders-from-disk   Read shaders from data/ instead of the copies built into the executable
+	//   --upload-benchmark    Measure texture upload speed of every pixel layout instead of running a scene
+	std::string sceneName;
+	bool allScenes = false;
+	SceneParameters parameters;
+	bool headless = false;
+	int frames = 0;
+	std::string outputFile;
+	bool uploadBenchmark = false;
+	bool profile = false;
+	std::string traceFile;
+	for (int i = 1; i < argc; ++i)
+	{
+		std::string arg = argv[i];
+		if (arg == "--scene" && i + 1 < argc)
+			sceneName = argv[++i];
+		else
+		if (arg == "--all-scenes")
+			allScenes = true;
+		else
+		if (arg == "--list-scenes")
+		{
+			listScenes(std::cout);
+			return 0;
+		} else
+		if (arg == "--param" && i + 1 < argc)
+		{
+			if (!parameters.parse(argv[++i]))
+			{
+				std::cerr << "Malformed parameter '" << argv[i] << "', expected NAME=VALUE" << std::endl;
+				return -1;
+			}
+		} else
+		if (arg == "--headless")
+			headless = true;
+		else
+		if (arg == "--frames" && i + 1 < argc)
+			frames = std::atoi(argv[++i]);
+		else
+		if (arg == "--output" && i + 1 < argc)
+			outputFile = argv[++i];
+		else
+		if (arg == "--gl-validation" && i + 1 < argc)
+		{
+			GLValidation::Level level;
+			if (!GLValidation::parseLevel(argv[++i], level))
+			{
+				std::cerr << "Unknown OpenGL validation level '" << argv[i] << "', expected off, sampled, frame, draw or debug" << std::endl;
+				return -1;
+			}
+			GLValidation::setLevel(level);
+		} else
+		if (arg == "--gl-debug-filter" && i + 1 < argc)
+		{
+			if (!addDebugMessageFilter(argv[++i]))
+				return -1;
+		} else
+		if (arg == "--gl-debug-sync")
+			setDebugMessageSynchronous(true);
+		else
+		if (arg == "--gl-debug-rate" && i + 1 < argc)
+			setDebugMessageRateLimit(std::max(0, std::atoi(argv[++i])));
+		else
+		if (arg == "--log-level" && i + 1 < argc)
+		{
+			if (!Log::setLevels(argv[++i]))
+				return -1;
+		} else
+		if (arg == "--profile")
+			profile = true;
+		else
+		if (arg == "--trace" && i + 1 < argc)
+			traceFile = argv[++i];
+		else
+		if (arg == "--shaders-from-disk")
+			EmbeddedShaders::setDiskOverride(true);
+		else
+		if (arg == "--upload-benchmark")
+			uploadBenchmark = true;
+		else
+		{
+			std::cerr << "Unknown option '" << arg << "'" << std::endl;
+			return -1;
+		}
+	}
+
+	// Scenes to run
+	std::vector<std::string> sceneNames;
+	if (allScenes || (headless && sceneName.empty()))
+	{
+		const std::vector<SceneRegistry::Entry> &entries = SceneRegistry::getEntries();
+		for (size_t i = 0; i < entries.size(); ++i)
+			sceneNames.push_back(entries[i].name);
+	} else
+	{
+		sceneNames.push_back(sceneName.empty() ? "assignment3" : sceneName);
+		if (!SceneRegistry::find(sceneNames[0]))
+		{
+			std::cerr << "Unknown scene '" << sceneNames[0] << "'. Available scenes:" << std::endl;
+			listScenes(std::cerr);
+			return -1;
+		}
+	}
+
+	// Initialize libSDL, create an application window and initialize it with OpenGL context
+	// See sdlwrapper.* for implementation details
+	bool enableOpenGLDebugging = GLValidation::getLevel() == GLValidation::DEBUG_CONTEXT; // Enable OpenGL debug context and install debug message callback if available
+	int ogl_major_version = 3;                                // OpenGL major version to request. See https://www.opengl.org/wiki/History_of_OpenGL
+	int ogl_minor_version = 3;                                // OpenGL minor version to request.
+	Uint32 sdl_init_flags = SDL_INIT_TIMER | SDL_INIT_VIDEO;  // What SDL subsystems to initialize. See https://wiki.libsdl.org/SDL_Init
+	std::string window_name = "CG 2018 example";              // Created window name - should be UTF-8 string for libSDL
+	Uint32 window_width = 640;                                // Initial window width
+	Uint32 window_height = 480;                               // Initial window height
+	SDL sdl(enableOpenGLDebugging, ogl_major_version, ogl_minor_version, sdl_init_flags, window_name, window_width, window_height, headless);
+
+	if (!sdl.isOk())
+	{
+		std::cerr << "Unable to initialize SDL" << std::endl;
+		return -1;
+	}
+
+	if (!GLValidation::checkErrors())
+	{
+		std::cerr << "OpenGL Errors detected during SDL initialization" << std::endl;
+		return -1;
+	}
+
+	if (uploadBenchmark)
+	{
+		UploadFormat::benchmark();
+		return GLValidation::checkErrors() ? 0 : -1;
+	}
+
+	// Profiling needs the context to find out about timer queries and debug groups
+	Profiler::setEnabled(profile);
+	Profiler::setTracing(!traceFile.empty());
+
+	int result = headless ?
+		runHeadless(sceneNames, parameters, frames > 0 ? frames : 1000, window_width, window_height, outputFile) :
+		runWindowed(sdl, sceneNames, parameters, frames, window_width, window_height);
+
+	if (!traceFile.empty() && !Profiler::writeChromeTrace(traceFile))
+		result = -1;
+	return result;
+}
@@ -0,0 +1,161 @@
+/**
+ * \brief Pixel buffer object ring implementation
+ * \file
+ */
+#include <iostream>
+#include "pixelbufferring.h"
+
+/**
+ * \brief Allocate staging buffers
+ * \param regionSize Maximum bytes per upload
+ * \param regionCount Number of uploads that may be in flight at the same time. Two or three is usually enough.
+ */
+PixelBufferRing::PixelBufferRing(GLsizeiptr regionSize, unsigned int regionCount) :
+	regionSize(regionSize),
+	current(0),
+	persistent(isPersistentMappingSupported()),
+	fences(regionCount < 1 ? 1 : regionCount, static_cast<GLsync>(0)),
+	persistentPointer(0)
+{
+	unsigned int count = static_cast<unsigned int>(fences.size());
+
+	if (persistent)
+	{
+		// Storage is allocated once and stays mapped for the lifetime of the ring.
+		// Coherent mapping makes CPU writes visible to the GPU without explicit flushes.
+		const GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+
+		buffers.resize(1);
+		glGenBuffers(1, &buffers[0]);
+		glBindBuffer(GL_PIXEL_UNPACK_BUFFER, buffers[0]);
+		glBufferStorage(GL_PIXEL_UNPACK_BUFFER, regionSize * count, 0, flags);
+		persistentPointer = glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, regionSize * count, flags);
+		glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+
+		if (persistentPointer)
+			return;
+
+		std::cerr << "PixelBufferRing: Unable to map buffer persistently, falling back to orphaning" << std::endl;
+		glDeleteBuffers(1, &buffers[0]);
+		persistent = false;
+	}
+
+	buffers.resize(count);
+	glGenBuffers(count, &buffers[0]);
+	for (unsigned int i = 0; i < count; ++i)
+	{
+		glBindBuffer(GL_PIXEL_UNPACK_BUFFER, buffers[i]);
+		glBufferData(GL_PIXEL_UNPACK_BUFFER, regionSize, 0, GL_STREAM_DRAW);
+	}
+	glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+}
+
+PixelBufferRing::~PixelBufferRing()
+{
+	for (size_t i = 0; i < fences.size(); ++i)
+	{
+		if (fences[i])
+			glDeleteSync(fences[i]);
+	}
+
+	if (persistent)
+	{
+		glBindBuffer(GL_PIXEL_UNPACK_BUFFER, buffers[0]);
+		glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+		glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+	}
+
+	glDeleteBuffers(static_cast<GLsizei>(buffers.size()), &buffers[0]);
+}
+
+/**
+ * \brief Check if persistently mapped buffers are available (OpenGL 4.4 or ARB_buffer_storage)
+ */
+bool PixelBufferRing::isPersistentMappingSupported()
+{
+	return GLEW_ARB_buffer_storage != 0;
+}
+
+/**
+ * \brief Block until the GPU has finished reading a region
+ *
+ * Normally the fence has signaled long ago as the ring has several regions.
+ */
+void PixelBufferRing::waitFence(unsigned int region)
+{
+	if (!fences[region])
+		return;
+
+	// Flush on the first wait so that the fence is guaranteed to be submitted
+	GLbitfield flags = GL_SYNC_FLUSH_COMMANDS_BIT;
+	for (;;)
+	{
+		GLenum result = glClientWaitSync(fences[region], flags, 1000000); // 1 ms
+		if (result == GL_ALREADY_SIGNALED || result == GL_CONDITION_SATISFIED || result == GL_WAIT_FAILED)
+			break;
+		flags = 0;
+	}
+
+	glDeleteSync(fences[region]);
+	fences[region] = 0;
+}
+
+/**
+ * \brief Get write access to the next region of the ring
+ *
+ * \return Pointer to regionSize bytes of write-only memory or 0 on failure
+ */
+void *PixelBufferRing::map()
+{
+	current = (current + 1) % fences.size();
+
+	if (persistent)
+	{
+		waitFence(current);
+		return static_cast<char *>(persistentPointer) + regionSize * current;
+	}
+
+	// Orphan the previous storage of this buffer. Driver keeps the old storage alive until pending
+	// transfers from it have finished, so mapping never has to wait for the GPU.
+	glBindBuffer(GL_PIXEL_UNPACK_BUFFER, buffers[current]);
+	glBufferData(GL_PIXEL_UNPACK_BUFFER, regionSize, 0, GL_STREAM_DRAW);
+	void *ptr = glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, regionSize, GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT);
+	glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+	return ptr;
+}
+
+/**
+ * \brief Finish writing the region returned by map() and bind it for unpacking
+ *
+ * \return Offset of the region to be passed as the data pointer of glTexSubImage*()
+ */
+const void *PixelBufferRing::unmap()
+{
+	if (persistent)
+	{
+		glBindBuffer(GL_PIXEL_UNPACK_BUFFER, buffers[0]);
+		return reinterpret_cast<const void *>(static_cast<size_t>(regionSize) * current);
+	}
+
+	glBindBuffer(GL_PIXEL_UNPACK_BUFFER, buffers[current]);
+	if (glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER) != GL_TRUE)
+		std::cerr << "PixelBufferRing::unmap(): Buffer contents were lost" << std::endl;
+	return 0;
+}
+
+/**
+ * \brief Mark the end of uploads from the current region and unbind the buffer
+ *
+ * Must be called after the glTexSubImage*() calls reading the region so that map() knows when it can be reused.
+ */
+void PixelBufferRing::fence()
+{
+	if (persistent)
+	{
+		if (fences[current])
+			glDeleteSync(fences[current]);
+		fences[current] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+	}
+
+	glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+}
@@ -0,0 +1,63 @@
+/**
+ * \brief Pixel buffer object ring for streaming texture uploads
+ * \file
+ */
+#ifndef PIXELBUFFERRING_H_
+#define PIXELBUFFERRING_H_
+
+#include <vector>
+#include <GL/glew.h>
+
+/**
+ * \brief Ring of GL_PIXEL_UNPACK_BUFFER regions used as staging memory for texture uploads
+ *
+ * Texture data is copied into a mapped pixel buffer and glTexSubImage*() then reads it from the buffer offset
+ * instead of client memory. The call returns immediately and the transfer runs on the GPU while the CPU fills
+ * the next region of the ring. See https://www.opengl.org/wiki/Pixel_Buffer_Object
+ *
+ * With ARB_buffer_storage a single buffer is mapped persistently and every region is protected with a fence
+ * so that data still being read by the GPU is never overwritten. Without it every region is a separate buffer
+ * which is orphaned with glBufferData() before mapping, letting the driver hand out fresh memory.
+ *
+ * Usage for each upload:
+ * \code
+ * void *dst = ring.map();
+ * memcpy(dst, pixels, size);
+ * const void *offset = ring.unmap(); // Leaves the buffer bound to GL_PIXEL_UNPACK_BUFFER
+ * glTexSubImage2D(..., offset);
+ * ring.fence();                      // Also unbinds the buffer
+ * \endcode
+ */
+class PixelBufferRing
+{
+	GLsizeiptr regionSize; // Bytes in one region
+	unsigned int current;  // Region returned by the latest map()
+	bool persistent;       // True if buffers[0] is persistently mapped
+	std::vector<GLuint> buffers; // One buffer for persistent mapping, otherwise one per region
+	std::vector<GLsync> fences;  // Fence of the last upload from each region
+	void *persistentPointer;     // Start of the persistently mapped buffer
+
+	void waitFence(unsigned int region);
+
+	PixelBufferRing(const PixelBufferRing &);
+	PixelBufferRing &operator=(const PixelBufferRing &);
+public:
+	PixelBufferRing(GLsizeiptr regionSize, unsigned int regionCount = 3);
+	~PixelBufferRing();
+
+	void *map();
+	const void *unmap();
+	void fence();
+
+	static bool isPersistentMappingSupported();
+
+	/**
+	 * \brief Size of one region in bytes
+	 */
+	GLsizeiptr getRegionSize() const
+	{
+		return regionSize;
+	}
+};
+
+#endif
@@ -0,0 +1,777 @@
+/**
+ * \brief Procedural texture generator implementation
+ * \file
+ */
+#include <thread>
+#include <atomic>
+#include <vector>
+#include <cmath>
+#include <algorithm>
+#include <glm/gtc/noise.hpp>
+#include "proceduraltexture.h"
+
+// SSE2 is always available on x86-64
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define PROCEDURALTEXTURE_SSE2
+#endif
+
+namespace
+{
+	const float PI = 3.14159265358979f;
+
+	/**
+	 * \brief Hash table of improved Perlin noise
+	 *
+	 * glm::perlin() is written like GPU code and evaluates all four corners with vector math and polynomial hashing,
+	 * which is several times slower on the CPU than the classic table lookup below.
+	 */
+	class PerlinTable
+	{
+		unsigned char permutation[512]; // Shuffled 0..255, stored twice to avoid wrapping
+
+		static const float gradientX[8];
+		static const float gradientY[8];
+
+		/**
+		 * \brief Gradient indices of the corners 00, 10, 01 and 11 of a lattice cell already wrapped to the period
+		 */
+		void getHashes(int x0, int y0, int period, int *hashes) const
+		{
+			int x1 = x0 + 1 < period ? x0 + 1 : 0;
+			int y1 = y0 + 1 < period ? y0 + 1 : 0;
+			hashes[0] = permutation[permutation[x0] + y0] & 7;
+			hashes[1] = permutation[permutation[x1] + y0] & 7;
+			hashes[2] = permutation[permutation[x0] + y1] & 7;
+			hashes[3] = permutation[permutation[x1] + y1] & 7;
+		}
+	public:
+		PerlinTable()
+		{
+			for (int i = 0; i < 256; ++i)
+				permutation[i] = static_cast<unsigned char>(i);
+
+			// Fixed seed so that textures are the same on every run
+			Uint32 seed = 1;
+			for (int i = 255; i > 0; --i)
+			{
+				seed = seed * 1664525u + 1013904223u;
+				std::swap(permutation[i], permutation[(seed >> 8) % (i + 1)]);
+			}
+			for (int i = 0; i < 256; ++i)
+				permutation[256 + i] = permutation[i];
+		}
+
+		/**
+		 * \brief Gradient noise in about [-1, 1]
+		 * \param period Lattice cells after which the noise repeats, at most 256
+		 */
+		float noise(float x, float y, int period) const
+		{
+			float floorX = std::floor(x);
+			float floorY = std::floor(y);
+			float fx = x - floorX;
+			float fy = y - floorY;
+
+			// Wrap lattice coordinates to the period, also for negative coordinates
+			int x0 = static_cast<int>(floorX) % period;
+			int y0 = static_cast<int>(floorY) % period;
+			x0 += x0 < 0 ? period : 0;
+			y0 += y0 < 0 ? period : 0;
+
+			int hashes[4];
+			getHashes(x0, y0, period, hashes);
+			int h00 = hashes[0];
+			int h10 = hashes[1];
+			int h01 = hashes[2];
+			int h11 = hashes[3];
+
+			float n00 = gradientX[h00] * fx + gradientY[h00] * fy;
+			float n10 = gradientX[h10] * (fx - 1.0f) + gradientY[h10] * fy;
+			float n01 = gradientX[h01] * fx + gradientY[h01] * (fy - 1.0f);
+			float n11 = gradientX[h11] * (fx - 1.0f) + gradientY[h11] * (fy - 1.0f);
+
+			// Quintic fade curve
+			float sx = fx * fx * fx * (fx * (fx * 6.0f - 15.0f) + 10.0f);
+			float sy = fy * fy * fy * (fy * (fy * 6.0f - 15.0f) + 10.0f);
+			float nx0 = n00 + sx * (n10 - n00);
+			float nx1 = n01 + sx * (n11 - n01);
+			return nx0 + sy * (nx1 - nx0);
+		}
+
+		/**
+		 * \brief Gradient noise of a span of coordinates, same values as noise()
+		 *
+		 * With SSE2, four values are computed at once. Only the hash lookups are done one lane at a time.
+		 */
+		void noise(const float *x, const float *y, int count, int period, float *out) const
+		{
+			int i = 0;
+#ifdef PROCEDURALTEXTURE_SSE2
+			const __m128i periods = _mm_set1_epi32(period);
+			const __m128i zero = _mm_setzero_si128();
+			const __m128 one = _mm_set1_ps(1.0f);
+			int cellX = -1; // Lattice cell of cellGradients
+			int cellY = -1;
+			__m128 cellGradients[8];
+			for (int j = 0; j < 8; ++j)
+				cellGradients[j] = _mm_setzero_ps();
+			for (; i + 4 <= count; i += 4)
+			{
+				__m128 px = _mm_loadu_ps(x + i);
+				__m128 py = _mm_loadu_ps(y + i);
+
+				// Floor: truncation rounds negative values up, subtract one there (the mask is -1)
+				__m128i ix = _mm_cvttps_epi32(px);
+				__m128i iy = _mm_cvttps_epi32(py);
+				ix = _mm_add_epi32(ix, _mm_castps_si128(_mm_cmplt_ps(px, _mm_cvtepi32_ps(ix))));
+				iy = _mm_add_epi32(iy, _mm_castps_si128(_mm_cmplt_ps(py, _mm_cvtepi32_ps(iy))));
+				__m128 fx = _mm_sub_ps(px, _mm_cvtepi32_ps(ix));
+				__m128 fy = _mm_sub_ps(py, _mm_cvtepi32_ps(iy));
+
+				// Wrap to the period by one addition or subtraction. Coordinates further out, e.g. far warps, are rare
+				// and computed one at a time.
+				ix = _mm_add_epi32(ix, _mm_and_si128(_mm_cmplt_epi32(ix, zero), periods));
+				iy = _mm_add_epi32(iy, _mm_and_si128(_mm_cmplt_epi32(iy, zero), periods));
+				ix = _mm_sub_epi32(ix, _mm_andnot_si128(_mm_cmplt_epi32(ix, periods), periods));
+				iy = _mm_sub_epi32(iy, _mm_andnot_si128(_mm_cmplt_epi32(iy, periods), periods));
+				__m128i negative = _mm_or_si128(_mm_cmplt_epi32(ix, zero), _mm_cmplt_epi32(iy, zero));
+				__m128i inside = _mm_and_si128(_mm_cmplt_epi32(ix, periods), _mm_cmplt_epi32(iy, periods));
+				if (_mm_movemask_epi8(_mm_andnot_si128(negative, inside)) != 0xffff)
+				{
+					for (int lane = 0; lane < 4; ++lane)
+						out[i + lane] = noise(x[i + lane], y[i + lane], period);
+					continue;
+				}
+
+				// Gradients of the four corners. Neighboring texels are usually in the same lattice cell, so the
+				// gradients of the previous cell are reused if all lanes are in it.
+				__m128 g[8]; // x and y of corners 00, 10, 01, 11
+				int cx = _mm_cvtsi128_si32(ix);
+				int cy = _mm_cvtsi128_si32(iy);
+				__m128i sameCell = _mm_and_si128(_mm_cmpeq_epi32(ix, _mm_set1_epi32(cx)), _mm_cmpeq_epi32(iy, _mm_set1_epi32(cy)));
+				if (_mm_movemask_epi8(sameCell) == 0xffff)
+				{
+					if (cx != cellX || cy != cellY)
+					{
+						cellX = cx;
+						cellY = cy;
+						int hashes[4];
+						getHashes(cx, cy, period, hashes);
+						for (int corner = 0; corner < 4; ++corner)
+						{
+							cellGradients[2 * corner] = _mm_set1_ps(gradientX[hashes[corner]]);
+							cellGradients[2 * corner + 1] = _mm_set1_ps(gradientY[hashes[corner]]);
+						}
+					}
+					for (int j = 0; j < 8; ++j)
+						g[j] = cellGradients[j];
+				} else
+				{
+					int x0[4], y0[4];
+					_mm_storeu_si128(reinterpret_cast<__m128i *>(x0), ix);
+					_mm_storeu_si128(reinterpret_cast<__m128i *>(y0), iy);
+					float gradients[8][4];
+					for (int lane = 0; lane < 4; ++lane)
+					{
+						int hashes[4];
+						getHashes(x0[lane], y0[lane], period, hashes);
+						for (int corner = 0; corner < 4; ++corner)
+						{
+							gradients[2 * corner][lane] = gradientX[hashes[corner]];
+							gradients[2 * corner + 1][lane] = gradientY[hashes[corner]];
+						}
+					}
+					for (int j = 0; j < 8; ++j)
+						g[j] = _mm_loadu_ps(gradients[j]);
+				}
+
+				__m128 fx1 = _mm_sub_ps(fx, one);
+				__m128 fy1 = _mm_sub_ps(fy, one);
+				__m128 n00 = _mm_add_ps(_mm_mul_ps(g[0], fx), _mm_mul_ps(g[1], fy));
+				__m128 n10 = _mm_add_ps(_mm_mul_ps(g[2], fx1), _mm_mul_ps(g[3], fy));
+				__m128 n01 = _mm_add_ps(_mm_mul_ps(g[4], fx), _mm_mul_ps(g[5], fy1));
+				__m128 n11 = _mm_add_ps(_mm_mul_ps(g[6], fx1), _mm_mul_ps(g[7], fy1));
+
+				// Quintic fade curve
+				const __m128 six = _mm_set1_ps(6.0f);
+				const __m128 fifteen = _mm_set1_ps(15.0f);
+				const __m128 ten = _mm_set1_ps(10.0f);
+				__m128 sx = _mm_mul_ps(_mm_mul_ps(_mm_mul_ps(fx, fx), fx), _mm_add_ps(_mm_mul_ps(fx, _mm_sub_ps(_mm_mul_ps(fx, six), fifteen)), ten));
+				__m128 sy = _mm_mul_ps(_mm_mul_ps(_mm_mul_ps(fy, fy), fy), _mm_add_ps(_mm_mul_ps(fy, _mm_sub_ps(_mm_mul_ps(fy, six), fifteen)), ten));
+				__m128 nx0 = _mm_add_ps(n00, _mm_mul_ps(sx, _mm_sub_ps(n10, n00)));
+				__m128 nx1 = _mm_add_ps(n01, _mm_mul_ps(sx, _mm_sub_ps(n11, n01)));
+				_mm_storeu_ps(out + i, _mm_add_ps(nx0, _mm_mul_ps(sy, _mm_sub_ps(nx1, nx0))));
+			}
+#endif
+			for (; i < count; ++i)
+				out[i] = noise(x[i], y[i], period);
+		}
+	};
+
+	const float PerlinTable::gradientX[8] = {1.0f, -1.0f, 1.0f, -1.0f, 1.0f, -1.0f, 0.0f, 0.0f};
+	const float PerlinTable::gradientY[8] = {1.0f, 1.0f, -1.0f, -1.0f, 0.0f, 0.0f, 1.0f, -1.0f};
+
+	const PerlinTable perlinTable;
+
+	class ConstantNode : public ProceduralTexture::Node
+	{
+		float value;
+	public:
+		ConstantNode(float value) : value(value) {}
+
+		void evaluate(const float *, const float *, int count, float *out) const
+		{
+			for (int i = 0; i < count; ++i)
+				out[i] = value;
+		}
+	};
+
+	class LinearGradientNode : public ProceduralTexture::Node
+	{
+		glm::vec2 from;
+		glm::vec2 direction; // Scaled so that the value is 1 at the end point
+	public:
+		LinearGradientNode(const glm::vec2 &from, const glm::vec2 &to) :
+			from(from),
+			direction(to - from)
+		{
+			float length2 = glm::dot(direction, direction);
+			if (length2 > 0.0f)
+				direction /= length2;
+		}
+
+		void evaluate(const float *u, const float *v, int count, float *out) const
+		{
+			for (int i = 0; i < count; ++i)
+				out[i] = (u[i] - from.x) * direction.x + (v[i] - from.y) * direction.y;
+		}
+	};
+
+	class RadialGradientNode : public ProceduralTexture::Node
+	{
+		glm::vec2 center;
+		float invRadius;
+	public:
+		RadialGradientNode(const glm::vec2 &center, float radius) :
+			center(center),
+			invRadius(radius > 0.0f ? 1.0f / radius : 0.0f)
+		{
+		}
+
+		void evaluate(const float *u, const float *v, int count, float *out) const
+		{
+			for (int i = 0; i < count; ++i)
+			{
+				float du = u[i] - center.x;
+				float dv = v[i] - center.y;
+				out[i] = std::sqrt(du * du + dv * dv) * invRadius;
+			}
+		}
+	};
+
+	class CheckerNode : public ProceduralTexture::Node
+	{
+		float cellsX;
+		float cellsY;
+	public:
+		CheckerNode(int cellsX, int cellsY) :
+			cellsX(static_cast<float>(cellsX)),
+			cellsY(static_cast<float>(cellsY))
+		{
+		}
+
+		void evaluate(const float *u, const float *v, int count, float *out) const
+		{
+			for (int i = 0; i < count; ++i)
+			{
+				int cell = static_cast<int>(std::floor(u[i] * cellsX)) + static_cast<int>(std::floor(v[i] * cellsY));
+				out[i] = static_cast<float>(cell & 1);
+			}
+		}
+	};
+
+	/**
+	 * \brief Sum of noise octaves
+	 *
+	 * A single octave without absolute values is plain Perlin or simplex noise.
+	 */
+	class NoiseNode : public ProceduralTexture::Node
+	{
+		int octaves;
+		float frequency;
+		float gain;
+		bool tileable;  // Use periodic Perlin noise. Frequency is rounded to whole periods per texture, at most 256.
+		bool simplex;
+		bool absolute;  // Turbulence: sum of absolute values
+		glm::vec2 offset;
+		float normalize; // 1 / sum of amplitudes
+	public:
+		NoiseNode(int octaves, float frequency, float gain, bool tileable, bool simplex, bool absolute, const glm::vec2 &offset) :
+			octaves(std::max(1, octaves)),
+			frequency(tileable ? std::max(1.0f, std::floor(frequency + 0.5f)) : frequency),
+			gain(gain),
+			tileable(tileable && !simplex),
+			simplex(simplex),
+			absolute(absolute),
+			offset(offset)
+		{
+			float amplitude = 1.0f;
+			float sum = 0.0f;
+			for (int octave = 0; octave < this->octaves; ++octave)
+			{
+				sum += amplitude;
+				amplitude *= gain;
+			}
+			normalize = 1.0f / sum;
+		}
+
+		void evaluate(const float *u, const float *v, int count, float *out) const
+		{
+			float x[ProceduralTexture::TILE_SIZE]; // Noise coordinates of the octave
+			float y[ProceduralTexture::TILE_SIZE];
+			float n[ProceduralTexture::TILE_SIZE];
+			for (int i = 0; i < count; ++i)
+				out[i] = 0.0f;
+
+			float amplitude = normalize;
+			float f = frequency;
+			for (int octave = 0; octave < octaves; ++octave)
+			{
+				int period = tileable ? std::min(static_cast<int>(f), 256) : 256;
+				if (simplex)
+				{
+					for (int i = 0; i < count; ++i)
+						n[i] = glm::simplex(glm::vec2(u[i] * f + offset.x, v[i] * f + offset.y));
+				} else
+				{
+					for (int i = 0; i < count; ++i)
+					{
+						x[i] = u[i] * f + offset.x;
+						y[i] = v[i] * f + offset.y;
+					}
+					perlinTable.noise(x, y, count, period, n);
+				}
+
+				if (absolute)
+				{
+					for (int i = 0; i < count; ++i)
+						out[i] += amplitude * std::fabs(n[i]);
+				} else
+				{
+					for (int i = 0; i < count; ++i)
+						out[i] += amplitude * n[i];
+				}
+				amplitude *= gain;
+				f *= 2.0f;
+			}
+
+			// Noise is in [-1, 1], map it to [0, 1]. Turbulence already is.
+			if (!absolute)
+			{
+				for (int i = 0; i < count; ++i)
+					out[i] = 0.5f + 0.5f * out[i];
+			}
+		}
+	};
+
+	class AddNode : public ProceduralTexture::Node
+	{
+		ProceduralTexture::Field a, b;
+	public:
+		AddNode(const ProceduralTexture::Field &a, const ProceduralTexture::Field &b) : a(a), b(b) {}
+
+		void evaluate(const float *u, const float *v, int count, float *out) const
+		{
+			float tmp[ProceduralTexture::TILE_SIZE];
+			a->evaluate(u, v, count, out);
+			b->evaluate(u, v, count, tmp);
+			for (int i = 0; i < count; ++i)
+				out[i] += tmp[i];
+		}
+	};
+
+	class MultiplyNode : public ProceduralTexture::Node
+	{
+		ProceduralTexture::Field a, b;
+	public:
+		MultiplyNode(const ProceduralTexture::Field &a, const ProceduralTexture::Field &b) : a(a), b(b) {}
+
+		void evaluate(const float *u, const float *v, int count, float *out) const
+		{
+			float tmp[ProceduralTexture::TILE_SIZE];
+			a->evaluate(u, v, count, out);
+			b->evaluate(u, v, count, tmp);
+			for (int i = 0; i < count; ++i)
+				out[i] *= tmp[i];
+		}
+	};
+
+	class MixNode : public ProceduralTexture::Node
+	{
+		ProceduralTexture::Field a, b, t;
+	public:
+		MixNode(const ProceduralTexture::Field &a, const ProceduralTexture::Field &b, const ProceduralTexture::Field &t) : a(a), b(b), t(t) {}
+
+		void evaluate(const float *u, const float *v, int count, float *out) const
+		{
+			float tmpB[ProceduralTexture::TILE_SIZE];
+			float tmpT[ProceduralTexture::TILE_SIZE];
+			a->evaluate(u, v, count, out);
+			b->evaluate(u, v, count, tmpB);
+			t->evaluate(u, v, count, tmpT);
+			for (int i = 0; i < count; ++i)
+				out[i] += (tmpB[i] - out[i]) * tmpT[i];
+		}
+	};
+
+	class ScaleBiasNode : public ProceduralTexture::Node
+	{
+		ProceduralTexture::Field a;
+		float scale, bias;
+	public:
+		ScaleBiasNode(const ProceduralTexture::Field &a, float scale, float bias) : a(a), scale(scale), bias(bias) {}
+
+		void evaluate(const float *u, const float *v, int count, float *out) const
+		{
+			a->evaluate(u, v, count, out);
+			for (int i = 0; i < count; ++i)
+				out[i] = out[i] * scale + bias;
+		}
+	};
+
+	class ClampNode : public ProceduralTexture::Node
+	{
+		ProceduralTexture::Field a;
+		float minValue, maxValue;
+	public:
+		ClampNode(const ProceduralTexture::Field &a, float minValue, float maxValue) : a(a), minValue(minValue), maxValue(maxValue) {}
+
+		void evaluate(const float *u, const float *v, int count, float *out) const
+		{
+			a->evaluate(u, v, count, out);
+			for (int i = 0; i < count; ++i)
+				out[i] = std::min(std::max(out[i], minValue), maxValue);
+		}
+	};
+
+	class SmoothstepNode : public ProceduralTexture::Node
+	{
+		ProceduralTexture::Field a;
+		float edge0, invRange;
+	public:
+		SmoothstepNode(const ProceduralTexture::Field &a, float edge0, float edge1) :
+			a(a),
+			edge0(edge0),
+			invRange(edge1 != edge0 ? 1.0f / (edge1 - edge0) : 0.0f)
+		{
+		}
+
+		void evaluate(const float *u, const float *v, int count, float *out) const
+		{
+			a->evaluate(u, v, count, out);
+			for (int i = 0; i < count; ++i)
+			{
+				float t = std::min(std::max((out[i] - edge0) * invRange, 0.0f), 1.0f);
+				out[i] = t * t * (3.0f - 2.0f * t);
+			}
+		}
+	};
+
+	class SineNode : public ProceduralTexture::Node
+	{
+		ProceduralTexture::Field a;
+	public:
+		SineNode(const ProceduralTexture::Field &a) : a(a) {}
+
+		void evaluate(const float *u, const float *v, int count, float *out) const
+		{
+			a->evaluate(u, v, count, out);
+			for (int i = 0; i < count; ++i)
+				out[i] = 0.5f + 0.5f * std::sin(2.0f * PI * out[i]);
+		}
+	};
+
+	class WarpNode : public ProceduralTexture::Node
+	{
+		ProceduralTexture::Field a, offsetU, offsetV;
+		float amount;
+	public:
+		WarpNode(const ProceduralTexture::Field &a, const ProceduralTexture::Field &offsetU, const ProceduralTexture::Field &offsetV, float amount) :
+			a(a), offsetU(offsetU), offsetV(offsetV), amount(amount)
+		{
+		}
+
+		void evaluate(const float *u, const float *v, int count, float *out) const
+		{
+			float warpedU[ProceduralTexture::TILE_SIZE];
+			float warpedV[ProceduralTexture::TILE_SIZE];
+			offsetU->evaluate(u, v, count, warpedU);
+			offsetV->evaluate(u, v, count, warpedV);
+			for (int i = 0; i < count; ++i)
+			{
+				// Offsets are centered around 0.5 like noise values
+				warpedU[i] = u[i] + amount * (warpedU[i] - 0.5f);
+				warpedV[i] = v[i] + amount * (warpedV[i] - 0.5f);
+			}
+			a->evaluate(warpedU, warpedV, count, out);
+		}
+	};
+
+	/**
+	 * \brief Work shared by the generator threads
+	 */
+	struct Job
+	{
+		ProceduralTexture::Field channels[4]; // Red, green, blue and alpha, or only channels[0] with a color map
+		bool colorMap;
+		glm::vec4 color0, color1;
+		Uint8 *pixels;
+		int pitch;
+		int width, height;
+		int tilesX, tileCount;
+		std::atomic<int> nextTile;
+	};
+
+	/**
+	 * \brief Convert [0, 1] value to an 8-bit channel
+	 */
+	inline Uint32 toByte(float value)
+	{
+		return static_cast<Uint32>(std::min(std::max(value, 0.0f), 1.0f) * 255.0f + 0.5f);
+	}
+
+	void generateTiles(Job *job)
+	{
+		float u[ProceduralTexture::TILE_SIZE];
+		float v[ProceduralTexture::TILE_SIZE];
+		float values[4][ProceduralTexture::TILE_SIZE];
+
+		for (int tile = job->nextTile++; tile < job->tileCount; tile = job->nextTile++)
+		{
+			int x0 = (tile % job->tilesX) * ProceduralTexture::TILE_SIZE;
+			int y0 = (tile / job->tilesX) * ProceduralTexture::TILE_SIZE;
+			int count = std::min(ProceduralTexture::TILE_SIZE, job->width - x0);
+			int y1 = std::min(y0 + ProceduralTexture::TILE_SIZE, job->height);
+
+			// Sample at texel centers
+			for (int i = 0; i < count; ++i)
+				u[i] = (x0 + i + 0.5f) / job->width;
+
+			for (int y = y0; y < y1; ++y)
+			{
+				std::fill(v, v + count, (y + 0.5f) / job->height);
+
+				Uint32 *row = reinterpret_cast<Uint32 *>(job->pixels + y * job->pitch) + x0;
+				if (job->colorMap)
+				{
+					job->channels[0]->evaluate(u, v, count, values[0]);
+					for (int i = 0; i < count; ++i)
+					{
+						float t = std::min(std::max(values[0][i], 0.0f), 1.0f);
+						glm::vec4 color = job->color0 + (job->color1 - job->color0) * t;
+						row[i] = (toByte(color.r) << 24) | (toByte(color.g) << 16) | (toByte(color.b) << 8) | toByte(color.a);
+					}
+				} else
+				{
+					for (int c = 0; c < 4; ++c)
+						job->channels[c]->evaluate(u, v, count, values[c]);
+					for (int i = 0; i < count; ++i)
+						row[i] = (toByte(values[0][i]) << 24) | (toByte(values[1][i]) << 16) | (toByte(values[2][i]) << 8) | toByte(values[3][i]);
+				}
+			}
+		}
+	}
+
+	/**
+	 * \brief Evaluate all tiles of a job and upload the texture
+	 */
+	bool run(Texture &texture, Job &job, unsigned int threads)
+	{
+		job.pixels = reinterpret_cast<Uint8 *>(texture.lockPixels(job.pitch));
+		if (!job.pixels)
+		{
+			std::cerr << "ProceduralTexture::generate(): Texture has no software buffer" << std::endl;
+			return false;
+		}
+
+		job.width = texture.getWidth();
+		job.height = texture.getHeight();
+		job.tilesX = (job.width + ProceduralTexture::TILE_SIZE - 1) / ProceduralTexture::TILE_SIZE;
+		job.tileCount = job.tilesX * ((job.height + ProceduralTexture::TILE_SIZE - 1) / ProceduralTexture::TILE_SIZE);
+		job.nextTile = 0;
+
+		if (threads == 0)
+			threads = std::max(1u, std::thread::hardware_concurrency());
+		threads = std::min(threads, static_cast<unsigned int>(std::max(1, job.tileCount)));
+
+		// Calling thread works too
+		std::vector<std::thread> workers;
+		for (unsigned int i = 1; i < threads; ++i)
+			workers.push_back(std::thread(generateTiles, &job));
+		generateTiles(&job);
+		for (size_t i = 0; i < workers.size(); ++i)
+			workers[i].join();
+
+		texture.unlockPixels();
+		texture.updateGLTexture();
+		return true;
+	}
+}
+
+/**
+ * \brief Same value everywhere
+ */
+ProceduralTexture::Field ProceduralTexture::constant(float value)
+{
+	return Field(new ConstantNode(value));
+}
+
+/**
+ * \brief Value 0 at from increasing linearly to 1 at to, continues outside the range
+ */
+ProceduralTexture::Field ProceduralTexture::linearGradient(const glm::vec2 &from, const glm::vec2 &to)
+{
+	return Field(new LinearGradientNode(from, to));
+}
+
+/**
+ * \brief Distance from center, 1 at radius
+ */
+ProceduralTexture::Field ProceduralTexture::radialGradient(const glm::vec2 &center, float radius)
+{
+	return Field(new RadialGradientNode(center, radius));
+}
+
+/**
+ * \brief Alternating 0 and 1 cells, 0 at the lower left corner
+ */
+ProceduralTexture::Field ProceduralTexture::checker(int cellsX, int cellsY)
+{
+	return Field(new CheckerNode(cellsX, cellsY));
+}
+
+/**
+ * \brief Perlin noise in [0, 1]
+ * \param frequency Noise cells across the texture
+ * \param tileable Wrap around the texture edges seamlessly. Frequency is rounded to a whole number.
+ * \param offset Translation of the noise, different offsets give different patterns
+ */
+ProceduralTexture::Field ProceduralTexture::perlin(float frequency, bool tileable, const glm::vec2 &offset)
+{
+	return Field(new NoiseNode(1, frequency, 1.0f, tileable, false, false, offset));
+}
+
+/**
+ * \brief Simplex noise in [0, 1]. Does not tile.
+ */
+ProceduralTexture::Field ProceduralTexture::simplex(float frequency, const glm::vec2 &offset)
+{
+	return Field(new NoiseNode(1, frequency, 1.0f, false, true, false, offset));
+}
+
+/**
+ * \brief Fractal Brownian motion: octaves of Perlin noise, each with double frequency and gain times the amplitude
+ */
+ProceduralTexture::Field ProceduralTexture::fbm(int octaves, float frequency, float gain, bool tileable)
+{
+	return Field(new NoiseNode(octaves, frequency, gain, tileable, false, false, glm::vec2(0.0f)));
+}
+
+/**
+ * \brief Like fbm() but sums absolute noise values, giving sharp creases
+ */
+ProceduralTexture::Field ProceduralTexture::turbulence(int octaves, float frequency, float gain, bool tileable)
+{
+	return Field(new NoiseNode(octaves, frequency, gain, tileable, false, true, glm::vec2(0.0f)));
+}
+
+ProceduralTexture::Field ProceduralTexture::add(const Field &a, const Field &b)
+{
+	return Field(new AddNode(a, b));
+}
+
+ProceduralTexture::Field ProceduralTexture::multiply(const Field &a, const Field &b)
+{
+	return Field(new MultiplyNode(a, b));
+}
+
+/**
+ * \brief Linear interpolation from a to b by t
+ */
+ProceduralTexture::Field ProceduralTexture::mix(const Field &a, const Field &b, const Field &t)
+{
+	return Field(new MixNode(a, b, t));
+}
+
+/**
+ * \brief a * scale + bias
+ */
+ProceduralTexture::Field ProceduralTexture::scaleBias(const Field &a, float scale, float bias)
+{
+	return Field(new ScaleBiasNode(a, scale, bias));
+}
+
+ProceduralTexture::Field ProceduralTexture::clamp(const Field &a, float minValue, float maxValue)
+{
+	return Field(new ClampNode(a, minValue, maxValue));
+}
+
+/**
+ * \brief Smooth Hermite step from 0 at edge0 to 1 at edge1, like GLSL smoothstep()
+ */
+ProceduralTexture::Field ProceduralTexture::smoothstep(const Field &a, float edge0, float edge1)
+{
+	return Field(new SmoothstepNode(a, edge0, edge1));
+}
+
+/**
+ * \brief Sine wave in [0, 1] with one period for every unit of a. Gives bands from gradients.
+ */
+ProceduralTexture::Field ProceduralTexture::sine(const Field &a)
+{
+	return Field(new SineNode(a));
+}
+
+/**
+ * \brief Sample a at coordinates displaced by two other fields
+ * \param amount Displacement in texture coordinates for offset values of 0 and 1, 0.5 is no displacement
+ */
+ProceduralTexture::Field ProceduralTexture::warp(const Field &a, const Field &offsetU, const Field &offsetV, float amount)
+{
+	return Field(new WarpNode(a, offsetU, offsetV, amount));
+}
+
+/**
+ * \brief Fill a texture with a field mapped between two colors and upload it
+ * \param texture Texture to overwrite, for example created with Texture(int width, int height)
+ * \param value Field selecting the color, clamped to [0, 1]
+ * \param color0 RGBA color for value 0
+ * \param color1 RGBA color for value 1
+ * \param threads Number of threads to use. 0 uses one for each CPU core.
+ * \return false if the texture has no image
+ */
+bool ProceduralTexture::generate(Texture &texture, const Field &value, const glm::vec4 &color0, const glm::vec4 &color1, unsigned int threads)
+{
+	Job job;
+	job.channels[0] = value;
+	job.colorMap = true;
+	job.color0 = color0;
+	job.color1 = color1;
+	return run(texture, job, threads);
+}
+
+/**
+ * \brief Fill a texture with separate fields for every channel and upload it
+ * \return false if the texture has no image
+ */
+bool ProceduralTexture::generate(Texture &texture, const Field &red, const Field &green, const Field &blue, const Field &alpha, unsigned int threads)
+{
+	Job job;
+	job.channels[0] = red;
+	job.channels[1] = green;
+	job.channels[2] = blue;
+	job.channels[3] = alpha;
+	job.colorMap = false;
+	return run(texture, job, threads);
+}
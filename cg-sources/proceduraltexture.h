@@ -0,0 +1,83 @@
+/**
+ * \brief Procedural texture generator interface
+ * \file
+ */
+#ifndef PROCEDURALTEXTURE_H_
+#define PROCEDURALTEXTURE_H_
+
+#include <memory>
+#include <glm/glm.hpp>
+#include "texture.h"
+
+/**
+ * \brief Generates Texture contents from composable scalar fields
+ *
+ * A field maps texture coordinates (u, v) in [0, 1] to a value, usually also in [0, 1]. v = 0 is the bottom of
+ * the image like in OpenGL. Fields are built from generators (noise, gradients, checkers) and combined with
+ * operators, for example a marble pattern:
+ * \code
+ * ProceduralTexture::Field marble = ProceduralTexture::sine(
+ *     ProceduralTexture::add(ProceduralTexture::linearGradient(glm::vec2(0.0f), glm::vec2(0.1f, 0.0f)),
+ *                            ProceduralTexture::scaleBias(ProceduralTexture::turbulence(5, 4.0f), 0.5f, 0.0f)));
+ * Texture texture(4096, 4096);
+ * ProceduralTexture::generate(texture, marble, glm::vec4(0.2f, 0.2f, 0.25f, 1.0f), glm::vec4(0.9f, 0.9f, 0.85f, 1.0f));
+ * \endcode
+ *
+ * The image is split into tiles of TILE_SIZE x TILE_SIZE texels which worker threads evaluate in parallel one row
+ * span at a time. Spans are processed with plain loops over float arrays so that the compiler can vectorize the
+ * operators. Perlin noise, the bulk of the work, is evaluated four texels at a time with SSE2 and looks up the
+ * gradients of a lattice cell once for all texels in it. Results are written directly into the Texture software
+ * buffer and uploaded once at the end.
+ */
+class ProceduralTexture
+{
+public:
+	static const int TILE_SIZE = 64; ///< Width of the spans evaluated at once
+
+	/**
+	 * \brief Node of a field expression
+	 */
+	class Node
+	{
+	public:
+		virtual ~Node() {}
+
+		/**
+		 * \brief Evaluate a span of values
+		 *
+		 * Called concurrently from several threads so it must not modify the node.
+		 * \param u Horizontal texture coordinates
+		 * \param v Vertical texture coordinates
+		 * \param count Number of values, at most TILE_SIZE
+		 * \param out Result values
+		 */
+		virtual void evaluate(const float *u, const float *v, int count, float *out) const = 0;
+	};
+
+	typedef std::shared_ptr<const Node> Field;
+
+	// Generators
+	static Field constant(float value);
+	static Field linearGradient(const glm::vec2 &from, const glm::vec2 &to);
+	static Field radialGradient(const glm::vec2 &center, float radius);
+	static Field checker(int cellsX, int cellsY);
+	static Field perlin(float frequency, bool tileable = true, const glm::vec2 &offset = glm::vec2(0.0f));
+	static Field simplex(float frequency, const glm::vec2 &offset = glm::vec2(0.0f));
+	static Field fbm(int octaves, float frequency, float gain = 0.5f, bool tileable = true);
+	static Field turbulence(int octaves, float frequency, float gain = 0.5f, bool tileable = true);
+
+	// Operators
+	static Field add(const Field &a, const Field &b);
+	static Field multiply(const Field &a, const Field &b);
+	static Field mix(const Field &a, const Field &b, const Field &t);
+	static Field scaleBias(const Field &a, float scale, float bias);
+	static Field clamp(const Field &a, float minValue = 0.0f, float maxValue = 1.0f);
+	static Field smoothstep(const Field &a, float edge0, float edge1);
+	static Field sine(const Field &a);
+	static Field warp(const Field &a, const Field &offsetU, const Field &offsetV, float amount);
+
+	static bool generate(Texture &texture, const Field &value, const glm::vec4 &color0, const glm::vec4 &color1, unsigned int threads = 0);
+	static bool generate(Texture &texture, const Field &red, const Field &green, const Field &blue, const Field &alpha, unsigned int threads = 0);
+};
+
+#endif
@@ -0,0 +1,426 @@
+/**
+ * \brief CPU and GPU scope timing implementation
+ * \file
+ */
+#include <iostream>
+#include <fstream>
+#include <iomanip>
+#include <algorithm>
+#include <cstdio>
+#include "profiler.h"
+#include "log.h"
+
+namespace
+{
+	const size_t MAX_TRACE_EVENTS = 1 << 20;
+	const char *FRAME_SCOPE = "frame";
+	const size_t ROW_LENGTH = 128; // Characters of a statistics row at most
+	const char *HEADER_FORMAT = "%-20s%8s%12s%10s%12s%10s";
+
+	double ticksToMilliseconds(Uint64 ticks)
+	{
+		return ticks * 1000.0 / SDL_GetPerformanceFrequency();
+	}
+
+	void writeJsonString(std::ostream &os, const char *text)
+	{
+		os << '"';
+		for (; *text; ++text)
+		{
+			if (*text == '"' || *text == '\\')
+				os << '\\';
+			if (static_cast<unsigned char>(*text) >= 32)
+				os << *text;
+		}
+		os << '"';
+	}
+}
+
+bool Profiler::enabled = false;
+bool Profiler::tracing = false;
+bool Profiler::timerQueries = false;
+bool Profiler::debugGroups = false;
+bool Profiler::inFrame = false;
+unsigned long long Profiler::frame = 0;
+Uint64 Profiler::frameStart = 0;
+Uint64 Profiler::traceStart = 0;
+double Profiler::gpuClockOffset = 0.0;
+bool Profiler::gpuClockSynced = false;
+std::vector<Profiler::OpenScope> Profiler::openScopes;
+std::vector<Profiler::GpuScope> Profiler::pendingScopes[Profiler::LATENCY];
+std::vector<GLuint> Profiler::freeQueries;
+std::map<const char *, Profiler::ScopeStatistics, Profiler::NameLess> Profiler::statistics;
+std::vector<Profiler::TraceEvent> Profiler::traceEvents;
+
+void Profiler::History::add(double value)
+{
+	if (samples.size() < HISTORY)
+	{
+		samples.push_back(value);
+		return;
+	}
+	samples[next] = value;
+	next = (next + 1) % HISTORY;
+}
+
+double Profiler::History::getMean() const
+{
+	double sum = 0.0;
+	for (size_t i = 0; i < samples.size(); ++i)
+		sum += samples[i];
+	return samples.empty() ? 0.0 : sum / samples.size();
+}
+
+double Profiler::History::getMax() const
+{
+	double maximum = 0.0;
+	for (size_t i = 0; i < samples.size(); ++i)
+		maximum = std::max(maximum, samples[i]);
+	return maximum;
+}
+
+/**
+ * \brief Start or stop measuring. Needs a current OpenGL context for GPU scopes.
+ */
+void Profiler::setEnabled(bool enable)
+{
+	enabled = enable;
+	if (!enable)
+		return;
+
+	timerQueries = GLEW_VERSION_3_3 || GLEW_ARB_timer_query;
+	debugGroups = GLEW_VERSION_4_3 || GLEW_KHR_debug;
+	if (!traceStart)
+		traceStart = SDL_GetPerformanceCounter();
+}
+
+/**
+ * \brief Keep every scope for writeChromeTrace(). Also enables the profiler.
+ */
+void Profiler::setTracing(bool enable)
+{
+	tracing = enable;
+	if (enable)
+		setEnabled(true);
+}
+
+/**
+ * \brief Start measuring a frame. Reads GPU results of the frame LATENCY frames ago.
+ */
+void Profiler::beginFrame()
+{
+	if (!enabled)
+		return;
+	if (inFrame)
+		endFrame();
+
+	++frame;
+	inFrame = true;
+
+	// Queries of this slot were issued LATENCY frames ago and are done by now in practice
+	resolveGpuScopes(frame % LATENCY);
+
+	// Match the GPU clock to the CPU clock once for the trace time line
+	if (timerQueries && !gpuClockSynced)
+	{
+		GLint64 gpuTime = 0;
+		glGetInteger64v(GL_TIMESTAMP, &gpuTime);
+		gpuClockOffset = getTraceTime(SDL_GetPerformanceCounter()) - gpuTime / 1000.0;
+		gpuClockSynced = true;
+	}
+
+	frameStart = SDL_GetPerformanceCounter();
+}
+
+/**
+ * \brief Finish the frame started with beginFrame() and add its CPU times to the statistics
+ */
+void Profiler::endFrame()
+{
+	if (!enabled || !inFrame)
+		return;
+
+	if (!openScopes.empty())
+	{
+		std::cerr << "Profiler::endFrame(): Scope '" << openScopes.back().name << "' still open" << std::endl;
+		while (!openScopes.empty())
+			endScope();
+	}
+
+	Uint64 end = SDL_GetPerformanceCounter();
+	ScopeStatistics &frameStatistics = statistics[FRAME_SCOPE];
+	frameStatistics.cpuFrame += ticksToMilliseconds(end - frameStart);
+	++frameStatistics.callsFrame;
+	if (tracing)
+		addTraceEvent(FRAME_SCOPE, getTraceTime(frameStart), ticksToMilliseconds(end - frameStart) * 1000.0, false);
+
+	// Scopes not entered during the frame get zero so that means are per frame
+	std::map<const char *, ScopeStatistics, NameLess>::iterator it;
+	for (it = statistics.begin(); it != statistics.end(); ++it)
+	{
+		it->second.cpu.add(it->second.cpuFrame);
+		it->second.calls.add(it->second.callsFrame);
+		it->second.cpuFrame = 0.0;
+		it->second.callsFrame = 0;
+	}
+
+	inFrame = false;
+}
+
+/**
+ * \brief Start a scope, usually through ProfileScope
+ * \param gpu Also measure GPU time and push a debug group. Outside frames only the debug group is pushed.
+ */
+void Profiler::beginScope(const char *name, bool gpu)
+{
+	OpenScope scope;
+	scope.name = name;
+	scope.gpu = gpu;
+	scope.beginQuery = 0;
+
+	if (gpu && debugGroups)
+		glPushDebugGroup(GL_DEBUG_SOURCE_APPLICATION, 0, -1, name);
+	if (gpu && timerQueries && inFrame)
+	{
+		scope.beginQuery = getQuery();
+		glQueryCounter(scope.beginQuery, GL_TIMESTAMP);
+	}
+
+	scope.start = SDL_GetPerformanceCounter();
+	openScopes.push_back(scope);
+}
+
+/**
+ * \brief End the innermost scope
+ */
+void Profiler::endScope()
+{
+	if (openScopes.empty())
+		return;
+
+	Uint64 end = SDL_GetPerformanceCounter();
+	OpenScope scope = openScopes.back();
+	openScopes.pop_back();
+
+	if (scope.beginQuery)
+	{
+		GpuScope gpuScope;
+		gpuScope.name = scope.name;
+		gpuScope.beginQuery = scope.beginQuery;
+		gpuScope.endQuery = getQuery();
+		glQueryCounter(gpuScope.endQuery, GL_TIMESTAMP);
+		pendingScopes[frame % LATENCY].push_back(gpuScope);
+	}
+	if (scope.gpu && debugGroups)
+		glPopDebugGroup();
+
+	// Scopes outside frames, such as scene init(), only go to the trace
+	double milliseconds = ticksToMilliseconds(end - scope.start);
+	if (inFrame)
+	{
+		ScopeStatistics &scopeStatistics = statistics[scope.name];
+		scopeStatistics.cpuFrame += milliseconds;
+		++scopeStatistics.callsFrame;
+	}
+	if (tracing)
+		addTraceEvent(scope.name, getTraceTime(scope.start), milliseconds * 1000.0, false);
+}
+
+/**
+ * \brief Query object from the pool
+ */
+GLuint Profiler::getQuery()
+{
+	if (freeQueries.empty())
+	{
+		GLuint queries[16];
+		glGenQueries(16, queries);
+		freeQueries.assign(queries, queries + 16);
+	}
+
+	GLuint query = freeQueries.back();
+	freeQueries.pop_back();
+	return query;
+}
+
+/**
+ * \brief Read the GPU scopes of one frame into the statistics and return their queries to the pool
+ */
+void Profiler::resolveGpuScopes(unsigned int slot)
+{
+	std::vector<GpuScope> &scopes = pendingScopes[slot];
+	if (scopes.empty())
+		return;
+
+	for (size_t i = 0; i < scopes.size(); ++i)
+	{
+		GLuint64 begin = 0;
+		GLuint64 end = 0;
+		glGetQueryObjectui64v(scopes[i].beginQuery, GL_QUERY_RESULT, &begin);
+		glGetQueryObjectui64v(scopes[i].endQuery, GL_QUERY_RESULT, &end);
+		freeQueries.push_back(scopes[i].beginQuery);
+		freeQueries.push_back(scopes[i].endQuery);
+
+		// Nanoseconds
+		double duration = end > begin ? static_cast<double>(end - begin) : 0.0;
+		ScopeStatistics &scopeStatistics = statistics[scopes[i].name];
+		scopeStatistics.gpuFrame += duration * 1e-6;
+		scopeStatistics.gpuFrameSeen = true;
+		if (tracing)
+			addTraceEvent(scopes[i].name, begin / 1000.0 + gpuClockOffset, duration / 1000.0, true);
+	}
+	scopes.clear();
+
+	std::map<const char *, ScopeStatistics, NameLess>::iterator it;
+	for (it = statistics.begin(); it != statistics.end(); ++it)
+	{
+		if (it->second.gpuFrameSeen)
+			it->second.gpu.add(it->second.gpuFrame);
+		it->second.gpuFrame = 0.0;
+		it->second.gpuFrameSeen = false;
+	}
+}
+
+double Profiler::getTraceTime(Uint64 ticks)
+{
+	return ticksToMilliseconds(ticks - traceStart) * 1000.0;
+}
+
+void Profiler::addTraceEvent(const char *name, double start, double duration, bool gpu)
+{
+	if (traceEvents.size() >= MAX_TRACE_EVENTS)
+	{
+		if (traceEvents.size() == MAX_TRACE_EVENTS)
+		{
+			std::cerr << "Profiler: Trace is full after " << MAX_TRACE_EVENTS << " scopes, ignoring later ones" << std::endl;
+			TraceEvent marker = {"trace full", start, 0.0, false};
+			traceEvents.push_back(marker);
+		}
+		return;
+	}
+
+	TraceEvent event = {name, start, duration, gpu};
+	traceEvents.push_back(event);
+}
+
+/**
+ * \brief One row of the statistics table with columns aligned under the header
+ */
+void Profiler::formatStatistics(char *row, size_t size, const char *name, const ScopeStatistics &scopeStatistics)
+{
+	if (scopeStatistics.gpu.samples.empty())
+		std::snprintf(row, size, "%-20s%8.1f%12.3f%10.3f%12s%10s", name, scopeStatistics.calls.getMean(),
+		              scopeStatistics.cpu.getMean(), scopeStatistics.cpu.getMax(), "-", "-");
+	else
+		std::snprintf(row, size, "%-20s%8.1f%12.3f%10.3f%12.3f%10.3f", name, scopeStatistics.calls.getMean(),
+		              scopeStatistics.cpu.getMean(), scopeStatistics.cpu.getMax(), scopeStatistics.gpu.getMean(), scopeStatistics.gpu.getMax());
+}
+
+/**
+ * \brief Print mean and maximum per-frame times of every scope over the last HISTORY frames, flushing once
+ */
+void Profiler::writeStatistics(std::ostream &os)
+{
+	char row[ROW_LENGTH];
+	std::snprintf(row, sizeof(row), HEADER_FORMAT, "Scope", "Calls", "CPU ms", "max", "GPU ms", "max");
+	os << row << '\n';
+
+	std::map<const char *, ScopeStatistics, NameLess>::const_iterator it;
+	for (it = statistics.begin(); it != statistics.end(); ++it)
+	{
+		formatStatistics(row, sizeof(row), it->first, it->second);
+		os << row << '\n';
+	}
+	os.flush();
+}
+
+/**
+ * \brief Log the same table as writeStatistics() at info level in the render category
+ *
+ * Rows are written by the log writer thread, so the render loop neither waits for the console nor interleaves
+ * its output with other log messages.
+ */
+void Profiler::logStatistics()
+{
+	if (!Log::isEnabled(Log::LEVEL_INFO, Log::RENDER))
+		return;
+
+	char row[ROW_LENGTH];
+	std::snprintf(row, sizeof(row), HEADER_FORMAT, "Scope", "Calls", "CPU ms", "max", "GPU ms", "max");
+	LOG_INFO(RENDER, row);
+
+	std::map<const char *, ScopeStatistics, NameLess>::const_iterator it;
+	for (it = statistics.begin(); it != statistics.end(); ++it)
+	{
+		formatStatistics(row, sizeof(row), it->first, it->second);
+		LOG_INFO(RENDER, row);
+	}
+}
+
+/**
+ * \brief Forget the statistics, e.g. when switching to another scene
+ *
+ * GPU scopes still in flight belong to the previous frames, so they are resolved first. Their results still reach the
+ * trace but not the new statistics.
+ */
+void Profiler::resetStatistics()
+{
+	for (unsigned int slot = 0; slot < LATENCY; ++slot)
+		resolveGpuScopes(slot);
+	statistics.clear();
+}
+
+/**
+ * \brief Write the scopes recorded since setTracing(true) in Chrome trace event format
+ * \return false if the file could not be written
+ */
+bool Profiler::writeChromeTrace(const std::string &filename)
+{
+	// GPU scopes of the last frames
+	for (unsigned int slot = 0; slot < LATENCY; ++slot)
+		resolveGpuScopes(slot);
+
+	std::ofstream os(filename.c_str());
+	if (!os.is_open())
+	{
+		std::cerr << "Profiler::writeChromeTrace(): Unable to open '" << filename << "' for writing." << std::endl;
+		return false;
+	}
+
+	os << std::fixed << std::setprecision(3);
+	os << "{\"displayTimeUnit\": \"ms\", \"traceEvents\": [\n";
+	os << "{\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": 1, \"tid\": 1, \"args\": {\"name\": \"CPU\"}},\n";
+	os << "{\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": 1, \"tid\": 2, \"args\": {\"name\": \"GPU\"}}";
+	for (size_t i = 0; i < traceEvents.size(); ++i)
+	{
+		const TraceEvent &event = traceEvents[i];
+		os << ",\n{\"name\": ";
+		writeJsonString(os, event.name);
+		os << ", \"cat\": \"" << (event.gpu ? "gpu" : "cpu") << "\", \"ph\": \"X\", \"pid\": 1, \"tid\": " << (event.gpu ? 2 : 1)
+		   << ", \"ts\": " << event.start << ", \"dur\": " << event.duration << "}";
+	}
+	os << "\n]}\n";
+
+	return os.good();
+}
+
+/**
+ * \brief Delete query objects. Called before the OpenGL context is destroyed.
+ */
+void Profiler::release()
+{
+	for (unsigned int slot = 0; slot < LATENCY; ++slot)
+	{
+		for (size_t i = 0; i < pendingScopes[slot].size(); ++i)
+		{
+			freeQueries.push_back(pendingScopes[slot][i].beginQuery);
+			freeQueries.push_back(pendingScopes[slot][i].endQuery);
+		}
+		pendingScopes[slot].clear();
+	}
+
+	if (!freeQueries.empty())
+		glDeleteQueries(static_cast<GLsizei>(freeQueries.size()), &freeQueries[0]);
+	freeQueries.clear();
+	enabled = false;
+}
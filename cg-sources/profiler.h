@@ -0,0 +1,180 @@
+/**
+ * \brief CPU and GPU scope timing
+ * \file
+ */
+#ifndef PROFILER_H_
+#define PROFILER_H_
+
+#include <string>
+#include <vector>
+#include <map>
+#include <ostream>
+#include <cstring>
+#include <GL/glew.h>
+#include <SDL.h>
+
+/**
+ * \brief Collects timings of named scopes for rolling statistics and Chrome trace files
+ *
+ * Scopes are marked with the PROFILE_SCOPE() and PROFILE_GPU_SCOPE() macros. Both measure CPU time with
+ * SDL_GetPerformanceCounter(). GPU scopes also record GL_TIMESTAMP queries around the commands issued inside them
+ * and label them with glPushDebugGroup(), so that they show up named in tools such as RenderDoc and apitrace.
+ *
+ * Query results are read LATENCY frames later from a pool of query objects, so measuring never waits for the GPU.
+ * Timestamps are used instead of GL_TIME_ELAPSED queries because those can not be nested or overlap the frame
+ * queries of Benchmark.
+ *
+ * The render loop calls beginFrame() and endFrame() around every frame. Everything is off until setEnabled(true),
+ * and disabled scopes cost one branch. Scope names must be string literals or otherwise outlive the profiler.
+ *
+ * Traces written by writeChromeTrace() open in chrome://tracing or https://ui.perfetto.dev with CPU and GPU scopes
+ * on separate tracks.
+ */
+class Profiler
+{
+public:
+	static const unsigned int LATENCY = 4;    ///< Frames before GPU results are read
+	static const unsigned int HISTORY = 120;  ///< Frames in the rolling statistics
+
+	static void setEnabled(bool enable);
+	static void setTracing(bool enable);
+
+	/**
+	 * \brief True if scopes are measured
+	 */
+	static bool isEnabled()
+	{
+		return enabled;
+	}
+
+	static void beginFrame();
+	static void endFrame();
+	static void beginScope(const char *name, bool gpu);
+	static void endScope();
+
+	static void writeStatistics(std::ostream &os);
+	static void logStatistics();
+	static void resetStatistics();
+	static bool writeChromeTrace(const std::string &filename);
+	static void release();
+
+private:
+	/**
+	 * \brief Last HISTORY per-frame values
+	 */
+	struct History
+	{
+		std::vector<double> samples;
+		size_t next;
+
+		History() : next(0) {}
+		void add(double value);
+		double getMean() const;
+		double getMax() const;
+	};
+
+	struct ScopeStatistics
+	{
+		History cpu;           // Milliseconds per frame
+		History gpu;
+		History calls;         // Calls per frame
+		double cpuFrame;       // Sums of the frame in progress
+		double gpuFrame;
+		unsigned int callsFrame;
+		bool gpuFrameSeen;
+
+		ScopeStatistics() : cpuFrame(0.0), gpuFrame(0.0), callsFrame(0), gpuFrameSeen(false) {}
+	};
+
+	struct NameLess
+	{
+		bool operator()(const char *a, const char *b) const
+		{
+			return std::strcmp(a, b) < 0;
+		}
+	};
+
+	struct OpenScope
+	{
+		const char *name;
+		Uint64 start;
+		bool gpu;          // Debug group pushed
+		GLuint beginQuery; // 0 without timer queries or outside frames
+	};
+
+	struct GpuScope
+	{
+		const char *name;
+		GLuint beginQuery;
+		GLuint endQuery;
+	};
+
+	struct TraceEvent
+	{
+		const char *name;
+		double start;     // Microseconds from the start of tracing
+		double duration;
+		bool gpu;
+	};
+
+	static bool enabled;
+	static bool tracing;
+	static bool timerQueries;
+	static bool debugGroups;
+	static bool inFrame;
+	static unsigned long long frame;
+	static Uint64 frameStart;
+	static Uint64 traceStart;
+	static double gpuClockOffset;  // Microseconds to add to GL_TIMESTAMP / 1000 for the trace time line
+	static bool gpuClockSynced;
+	static std::vector<OpenScope> openScopes;
+	static std::vector<GpuScope> pendingScopes[LATENCY];
+	static std::vector<GLuint> freeQueries;
+	static std::map<const char *, ScopeStatistics, NameLess> statistics;
+	static std::vector<TraceEvent> traceEvents;
+
+	static GLuint getQuery();
+	static void formatStatistics(char *row, size_t size, const char *name, const ScopeStatistics &scopeStatistics);
+	static void resolveGpuScopes(unsigned int slot);
+	static void addTraceEvent(const char *name, double start, double duration, bool gpu);
+	static double getTraceTime(Uint64 ticks);
+};
+
+/**
+ * \brief Measures the enclosing block, see PROFILE_SCOPE()
+ */
+class ProfileScope
+{
+	bool active;
+
+	ProfileScope(const ProfileScope &);
+	ProfileScope &operator=(const ProfileScope &);
+public:
+	explicit ProfileScope(const char *name, bool gpu = false) :
+		active(Profiler::isEnabled())
+	{
+		if (active)
+			Profiler::beginScope(name, gpu);
+	}
+
+	~ProfileScope()
+	{
+		if (active)
+			Profiler::endScope();
+	}
+};
+
+#define PROFILE_CONCATENATE2(a, b) a##b
+#define PROFILE_CONCATENATE(a, b) PROFILE_CONCATENATE2(a, b)
+
+/**
+ * \brief Measure CPU time of the rest of the enclosing block
+ */
+#define PROFILE_SCOPE(name) ProfileScope PROFILE_CONCATENATE(profileScope, __LINE__)(name)
+
+/**
+ * \brief Measure CPU and GPU time of the rest of the enclosing block
+ */
+#define PROFILE_GPU_SCOPE(name) ProfileScope PROFILE_CONCATENATE(profileScope, __LINE__)(name, true)
+
+#endif
@@ -0,0 +1,183 @@
+/**
+ * \brief Disk cache for linked shader program binaries
+ * \file
+ */
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <iomanip>
+#include <vector>
+#include <algorithm>
+#include "programbinarycache.h"
+
+#ifdef _WIN32
+#include <direct.h>
+#else
+#include <sys/stat.h>
+#endif
+
+std::string ProgramBinaryCache::directory = "shadercache";
+bool ProgramBinaryCache::enabled = true;
+
+namespace
+{
+	const char FILE_MAGIC[4] = {'C', 'G', 'P', 'B'};
+
+	/**
+	 * \brief 64-bit FNV-1a hash, continuing from hash
+	 */
+	unsigned long long hashString(const std::string &text, unsigned long long hash = 14695981039346656037ULL)
+	{
+		for (size_t i = 0; i < text.size(); ++i)
+		{
+			hash ^= static_cast<unsigned char>(text[i]);
+			hash *= 1099511628211ULL;
+		}
+		return hash;
+	}
+
+	std::string getString(GLenum name)
+	{
+		const GLubyte *value = glGetString(name);
+		return value ? reinterpret_cast<const char *>(value) : "";
+	}
+}
+
+/**
+ * \brief Set the directory for cache files, relative to the working directory. Default is "shadercache".
+ */
+void ProgramBinaryCache::setDirectory(const std::string &dir)
+{
+	directory = dir;
+}
+
+/**
+ * \brief Disable the cache, e.g. while editing shaders
+ */
+void ProgramBinaryCache::setEnabled(bool enable)
+{
+	enabled = enable;
+}
+
+/**
+ * \brief True if the driver can save program binaries and the cache has not been disabled
+ */
+bool ProgramBinaryCache::isSupported()
+{
+	if (!enabled || !GLEW_ARB_get_program_binary)
+		return false;
+
+	// Drivers may support the extension with no binary formats at all
+	GLint formats = 0;
+	glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formats);
+	return formats > 0;
+}
+
+/**
+ * \brief Cache key of a program
+ * \param sources All shader sources of the program concatenated
+ * \param defines Preprocessor definitions or other options affecting the compiled program
+ * \return 16 hex digits
+ */
+std::string ProgramBinaryCache::getKey(const std::string &sources, const std::string &defines)
+{
+	unsigned long long hash = hashString(sources);
+	hash = hashString(std::string(1, '\0') + defines, hash);
+	hash = hashString(std::string(1, '\0') + getString(GL_VENDOR), hash);
+	hash = hashString(std::string(1, '\0') + getString(GL_RENDERER), hash);
+	hash = hashString(std::string(1, '\0') + getString(GL_VERSION), hash);
+
+	std::ostringstream key;
+	key << std::hex << std::setw(16) << std::setfill('0') << hash;
+	return key.str();
+}
+
+std::string ProgramBinaryCache::getPath(const std::string &key)
+{
+	return directory + "/" + key + ".bin";
+}
+
+/**
+ * \brief Restore a program from the cache
+ * \param program Program object without attached shaders
+ * \param key Key from getKey()
+ * \return true if the program is linked and ready to use. Otherwise it must be compiled and linked normally.
+ */
+bool ProgramBinaryCache::load(GLuint program, const std::string &key)
+{
+	if (!isSupported())
+		return false;
+
+	std::ifstream is(getPath(key).c_str(), std::ifstream::binary);
+	if (!is.is_open())
+		return false;
+
+	char magic[4];
+	GLenum format = 0;
+	GLint length = 0;
+	is.read(magic, sizeof(magic));
+	is.read(reinterpret_cast<char *>(&format), sizeof(format));
+	is.read(reinterpret_cast<char *>(&length), sizeof(length));
+	if (!is.good() || !std::equal(magic, magic + 4, FILE_MAGIC) || length <= 0)
+		return false;
+
+	std::vector<char> binary(length);
+	is.read(&binary[0], length);
+	if (!is.good())
+		return false;
+
+	glProgramBinary(program, format, &binary[0], length);
+
+	// Driver rejects binaries from other driver versions or with changed state by not linking the program
+	GLint linked = GL_FALSE;
+	glGetProgramiv(program, GL_LINK_STATUS, &linked);
+	return linked == GL_TRUE;
+}
+
+/**
+ * \brief Ask the driver to keep the binary of a program. Call before glLinkProgram().
+ */
+void ProgramBinaryCache::prepare(GLuint program)
+{
+	if (isSupported())
+		glProgramParameteri(program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+}
+
+/**
+ * \brief Save a linked program to the cache
+ * \return false if the binary could not be retrieved or written
+ */
+bool ProgramBinaryCache::store(GLuint program, const std::string &key)
+{
+	if (!isSupported())
+		return false;
+
+	GLint length = 0;
+	glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &length);
+	if (length <= 0)
+		return false;
+
+	std::vector<char> binary(length);
+	GLenum format = 0;
+	glGetProgramBinary(program, length, &length, &format, &binary[0]);
+
+	// Existing directory is fine
+#ifdef _WIN32
+	_mkdir(directory.c_str());
+#else
+	mkdir(directory.c_str(), 0755);
+#endif
+
+	std::ofstream os(getPath(key).c_str(), std::ofstream::binary);
+	if (!os.is_open())
+	{
+		std::cerr << "ProgramBinaryCache::store(): Unable to write " << getPath(key) << std::endl;
+		return false;
+	}
+
+	os.write(FILE_MAGIC, sizeof(FILE_MAGIC));
+	os.write(reinterpret_cast<const char *>(&format), sizeof(format));
+	os.write(reinterpret_cast<const char *>(&length), sizeof(length));
+	os.write(&binary[0], length);
+	return os.good();
+}
@@ -0,0 +1,39 @@
+/**
+ * \brief Disk cache for linked shader program binaries
+ * \file
+ */
+#ifndef PROGRAMBINARYCACHE_H_
+#define PROGRAMBINARYCACHE_H_
+
+#include <string>
+#include <GL/glew.h>
+
+/**
+ * \brief Stores linked programs with glGetProgramBinary() and restores them with glProgramBinary()
+ *
+ * Compiling and linking GLSL can take hundreds of milliseconds per program, especially with software renderers.
+ * Cached binaries skip that on later runs. A binary is only valid for the driver that created it, so the cache key
+ * is a hash of the shader sources, defines and the GL_VENDOR, GL_RENDERER and GL_VERSION strings. Drivers may still
+ * reject a binary after an update, in which case load() fails and the program is compiled again.
+ *
+ * Files are stored as <directory>/<key>.bin. Deleting the directory clears the cache.
+ * Requires ARB_get_program_binary (core in OpenGL 4.1). Without it load() and store() do nothing.
+ */
+class ProgramBinaryCache
+{
+	static std::string directory;
+	static bool enabled;
+
+	static std::string getPath(const std::string &key);
+public:
+	static void setDirectory(const std::string &directory);
+	static void setEnabled(bool enable);
+	static bool isSupported();
+
+	static std::string getKey(const std::string &sources, const std::string &defines = std::string());
+	static bool load(GLuint program, const std::string &key);
+	static bool store(GLuint program, const std::string &key);
+	static void prepare(GLuint program);
+};
+
+#endif
@@ -0,0 +1,95 @@
+/**
+ * \brief Program pipeline implementation
+ * \file
+ */
+#include <iostream>
+#include <string>
+#include "programpipeline.h"
+
+/**
+ * \brief Create an empty pipeline. Does nothing if isSupported() is false.
+ */
+ProgramPipeline::ProgramPipeline() :
+	pipeline(0),
+	vertexProgram(0),
+	fragmentProgram(0)
+{
+	if (isSupported())
+		glGenProgramPipelines(1, &pipeline);
+}
+
+ProgramPipeline::~ProgramPipeline()
+{
+	if (pipeline)
+		glDeleteProgramPipelines(1, &pipeline);
+}
+
+/**
+ * \brief Use the stages of a program loaded with ShaderProgram::loadStage() in this pipeline
+ *
+ * The pipeline does not own the program, which must stay alive while the pipeline uses it.
+ */
+void ProgramPipeline::setStage(const ShaderProgram &stage)
+{
+	GLbitfield stages = stage.getStages();
+	GLuint program = stage.getShaderProgram();
+	if (!pipeline || !stages)
+	{
+		std::cerr << "ProgramPipeline::setStage(): Program is not a separable stage" << std::endl;
+		return;
+	}
+
+	bool vertex = (stages & GL_VERTEX_SHADER_BIT) != 0;
+	bool fragment = (stages & GL_FRAGMENT_SHADER_BIT) != 0;
+	if ((!vertex || vertexProgram == program) && (!fragment || fragmentProgram == program))
+		return;
+
+	glUseProgramStages(pipeline, stages, program);
+	if (vertex)
+		vertexProgram = program;
+	if (fragment)
+		fragmentProgram = program;
+}
+
+/**
+ * \brief Draw with this pipeline. A program bound with glUseProgram() would override it, so that is unbound if there is one.
+ */
+void ProgramPipeline::bind() const
+{
+	GLint current = 0;
+	glGetIntegerv(GL_CURRENT_PROGRAM, &current);
+	if (current != 0)
+		glUseProgram(0);
+	glBindProgramPipeline(pipeline);
+}
+
+/**
+ * \brief Check that the stages fit together and print the reason if they don't
+ *
+ * Validation also depends on current state such as bound textures, so call this right before drawing, e.g.
+ * when debugging a draw call that renders nothing.
+ */
+bool ProgramPipeline::validate() const
+{
+	glValidateProgramPipeline(pipeline);
+
+	GLint valid = GL_FALSE;
+	glGetProgramPipelineiv(pipeline, GL_VALIDATE_STATUS, &valid);
+	if (valid == GL_TRUE)
+		return true;
+
+	GLint length = 0;
+	glGetProgramPipelineiv(pipeline, GL_INFO_LOG_LENGTH, &length);
+	std::string log(length > 1 ? length : 1, '\0');
+	glGetProgramPipelineInfoLog(pipeline, static_cast<GLsizei>(log.size()), 0, &log[0]);
+	std::cerr << "ProgramPipeline: Validation failed: " << log.c_str() << std::endl;
+	return false;
+}
+
+/**
+ * \brief Check if program pipelines are available (OpenGL 4.1 or ARB_separate_shader_objects)
+ */
+bool ProgramPipeline::isSupported()
+{
+	return GLEW_ARB_separate_shader_objects != 0;
+}
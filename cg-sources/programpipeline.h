@@ -0,0 +1,49 @@
+/**
+ * \brief Program pipelines combining separately linked shader stages
+ * \file
+ */
+#ifndef PROGRAMPIPELINE_H_
+#define PROGRAMPIPELINE_H_
+
+#include <GL/glew.h>
+#include "shaderprogram.h"
+
+/**
+ * \brief Pipeline object that draws with the vertex stage of one program and the fragment stage of another
+ *
+ * Stages are loaded with ShaderProgram::loadStage() and linked on their own, so a vertex stage shared by many
+ * materials is compiled and linked once instead of once per material. Switching the material of a bound pipeline
+ * with setStage() replaces only the fragment stage.
+ *
+ * \code
+ * vertexStage.loadStage(GL_VERTEX_SHADER, "data/object.vs");
+ * fragmentStage.loadStage(GL_FRAGMENT_SHADER, "data/land.fs");
+ * pipeline.setStage(vertexStage);
+ * pipeline.setStage(fragmentStage);
+ * pipeline.bind();
+ * \endcode
+ *
+ * Uniforms are set through the stage programs with ShaderProgram::setUniform(), which uses glProgramUniform*() for
+ * stages so that neither the program nor the pipeline has to be bound. Requires ARB_separate_shader_objects
+ * (core in OpenGL 4.1).
+ */
+class ProgramPipeline
+{
+	GLuint pipeline;
+	GLuint vertexProgram;   // Programs set to the stages, to skip redundant glUseProgramStages() calls
+	GLuint fragmentProgram;
+
+	ProgramPipeline(const ProgramPipeline &);
+	ProgramPipeline &operator=(const ProgramPipeline &);
+public:
+	ProgramPipeline();
+	~ProgramPipeline();
+
+	void setStage(const ShaderProgram &stage);
+	void bind() const;
+	bool validate() const;
+
+	static bool isSupported();
+};
+
+#endif
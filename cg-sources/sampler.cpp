@@ -0,0 +1,93 @@
+/**
+ * \brief Shared sampler object cache implementation
+ * \file
+ */
+#include "sampler.h"
+
+std::map<Sampler::Parameters, GLuint> Sampler::cache;
+
+/**
+ * \brief Strict weak ordering for the cache
+ */
+bool Sampler::Parameters::operator<(const Parameters &other) const
+{
+	if (magFilter != other.magFilter)
+		return magFilter < other.magFilter;
+	if (minFilter != other.minFilter)
+		return minFilter < other.minFilter;
+	if (wrapS != other.wrapS)
+		return wrapS < other.wrapS;
+	if (wrapT != other.wrapT)
+		return wrapT < other.wrapT;
+	return maxAnisotropy < other.maxAnisotropy;
+}
+
+/**
+ * \brief Check if sampler objects are available (OpenGL 3.3 or ARB_sampler_objects)
+ */
+bool Sampler::isSupported()
+{
+	return GLEW_ARB_sampler_objects != 0;
+}
+
+/**
+ * \brief Get a sampler object with given parameters
+ *
+ * Sampler object is created on the first request and shared by all later requests with the same parameters.
+ * \return Sampler object id or 0 if sampler objects are not supported
+ */
+GLuint Sampler::get(const Parameters &parameters)
+{
+	if (!isSupported())
+		return 0;
+
+	std::map<Parameters, GLuint>::const_iterator it = cache.find(parameters);
+	if (it != cache.end())
+		return it->second;
+
+	GLuint sampler = 0;
+	glGenSamplers(1, &sampler);
+	glSamplerParameteri(sampler, GL_TEXTURE_MAG_FILTER, parameters.magFilter);
+	glSamplerParameteri(sampler, GL_TEXTURE_MIN_FILTER, parameters.minFilter);
+	glSamplerParameteri(sampler, GL_TEXTURE_WRAP_S, parameters.wrapS);
+	glSamplerParameteri(sampler, GL_TEXTURE_WRAP_T, parameters.wrapT);
+
+	// Anisotropic filtering requires mipmapping levels to be available for the best results!
+	if (parameters.maxAnisotropy > 1.0f && GLEW_EXT_texture_filter_anisotropic)
+		glSamplerParameterf(sampler, GL_TEXTURE_MAX_ANISOTROPY_EXT, parameters.maxAnisotropy);
+
+	cache[parameters] = sampler;
+	return sampler;
+}
+
+/**
+ * \brief Store parameters in the currently bound texture object
+ *
+ * Texture state is used when no sampler object is bound to the texture unit, i.e. when a texture is bound
+ * directly with glBindTexture() or sampler objects are not supported.
+ * \param target Texture target such as GL_TEXTURE_2D
+ * \param parameters Sampling parameters
+ */
+void Sampler::applyToTexture(GLenum target, const Parameters &parameters)
+{
+	glTexParameteri(target, GL_TEXTURE_MAG_FILTER, parameters.magFilter);
+	glTexParameteri(target, GL_TEXTURE_MIN_FILTER, parameters.minFilter);
+	glTexParameteri(target, GL_TEXTURE_WRAP_S, parameters.wrapS);
+	glTexParameteri(target, GL_TEXTURE_WRAP_T, parameters.wrapT);
+
+	if (parameters.maxAnisotropy > 1.0f && GLEW_EXT_texture_filter_anisotropic)
+		glTexParameterf(target, GL_TEXTURE_MAX_ANISOTROPY_EXT, parameters.maxAnisotropy);
+}
+
+/**
+ * \brief Release all cached sampler objects
+ *
+ * Must be called while the OpenGL context still exists.
+ */
+void Sampler::releaseAll()
+{
+	std::map<Parameters, GLuint>::iterator it;
+	for (it = cache.begin(); it != cache.end(); ++it)
+		glDeleteSamplers(1, &it->second);
+	cache.clear();
+}
@@ -0,0 +1,55 @@
+/**
+ * \brief Shared sampler object cache interface
+ * \file
+ */
+#ifndef SAMPLER_H_
+#define SAMPLER_H_
+
+#include <map>
+#include <GL/glew.h>
+
+/**
+ * \brief Cache of OpenGL sampler objects keyed by their parameters
+ *
+ * Textures with the same filtering and wrapping share one sampler object, so sampling state is set once
+ * instead of with glTexParameter() calls on every texture upload. See https://www.opengl.org/wiki/Sampler_Object
+ */
+class Sampler
+{
+public:
+	/**
+	 * \brief Sampling state stored in a sampler object
+	 */
+	struct Parameters
+	{
+		GLint magFilter;
+		GLint minFilter;
+		GLint wrapS;
+		GLint wrapT;
+		GLfloat maxAnisotropy; ///< 1.0 disables anisotropic filtering
+
+		/**
+		 * \brief Default parameters: trilinear filtering and repeating texture coordinates
+		 */
+		Parameters(GLint magFilter = GL_LINEAR, GLint minFilter = GL_LINEAR_MIPMAP_LINEAR, GLint wrapS = GL_REPEAT, GLint wrapT = GL_REPEAT, GLfloat maxAnisotropy = 1.0f) :
+			magFilter(magFilter),
+			minFilter(minFilter),
+			wrapS(wrapS),
+			wrapT(wrapT),
+			maxAnisotropy(maxAnisotropy)
+		{
+		}
+
+		bool operator<(const Parameters &other) const;
+	};
+
+	static bool isSupported();
+	static GLuint get(const Parameters &parameters = Parameters());
+	static void applyToTexture(GLenum target, const Parameters &parameters);
+	static void releaseAll();
+
+private:
+	static std::map<Parameters, GLuint> cache;
+};
+
+#endif
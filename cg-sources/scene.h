@@ -37,11 +37,21 @@ public:
 	/**
 	 * \brief Update scene
 	 *
-	 * Simulate a time step for your scene and things move.
+	 * Simulate a time step for your scene and things move. Called with the same time step every time,
+	 * zero or more times per frame, see FixedTimestep.
  	 * \param timestep Time step in seconds
 	 */
 	virtual void update(float timestep) = 0;
 
+	/**
+	 * \brief Blend the two latest update() states for the next render()
+	 *
+	 * update() runs with a fixed time step, so frames are usually rendered between two simulation steps.
+	 * Scenes that keep the state before the latest update() can blend it here to animate smoothly.
+	 * \param alpha 0 for the state before the latest update(), 1 for the state after it
+	 */
+	virtual void interpolate(float alpha) {}
+
 	/**
 	 * \brief Render view
 	 *
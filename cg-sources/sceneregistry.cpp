@@ -0,0 +1,168 @@
+/**
+ * \brief Scene registry implementation
+ * \file
+ */
+#include <iostream>
+#include <cstdlib>
+#include <algorithm>
+#include "sceneregistry.h"
+
+namespace
+{
+	bool compareNames(const SceneRegistry::Entry &a, const SceneRegistry::Entry &b)
+	{
+		return a.name < b.name;
+	}
+}
+
+/**
+ * \brief Add a value given as "name=value"
+ * \return false if there is no '=' or the name is empty
+ */
+bool SceneParameters::parse(const std::string &assignment)
+{
+	size_t separator = assignment.find('=');
+	if (separator == std::string::npos || separator == 0)
+		return false;
+
+	set(assignment.substr(0, separator), assignment.substr(separator + 1));
+	return true;
+}
+
+void SceneParameters::set(const std::string &name, const std::string &value)
+{
+	values[name] = value;
+}
+
+/**
+ * \brief Parameters seen by one scene: values prefixed with "sceneName." replace unprefixed ones
+ */
+SceneParameters SceneParameters::forScene(const std::string &sceneName) const
+{
+	SceneParameters parameters;
+	std::string prefix = sceneName + ".";
+
+	// Unprefixed values first so that the scene specific ones win
+	std::map<std::string, std::string>::const_iterator it;
+	for (it = values.begin(); it != values.end(); ++it)
+	{
+		if (it->first.find('.') == std::string::npos)
+			parameters.values[it->first] = it->second;
+	}
+	for (it = values.begin(); it != values.end(); ++it)
+	{
+		if (it->first.compare(0, prefix.size(), prefix) == 0)
+			parameters.values[it->first.substr(prefix.size())] = it->second;
+	}
+	return parameters;
+}
+
+bool SceneParameters::has(const std::string &name) const
+{
+	return values.find(name) != values.end();
+}
+
+std::string SceneParameters::getString(const std::string &name, const std::string &defaultValue) const
+{
+	std::map<std::string, std::string>::const_iterator it = values.find(name);
+	return it != values.end() ? it->second : defaultValue;
+}
+
+int SceneParameters::getInt(const std::string &name, int defaultValue) const
+{
+	std::map<std::string, std::string>::const_iterator it = values.find(name);
+	if (it == values.end())
+		return defaultValue;
+
+	char *end = 0;
+	long value = std::strtol(it->second.c_str(), &end, 10);
+	if (it->second.empty() || *end != '\0')
+	{
+		std::cerr << "SceneParameters: '" << name << "' expects an integer, got '" << it->second << "'" << std::endl;
+		return defaultValue;
+	}
+	return static_cast<int>(value);
+}
+
+float SceneParameters::getFloat(const std::string &name, float defaultValue) const
+{
+	std::map<std::string, std::string>::const_iterator it = values.find(name);
+	if (it == values.end())
+		return defaultValue;
+
+	char *end = 0;
+	double value = std::strtod(it->second.c_str(), &end);
+	if (it->second.empty() || *end != '\0')
+	{
+		std::cerr << "SceneParameters: '" << name << "' expects a number, got '" << it->second << "'" << std::endl;
+		return defaultValue;
+	}
+	return static_cast<float>(value);
+}
+
+/**
+ * \brief Registered scenes. A function local static, so that registrations from static constructors of other
+ * files find it constructed.
+ */
+std::vector<SceneRegistry::Entry> &SceneRegistry::entries()
+{
+	static std::vector<Entry> registered;
+	return registered;
+}
+
+/**
+ * \brief Register a scene, usually through Registration
+ */
+void SceneRegistry::add(const std::string &name, const std::string &description, const std::string &parameters, Factory create)
+{
+	if (find(name))
+	{
+		std::cerr << "SceneRegistry::add(): Scene '" << name << "' registered twice" << std::endl;
+		return;
+	}
+
+	Entry entry;
+	entry.name = name;
+	entry.description = description;
+	entry.parameters = parameters;
+	entry.create = create;
+
+	// Keep sorted, static constructors run in link order
+	std::vector<Entry> &registered = entries();
+	registered.insert(std::upper_bound(registered.begin(), registered.end(), entry, compareNames), entry);
+}
+
+/**
+ * \brief Every registered scene sorted by name
+ */
+const std::vector<SceneRegistry::Entry> &SceneRegistry::getEntries()
+{
+	return entries();
+}
+
+/**
+ * \return 0 if no scene has the name
+ */
+const SceneRegistry::Entry *SceneRegistry::find(const std::string &name)
+{
+	const std::vector<Entry> &registered = entries();
+	for (size_t i = 0; i < registered.size(); ++i)
+	{
+		if (registered[i].name == name)
+			return &registered[i];
+	}
+	return 0;
+}
+
+/**
+ * \brief Create a scene. Needs a current OpenGL context, init() is left to the caller.
+ * \param parameters Parameters of every scene, the ones for this scene are picked with SceneParameters::forScene()
+ * \return 0 if no scene has the name
+ */
+Scene *SceneRegistry::create(const std::string &name, const SceneParameters &parameters)
+{
+	const Entry *entry = find(name);
+	if (!entry)
+		return 0;
+	return entry->create(parameters.forScene(name));
+}
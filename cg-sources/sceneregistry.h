@@ -0,0 +1,97 @@
+/**
+ * \brief Scenes selectable by name
+ * \file
+ */
+#ifndef SCENEREGISTRY_H_
+#define SCENEREGISTRY_H_
+
+#include <string>
+#include <map>
+#include <vector>
+#include <type_traits>
+#include "scene.h"
+
+/**
+ * \brief Named options given to scenes on the command line with --param name=value
+ *
+ * A name prefixed with a scene name, e.g. example3.tessellation=5, applies to that scene only and overrides the
+ * unprefixed value. Scenes read values in their constructor and fall back to their defaults for missing or
+ * malformed values.
+ */
+class SceneParameters
+{
+	std::map<std::string, std::string> values;
+public:
+	bool parse(const std::string &assignment);
+	void set(const std::string &name, const std::string &value);
+	SceneParameters forScene(const std::string &sceneName) const;
+
+	bool has(const std::string &name) const;
+	std::string getString(const std::string &name, const std::string &defaultValue) const;
+	int getInt(const std::string &name, int defaultValue) const;
+	float getFloat(const std::string &name, float defaultValue) const;
+};
+
+/**
+ * \brief Creates scenes by name
+ *
+ * Every scene registers itself in its own source file with a static Registration, so adding a scene needs no
+ * changes elsewhere:
+ * \code
+ * static SceneRegistry::Registration<ExampleScene3> registration("example3", "A shaded sphere", "tessellation=4");
+ * \endcode
+ * Scenes with a constructor taking const SceneParameters & get the parameters, others are default constructed.
+ */
+class SceneRegistry
+{
+public:
+	typedef Scene *(*Factory)(const SceneParameters &parameters);
+
+	/**
+	 * \brief Registered scene
+	 */
+	struct Entry
+	{
+		std::string name;
+		std::string description;
+		std::string parameters; ///< Accepted parameters with defaults, e.g. "tessellation=4"
+		Factory create;
+	};
+
+	/**
+	 * \brief Registers T when constructed, meant for static objects in the source file of the scene
+	 */
+	template <class T>
+	class Registration
+	{
+		static Scene *create(const SceneParameters &parameters, std::true_type)
+		{
+			return new T(parameters);
+		}
+
+		static Scene *create(const SceneParameters &, std::false_type)
+		{
+			return new T;
+		}
+
+		static Scene *create(const SceneParameters &parameters)
+		{
+			return create(parameters, std::is_constructible<T, const SceneParameters &>());
+		}
+	public:
+		Registration(const char *name, const char *description, const char *parameters = "")
+		{
+			SceneRegistry::add(name, description, parameters, &create);
+		}
+	};
+
+	static void add(const std::string &name, const std::string &description, const std::string &parameters, Factory create);
+	static const std::vector<Entry> &getEntries();
+	static const Entry *find(const std::string &name);
+	static Scene *create(const std::string &name, const SceneParameters &parameters);
+
+private:
+	static std::vector<Entry> &entries();
+};
+
+#endif
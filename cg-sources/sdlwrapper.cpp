@@ -4,8 +4,14 @@
 #include <iostream>
 #include "sdlwrapper.h"
 #include "debugmessagecallback.h"
+#include "sampler.h"
+#include "profiler.h"
 
-SDL::SDL(bool doOpenGLDebug, int ogl_major_version, int ogl_minor_version, Uint32 flags, const std::string &window_name, Uint32 window_width, Uint32 window_height) :
+/**
+ * \brief Initialize SDL and create a window with an OpenGL context
+ * \param headless Keep the window hidden and disable vertical sync, for rendering into framebuffer objects only
+ */
+SDL::SDL(bool doOpenGLDebug, int ogl_major_version, int ogl_minor_version, Uint32 flags, const std::string &window_name, Uint32 window_width, Uint32 window_height, bool headless) :
 	win(0),
 	glcontext(0),
 	ok(false)
@@ -52,7 +58,7 @@ SDL::SDL(bool doOpenGLDebug, int ogl_major_version, int ogl_minor_version, Uint3
 	// See https://wiki.libsdl.org/SDL_CreateWindow for more options
 	int posX = SDL_WINDOWPOS_CENTERED, posY = SDL_WINDOWPOS_CENTERED;
 
-	win = SDL_CreateWindow(window_name.c_str(), posX, posY, window_width, window_height, SDL_WINDOW_OPENGL | SDL_WINDOW_RESIZABLE);
+	win = SDL_CreateWindow(window_name.c_str(), posX, posY, window_width, window_height, SDL_WINDOW_OPENGL | (headless ? SDL_WINDOW_HIDDEN : SDL_WINDOW_RESIZABLE));
 
 	if (win == 0)
 	{
@@ -68,6 +74,10 @@ SDL::SDL(bool doOpenGLDebug, int ogl_major_version, int ogl_minor_version, Uint3
 		return;
 	}
 
+	// Swap interval applies to the current context, so it can only be changed now
+	if (headless)
+		SDL_GL_SetSwapInterval(0);
+
 	// Initialize GLEW now that we have a context
 	// Setting glewExperimental allows OpenGL symbols to be found even when they are not listed in driver's extension list - Needed when using core profiles due to GLEW bugs
 	// Depending on the drivers, this might be necessary to get even some of the basic functionality to work.
@@ -131,9 +141,14 @@ SDL::SDL(bool doOpenGLDebug, int ogl_major_version, int ogl_minor_version, Uint3
 
 SDL::~SDL()
 {
-	// Release GL context
+	// Release GL context and shared objects living in it
 	if (glcontext)
+	{
+		releaseDebugMessageCallback();
+		Sampler::releaseAll();
+		Profiler::release();
 		SDL_GL_DeleteContext(glcontext);
+	}
 
 	// Release window
 	if (win)
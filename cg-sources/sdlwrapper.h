@@ -22,7 +22,7 @@ class SDL
 	SDL_GLContext glcontext;
 	bool ok;
 public:
-	SDL(bool doOpenGLDebug, int ogl_major_version, int ogl_minor_version, Uint32 flags, const std::string &window_name, Uint32 window_width, Uint32 window_height);
+	SDL(bool doOpenGLDebug, int ogl_major_version, int ogl_minor_version, Uint32 flags, const std::string &window_name, Uint32 window_width, Uint32 window_height, bool headless = false);
 
 	~SDL();
 
@@ -4,10 +4,58 @@
 #include <iostream>
 #include <fstream>
 #include <sstream>
+#include <cstring>
+#include <algorithm>
+#include <glm/gtc/type_ptr.hpp>
 #include "shaderprogram.h"
+#include "programbinarycache.h"
+#include "uniformbuffer.h"
+#include "programpipeline.h"
+#include "embeddedshaders.h"
+
+// Older GLEW versions lack the parallel compile extensions
+#ifndef GL_COMPLETION_STATUS_KHR
+#define GL_COMPLETION_STATUS_KHR 0x91B1
+#endif
+
+namespace
+{
+	/**
+	 * \brief Bytes of one element of a uniform type, 0 for types whose values are not cached
+	 */
+	size_t getUniformTypeSize(GLenum type)
+	{
+		switch (type)
+		{
+		case GL_FLOAT: return 4;
+		case GL_FLOAT_VEC2: return 8;
+		case GL_FLOAT_VEC3: return 12;
+		case GL_FLOAT_VEC4: return 16;
+		case GL_INT: case GL_BOOL: return 4;
+		case GL_INT_VEC2: case GL_BOOL_VEC2: return 8;
+		case GL_INT_VEC3: case GL_BOOL_VEC3: return 12;
+		case GL_INT_VEC4: case GL_BOOL_VEC4: return 16;
+		case GL_FLOAT_MAT2: return 16;
+		case GL_FLOAT_MAT3: return 36;
+		case GL_FLOAT_MAT4: return 64;
+		case GL_SAMPLER_1D: case GL_SAMPLER_2D: case GL_SAMPLER_3D: case GL_SAMPLER_CUBE:
+		case GL_SAMPLER_2D_SHADOW: case GL_SAMPLER_2D_ARRAY: case GL_SAMPLER_BUFFER:
+		case GL_INT_SAMPLER_2D: case GL_UNSIGNED_INT_SAMPLER_2D: return 4;
+		default: return 0;
+		}
+	}
+}
 
 bool ShaderProgram::loadFile(const std::string &filename, std::string &contents) const
 {
+	// Files compiled into the executable need no I/O
+	const EmbeddedShader *embedded = EmbeddedShaders::find(filename);
+	if (embedded)
+	{
+		contents.assign(embedded->source, embedded->length);
+		return true;
+	}
+
 	std::ifstream is(filename.c_str(), std::ifstream::binary);
 
 	if (!is.is_open())
@@ -25,7 +73,98 @@ bool ShaderProgram::loadFile(const std::string &filename, std::string &contents)
 }
 
 /**
- * Compile a single shader.
+ * \brief Read a shader file and replace #include "file" lines with the contents of the file
+ *
+ * #line directives keep line numbers of compile errors correct. Each file gets its own source string number,
+ * which is its index in files.
+ */
+bool ShaderProgram::expandIncludes(const std::string &filename, std::string &source, std::vector<std::string> &files, int depth) const
+{
+	if (depth > 16)
+	{
+		std::cerr << "ShaderProgram: #include nested too deeply in '" << filename << "'" << std::endl;
+		return false;
+	}
+
+	std::string contents;
+	if (!loadFile(filename, contents))
+		return false;
+
+	size_t fileIndex = files.size();
+	files.push_back(filename);
+
+	// Included paths are relative to the including file
+	size_t slash = filename.find_last_of("/\\");
+	std::string directory = slash == std::string::npos ? std::string() : filename.substr(0, slash + 1);
+
+	std::istringstream lines(contents);
+	std::string line;
+	int lineNumber = 0;
+	while (std::getline(lines, line))
+	{
+		++lineNumber;
+
+		size_t first = line.find_first_not_of(" \t");
+		if (first == std::string::npos || line.compare(first, 8, "#include") != 0)
+		{
+			source += line;
+			source += '\n';
+			continue;
+		}
+
+		size_t open = line.find('"', first + 8);
+		size_t close = open == std::string::npos ? open : line.find('"', open + 1);
+		if (close == std::string::npos)
+		{
+			std::cerr << filename << "(" << lineNumber << "): Malformed #include, expected #include \"file\"" << std::endl;
+			return false;
+		}
+
+		source += "#line 1 " + std::to_string(files.size()) + "\n";
+		if (!expandIncludes(directory + line.substr(open + 1, close - open - 1), source, files, depth + 1))
+		{
+			std::cerr << "  included from " << filename << "(" << lineNumber << ")" << std::endl;
+			return false;
+		}
+		source += "#line " + std::to_string(lineNumber + 1) + " " + std::to_string(fileIndex) + "\n";
+	}
+
+	return true;
+}
+
+/**
+ * \brief Load a shader file with includes expanded and defines inserted after the #version line
+ * \param[out] files Names of the files in the source by source string number
+ */
+bool ShaderProgram::preprocess(const std::string &filename, const Defines &defines, std::string &source, std::vector<std::string> &files) const
+{
+	files.clear();
+	std::string expanded;
+	if (!expandIncludes(filename, expanded, files, 0))
+		return false;
+
+	// #version must stay the first directive
+	size_t insertAt = 0;
+	int nextLine = 1;
+	size_t version = expanded.find("#version");
+	if (version != std::string::npos)
+	{
+		insertAt = expanded.find('\n', version);
+		insertAt = insertAt == std::string::npos ? expanded.size() : insertAt + 1;
+		nextLine = static_cast<int>(std::count(expanded.begin(), expanded.begin() + insertAt, '\n')) + 1;
+	}
+
+	std::ostringstream header;
+	for (Defines::const_iterator it = defines.begin(); it != defines.end(); ++it)
+		header << "#define " << it->first << " " << it->second << "\n";
+	header << "#line " << nextLine << " 0\n";
+
+	source = expanded.substr(0, insertAt) + header.str() + expanded.substr(insertAt);
+	return true;
+}
+
+/**
+ * Issue compilation of a single shader. The result is checked later with checkCompileStatus().
  * \param shadertype GL_FRAGMENT_SHADER, GL_VERTEX_SHADER etc.
  * \param source Shader source
  * \param[out] shaderhandle Allocated handle for the new shader if successful
@@ -34,53 +173,75 @@ bool ShaderProgram::compile(GLenum shadertype, const std::string &source, GLuint
 {
 	// Allocate handle for new shader
 	shaderhandle = glCreateShader(shadertype);
+	if (!shaderhandle)
+		return false;
 
 	// Set shader source to come from a single string. glShaderSource() supports multiple strings that are concatenated together.
 	const GLchar *src = source.c_str();
 	glShaderSource(shaderhandle, 1, &src, 0);
 
-	// Try to compile it
-	GLint isCompiled;
+	// Querying the status here would wait for the compiler, so that is left to finishLoad()
 	glCompileShader(shaderhandle);
-	glGetShaderiv(shaderhandle, GL_COMPILE_STATUS, &isCompiled);
+	return true;
+}
 
-	if (!isCompiled)
-	{
-		GLint maxlen;
-		// Something was wrong. Query for any error/information string lengths. It includes \0 at the end.
-		glGetShaderiv(shaderhandle, GL_INFO_LOG_LENGTH, &maxlen);
-		std::string errstr;
-		errstr.resize(maxlen);
-		glGetShaderInfoLog(shaderhandle, maxlen, &maxlen, &errstr[0]);
+/**
+ * \brief Print the info log of a shader that failed to compile
+ * \return true if the shader compiled successfully
+ */
+bool ShaderProgram::checkCompileStatus(GLuint shaderhandle, const std::vector<std::string> &files) const
+{
+	GLint isCompiled;
+	glGetShaderiv(shaderhandle, GL_COMPILE_STATUS, &isCompiled);
+	if (isCompiled)
+		return true;
 
-		std::cerr << "Unable to compile shader: " << std::endl << errstr << std::endl;
+	GLint maxlen;
+	// Something was wrong. Query for any error/information string lengths. It includes \0 at the end.
+	glGetShaderiv(shaderhandle, GL_INFO_LOG_LENGTH, &maxlen);
+	std::string errstr;
+	errstr.resize(std::max(maxlen, 1));
+	glGetShaderInfoLog(shaderhandle, maxlen, &maxlen, &errstr[0]);
 
-		// Release shader
-		glDeleteShader(shaderhandle);
-		shaderhandle = 0;
-		return false;
+	std::cerr << "Unable to compile shader '" << files[0] << "':" << std::endl << errstr << std::endl;
+	if (files.size() > 1)
+	{
+		std::cerr << "Source strings:";
+		for (size_t i = 0; i < files.size(); ++i)
+			std::cerr << " " << i << " = " << files[i];
+		std::cerr << std::endl;
 	}
-
-	// Everything should be ok now.
-	return true;
+	return false;
 }
 
 ShaderProgram::ShaderProgram() :
 	vertexshader(0),
 	fragmentshader(0),
-	shaderprogram(0)
+	shaderprogram(0),
+	stages(0),
+	linkPending(false)
 {
 }
 
 ShaderProgram::ShaderProgram(const std::string &vertexshaderfile, const std::string &fragmentshaderfile) :
 	vertexshader(0),
 	fragmentshader(0),
-	shaderprogram(0)
+	shaderprogram(0),
+	stages(0),
+	linkPending(false)
 {
 	load(vertexshaderfile, fragmentshaderfile);
 }
 
 ShaderProgram::~ShaderProgram()
+{
+	release();
+}
+
+/**
+ * \brief Delete shaders and the program, e.g. before loading another one
+ */
+void ShaderProgram::release()
 {
 	// In this implementation, independent shaders have already been released except the final program but
 	// we need to make sure that it also happens in case we encounter some problem during shader compilation and linking.
@@ -90,32 +251,162 @@ ShaderProgram::~ShaderProgram()
 		glDeleteShader(fragmentshader);
 	if (shaderprogram)
 		glDeleteProgram(shaderprogram);
+
+	vertexshader = 0;
+	fragmentshader = 0;
+	shaderprogram = 0;
+	stages = 0;
+	linkPending = false;
+
+	uniforms.clear();
+	uniformValues.clear();
+	attributes.clear();
+	uniformBlocks.clear();
+}
+
+/**
+ * \brief Load, compile and link a program
+ * \param defines Preprocessor definitions inserted to both shaders
+ * \return false if the files could not be loaded or the program failed to compile or link
+ */
+bool ShaderProgram::load(const std::string &vertexshaderfile, const std::string &fragmentshaderfile, const Defines &defines)
+{
+	return startLoad(vertexshaderfile, fragmentshaderfile, defines) && finishLoad();
+}
+
+/**
+ * \brief Load shader files and issue compiling and linking without waiting for the result
+ *
+ * The program can not be used before finishLoad().
+ * \return false if the files could not be loaded
+ */
+bool ShaderProgram::startLoad(const std::string &vertexshaderfile, const std::string &fragmentshaderfile, const Defines &defines)
+{
+	return startLoadShaders(vertexshaderfile, fragmentshaderfile, defines, 0);
+}
+
+/**
+ * \brief Load, compile and link a separable program of a single stage for ProgramPipeline
+ * \param shadertype GL_VERTEX_SHADER or GL_FRAGMENT_SHADER
+ */
+bool ShaderProgram::loadStage(GLenum shadertype, const std::string &shaderfile, const Defines &defines)
+{
+	return startLoadStage(shadertype, shaderfile, defines) && finishLoad();
 }
 
-bool ShaderProgram::load(const std::string &vertexshaderfile, const std::string &fragmentshaderfile)
+/**
+ * \brief Like startLoad() for a separable program of a single stage
+ * \param shadertype GL_VERTEX_SHADER or GL_FRAGMENT_SHADER
+ */
+bool ShaderProgram::startLoadStage(GLenum shadertype, const std::string &shaderfile, const Defines &defines)
+{
+	if (!ProgramPipeline::isSupported())
+	{
+		std::cerr << "ShaderProgram::startLoadStage(): ARB_separate_shader_objects is not supported" << std::endl;
+		release();
+		return false;
+	}
+
+	if (shadertype == GL_VERTEX_SHADER)
+		return startLoadShaders(shaderfile, std::string(), defines, GL_VERTEX_SHADER_BIT);
+	else
+	if (shadertype == GL_FRAGMENT_SHADER)
+		return startLoadShaders(std::string(), shaderfile, defines, GL_FRAGMENT_SHADER_BIT);
+
+	std::cerr << "ShaderProgram::startLoadStage(): Unsupported shader type " << shadertype << std::endl;
+	release();
+	return false;
+}
+
+/**
+ * \brief String identifying the sources of the program for the binary cache
+ *
+ * If every file, includes too, is embedded, the names and precomputed hashes of the files identify the program and
+ * the preprocessed sources need not be hashed again. Otherwise the sources are used as they are.
+ */
+std::string ShaderProgram::getSourceIdentity(const std::string &sources) const
 {
+	std::ostringstream identity;
+	identity << std::hex;
+
+	for (int stage = 0; stage < 2; ++stage)
+	{
+		const std::vector<std::string> &files = stage == 0 ? vertexFiles : fragmentFiles;
+		for (size_t i = 0; i < files.size(); ++i)
+		{
+			const EmbeddedShader *embedded = EmbeddedShaders::find(files[i]);
+			if (!embedded)
+				return sources;
+			identity << files[i] << '@' << embedded->hash << '\n';
+		}
+		identity << '\0';
+	}
+	return identity.str();
+}
+
+/**
+ * \brief Issue compiling and linking of the given shader files. Empty file names are left out of the program.
+ * \param separableStages Stage bits for a separable program, 0 for a complete program
+ */
+bool ShaderProgram::startLoadShaders(const std::string &vertexshaderfile, const std::string &fragmentshaderfile, const Defines &defines, GLbitfield separableStages)
+{
+	// Loading again replaces the previous program
+	release();
+
 	std::string vs;
 	std::string fs;
+	vertexFiles.clear();
+	fragmentFiles.clear();
 
 	// Load shader strings
-	if ((!loadFile(vertexshaderfile, vs)) ||
-		(!loadFile(fragmentshaderfile, fs)))
+	if ((!vertexshaderfile.empty() && !preprocess(vertexshaderfile, defines, vs, vertexFiles)) ||
+		(!fragmentshaderfile.empty() && !preprocess(fragmentshaderfile, defines, fs, fragmentFiles)))
 	{
 		// Unable to load one of the shader sources
 		return false;
 	}
 
-	// Compile vertex shader
-	if (!compile(GL_VERTEX_SHADER, vs, vertexshader))
+	// Use the program binary stored by an earlier run if the driver accepts it.
+	// Separable programs must be marked before restoring so that the flag matches the binary.
+	cacheKey = ProgramBinaryCache::getKey(getSourceIdentity(vs + '\0' + fs), getDefinesKey(defines) + (separableStages ? "separable" : ""));
+	shaderprogram = glCreateProgram();
+	if (shaderprogram && separableStages)
+		glProgramParameteri(shaderprogram, GL_PROGRAM_SEPARABLE, GL_TRUE);
+	if (shaderprogram && ProgramBinaryCache::load(shaderprogram, cacheKey))
 	{
-		std::cerr << "Unable to compile '" << vertexshaderfile << std::endl;
-		return false;
+		stages = separableStages;
+		reflect();
+		return true;
+	}
+
+	// Program object with a rejected binary can't be relinked reliably on all drivers
+	if (shaderprogram)
+	{
+		glDeleteProgram(shaderprogram);
+		shaderprogram = 0;
 	}
 
-	// Compile fragment shader
-	if (!compile(GL_FRAGMENT_SHADER, fs, fragmentshader))
+	// Let the driver use as many compiler threads as it likes. Compiling and linking then return immediately.
+	static bool parallelCompileEnabled = false;
+	if (!parallelCompileEnabled)
 	{
-		std::cerr << "Unable to compile '" << fragmentshaderfile << std::endl;
+#ifdef GL_KHR_parallel_shader_compile
+		if (GLEW_KHR_parallel_shader_compile)
+			glMaxShaderCompilerThreadsKHR(0xffffffff);
+#endif
+#ifdef GL_ARB_parallel_shader_compile
+		if (GLEW_ARB_parallel_shader_compile)
+			glMaxShaderCompilerThreadsARB(0xffffffff);
+#endif
+		parallelCompileEnabled = true;
+	}
+
+	// Compile vertex and fragment shaders
+	if ((!vertexshaderfile.empty() && !compile(GL_VERTEX_SHADER, vs, vertexshader)) ||
+		(!fragmentshaderfile.empty() && !compile(GL_FRAGMENT_SHADER, fs, fragmentshader)))
+	{
+		std::cerr << "Unable to create shaders for " << vertexshaderfile << " and " << fragmentshaderfile << std::endl;
+		release();
 		return false;
 	}
 
@@ -125,25 +416,383 @@ bool ShaderProgram::load(const std::string &vertexshaderfile, const std::string
 	if (shaderprogram == 0)
 	{
 		std::cerr << "Unable to create shader program using " << vertexshaderfile << " and " << fragmentshaderfile << std::endl;
+		release();
 		return false;
 	}
 
 	// Attach different shader passes to shader program
-	glAttachShader(shaderprogram, vertexshader);
-	glAttachShader(shaderprogram, fragmentshader);
+	if (vertexshader)
+		glAttachShader(shaderprogram, vertexshader);
+	if (fragmentshader)
+		glAttachShader(shaderprogram, fragmentshader);
+
+	// Stages are linked on their own and combined with other stages in a program pipeline
+	stages = separableStages;
+	if (stages)
+		glProgramParameteri(shaderprogram, GL_PROGRAM_SEPARABLE, GL_TRUE);
 
-	// Link shaders into an executable
+	// Link shaders into an executable. Drivers defer this until the compile results are available.
+	ProgramBinaryCache::prepare(shaderprogram);
 	glLinkProgram(shaderprogram);
+	linkPending = true;
+
+	return true;
+}
+
+/**
+ * \brief True if finishLoad() will not have to wait for the compiler
+ *
+ * Always true without KHR_parallel_shader_compile, in which case compiling happens inside finishLoad().
+ */
+bool ShaderProgram::isLoadComplete() const
+{
+	if (!linkPending || !isParallelCompileSupported())
+		return true;
+
+	GLint complete = GL_TRUE;
+	glGetProgramiv(shaderprogram, GL_COMPLETION_STATUS_KHR, &complete);
+	return complete == GL_TRUE;
+}
+
+/**
+ * \brief Wait for compiling and linking started by startLoad() to finish
+ * \return true if the program is ready to use
+ */
+bool ShaderProgram::finishLoad()
+{
+	if (!linkPending)
+		return shaderprogram != 0;
+	linkPending = false;
+
+	GLint linked = GL_FALSE;
+	glGetProgramiv(shaderprogram, GL_LINK_STATUS, &linked);
+	if (linked != GL_TRUE)
+	{
+		if ((!vertexshader || checkCompileStatus(vertexshader, vertexFiles)) &&
+			(!fragmentshader || checkCompileStatus(fragmentshader, fragmentFiles)))
+		{
+			GLint maxlen = 0;
+			glGetProgramiv(shaderprogram, GL_INFO_LOG_LENGTH, &maxlen);
+			std::string errstr;
+			errstr.resize(std::max(maxlen, 1));
+			glGetProgramInfoLog(shaderprogram, maxlen, &maxlen, &errstr[0]);
+			std::cerr << "Unable to link '" << (vertexFiles.empty() ? "" : vertexFiles[0]) << "' and '" << (fragmentFiles.empty() ? "" : fragmentFiles[0]) << "':" << std::endl << errstr << std::endl;
+		}
+
+		release();
+		return false;
+	}
+
+	// Save the binary for the next run
+	ProgramBinaryCache::store(shaderprogram, cacheKey);
+	reflect();
 
 	// Now that we have linked shaders to a program, we can detach and delete individual shaders.
 	// This frees up memory (shader sources) that are no longer needed. The rest of the resources are released
 	// automatically when the program is deleted (assuming non-buggy drivers..).
-	glDetachShader(shaderprogram, vertexshader);
-	glDeleteShader(vertexshader);
-	vertexshader = 0;
-	glDetachShader(shaderprogram, fragmentshader);
-	glDeleteShader(fragmentshader);
-	fragmentshader = 0;
+	if (vertexshader)
+	{
+		glDetachShader(shaderprogram, vertexshader);
+		glDeleteShader(vertexshader);
+		vertexshader = 0;
+	}
+	if (fragmentshader)
+	{
+		glDetachShader(shaderprogram, fragmentshader);
+		glDeleteShader(fragmentshader);
+		fragmentshader = 0;
+	}
 
 	return true;
 }
+
+/**
+ * \brief Defines as a string for cache keys, e.g. "DIFFUSE=vec4(1.0);SHININESS=80.0;"
+ */
+std::string ShaderProgram::getDefinesKey(const Defines &defines)
+{
+	std::string key;
+	for (Defines::const_iterator it = defines.begin(); it != defines.end(); ++it)
+		key += it->first + "=" + it->second + ";";
+	return key;
+}
+
+/**
+ * \brief Check if the driver compiles shaders in the background (KHR_parallel_shader_compile or ARB_parallel_shader_compile)
+ */
+bool ShaderProgram::isParallelCompileSupported()
+{
+#if defined(GL_KHR_parallel_shader_compile) || defined(GL_ARB_parallel_shader_compile)
+	bool supported = false;
+#ifdef GL_KHR_parallel_shader_compile
+	supported = supported || GLEW_KHR_parallel_shader_compile;
+#endif
+#ifdef GL_ARB_parallel_shader_compile
+	supported = supported || GLEW_ARB_parallel_shader_compile;
+#endif
+	return supported;
+#else
+	return false;
+#endif
+}
+
+/**
+ * \brief List active uniforms, attributes and uniform blocks of the linked program
+ */
+void ShaderProgram::reflect()
+{
+	uniforms.clear();
+	uniformValues.clear();
+	attributes.clear();
+	uniformBlocks.clear();
+
+	GLint count = 0;
+	GLint maxLength = 0;
+	std::vector<GLchar> name;
+
+	glGetProgramiv(shaderprogram, GL_ACTIVE_UNIFORMS, &count);
+	glGetProgramiv(shaderprogram, GL_ACTIVE_UNIFORM_MAX_LENGTH, &maxLength);
+	name.resize(std::max(maxLength, 1));
+	for (GLint i = 0; i < count; ++i)
+	{
+		Uniform uniform;
+		GLsizei length = 0;
+		glGetActiveUniform(shaderprogram, i, static_cast<GLsizei>(name.size()), &length, &uniform.size, &uniform.type, &name[0]);
+		uniform.name.assign(&name[0], length);
+		uniform.location = glGetUniformLocation(shaderprogram, &name[0]);
+
+		// Members of uniform blocks have no location and are set through buffers
+		if (uniform.location < 0)
+			continue;
+
+		if (uniform.name.size() > 3 && uniform.name.compare(uniform.name.size() - 3, 3, "[0]") == 0)
+			uniform.name.resize(uniform.name.size() - 3);
+
+		uniform.cacheSize = getUniformTypeSize(uniform.type) * uniform.size;
+		uniform.cacheOffset = uniformValues.size();
+		uniform.valueSet = false;
+		uniformValues.resize(uniformValues.size() + uniform.cacheSize);
+		uniforms.push_back(uniform);
+	}
+
+	glGetProgramiv(shaderprogram, GL_ACTIVE_ATTRIBUTES, &count);
+	glGetProgramiv(shaderprogram, GL_ACTIVE_ATTRIBUTE_MAX_LENGTH, &maxLength);
+	name.resize(std::max(maxLength, 1));
+	for (GLint i = 0; i < count; ++i)
+	{
+		Attribute attribute;
+		GLsizei length = 0;
+		glGetActiveAttrib(shaderprogram, i, static_cast<GLsizei>(name.size()), &length, &attribute.size, &attribute.type, &name[0]);
+		attribute.name.assign(&name[0], length);
+		attribute.location = glGetAttribLocation(shaderprogram, &name[0]);
+
+		// Built-in inputs like gl_VertexID have no location
+		if (attribute.location >= 0)
+			attributes.push_back(attribute);
+	}
+
+	glGetProgramiv(shaderprogram, GL_ACTIVE_UNIFORM_BLOCKS, &count);
+	glGetProgramiv(shaderprogram, GL_ACTIVE_UNIFORM_BLOCK_MAX_NAME_LENGTH, &maxLength);
+	name.resize(std::max(maxLength, 1));
+	for (GLint i = 0; i < count; ++i)
+	{
+		UniformBlock block;
+		GLsizei length = 0;
+		glGetActiveUniformBlockName(shaderprogram, i, static_cast<GLsizei>(name.size()), &length, &name[0]);
+		block.name.assign(&name[0], length);
+		block.index = i;
+		glGetActiveUniformBlockiv(shaderprogram, i, GL_UNIFORM_BLOCK_DATA_SIZE, &block.dataSize);
+
+		// Shared blocks are connected to their binding points here as GLSL 3.30 has no layout(binding)
+		GLuint binding = UniformBuffer::getBlockBinding(block.name);
+		if (binding != GL_INVALID_INDEX)
+			glUniformBlockBinding(shaderprogram, i, binding);
+
+		glGetActiveUniformBlockiv(shaderprogram, i, GL_UNIFORM_BLOCK_BINDING, &block.binding);
+		uniformBlocks.push_back(block);
+	}
+}
+
+/**
+ * \brief Get a handle for setUniform()
+ *
+ * Look handles up once after load(), not every frame.
+ * \return Handle or -1 if the program has no active uniform with this name
+ */
+int ShaderProgram::getUniform(const std::string &name) const
+{
+	for (size_t i = 0; i < uniforms.size(); ++i)
+	{
+		if (uniforms[i].name == name)
+			return static_cast<int>(i);
+	}
+	return -1;
+}
+
+/**
+ * \brief OpenGL location of a uniform, -1 if not active
+ */
+GLint ShaderProgram::getUniformLocation(const std::string &name) const
+{
+	int handle = getUniform(name);
+	return handle >= 0 ? uniforms[handle].location : -1;
+}
+
+/**
+ * \brief Location of a vertex attribute, -1 if not active
+ */
+GLint ShaderProgram::getAttribLocation(const std::string &name) const
+{
+	for (size_t i = 0; i < attributes.size(); ++i)
+	{
+		if (attributes[i].name == name)
+			return attributes[i].location;
+	}
+	return -1;
+}
+
+GLuint ShaderProgram::getAttribLocation(const std::string &name, GLuint defaultLocation) const
+{
+	GLint location = getAttribLocation(name);
+	return location >= 0 ? static_cast<GLuint>(location) : defaultLocation;
+}
+
+/**
+ * \brief Index of a uniform block for glUniformBlockBinding(), GL_INVALID_INDEX if not active
+ */
+GLint ShaderProgram::getUniformBlockIndex(const std::string &name) const
+{
+	for (size_t i = 0; i < uniformBlocks.size(); ++i)
+	{
+		if (uniformBlocks[i].name == name)
+			return uniformBlocks[i].index;
+	}
+	return GL_INVALID_INDEX;
+}
+
+/**
+ * \brief Store a new uniform value in the cache
+ * \return true if the value differs from the last set value and has to be sent to OpenGL
+ */
+bool ShaderProgram::changeUniform(int handle, const void *value, size_t bytes)
+{
+	if (handle < 0 || handle >= static_cast<int>(uniforms.size()))
+		return false;
+
+	Uniform &uniform = uniforms[handle];
+	if (bytes > uniform.cacheSize)
+		return true;
+
+	unsigned char *cached = &uniformValues[uniform.cacheOffset];
+	if (uniform.valueSet && std::memcmp(cached, value, bytes) == 0)
+		return false;
+
+	std::memcpy(cached, value, bytes);
+	uniform.valueSet = true;
+	return true;
+}
+
+void ShaderProgram::setUniform(int handle, GLint value)
+{
+	if (!changeUniform(handle, &value, sizeof(value)))
+		return;
+
+	if (stages)
+		glProgramUniform1i(shaderprogram, uniforms[handle].location, value);
+	else
+		glUniform1i(uniforms[handle].location, value);
+}
+
+void ShaderProgram::setUniform(int handle, GLfloat value)
+{
+	if (!changeUniform(handle, &value, sizeof(value)))
+		return;
+
+	if (stages)
+		glProgramUniform1f(shaderprogram, uniforms[handle].location, value);
+	else
+		glUniform1f(uniforms[handle].location, value);
+}
+
+void ShaderProgram::setUniform(int handle, const glm::vec2 &value)
+{
+	if (!changeUniform(handle, glm::value_ptr(value), sizeof(value)))
+		return;
+
+	if (stages)
+		glProgramUniform2fv(shaderprogram, uniforms[handle].location, 1, glm::value_ptr(value));
+	else
+		glUniform2fv(uniforms[handle].location, 1, glm::value_ptr(value));
+}
+
+void ShaderProgram::setUniform(int handle, const glm::vec3 &value)
+{
+	if (!changeUniform(handle, glm::value_ptr(value), sizeof(value)))
+		return;
+
+	if (stages)
+		glProgramUniform3fv(shaderprogram, uniforms[handle].location, 1, glm::value_ptr(value));
+	else
+		glUniform3fv(uniforms[handle].location, 1, glm::value_ptr(value));
+}
+
+void ShaderProgram::setUniform(int handle, const glm::vec4 &value)
+{
+	if (!changeUniform(handle, glm::value_ptr(value), sizeof(value)))
+		return;
+
+	if (stages)
+		glProgramUniform4fv(shaderprogram, uniforms[handle].location, 1, glm::value_ptr(value));
+	else
+		glUniform4fv(uniforms[handle].location, 1, glm::value_ptr(value));
+}
+
+void ShaderProgram::setUniform(int handle, const glm::mat3 &value)
+{
+	if (!changeUniform(handle, glm::value_ptr(value), sizeof(value)))
+		return;
+
+	if (stages)
+		glProgramUniformMatrix3fv(shaderprogram, uniforms[handle].location, 1, GL_FALSE, glm::value_ptr(value));
+	else
+		glUniformMatrix3fv(uniforms[handle].location, 1, GL_FALSE, glm::value_ptr(value));
+}
+
+void ShaderProgram::setUniform(int handle, const glm::mat4 &value)
+{
+	if (!changeUniform(handle, glm::value_ptr(value), sizeof(value)))
+		return;
+
+	if (stages)
+		glProgramUniformMatrix4fv(shaderprogram, uniforms[handle].location, 1, GL_FALSE, glm::value_ptr(value));
+	else
+		glUniformMatrix4fv(uniforms[handle].location, 1, GL_FALSE, glm::value_ptr(value));
+}
+
+/**
+ * \brief Set elements of an int or sampler array starting from the first one
+ */
+void ShaderProgram::setUniform(int handle, const GLint *values, GLsizei count)
+{
+	if (!changeUniform(handle, values, sizeof(GLint) * count))
+		return;
+
+	if (stages)
+		glProgramUniform1iv(shaderprogram, uniforms[handle].location, count, values);
+	else
+		glUniform1iv(uniforms[handle].location, count, values);
+}
+
+/**
+ * \brief Set elements of a float array starting from the first one
+ */
+void ShaderProgram::setUniform(int handle, const GLfloat *values, GLsizei count)
+{
+	if (!changeUniform(handle, values, sizeof(GLfloat) * count))
+		return;
+
+	if (stages)
+		glProgramUniform1fv(shaderprogram, uniforms[handle].location, count, values);
+	else
+		glUniform1fv(uniforms[handle].location, count, values);
+}
@@ -6,36 +6,157 @@
 #define SHADERPROGRAM_H_
 
 #include <string>
+#include <vector>
+#include <map>
 #include <GL/glew.h>
+#include <glm/glm.hpp>
 
 /**
  * \brief Class to load shaders from file and compile them into combined programs to run on GPU
+ *
+ * After linking, active uniforms, vertex attributes and uniform blocks are listed into tables. Look up uniform handles
+ * once with getUniform() and set values with setUniform(), which skips the glUniform*() call if the uniform already
+ * has the same value. Values set with glUniform*() directly bypass this cache.
+ *
+ * Shader files can use #include "file" with paths relative to the including file. Defines given to load() are
+ * inserted after the #version line, so one source file produces variants with constants folded at compile time.
+ * Compile errors refer to files by source string number, which is printed with the errors.
+ *
+ * startLoad() only issues compilation. Start several programs before calling finishLoad() on any of them so that
+ * drivers with KHR_parallel_shader_compile can compile them on multiple threads. load() does both at once.
+ *
+ * loadStage() builds a separable program of a single stage to be combined with other stages in a ProgramPipeline.
  */
 class ShaderProgram
 {
+public:
+	/**
+	 * \brief Active uniform outside uniform blocks
+	 */
+	struct Uniform
+	{
+		std::string name;  ///< Arrays without the "[0]" suffix
+		GLint location;
+		GLenum type;       ///< GL_FLOAT_VEC4, GL_SAMPLER_2D etc.
+		GLint size;        ///< Number of array elements, 1 for non-arrays
+		size_t cacheOffset; ///< Position of the last set value in uniformValues
+		size_t cacheSize;   ///< Bytes of the value, 0 if not cached
+		bool valueSet;      ///< False until the value has been set through setUniform()
+	};
+
+	/**
+	 * \brief Active vertex attribute
+	 */
+	struct Attribute
+	{
+		std::string name;
+		GLint location;
+		GLenum type;
+		GLint size;
+	};
+
+	/**
+	 * \brief Active uniform block
+	 */
+	struct UniformBlock
+	{
+		std::string name;
+		GLuint index;    ///< For glUniformBlockBinding()
+		GLint dataSize;  ///< Minimum buffer size in bytes
+		GLint binding;   ///< Binding point at link time
+	};
+
+	/**
+	 * \brief Preprocessor definitions, name to value. Value can be empty.
+	 */
+	typedef std::map<std::string, std::string> Defines;
+
+private:
 	GLuint vertexshader;
 	GLuint fragmentshader;
 	GLuint shaderprogram;
 
+	GLbitfield stages;                      // Stage bits of a separable program, 0 for complete programs
+	bool linkPending;                       // Link issued by startLoad() but status not checked yet
+	std::string cacheKey;                   // ProgramBinaryCache key of the program being loaded
+	std::vector<std::string> vertexFiles;   // Files of the vertex shader by source string number
+	std::vector<std::string> fragmentFiles; // Files of the fragment shader by source string number
+
+	std::vector<Uniform> uniforms;
+	std::vector<unsigned char> uniformValues; // Last set values of all uniforms
+	std::vector<Attribute> attributes;
+	std::vector<UniformBlock> uniformBlocks;
+
 	bool loadFile(const std::string &filename, std::string &contents) const;
+	bool expandIncludes(const std::string &filename, std::string &source, std::vector<std::string> &files, int depth) const;
+	bool preprocess(const std::string &filename, const Defines &defines, std::string &source, std::vector<std::string> &files) const;
+	std::string getSourceIdentity(const std::string &sources) const;
 	bool compile(GLenum shadertype, const std::string &source, GLuint &shaderhandle);
+	bool checkCompileStatus(GLuint shaderhandle, const std::vector<std::string> &files) const;
+	bool startLoadShaders(const std::string &vertexshaderfile, const std::string &fragmentshaderfile, const Defines &defines, GLbitfield separableStages);
+	void release();
+	void reflect();
+	bool changeUniform(int handle, const void *value, size_t bytes);
+	GLuint getAttribLocation(const std::string &name, GLuint defaultLocation) const;
+
+	ShaderProgram(const ShaderProgram &);
+	ShaderProgram &operator=(const ShaderProgram &);
 public:
 	ShaderProgram();
 	ShaderProgram(const std::string &vertexshader, const std::string &fragmentshader);
 	~ShaderProgram();
 
-	bool load(const std::string &vertexshader, const std::string &fragmentshader);
+	bool load(const std::string &vertexshader, const std::string &fragmentshader, const Defines &defines = Defines());
+	bool startLoad(const std::string &vertexshader, const std::string &fragmentshader, const Defines &defines = Defines());
+	bool finishLoad();
+	bool loadStage(GLenum shadertype, const std::string &shaderfile, const Defines &defines = Defines());
+	bool startLoadStage(GLenum shadertype, const std::string &shaderfile, const Defines &defines = Defines());
+	bool isLoadComplete() const;
+
+	static std::string getDefinesKey(const Defines &defines);
+	static bool isParallelCompileSupported();
 
-	GLuint getShaderProgram()
+	GLuint getShaderProgram() const
 	{
 		return shaderprogram;
 	}
 
-	GLuint getPositionAttribLocation() const { return 0; } 
-	GLuint getColorAttribLocation() const { return 1; }
-	GLuint getNormalAttribLocation() const { return 2; }
-	GLuint getTexture0AttribLocation() const { return 3; }
-	GLuint getTexture1AttribLocation() const { return 4; }
+	/**
+	 * \brief GL_VERTEX_SHADER_BIT or GL_FRAGMENT_SHADER_BIT for programs loaded with loadStage(), otherwise 0
+	 */
+	GLbitfield getStages() const
+	{
+		return stages;
+	}
+
+	int getUniform(const std::string &name) const;
+	GLint getUniformLocation(const std::string &name) const;
+	GLint getAttribLocation(const std::string &name) const;
+	GLint getUniformBlockIndex(const std::string &name) const;
+
+	// Program must be in use with glUseProgram(), except stages which are set with glProgramUniform*().
+	// Handles of -1 are ignored like location -1 in glUniform*().
+	void setUniform(int handle, GLint value);
+	void setUniform(int handle, GLfloat value);
+	void setUniform(int handle, const glm::vec2 &value);
+	void setUniform(int handle, const glm::vec3 &value);
+	void setUniform(int handle, const glm::vec4 &value);
+	void setUniform(int handle, const glm::mat3 &value);
+	void setUniform(int handle, const glm::mat4 &value);
+	void setUniform(int handle, const GLint *values, GLsizei count);
+	void setUniform(int handle, const GLfloat *values, GLsizei count);
+
+	const std::vector<Uniform> &getUniforms() const { return uniforms; }
+	const std::vector<Attribute> &getAttributes() const { return attributes; }
+	const std::vector<UniformBlock> &getUniformBlocks() const { return uniformBlocks; }
+
+	// Locations of the in_Position, in_Color, in_Normal, in_TexCoord0 and in_TexCoord1 attributes.
+	// Conventional locations are returned for attributes the program doesn't use.
+	GLuint getPositionAttribLocation() const { return getAttribLocation("in_Position", 0); }
+	GLuint getColorAttribLocation() const { return getAttribLocation("in_Color", 1); }
+	GLuint getNormalAttribLocation() const { return getAttribLocation("in_Normal", 2); }
+	GLuint getTexture0AttribLocation() const { return getAttribLocation("in_TexCoord0", 3); }
+	GLuint getTexture1AttribLocation() const { return getAttribLocation("in_TexCoord1", 4); }
 };
 
 #endif
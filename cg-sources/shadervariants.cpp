@@ -0,0 +1,45 @@
+/**
+ * \brief Shader program permutation implementation
+ * \file
+ */
+#include "shadervariants.h"
+
+ShaderVariants::ShaderVariants(const std::string &vertexShaderFile, const std::string &fragmentShaderFile) :
+	vertexShaderFile(vertexShaderFile),
+	fragmentShaderFile(fragmentShaderFile)
+{
+}
+
+/**
+ * \brief Start compiling a variant unless it has been requested already
+ */
+void ShaderVariants::request(const ShaderProgram::Defines &defines)
+{
+	std::unique_ptr<ShaderProgram> &program = programs[ShaderProgram::getDefinesKey(defines)];
+	if (program)
+		return;
+
+	program.reset(new ShaderProgram());
+	program->startLoad(vertexShaderFile, fragmentShaderFile, defines);
+}
+
+/**
+ * \brief Get a variant, compiling it first if needed
+ * \return Linked program or 0 if the variant failed to compile. Failed variants are not retried.
+ */
+ShaderProgram *ShaderVariants::get(const ShaderProgram::Defines &defines)
+{
+	request(defines);
+
+	ShaderProgram *program = programs[ShaderProgram::getDefinesKey(defines)].get();
+	return program->finishLoad() ? program : 0;
+}
+
+/**
+ * \brief True if get() would return without waiting for the compiler
+ */
+bool ShaderVariants::isReady(const ShaderProgram::Defines &defines) const
+{
+	std::map<std::string, std::unique_ptr<ShaderProgram> >::const_iterator it = programs.find(ShaderProgram::getDefinesKey(defines));
+	return it != programs.end() && it->second->isLoadComplete();
+}
@@ -0,0 +1,51 @@
+/**
+ * \brief Shader program permutations compiled from the same sources with different defines
+ * \file
+ */
+#ifndef SHADERVARIANTS_H_
+#define SHADERVARIANTS_H_
+
+#include <string>
+#include <map>
+#include <memory>
+#include "shaderprogram.h"
+
+/**
+ * \brief Set of programs built from one vertex and fragment shader pair, keyed by their defines
+ *
+ * Every distinct set of defines is compiled once, however many times it is requested. Constants such as material
+ * colors are given as defines, so the compiler folds them instead of them being uniforms or runtime branches.
+ *
+ * Variants needed soon should be requested together before getting any of them, so that compiling overlaps with
+ * KHR_parallel_shader_compile:
+ * \code
+ * variants.request(clay);
+ * variants.request(metal);
+ * ShaderProgram *program = variants.get(clay); // Waits only for clay
+ * \endcode
+ */
+class ShaderVariants
+{
+	std::string vertexShaderFile;
+	std::string fragmentShaderFile;
+	std::map<std::string, std::unique_ptr<ShaderProgram> > programs; // Keyed by ShaderProgram::getDefinesKey()
+
+	ShaderVariants(const ShaderVariants &);
+	ShaderVariants &operator=(const ShaderVariants &);
+public:
+	ShaderVariants(const std::string &vertexShaderFile, const std::string &fragmentShaderFile);
+
+	void request(const ShaderProgram::Defines &defines);
+	ShaderProgram *get(const ShaderProgram::Defines &defines);
+	bool isReady(const ShaderProgram::Defines &defines) const;
+
+	/**
+	 * \brief Number of distinct variants requested so far
+	 */
+	size_t size() const
+	{
+		return programs.size();
+	}
+};
+
+#endif
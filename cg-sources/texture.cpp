@@ -2,7 +2,14 @@
  * \brief Texture class implementation
  * \file
  */
+#include <algorithm>
+#include <cstring>
+#include <sys/stat.h>
 #include "texture.h"
+#include "imagedecoder.h"
+
+unsigned int Texture::bindCount = 0;
+std::vector<Texture *> Texture::streamingTextures;
 
 /**
  * \brief Static method to load GL texture without creating a software surface to back it.
@@ -10,56 +17,127 @@
  * Use this if you just want to load a texture and use some other way to manage OpenGL texture object ids
  * instead of Texture object. As this releases any software buffers to hold the texture, it also uses less RAM.
  *
+ * PNG and JPEG images are decoded with ImageDecoder directly into a pixel buffer object, so the image never exists
+ * in client memory. Rows are in OpenGL order like with Texture objects.
+ *
  * \param filename Image file to load
  * \return Texture id or 0 if something failed.
  */
 GLuint Texture::loadGLTexture(const std::string &filename)
 {
 	GLuint oid = 0;
+	int width, height;
+
+	if (ImageDecoder::getSize(filename, width, height))
+	{
+		GLsizeiptr size = static_cast<GLsizeiptr>(width) * height * 4;
+		GLuint buffer;
+		glGenBuffers(1, &buffer);
+		glBindBuffer(GL_PIXEL_UNPACK_BUFFER, buffer);
+		glBufferData(GL_PIXEL_UNPACK_BUFFER, size, 0, GL_STREAM_DRAW);
+
+		void *pixels = glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, size, GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT);
+		bool decoded = pixels && ImageDecoder::decode(filename, pixels, width * 4, width, height);
+
+		// Unmapping fails if the buffer contents were lost, e.g. on a video mode change
+		if (pixels && !glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER))
+			decoded = false;
+
+		if (decoded)
+		{
+			glGenTextures(1, &oid);
+			glBindTexture(GL_TEXTURE_2D, oid);
+			glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, width, height, 0, GL_RGBA, GL_UNSIGNED_INT_8_8_8_8, 0);
+		}
+
+		// Driver keeps the buffer alive until the upload has finished
+		glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+		glDeleteBuffers(1, &buffer);
+
+		if (decoded)
+			return oid;
+	}
+
+	// Other formats through SDL_image
+	SDL_Surface *surface = loadSurface(filename);
+	if (!surface)
+	{
+		std::cerr << "Texture::loadGLTexture(): Unable to load image " << filename << std::endl;
+		return 0;
+	}
+
+	// Generate texture id
+	glGenTextures(1, &oid);
+
+	// Bind texture as 2-D texture
+	glBindTexture(GL_TEXTURE_2D, oid);
+
+	if (SDL_MUSTLOCK(surface))
+		SDL_LockSurface(surface);
+
+	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, surface->w, surface->h, 0, GL_RGBA, GL_UNSIGNED_INT_8_8_8_8, surface->pixels);
+
+	if (SDL_MUSTLOCK(surface))
+		SDL_UnlockSurface(surface);
+
+	SDL_FreeSurface(surface);
+
+	// Return allocated object id
+	return oid;
+}
+
+/**
+ * \brief Load image file into a software surface
+ *
+ * Image is converted to SDL_PIXELFORMAT_RGBA8888 and flipped vertically to OpenGL row order (first row is the bottom of the image).
+ * PNG and JPEG images are decoded in a single pass with ImageDecoder when it is available.
+ * \param filename Image file to load
+ * \return Surface that must be released with SDL_FreeSurface() or 0 if something failed.
+ */
+SDL_Surface *Texture::loadSurface(const std::string &filename)
+{
+	SDL_Surface *decoded = ImageDecoder::load(filename);
+	if (decoded)
+		return decoded;
 
 	// Load texture if possible
 	SDL_Surface *orig_surface = IMG_Load(filename.c_str());
-	SDL_Surface *surface = 0;
 
 	// Texture loading failed..
 	if (!orig_surface)
 	{
-		std::cerr << "Texture::loadGLTexture(): Unable to load image " << filename << std::endl;
+		std::cerr << "Texture::loadSurface(): Unable to load image " << filename << std::endl;
 		return 0;
 	}
 
-	// Convert texture into RGBA anyway because GPUs like that
-	// Alpha channel defined. Convert to RGBA texture
+	// Convert texture into either RGBA surface as GPUs prefer those
+	// LibSDL accesses these images as Uint32 and that affects underlying byte order depending on endianess.
 	SDL_PixelFormat *target_format = SDL_AllocFormat(SDL_PIXELFORMAT_RGBA8888);
-	surface = SDL_ConvertSurface(orig_surface, target_format, 0);
+	SDL_Surface *surface = SDL_ConvertSurface(orig_surface, target_format, 0);
 	SDL_FreeFormat(target_format);
 
-	if (surface == 0)
-		std::cerr << "Texture::loadGLTexture(): Unable to convert surface from " << filename << ": " << SDL_GetError() << std::endl;
-
 	// Release original surface
 	SDL_FreeSurface(orig_surface);
 
-	if (surface)
+	if (surface == 0)
 	{
-		// Generate texture id
-		glGenTextures(1, &oid);
-
-		// Bind texture as 2-D texture
-		glBindTexture(GL_TEXTURE_2D, oid);
-
-		if (SDL_MUSTLOCK(surface))
-			SDL_LockSurface(surface);
+		std::cerr << "Texture::loadSurface(): Unable to convert surface from " << filename << ": " << SDL_GetError() << std::endl;
+		return 0;
+	}
 
-//		glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, surface->w, surface->h, 0, GL_RGBA, GL_UNSIGNED_BYTE, surface->pixels);
-		glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, surface->w, surface->h, 0, GL_RGBA, GL_UNSIGNED_INT_8_8_8_8, surface->pixels);
+	// Flip loaded image vertically
+	// Might not be the most efficient implementation.. memcpy() would probably be faster with a separate row buffer
+	for (int y = 0; y < surface->h / 2; ++y)
+	{
+		Uint32 *ptr1 = reinterpret_cast<Uint32 *>(static_cast<Uint8 *>(surface->pixels) + ((y) * surface->pitch));
+		Uint32 *ptr2 = reinterpret_cast<Uint32 *>(static_cast<Uint8 *>(surface->pixels) + ((surface->h - 1 - y) * surface->pitch));
 
-		if (SDL_MUSTLOCK(surface))
-			SDL_UnlockSurface(surface);
+		// Swap elements of these rows. 
+		for (int x = 0; x < surface->w; ++x)
+			std::swap(*ptr1++, *ptr2++);
 	}
 
-	// Return allocated object id
-	return oid;
+	return surface;
 }
 
 /**
@@ -70,7 +148,17 @@ GLuint Texture::loadGLTexture(const std::string &filename)
 Texture::Texture(int width, int height) :
 	oid(0),
 	dirty(true),
-	surface(0)
+	surface(0),
+	width(0),
+	height(0),
+	residency(CPU_AND_GPU),
+	compression(UNCOMPRESSED),
+	compressionQuality(BlockCompressor::NORMAL),
+	sampler(Sampler::get()),
+	uploadRing(0),
+	streamLevel(0),
+	decodeDone(false),
+	decodedSurface(0)
 {
 	Uint32 rmask, gmask, bmask, amask = 0;
 
@@ -88,6 +176,8 @@ Texture::Texture(int width, int height) :
 	#endif
 
 	surface = SDL_CreateRGBSurface(0, width, height, 32, rmask, gmask, bmask, amask);
+	this->width = width;
+	this->height = height;
 
 	// Create OpenGL texture with this
 	updateGLTexture();
@@ -95,46 +185,97 @@ Texture::Texture(int width, int height) :
 
 /**
  * \brief Load texture from file
+ * \param filename Image file to load
+ * \param compression OpenGL storage format. Compressed formats fall back to UNCOMPRESSED if S3TC is not supported.
+ *                    Ignored for DDS files which are always uploaded in their stored format.
+ * \param quality Block compression quality. Higher quality takes longer to load.
+ * \param mode PROGRESSIVE to return immediately with small mipmaps if a sidecar file from an earlier load exists.
+ *             Compressed textures are always loaded immediately.
  */
-Texture::Texture(const std::string &filename) :
+Texture::Texture(const std::string &filename, Compression compression, BlockCompressor::Quality quality, LoadMode mode) :
 	oid(0),
 	dirty(true),
-	surface(0)
+	surface(0),
+	width(0),
+	height(0),
+	residency(CPU_AND_GPU),
+	compression(compression),
+	compressionQuality(quality),
+	sampler(Sampler::get()),
+	uploadRing(0),
+	streamLevel(0),
+	decodeDone(false),
+	decodedSurface(0)
 {
-	// Load texture if possible
-	SDL_Surface *orig_surface = IMG_Load(filename.c_str());
-
-	// Texture loading failed..
-	if (!orig_surface)
+	// GPU ready containers are uploaded directly without a software buffer
+	if (DDSFile::isDDSFile(filename))
 	{
-		std::cerr << "Texture::Texture(): Unable to load image " << filename << std::endl;
+		loadContainer(filename);
 		return;
 	}
 
-	// Convert texture into either RGBA surface as GPUs prefer those
-	// LibSDL accesses these images as Uint32 and that affects underlying byte order depending on endianess.
-	SDL_PixelFormat *target_format = SDL_AllocFormat(SDL_PIXELFORMAT_RGBA8888);
-	surface = SDL_ConvertSurface(orig_surface, target_format, 0);
-	SDL_FreeFormat(target_format);
+	if (mode == PROGRESSIVE && compression == UNCOMPRESSED && loadProgressive(filename))
+		return;
 
-	if (surface == 0)
-		std::cerr << "Texture::Texture(): Unable to convert surface from " << filename << ": " << SDL_GetError() << std::endl;
+	surface = loadSurface(filename);
 
-	// Release original surface
-	SDL_FreeSurface(orig_surface);
+	// Texture loading failed..
+	if (!surface)
+		return;
 
-	// Flip loaded image vertically
-	// Might not be the most efficient implementation.. memcpy() would probably be faster with a separate row buffer
-	for (int y = 0; y < surface->h / 2; ++y)
+	sourceFile = filename;
+	width = surface->w;
+	height = surface->h;
+
+	// Create OpenGL texture of this
+	updateGLTexture();
+
+	// Next load can start from the small mipmaps
+	if (mode == PROGRESSIVE && compression == UNCOMPRESSED)
+		writeSidecar(filename, surface);
+}
+
+/**
+ * \brief Create texture from an existing surface
+ *
+ * Texture takes ownership of the surface. Rows must already be in OpenGL order (first row is the bottom of the image).
+ * Surfaces in other formats than SDL_PIXELFORMAT_RGBA8888 are converted.
+ * \param image Surface to use as the software texture buffer
+ */
+Texture::Texture(SDL_Surface *image) :
+	oid(0),
+	dirty(true),
+	surface(0),
+	width(0),
+	height(0),
+	residency(CPU_AND_GPU),
+	compression(UNCOMPRESSED),
+	compressionQuality(BlockCompressor::NORMAL),
+	sampler(Sampler::get()),
+	uploadRing(0),
+	streamLevel(0),
+	decodeDone(false),
+	decodedSurface(0)
+{
+	if (image->format->format == SDL_PIXELFORMAT_RGBA8888)
+		surface = image;
+	else
 	{
-		Uint32 *ptr1 = reinterpret_cast<Uint32 *>(static_cast<Uint8 *>(surface->pixels) + ((y) * surface->pitch));
-		Uint32 *ptr2 = reinterpret_cast<Uint32 *>(static_cast<Uint8 *>(surface->pixels) + ((surface->h - 1 - y) * surface->pitch));
+		SDL_PixelFormat *target_format = SDL_AllocFormat(SDL_PIXELFORMAT_RGBA8888);
+		surface = SDL_ConvertSurface(image, target_format, 0);
+		SDL_FreeFormat(target_format);
+		SDL_FreeSurface(image);
 
-		// Swap elements of these rows. 
-		for (int x = 0; x < surface->w; ++x)
-			std::swap(*ptr1++, *ptr2++);
+		if (surface == 0)
+		{
+			std::cerr << "Texture::Texture(): Unable to convert surface: " << SDL_GetError() << std::endl;
+			return;
+		}
 	}
 
+	width = surface->w;
+	height = surface->h;
+
 	// Create OpenGL texture of this
 	updateGLTexture();
 }
@@ -154,9 +295,16 @@ Texture::Texture(const std::string &filename) :
 void Texture::setPixel(int x, int y, unsigned char r, unsigned char g, unsigned char b, unsigned char a)
 {
 	// Don't try to modify pixels outside image
-	if (x < 0 || y < 0 || x >= surface->w || y >= surface->h)
+	if (x < 0 || y < 0 || x >= width || y >= height)
+		return;
+
+	// Bring back released software buffer. It is released again on the next updateGLTexture().
+	if (!surface && !restoreSurface())
 		return;
 
+	// Edited image can no longer be restored from the file
+	sourceFile.clear();
+
 	// Locking surface can be an expensive operation so this is really inefficient way for manipulating lots of pixels!
 	if (SDL_MUSTLOCK(surface))
 		SDL_LockSurface(surface);
@@ -178,6 +326,44 @@ void Texture::setPixel(int x, int y, unsigned char r, unsigned char g, unsigned
 		SDL_UnlockSurface(surface);
 }
 
+/**
+ * \brief Get direct access to the software buffer for editing many pixels at once
+ *
+ * Pixels are 32-bit RGBA values with red in the most significant byte, like in setPixel(). Rows are in OpenGL order,
+ * i.e. the first row is the bottom of the image. Call unlockPixels() when done and updateGLTexture() to upload.
+ * \param pitch Bytes from one row to the next
+ * \return First pixel of the bottom row or 0 if there is no software buffer
+ */
+Uint32 *Texture::lockPixels(int &pitch)
+{
+	// Bring back released software buffer. It is released again on the next updateGLTexture().
+	if (!surface && !restoreSurface())
+		return 0;
+
+	// Edited image can no longer be restored from the file
+	sourceFile.clear();
+
+	if (SDL_MUSTLOCK(surface))
+		SDL_LockSurface(surface);
+
+	pitch = surface->pitch;
+	return static_cast<Uint32 *>(surface->pixels);
+}
+
+/**
+ * \brief End editing started with lockPixels()
+ */
+void Texture::unlockPixels()
+{
+	if (!surface)
+		return;
+
+	dirty = true;
+
+	if (SDL_MUSTLOCK(surface))
+		SDL_UnlockSurface(surface);
+}
+
 /**
  * \brief Get OpenGL texture id for this texture
  *
@@ -187,6 +373,10 @@ void Texture::setPixel(int x, int y, unsigned char r, unsigned char g, unsigned
  */
 GLuint Texture::updateGLTexture()
 {
+	// Nothing to upload if loading failed or surface has been released after upload
+	if (!surface)
+		return oid;
+
 	// If texture has not been generated yet, do it now
 	if (oid == 0)
 	{
@@ -198,10 +388,32 @@ GLuint Texture::updateGLTexture()
 		// Bind texture as 2-D texture
 		glBindTexture(GL_TEXTURE_2D, oid);
 
-		// We just allocate a new texture and not provide any actual texture for it
-		// by providing null pointer as texture data as last parameter.
-		// Texture data would be transferred there as well if the last parameter points to surface->pixels instead of having a null value
-		glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, surface->w, surface->h, 0, GL_RGBA, GL_UNSIGNED_INT_8_8_8_8, 0);
+		GLsizei levels = getMipLevelCount(surface->w, surface->h);
+
+		if (useImmutableStorage())
+		{
+			// Allocate all mipmap levels at once with a format that can't change later. Driver knows the texture is
+			// complete and doesn't need to validate it again. See https://www.opengl.org/wiki/Texture_Storage
+			GLenum internalFormat = GL_RGBA8;
+			if (useCompression())
+				internalFormat = compression == COMPRESSED_BC1 ? GL_COMPRESSED_RGB_S3TC_DXT1_EXT : GL_COMPRESSED_RGBA_S3TC_DXT5_EXT;
+			glTexStorage2D(GL_TEXTURE_2D, levels, internalFormat, surface->w, surface->h);
+		} else
+		if (!useCompression())
+		{
+			// We just allocate a new texture and not provide any actual texture for it
+			// by providing null pointer as texture data as last parameter.
+			// Texture data would be transferred there as well if the last parameter points to surface->pixels instead of having a null value
+			// Compressed textures are allocated level by level when they are uploaded.
+			glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, surface->w, surface->h, 0, GL_RGBA, GL_UNSIGNED_INT_8_8_8_8, 0);
+		}
+
+		// Texture parameters are set once here. Texture::bind() uses a shared sampler object with the same parameters
+		// which overrides these, but code binding the texture directly with glBindTexture() still needs them.
+		// Anisotropic filtering or other filtering modes can be selected with Sampler::Parameters.
+		// Parameters can always be changed later by just binding the texture and updating the relevant parameters
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, levels - 1);
+		Sampler::applyToTexture(GL_TEXTURE_2D, samplerParameters);
 	}
 
 	// If texture has been modified or has not been used yet, update it with a new copy
@@ -220,47 +432,694 @@ GLuint Texture::updateGLTexture()
 		// We can also just replace a rectangular subsection of the image if necessary using glTexSubImage2D() but the following call replaces the whole image
 		// As we request OpenGL to accesses memory using 32-bit integer operations (GL_UNSIGNED_INT_...), this line should match libSDL convention on both little and big endian systems
 //		glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, surface->w, surface->h, 0, GL_RGBA, GL_UNSIGNED_INT_8_8_8_8, surface->pixels); // Does reallocation for image data
-		glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, surface->w, surface->h, GL_RGBA, GL_UNSIGNED_INT_8_8_8_8, surface->pixels); // Just replaces previously allocated texture with specified one
+		if (useCompression())
+			uploadCompressed(); // Encodes and uploads the whole mipmap chain
+		else
+		if (uploadRing)
+			uploadStreaming(); // Copies pixels to a pixel buffer and lets the GPU fetch them asynchronously
+		else
+			uploadLevel(0, surface->w, surface->h, surface->pixels); // Just replaces previously allocated texture with specified one
 
 		if (SDL_MUSTLOCK(surface))
 			SDL_UnlockSurface(surface);
 
-		// Example of how to set some texture parameters
-		// Texture parameters can always be changed later by just binding the texture and updating the relevant parameters
-/*		
-		// Enable anisotropic filtering - requires mipmapping levels below to be available for the best results!
-		// Maximum anisotropy level is determined by glGetFloatv(MAX_TEXTURE_MAX_ANISOTROPY_EX)
-		if (GLEW_EXT_texture_filter_anisotropic)
+		// Generate mipmaps from top level texture to reduce aliasing effects
+		// Compressed formats can't be rendered to so their mipmaps were already created by uploadCompressed()
+		if (!useCompression())
+			glGenerateMipmap(GL_TEXTURE_2D);
+	}
+
+	// Streamed textures are modified all the time so they keep their surface
+	if (residency == GPU_ONLY && !uploadRing)
+		releaseSurface();
+
+	// Return allocated object id
+	return oid;
+}
+
+/**
+ * \brief Bind texture to a texture unit
+ *
+ * Binds are counted so that the number of texture binds per frame can be measured with getBindCount().
+ * \param unit Texture unit index (GL_TEXTURE0 + unit is activated)
+ */
+void Texture::bind(GLuint unit) const
+{
+	glActiveTexture(GL_TEXTURE0 + unit);
+	glBindTexture(GL_TEXTURE_2D, oid);
+	if (sampler)
+		glBindSampler(unit, sampler);
+	++bindCount;
+}
+
+/**
+ * \brief Upload through pixel buffer objects
+ *
+ * Meant for textures modified every frame. glTexSubImage2D() copies client memory synchronously before returning
+ * but with a pixel buffer bound it just queues a transfer from GPU accessible memory. The CPU can then modify
+ * the surface for the next frame while the GPU is still processing the previous upload.
+ * \param enable True to stream updates, false to return to direct uploads
+ */
+void Texture::setStreaming(bool enable)
+{
+	if (!enable || useCompression())
+	{
+		delete uploadRing;
+		uploadRing = 0;
+		return;
+	}
+
+	if (!surface && !restoreSurface())
+		return;
+
+	if (!uploadRing)
+		uploadRing = new PixelBufferRing(static_cast<GLsizeiptr>(surface->pitch) * surface->h);
+}
+
+/**
+ * \brief Upload RGBA8888 pixels to a level of the bound texture in the layout the driver prefers
+ *
+ * Converting here once is faster than the generic conversion drivers do for non-native layouts.
+ */
+void Texture::uploadLevel(GLint level, int levelWidth, int levelHeight, const void *pixels)
+{
+	const UploadFormat &layout = UploadFormat::getPreferred();
+	const void *upload = layout.prepare(pixels, static_cast<size_t>(levelWidth) * levelHeight);
+	glTexSubImage2D(GL_TEXTURE_2D, level, 0, 0, levelWidth, levelHeight, layout.format, layout.type, upload);
+}
+
+/**
+ * \brief Copy surface to the next pixel buffer and upload the top level from there
+ */
+void Texture::uploadStreaming()
+{
+	void *dst = uploadRing->map();
+	if (!dst)
+	{
+		uploadLevel(0, surface->w, surface->h, surface->pixels);
+		return;
+	}
+
+	// Swizzling to the driver's layout costs nothing extra as the pixels are copied anyway
+	const UploadFormat &layout = UploadFormat::getPreferred();
+	layout.convert(surface->pixels, dst, static_cast<size_t>(surface->w) * surface->h);
+	const void *offset = uploadRing->unmap();
+
+	// Pitch of RGBA8888 surfaces is always width * 4 so default unpack alignment works
+	glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, surface->w, surface->h, layout.format, layout.type, offset);
+	uploadRing->fence();
+}
+
+/**
+ * \brief Select whether the software buffer is kept after upload
+ *
+ * In GPU_ONLY mode the surface is released as soon as it has been uploaded, so the texture only uses video memory.
+ * setPixel() and restoreSurface() bring it back when needed.
+ * \param mode New residency mode
+ */
+void Texture::setResidency(Residency mode)
+{
+	residency = mode;
+
+	if (residency == GPU_ONLY)
+	{
+		// Upload pending changes first, this also releases the surface
+		if (oid)
+			updateGLTexture();
+	} else
+		restoreSurface();
+}
+
+/**
+ * \brief Free the software buffer of an uploaded texture
+ */
+void Texture::releaseSurface()
+{
+	if (!surface || !oid || dirty)
+		return;
+
+	SDL_FreeSurface(surface);
+	surface = 0;
+}
+
+/**
+ * \brief Recreate a released software buffer
+ *
+ * Unmodified textures loaded from a file are decoded again. Otherwise the top level is read back from OpenGL,
+ * which waits for the GPU to finish pending work with the texture. Read back of compressed textures returns
+ * the decompressed and thus slightly lossy image.
+ * \return true if surface is available
+ */
+bool Texture::restoreSurface()
+{
+	finishStreaming();
+
+	if (surface)
+		return true;
+
+	if (!sourceFile.empty())
+	{
+		surface = loadSurface(sourceFile);
+		if (surface && surface->w == width && surface->h == height)
+			return true;
+
+		std::cerr << "Texture::restoreSurface(): " << sourceFile << " has changed, reading texture back from OpenGL" << std::endl;
+		if (surface)
+			SDL_FreeSurface(surface);
+		surface = 0;
+		sourceFile.clear();
+	}
+
+	if (!oid)
+		return false;
+
+	// Red in the most significant byte, matching SDL_PIXELFORMAT_RGBA8888
+	surface = SDL_CreateRGBSurface(0, width, height, 32, 0xff000000, 0x00ff0000, 0x0000ff00, 0x000000ff);
+	if (!surface)
+	{
+		std::cerr << "Texture::restoreSurface(): Unable to create surface: " << SDL_GetError() << std::endl;
+		return false;
+	}
+
+	if (SDL_MUSTLOCK(surface))
+		SDL_LockSurface(surface);
+
+	// Pitch of RGBA8888 surfaces is always width * 4 so default pack alignment works
+	glBindTexture(GL_TEXTURE_2D, oid);
+	glGetTexImage(GL_TEXTURE_2D, 0, GL_RGBA, GL_UNSIGNED_INT_8_8_8_8, surface->pixels);
+
+	if (SDL_MUSTLOCK(surface))
+		SDL_UnlockSurface(surface);
+
+	return true;
+}
+
+/**
+ * \brief Select filtering and wrapping used by bind()
+ *
+ * Textures with equal parameters share the same sampler object.
+ * \param parameters Sampling parameters
+ */
+void Texture::setSamplerParameters(const Sampler::Parameters &parameters)
+{
+	samplerParameters = parameters;
+	sampler = Sampler::get(parameters);
+
+	// Keep texture object state in sync for code binding the texture directly
+	if (oid)
+	{
+		glBindTexture(GL_TEXTURE_2D, oid);
+		Sampler::applyToTexture(GL_TEXTURE_2D, parameters);
+	}
+}
+
+/**
+ * \brief Number of mipmap levels in a full chain down to 1x1
+ */
+GLsizei Texture::getMipLevelCount(int width, int height)
+{
+	GLsizei levels = 1;
+	for (int size = std::max(width, height); size > 1; size /= 2)
+		++levels;
+	return levels;
+}
+
+/**
+ * \brief True if texture storage is allocated with glTexStorage2D()
+ */
+bool Texture::useImmutableStorage()
+{
+	return GLEW_ARB_texture_storage != 0;
+}
+
+/**
+ * \brief Check if the current OpenGL context can use block compressed textures
+ */
+bool Texture::isCompressionSupported()
+{
+	return GLEW_EXT_texture_compression_s3tc != 0;
+}
+
+/**
+ * \brief True if this texture is uploaded in a compressed format
+ */
+bool Texture::useCompression() const
+{
+	return compression != UNCOMPRESSED && isCompressionSupported();
+}
+
+/**
+ * \brief Compress surface and upload it with a full mipmap chain
+ *
+ * Texture must be bound and surface locked before calling this.
+ */
+void Texture::uploadCompressed()
+{
+	BlockCompressor::Format format = compression == COMPRESSED_BC1 ? BlockCompressor::BC1 : BlockCompressor::BC3;
+	GLenum internalFormat = compression == COMPRESSED_BC1 ? GL_COMPRESSED_RGB_S3TC_DXT1_EXT : GL_COMPRESSED_RGBA_S3TC_DXT5_EXT;
+
+	std::vector<Uint8> blocks;
+	std::vector<Uint32> level, nextLevel;
+	const Uint32 *pixels = static_cast<const Uint32 *>(surface->pixels);
+	int width = surface->w;
+	int height = surface->h;
+	int pitch = surface->pitch;
+
+	for (GLint mip = 0; ; ++mip)
+	{
+		BlockCompressor::compress(format, compressionQuality, pixels, width, height, pitch, blocks);
+		if (useImmutableStorage())
+			glCompressedTexSubImage2D(GL_TEXTURE_2D, mip, 0, 0, width, height, internalFormat, static_cast<GLsizei>(blocks.size()), &blocks[0]);
+		else
+			glCompressedTexImage2D(GL_TEXTURE_2D, mip, internalFormat, width, height, 0, static_cast<GLsizei>(blocks.size()), &blocks[0]);
+
+		if (width == 1 && height == 1)
+			break;
+
+		// Next level is calculated from the previous one
+		downsample(pixels, width, height, pitch, nextLevel);
+		level.swap(nextLevel);
+		pixels = &level[0];
+		width = std::max(1, width / 2);
+		height = std::max(1, height / 2);
+		pitch = width * 4;
+	}
+}
+
+/**
+ * \brief Upload a DDS file
+ *
+ * Level data is read straight from the memory mapped file. Mipmaps are only generated if the file has a single
+ * uncompressed level. Texture is left in GPU_ONLY mode as there is no software buffer.
+ * \return true if success
+ */
+bool Texture::loadContainer(const std::string &filename)
+{
+	DDSFile dds;
+	if (!dds.open(filename))
+		return false;
+
+	GLenum internalFormat = GL_RGBA8;
+	GLenum type = GL_UNSIGNED_INT_8_8_8_8;
+	switch (dds.getFormat())
+	{
+	case DDSFile::ABGR8888:
+		type = GL_UNSIGNED_BYTE;
+		break;
+	case DDSFile::BC1:
+		compression = COMPRESSED_BC1;
+		internalFormat = GL_COMPRESSED_RGB_S3TC_DXT1_EXT;
+		break;
+	case DDSFile::BC3:
+		compression = COMPRESSED_BC3;
+		internalFormat = GL_COMPRESSED_RGBA_S3TC_DXT5_EXT;
+		break;
+	default:
+		break;
+	}
+
+	if (dds.isCompressed() && !isCompressionSupported())
+	{
+		std::cerr << "Texture::loadContainer(): " << filename << " is S3TC compressed but S3TC textures are not supported" << std::endl;
+		compression = UNCOMPRESSED;
+		return false;
+	}
+
+	width = dds.getLevel(0).width;
+	height = dds.getLevel(0).height;
+	bool generateMipmaps = dds.getLevelCount() == 1 && !dds.isCompressed();
+	GLsizei levels = generateMipmaps ? getMipLevelCount(width, height) : dds.getLevelCount();
+
+	glGenTextures(1, &oid);
+	glBindTexture(GL_TEXTURE_2D, oid);
+
+	if (useImmutableStorage())
+		glTexStorage2D(GL_TEXTURE_2D, levels, internalFormat, width, height);
+
+	for (int i = 0; i < dds.getLevelCount(); ++i)
+	{
+		const DDSFile::Level &level = dds.getLevel(i);
+		if (dds.isCompressed())
 		{
-			GLfloat max_aniso;
-			glGetFloatv(GL_MAX_TEXTURE_MAX_ANISOTROPY_EXT, &max_aniso);
-			glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_MAX_ANISOTROPY_EXT, max_aniso);
-			std::cout << "Enabling anisotropic filtering for texture." << std::endl;
-			
-		}  else
+			if (useImmutableStorage())
+				glCompressedTexSubImage2D(GL_TEXTURE_2D, i, 0, 0, level.width, level.height, internalFormat, static_cast<GLsizei>(level.size), level.data);
+			else
+				glCompressedTexImage2D(GL_TEXTURE_2D, i, internalFormat, level.width, level.height, 0, static_cast<GLsizei>(level.size), level.data);
+		} else
 		{
-			std::cout << "Unable to enable anisotropic filtering for texture." << std::endl;
+			if (useImmutableStorage())
+				glTexSubImage2D(GL_TEXTURE_2D, i, 0, 0, level.width, level.height, GL_RGBA, type, level.data);
+			else
+				glTexImage2D(GL_TEXTURE_2D, i, internalFormat, level.width, level.height, 0, GL_RGBA, type, level.data);
 		}
-*/	    
-		// Use linear filtering for texture sampling
-		// You can try GL_NEAREST and GL_LINEAR here
-		/*
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
-		*/
-		
-		// Mipmapping example
-		// Use linear filtering when zooming in after highest resolution level
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-		// Use mipmapping with linearly interpolated layers when zooming in ("trilinear filtering")
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
-		// Generate mipmaps from top level texture to reduce aliasing effects
+	}
+
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, levels - 1);
+	Sampler::applyToTexture(GL_TEXTURE_2D, samplerParameters);
+
+	if (generateMipmaps)
 		glGenerateMipmap(GL_TEXTURE_2D);
-		
+
+	dirty = false;
+	residency = GPU_ONLY;
+	return true;
+}
+
+/**
+ * \brief Write an image with a full mipmap chain into a DDS file
+ *
+ * This is the offline counterpart of loading with compression: the file can later be loaded without decoding or compressing.
+ * \param filename File to create
+ * \param image SDL_PIXELFORMAT_RGBA8888 surface in OpenGL row order, e.g. from loadSurface()
+ * \param compression Storage format in the file
+ * \param quality Block compression quality
+ * \return true if success
+ */
+bool Texture::writeContainer(const std::string &filename, const SDL_Surface *image, Compression compression, BlockCompressor::Quality quality)
+{
+	if (!image || image->format->format != SDL_PIXELFORMAT_RGBA8888)
+	{
+		std::cerr << "Texture::writeContainer(): Image must be an RGBA8888 surface" << std::endl;
+		return false;
 	}
 
-	// Return allocated object id
-	return oid;
+	DDSFile::Format format = compression == COMPRESSED_BC1 ? DDSFile::BC1 : compression == COMPRESSED_BC3 ? DDSFile::BC3 : DDSFile::RGBA8888;
+	BlockCompressor::Format blockFormat = compression == COMPRESSED_BC1 ? BlockCompressor::BC1 : BlockCompressor::BC3;
+
+	std::vector<std::vector<Uint8> > levels;
+	std::vector<Uint32> level, nextLevel;
+	const Uint32 *pixels = static_cast<const Uint32 *>(image->pixels);
+	int width = image->w;
+	int height = image->h;
+	int pitch = image->pitch;
+
+	for (;;)
+	{
+		levels.push_back(std::vector<Uint8>());
+		std::vector<Uint8> &data = levels.back();
+
+		if (compression == UNCOMPRESSED)
+		{
+			data.resize(static_cast<size_t>(width) * height * 4);
+			for (int y = 0; y < height; ++y)
+				std::memcpy(&data[static_cast<size_t>(y) * width * 4], reinterpret_cast<const Uint8 *>(pixels) + y * pitch, width * 4);
+		} else
+			BlockCompressor::compress(blockFormat, quality, pixels, width, height, pitch, data);
+
+		if (width == 1 && height == 1)
+			break;
+
+		// Next level is calculated from the previous one
+		downsample(pixels, width, height, pitch, nextLevel);
+		level.swap(nextLevel);
+		pixels = &level[0];
+		width = std::max(1, width / 2);
+		height = std::max(1, height / 2);
+		pitch = width * 4;
+	}
+
+	return DDSFile::write(filename, format, image->w, image->h, levels);
+}
+
+/**
+ * \brief Sidecar file holding the small mipmaps of an image for progressive loading
+ */
+std::string Texture::getSidecarFilename(const std::string &filename)
+{
+	return filename + ".mips.dds";
+}
+
+/**
+ * \brief Store mipmap levels up to SIDECAR_MAX_SIZE texels of an image into its sidecar file
+ */
+void Texture::writeSidecar(const std::string &filename, const SDL_Surface *image)
+{
+	std::vector<std::vector<Uint8> > levels;
+	std::vector<Uint32> level, nextLevel;
+	const Uint32 *pixels = static_cast<const Uint32 *>(image->pixels);
+	int w = image->w;
+	int h = image->h;
+	int pitch = image->pitch;
+	int firstLevel = -1;
+
+	for (int mip = 0; ; ++mip)
+	{
+		if (firstLevel < 0 && std::max(w, h) <= SIDECAR_MAX_SIZE)
+			firstLevel = mip;
+
+		if (firstLevel >= 0)
+		{
+			const Uint8 *data = reinterpret_cast<const Uint8 *>(pixels);
+			levels.push_back(std::vector<Uint8>(data, data + static_cast<size_t>(w) * h * 4));
+		}
+
+		if (w == 1 && h == 1)
+			break;
+
+		downsample(pixels, w, h, pitch, nextLevel);
+		level.swap(nextLevel);
+		pixels = &level[0];
+		w = std::max(1, w / 2);
+		h = std::max(1, h / 2);
+		pitch = w * 4;
+	}
+
+	// Small images load fast enough anyway
+	if (firstLevel == 0)
+		return;
+
+	if (!DDSFile::write(getSidecarFilename(filename), DDSFile::RGBA8888, image->w, image->h, levels, firstLevel))
+		std::cerr << "Texture::writeSidecar(): Unable to write " << getSidecarFilename(filename) << std::endl;
+}
+
+/**
+ * \brief Start progressive loading from a sidecar file
+ *
+ * Full size storage is allocated and the small mipmaps are uploaded right away. BASE_LEVEL and MIN_LOD limit sampling
+ * to the uploaded levels. Full image is decoded in a background thread and updateStreaming() uploads the missing
+ * levels one at a time, coarsest first.
+ * \return false if there is no valid sidecar file or it is older than the image
+ */
+bool Texture::loadProgressive(const std::string &filename)
+{
+	std::string sidecar = getSidecarFilename(filename);
+
+	struct stat imageInfo, sidecarInfo;
+	if (stat(filename.c_str(), &imageInfo) != 0 || stat(sidecar.c_str(), &sidecarInfo) != 0 || sidecarInfo.st_mtime < imageInfo.st_mtime)
+		return false;
+
+	DDSFile dds;
+	if (!dds.open(sidecar))
+		return false;
+
+	width = dds.getBaseWidth();
+	height = dds.getBaseHeight();
+	GLsizei levels = getMipLevelCount(width, height);
+	if (dds.getFormat() != DDSFile::RGBA8888 || dds.getFirstLevel() == 0 || dds.getFirstLevel() + dds.getLevelCount() != levels)
+	{
+		std::cerr << "Texture::loadProgressive(): " << sidecar << " does not match " << filename << std::endl;
+		return false;
+	}
+
+	glGenTextures(1, &oid);
+	glBindTexture(GL_TEXTURE_2D, oid);
+
+	if (useImmutableStorage())
+		glTexStorage2D(GL_TEXTURE_2D, levels, GL_RGBA8, width, height);
+	else
+	{
+		for (GLint level = 0; level < levels; ++level)
+			glTexImage2D(GL_TEXTURE_2D, level, GL_RGBA8, std::max(1, width >> level), std::max(1, height >> level), 0, GL_RGBA, GL_UNSIGNED_INT_8_8_8_8, 0);
+	}
+
+	for (int i = 0; i < dds.getLevelCount(); ++i)
+	{
+		const DDSFile::Level &level = dds.getLevel(i);
+		uploadLevel(dds.getFirstLevel() + i, level.width, level.height, level.data);
+	}
+
+	streamLevel = dds.getFirstLevel();
+
+	// Sampler objects have their own MIN_LOD so BASE_LEVEL is what actually limits sampling with Texture::bind()
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, streamLevel);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, levels - 1);
+	glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_MIN_LOD, static_cast<GLfloat>(streamLevel));
+	Sampler::applyToTexture(GL_TEXTURE_2D, samplerParameters);
+
+	sourceFile = filename;
+	dirty = false;
+
+	decodeThread = std::thread(&Texture::decodeLevels, this);
+	streamingTextures.push_back(this);
+	return true;
+}
+
+/**
+ * \brief Background thread: decode the image and create the levels that are not uploaded yet
+ *
+ * Only touches decodedSurface and decodedLevels, which the main thread doesn't access before decodeDone is set.
+ */
+void Texture::decodeLevels()
+{
+	decodedSurface = loadSurface(sourceFile);
+
+	if (decodedSurface && decodedSurface->w == width && decodedSurface->h == height)
+	{
+		decodedLevels.resize(streamLevel);
+
+		const Uint32 *pixels = static_cast<const Uint32 *>(decodedSurface->pixels);
+		int w = width;
+		int h = height;
+		int pitch = decodedSurface->pitch;
+		for (int level = 1; level < streamLevel; ++level)
+		{
+			downsample(pixels, w, h, pitch, decodedLevels[level]);
+			pixels = &decodedLevels[level][0];
+			w = std::max(1, w / 2);
+			h = std::max(1, h / 2);
+			pitch = w * 4;
+		}
+	} else
+	if (decodedSurface)
+	{
+		SDL_FreeSurface(decodedSurface);
+		decodedSurface = 0;
+	}
+
+	decodeDone = true;
+}
+
+/**
+ * \brief Upload the next finer level and allow sampling from it
+ */
+void Texture::streamNextLevel()
+{
+	if (!decodedSurface)
+	{
+		// Decoding failed, texture stays at the coarse levels
+		std::cerr << "Texture: Unable to stream " << sourceFile << ", using low resolution mipmaps" << std::endl;
+		sourceFile.clear();
+		stopStreaming();
+		return;
+	}
+
+	int level = streamLevel - 1;
+	const void *pixels = level ? static_cast<const void *>(&decodedLevels[level][0]) : decodedSurface->pixels;
+
+	glBindTexture(GL_TEXTURE_2D, oid);
+	uploadLevel(level, std::max(1, width >> level), std::max(1, height >> level), pixels);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, level);
+	glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_MIN_LOD, static_cast<GLfloat>(level));
+
+	// Swap with a temporary object to release memory completely
+	std::vector<Uint32> tmp;
+	decodedLevels[level].swap(tmp);
+	streamLevel = level;
+
+	if (streamLevel == 0)
+	{
+		// Decoded image becomes the regular software buffer
+		surface = decodedSurface;
+		decodedSurface = 0;
+		decodedLevels.clear();
+		stopStreaming();
+
+		glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_MIN_LOD, -1000.0f);
+		if (residency == GPU_ONLY)
+			releaseSurface();
+	}
+}
+
+/**
+ * \brief Wait for the decoding thread and stop updates from updateStreaming()
+ */
+void Texture::stopStreaming()
+{
+	if (decodeThread.joinable())
+		decodeThread.join();
+
+	std::vector<Texture *>::iterator it = std::find(streamingTextures.begin(), streamingTextures.end(), this);
+	if (it != streamingTextures.end())
+		streamingTextures.erase(it);
+}
+
+/**
+ * \brief Upload all missing levels, waiting for decoding if necessary
+ */
+void Texture::finishStreaming()
+{
+	if (!isStreaming() || std::find(streamingTextures.begin(), streamingTextures.end(), this) == streamingTextures.end())
+		return;
+
+	if (decodeThread.joinable())
+		decodeThread.join();
+
+	while (std::find(streamingTextures.begin(), streamingTextures.end(), this) != streamingTextures.end())
+		streamNextLevel();
+}
+
+/**
+ * \brief Upload levels of progressively loaded textures whose background decoding has finished
+ *
+ * Call once per frame. Uploading one level per texture and frame keeps frame times even.
+ * \param maxLevels Maximum number of levels uploaded per texture
+ */
+void Texture::updateStreaming(unsigned int maxLevels)
+{
+	// Copy as finished textures remove themselves from the list
+	std::vector<Texture *> textures(streamingTextures);
+	for (size_t i = 0; i < textures.size(); ++i)
+	{
+		Texture *texture = textures[i];
+		if (!texture->decodeDone)
+			continue;
+
+		for (unsigned int n = 0; n < maxLevels && texture->isStreaming(); ++n)
+		{
+			texture->streamNextLevel();
+			if (std::find(streamingTextures.begin(), streamingTextures.end(), texture) == streamingTextures.end())
+				break;
+		}
+	}
+}
+
+/**
+ * \brief Create the next mipmap level with a 2x2 box filter
+ *
+ * Odd sized dimensions clamp to the last row and column.
+ * \param src Source pixels in SDL_PIXELFORMAT_RGBA8888 format
+ * \param width Source width
+ * \param height Source height
+ * \param pitch Source row length in bytes
+ * \param[out] dst Destination pixels, tightly packed
+ */
+void Texture::downsample(const Uint32 *src, int width, int height, int pitch, std::vector<Uint32> &dst)
+{
+	int dstWidth = std::max(1, width / 2);
+	int dstHeight = std::max(1, height / 2);
+	dst.resize(static_cast<size_t>(dstWidth) * dstHeight);
+
+	for (int y = 0; y < dstHeight; ++y)
+	{
+		const Uint32 *row0 = reinterpret_cast<const Uint32 *>(reinterpret_cast<const Uint8 *>(src) + std::min(2 * y, height - 1) * pitch);
+		const Uint32 *row1 = reinterpret_cast<const Uint32 *>(reinterpret_cast<const Uint8 *>(src) + std::min(2 * y + 1, height - 1) * pitch);
+
+		for (int x = 0; x < dstWidth; ++x)
+		{
+			int x0 = std::min(2 * x, width - 1);
+			int x1 = std::min(2 * x + 1, width - 1);
+			Uint32 p[4] = { row0[x0], row0[x1], row1[x0], row1[x1] };
+
+			// Average each 8-bit channel separately
+			Uint32 result = 0;
+			for (int shift = 0; shift < 32; shift += 8)
+			{
+				Uint32 sum = ((p[0] >> shift) & 0xff) + ((p[1] >> shift) & 0xff) + ((p[2] >> shift) & 0xff) + ((p[3] >> shift) & 0xff);
+				result |= ((sum + 2) / 4) << shift;
+			}
+			dst[static_cast<size_t>(y) * dstWidth + x] = result;
+		}
+	}
 }
 
 /**
@@ -268,10 +1127,16 @@ GLuint Texture::updateGLTexture()
  */
 Texture::~Texture()
 {
+	stopStreaming();
+	if (decodedSurface)
+		SDL_FreeSurface(decodedSurface);
+
 	// Release software buffer if available
 	if (surface)
 		SDL_FreeSurface(surface);
 
+	delete uploadRing;
+
 	// Release allocated texture id
 	if (oid)
 		glDeleteTextures(1, &oid);
@@ -8,8 +8,16 @@
 #include <GL/glew.h>
 #include <iostream>
 #include <string>
+#include <vector>
+#include <thread>
+#include <atomic>
 #include <SDL.h>
 #include <SDL_image.h>
+#include "blockcompressor.h"
+#include "sampler.h"
+#include "pixelbufferring.h"
+#include "ddsfile.h"
+#include "uploadformat.h"
 
 /**
  * \brief Class to generate OpenGL textures
@@ -20,23 +28,158 @@
  *
  * If texture has been modified using setPixel(), updateGLTexture() must be called to refresh OpenGL texture for drawing
  * for the changes to be visible.
+ *
+ * Loaded textures can be stored block compressed (S3TC) on the GPU. Compression is done on the CPU with BlockCompressor
+ * when the texture is uploaded and falls back to uncompressed RGBA if the OpenGL context does not support S3TC.
+ *
+ * DDS files (see DDSFile) are uploaded as they are with their stored mipmaps and format. They have no software buffer
+ * until restoreSurface() is called.
+ *
+ * Large textures can be loaded with PROGRESSIVE mode to draw the first frames with small mipmaps while the full image
+ * is decoded in the background. Texture::updateStreaming() must be called once per frame for this.
+ *
+ * Textures updated every frame should enable setStreaming() so that uploads don't stall the render thread.
+ * Textures that are not edited after loading can use setResidency(GPU_ONLY) to release the software buffer.
  */
 class Texture
 {
+public:
+	/**
+	 * \brief Storage format of the OpenGL texture
+	 */
+	enum Compression
+	{
+		UNCOMPRESSED,   ///< GL_RGBA8, 4 bytes per texel
+		COMPRESSED_BC1, ///< S3TC DXT1, 0.5 bytes per texel. Alpha channel is dropped.
+		COMPRESSED_BC3  ///< S3TC DXT5, 1 byte per texel
+	};
+
+	/**
+	 * \brief Where texel data is kept after upload
+	 */
+	enum Residency
+	{
+		CPU_AND_GPU, ///< Surface stays in RAM for editing
+		GPU_ONLY     ///< Surface is released after upload and restored on demand
+	};
+
+	/**
+	 * \brief How a texture loaded from a file becomes available
+	 */
+	enum LoadMode
+	{
+		IMMEDIATE,  ///< Constructor decodes and uploads the full image
+		PROGRESSIVE ///< Small mipmaps are uploaded from a sidecar file and the rest streams in over following frames
+	};
+
+	static const int SIDECAR_MAX_SIZE = 64; ///< Largest mipmap level stored in a progressive loading sidecar file
+
+private:
 	GLuint oid; // Texture object id
 	bool dirty; // True if texture has been modified after it has been converted into a texture object
-	SDL_Surface *surface; // Software texture buffer for generated textures
+	SDL_Surface *surface; // Software texture buffer for generated textures. 0 if released in GPU_ONLY mode.
+	int width;  // Image width, valid also when surface has been released
+	int height; // Image height, valid also when surface has been released
+	Residency residency; // Whether surface is released after upload
+	std::string sourceFile; // File the surface can be decoded from again. Empty if surface has been edited.
+	Compression compression; // Requested OpenGL storage format
+	BlockCompressor::Quality compressionQuality; // Encoder quality used for compressed uploads
+	Sampler::Parameters samplerParameters; // Filtering and wrapping for this texture
+	GLuint sampler; // Shared sampler object matching samplerParameters or 0 if not supported
+	PixelBufferRing *uploadRing; // Staging buffers for streamed updates or 0 for direct uploads
+
+	bool useCompression() const;
+	static bool useImmutableStorage();
+	void uploadCompressed();
+	void uploadStreaming();
+	void uploadLevel(GLint level, int levelWidth, int levelHeight, const void *pixels);
+	void releaseSurface();
+	bool loadContainer(const std::string &filename);
+
+	// Progressive loading state
+	int streamLevel; // Finest uploaded mipmap level, 0 when the texture is complete
+	std::thread decodeThread; // Decodes the full image and its mipmaps in the background
+	std::atomic<bool> decodeDone; // Set by decodeThread when decodedSurface and decodedLevels are ready
+	SDL_Surface *decodedSurface; // Decoded full image
+	std::vector<std::vector<Uint32> > decodedLevels; // Decoded mipmap levels indexed by level, level 0 is decodedSurface
+
+	bool loadProgressive(const std::string &filename);
+	void decodeLevels();
+	void streamNextLevel();
+	void stopStreaming();
+	void finishStreaming();
+	static std::string getSidecarFilename(const std::string &filename);
+	static void writeSidecar(const std::string &filename, const SDL_Surface *image);
+
+	static std::vector<Texture *> streamingTextures; // Textures with levels still to be uploaded
+	static unsigned int bindCount; // Texture binds done through bind() since last resetBindCount()
 public:
 
 	static GLuint loadGLTexture(const std::string &filename);
+	static SDL_Surface *loadSurface(const std::string &filename);
+	static bool isCompressionSupported();
+	static GLsizei getMipLevelCount(int width, int height);
+	static void downsample(const Uint32 *src, int width, int height, int pitch, std::vector<Uint32> &dst);
+	static bool writeContainer(const std::string &filename, const SDL_Surface *image, Compression compression, BlockCompressor::Quality quality = BlockCompressor::NORMAL);
 
 	Texture(int width, int height);
-	Texture(const std::string &filename);
+	Texture(const std::string &filename, Compression compression = UNCOMPRESSED, BlockCompressor::Quality quality = BlockCompressor::NORMAL, LoadMode mode = IMMEDIATE);
+	explicit Texture(SDL_Surface *image);
 
 	void setPixel(int x, int y, unsigned char r, unsigned char g, unsigned char b, unsigned char a = 255);
+	Uint32 *lockPixels(int &pitch);
+	void unlockPixels();
 
 	GLuint updateGLTexture();
 
+	void bind(GLuint unit) const;
+	void setSamplerParameters(const Sampler::Parameters &parameters);
+	void setStreaming(bool enable);
+	void setResidency(Residency mode);
+	bool restoreSurface();
+
+	/**
+	 * \brief Count a texture bind done outside Texture::bind()
+	 */
+	static void countBind()
+	{
+		++bindCount;
+	}
+
+	/**
+	 * \brief Number of texture binds since the last resetBindCount()
+	 */
+	static unsigned int getBindCount()
+	{
+		return bindCount;
+	}
+
+	static void resetBindCount()
+	{
+		bindCount = 0;
+	}
+
+	static void updateStreaming(unsigned int maxLevels = 1);
+
+	/**
+	 * \brief True while progressively loaded mipmap levels are still missing
+	 */
+	bool isStreaming() const
+	{
+		return streamLevel > 0;
+	}
+
+	/**
+	 * \brief Get software texture buffer
+	 *
+	 * In GPU_ONLY mode call restoreSurface() first.
+	 * \return SDL_PIXELFORMAT_RGBA8888 surface in OpenGL row order or 0 if texture loading failed or surface has been released
+	 */
+	const SDL_Surface *getSurface() const
+	{
+		return surface;
+	}
+
 	/**
 	 * \brief Get OpenGL texture id
 	 *
@@ -49,12 +192,12 @@ public:
 
 	GLuint getWidth() const
 	{
-		return surface->w;
+		return width;
 	}
 
 	GLuint getHeight() const
 	{
-		return surface->h;
+		return height;
 	}
 
 
@@ -0,0 +1,224 @@
+/**
+ * \brief 2D texture array implementation
+ * \file
+ */
+#include <iostream>
+#include <algorithm>
+#include "texturearray.h"
+#include "uploadformat.h"
+
+/**
+ * \brief Create an empty array
+ * \param width Width of every layer
+ * \param height Height of every layer
+ */
+TextureArray::TextureArray(int width, int height) :
+	oid(0),
+	width(width),
+	height(height),
+	layerCount(0)
+{
+}
+
+TextureArray::~TextureArray()
+{
+	// Release allocated texture id
+	if (oid)
+		glDeleteTextures(1, &oid);
+}
+
+/**
+ * \brief Stage a new layer
+ *
+ * Images of a different size are resampled with a box filter if resize is true.
+ * \param image SDL_PIXELFORMAT_RGBA8888 surface in OpenGL row order
+ * \param resize Allow resampling to the layer size
+ * \return Layer index or -1 if image can not be added
+ */
+int TextureArray::addLayer(const SDL_Surface *image, bool resize)
+{
+	if (oid)
+	{
+		std::cerr << "TextureArray::addLayer(): Array has already been uploaded" << std::endl;
+		return -1;
+	}
+
+	if (!image || ((image->w != width || image->h != height) && !resize))
+		return -1;
+
+	layers.push_back(std::vector<Uint32>(static_cast<size_t>(width) * height));
+	std::vector<Uint32> &layer = layers.back();
+
+	for (int y = 0; y < height; ++y)
+	{
+		// Source rows and columns covered by this destination row. Upscaling covers at least one source texel.
+		int sy0 = y * image->h / height;
+		int sy1 = std::max(sy0 + 1, (y + 1) * image->h / height);
+
+		for (int x = 0; x < width; ++x)
+		{
+			int sx0 = x * image->w / width;
+			int sx1 = std::max(sx0 + 1, (x + 1) * image->w / width);
+
+			Uint32 sum[4] = { 0, 0, 0, 0 };
+			for (int sy = sy0; sy < sy1; ++sy)
+			{
+				const Uint32 *src = reinterpret_cast<const Uint32 *>(static_cast<const Uint8 *>(image->pixels) + sy * image->pitch);
+				for (int sx = sx0; sx < sx1; ++sx)
+				{
+					for (int c = 0; c < 4; ++c)
+						sum[c] += (src[sx] >> (8 * c)) & 0xff;
+				}
+			}
+
+			Uint32 count = static_cast<Uint32>((sy1 - sy0) * (sx1 - sx0));
+			Uint32 result = 0;
+			for (int c = 0; c < 4; ++c)
+				result |= ((sum[c] + count / 2) / count) << (8 * c);
+			layer[static_cast<size_t>(y) * width + x] = result;
+		}
+	}
+
+	return static_cast<int>(layers.size() - 1);
+}
+
+/**
+ * \brief Stage a copy of a texture as a new layer
+ * \return Layer index or -1 if texture can not be added
+ */
+int TextureArray::addLayer(const Texture &texture, bool resize)
+{
+	return addLayer(texture.getSurface(), resize);
+}
+
+/**
+ * \brief Upload staged layers
+ *
+ * Allocates the array on the first call and releases staged layers afterwards.
+ * \return OpenGL texture id allocated for this array
+ */
+GLuint TextureArray::updateGLTexture()
+{
+	if (oid != 0 || layers.empty())
+		return oid;
+
+	glGenTextures(1, &oid);
+	glBindTexture(GL_TEXTURE_2D_ARRAY, oid);
+
+	layerCount = static_cast<int>(layers.size());
+	GLsizei levels = Texture::getMipLevelCount(width, height);
+	const UploadFormat &layout = UploadFormat::getPreferred();
+	if (GLEW_ARB_texture_storage)
+		glTexStorage3D(GL_TEXTURE_2D_ARRAY, levels, GL_RGBA8, width, height, layerCount);
+	else
+		glTexImage3D(GL_TEXTURE_2D_ARRAY, 0, GL_RGBA8, width, height, layerCount, 0, layout.format, layout.type, 0);
+	for (int i = 0; i < layerCount; ++i)
+	{
+		// Staging layers are released below, so they are converted in place
+		layout.convert(&layers[i][0], &layers[i][0], layers[i].size());
+		glTexSubImage3D(GL_TEXTURE_2D_ARRAY, 0, 0, 0, i, width, height, 1, layout.format, layout.type, &layers[i][0]);
+	}
+
+	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAX_LEVEL, levels - 1);
+	Sampler::applyToTexture(GL_TEXTURE_2D_ARRAY, Sampler::Parameters());
+	glGenerateMipmap(GL_TEXTURE_2D_ARRAY);
+
+	// Swap with a temporary object to release staging memory completely
+	std::vector<std::vector<Uint32> > tmp;
+	layers.swap(tmp);
+
+	return oid;
+}
+
+/**
+ * \brief Bind array to a texture unit
+ *
+ * Uploads staged layers first if necessary and uses the shared default sampler. Binds are counted with Texture::countBind().
+ * \param unit Texture unit index (GL_TEXTURE0 + unit is activated)
+ */
+void TextureArray::bind(GLuint unit)
+{
+	GLuint id = updateGLTexture();
+	glActiveTexture(GL_TEXTURE0 + unit);
+	glBindTexture(GL_TEXTURE_2D_ARRAY, id);
+	if (Sampler::isSupported())
+		glBindSampler(unit, Sampler::get());
+	Texture::countBind();
+}
+
+TextureArraySet::~TextureArraySet()
+{
+	for (size_t i = 0; i < arrays.size(); ++i)
+		delete arrays[i];
+}
+
+/**
+ * \brief Load an image and add it to a matching array
+ * \param filename Image file to load
+ * \param[out] layer Location of the image
+ * \param resize Resample into the first array instead of creating a new one for a different size
+ * \return true if success
+ */
+bool TextureArraySet::add(const std::string &filename, Layer &layer, bool resize)
+{
+	SDL_Surface *image = Texture::loadSurface(filename);
+	if (!image)
+		return false;
+
+	bool ok = add(image, layer, resize);
+	SDL_FreeSurface(image);
+	return ok;
+}
+
+/**
+ * \brief Add a copy of a texture to a matching array
+ * \param texture Texture to copy
+ * \param[out] layer Location of the texture
+ * \param resize Resample into the first array instead of creating a new one for a different size
+ * \return true if success
+ */
+bool TextureArraySet::add(const Texture &texture, Layer &layer, bool resize)
+{
+	return add(texture.getSurface(), layer, resize);
+}
+
+/**
+ * \brief Add a copy of an image to a matching array
+ */
+bool TextureArraySet::add(const SDL_Surface *image, Layer &layer, bool resize)
+{
+	if (!image)
+		return false;
+
+	// Prefer an array of the same size that can still take layers
+	for (size_t i = 0; i < arrays.size(); ++i)
+	{
+		if (arrays[i]->getTextureId() == 0 && arrays[i]->getWidth() == image->w && arrays[i]->getHeight() == image->h)
+		{
+			layer.array = arrays[i];
+			layer.layer = arrays[i]->addLayer(image);
+			return layer.layer >= 0;
+		}
+	}
+
+	if (resize && !arrays.empty() && arrays[0]->getTextureId() == 0)
+	{
+		layer.array = arrays[0];
+		layer.layer = arrays[0]->addLayer(image, true);
+		return layer.layer >= 0;
+	}
+
+	arrays.push_back(new TextureArray(image->w, image->h));
+	layer.array = arrays.back();
+	layer.layer = layer.array->addLayer(image);
+	return layer.layer >= 0;
+}
+
+/**
+ * \brief Upload all arrays
+ */
+void TextureArraySet::updateGLTextures()
+{
+	for (size_t i = 0; i < arrays.size(); ++i)
+		arrays[i]->updateGLTexture();
+}
@@ -0,0 +1,107 @@
+/**
+ * \brief 2D texture array interface
+ * \file
+ */
+#ifndef TEXTUREARRAY_H_
+#define TEXTUREARRAY_H_
+
+#include <string>
+#include <vector>
+#include <GL/glew.h>
+#include <SDL.h>
+#include "texture.h"
+
+/**
+ * \brief GL_TEXTURE_2D_ARRAY made of equally sized images
+ *
+ * Objects using different layers of the same array can be drawn without binding a new texture between them.
+ * Shaders sample the array with a sampler2DArray and select the image with the layer index.
+ *
+ * Layers are staged in RAM until updateGLTexture() is called. After the first upload the array is immutable
+ * and staging memory is released.
+ */
+class TextureArray
+{
+	GLuint oid; // Texture object id
+	int width;  // Layer width in texels
+	int height; // Layer height in texels
+	int layerCount; // Number of uploaded layers
+	std::vector<std::vector<Uint32> > layers; // Staged RGBA8888 layers in OpenGL row order
+
+	TextureArray(const TextureArray &);
+	TextureArray &operator=(const TextureArray &);
+public:
+	TextureArray(int width, int height);
+	~TextureArray();
+
+	int addLayer(const SDL_Surface *image, bool resize = false);
+	int addLayer(const Texture &texture, bool resize = false);
+
+	GLuint updateGLTexture();
+	void bind(GLuint unit);
+
+	/**
+	 * \brief Get OpenGL texture id
+	 *
+	 * \return Created OpenGL texture object id or 0 if it has not been created
+	 */
+	GLuint getTextureId() const
+	{
+		return oid;
+	}
+
+	int getWidth() const { return width; }
+	int getHeight() const { return height; }
+
+	/**
+	 * \brief Number of layers in the array
+	 */
+	int getLayerCount() const
+	{
+		return oid ? layerCount : static_cast<int>(layers.size());
+	}
+};
+
+/**
+ * \brief Groups textures into as few TextureArray objects as possible
+ *
+ * Textures of the same size share an array. Textures of other sizes can optionally be resampled to the size
+ * of the first array so that all of them end up in a single array.
+ */
+class TextureArraySet
+{
+	std::vector<TextureArray *> arrays;
+
+	TextureArraySet(const TextureArraySet &);
+	TextureArraySet &operator=(const TextureArraySet &);
+public:
+	/**
+	 * \brief Location of a texture in the set
+	 */
+	struct Layer
+	{
+		TextureArray *array; ///< Array holding the texture. 0 if texture was not added.
+		int layer;           ///< Layer index within the array
+
+		Layer() : array(0), layer(-1) {}
+	};
+
+	TextureArraySet() {}
+	~TextureArraySet();
+
+	bool add(const std::string &filename, Layer &layer, bool resize = false);
+	bool add(const Texture &texture, Layer &layer, bool resize = false);
+	bool add(const SDL_Surface *image, Layer &layer, bool resize = false);
+
+	void updateGLTextures();
+
+	/**
+	 * \brief Number of separate texture arrays. A frame needs at least this many binds.
+	 */
+	size_t getArrayCount() const
+	{
+		return arrays.size();
+	}
+};
+
+#endif
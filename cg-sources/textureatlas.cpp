@@ -0,0 +1,476 @@
+/**
+ * \brief Texture atlas builder implementation
+ * \file
+ */
+#include <algorithm>
+#include "textureatlas.h"
+
+/**
+ * \brief Constructor
+ * \param maxSize Maximum width and height of the atlas texture
+ * \param padding Gutter width in texels at the smallest protected mipmap level
+ * \param mipLevels Number of mipmap levels below the base level that must not bleed between images.
+ *                  Gutters and image positions are scaled by 2^mipLevels to guarantee that.
+ */
+TextureAtlas::TextureAtlas(int maxSize, int padding, int mipLevels) :
+	maxSize(maxSize),
+	padding(padding),
+	mipLevels(mipLevels),
+	texture(0)
+{
+}
+
+TextureAtlas::~TextureAtlas()
+{
+	for (size_t i = 0; i < entries.size(); ++i)
+	{
+		if (entries[i].image)
+			SDL_FreeSurface(entries[i].image);
+	}
+
+	if (texture)
+		delete texture;
+}
+
+/**
+ * \brief Load an image and add it to the atlas
+ * \param name Name used to find the image later
+ * \param filename Image file to load
+ * \return true if success
+ */
+bool TextureAtlas::add(const std::string &name, const std::string &filename)
+{
+	if (texture)
+	{
+		std::cerr << "TextureAtlas::add(): Atlas has already been built, unable to add '" << name << "'" << std::endl;
+		return false;
+	}
+
+	if (entryIndex.find(name) != entryIndex.end())
+		return true;
+
+	SDL_Surface *image = Texture::loadSurface(filename);
+	if (!image)
+		return false;
+
+	return add(name, image);
+}
+
+/**
+ * \brief Add an image to the atlas
+ *
+ * Atlas takes ownership of the surface. Images can only be added before build(), which releases the source images.
+ * \param name Name used to find the image later
+ * \param image SDL_PIXELFORMAT_RGBA8888 surface in OpenGL row order (first row is the bottom of the image)
+ * \return true if success, false if the atlas has already been built
+ */
+bool TextureAtlas::add(const std::string &name, SDL_Surface *image)
+{
+	if (texture)
+	{
+		std::cerr << "TextureAtlas::add(): Atlas has already been built, unable to add '" << name << "'" << std::endl;
+		SDL_FreeSurface(image);
+		return false;
+	}
+
+	if (entryIndex.find(name) != entryIndex.end())
+	{
+		SDL_FreeSurface(image);
+		return true;
+	}
+
+	Entry entry;
+	entry.name = name;
+	entry.image = image;
+	entry.region.x = entry.region.y = 0;
+	entry.region.width = image->w;
+	entry.region.height = image->h;
+
+	entryIndex[name] = entries.size();
+	entries.push_back(entry);
+	return true;
+}
+
+/**
+ * \brief Add diffuse texture maps (map_Kd) of all materials in an object
+ *
+ * Images are named by the map_Kd value so materials sharing an image share the atlas region.
+ * \return Number of images added
+ */
+int TextureAtlas::addMaterials(const ObjParser &obj)
+{
+	int count = 0;
+
+	std::map<std::string, ObjParser::Material>::const_iterator mat_it;
+	for (mat_it = obj.matlib.begin(); mat_it != obj.matlib.end(); ++mat_it)
+	{
+		std::string diffuse_texture;
+		if (!mat_it->second.get("map_Kd", diffuse_texture))
+			continue;
+
+		if (add(diffuse_texture, obj.basePath + "/" + diffuse_texture))
+			++count;
+	}
+
+	return count;
+}
+
+/**
+ * \brief Texels of gutter around every image at the base level
+ */
+int TextureAtlas::getGutter() const
+{
+	return padding << mipLevels;
+}
+
+/**
+ * \brief Image allocations start at multiples of this so mipmap texels never straddle two images
+ */
+int TextureAtlas::getAlignment() const
+{
+	return 1 << mipLevels;
+}
+
+/**
+ * \brief Find the lowest position for a rectangle on the skyline
+ * \return true if rectangle fits
+ */
+bool TextureAtlas::findPosition(const std::vector<SkylineNode> &skyline, int width, int height, int atlasWidth, int atlasHeight, size_t &node, int &x, int &y) const
+{
+	bool found = false;
+	node = 0;
+	x = 0;
+	y = 0;
+
+	for (size_t i = 0; i < skyline.size(); ++i)
+	{
+		if (skyline[i].x + width > atlasWidth)
+			break;
+
+		// Rectangle rests on the highest node it spans
+		int top = 0;
+		int remaining = width;
+		for (size_t j = i; j < skyline.size() && remaining > 0; ++j)
+		{
+			top = std::max(top, skyline[j].y);
+			remaining -= skyline[j].width;
+		}
+
+		if (top + height > atlasHeight)
+			continue;
+
+		if (!found || top < y)
+		{
+			found = true;
+			node = i;
+			x = skyline[i].x;
+			y = top;
+		}
+	}
+
+	return found;
+}
+
+/**
+ * \brief Try to pack all images into an atlas of given size
+ * \return true if everything fits. Regions are updated.
+ */
+bool TextureAtlas::pack(int width, int height)
+{
+	int gutter = getGutter();
+	int alignment = getAlignment();
+
+	// Placing tall images first gives a flatter skyline
+	std::vector<size_t> order(entries.size());
+	for (size_t i = 0; i < order.size(); ++i)
+		order[i] = i;
+	std::sort(order.begin(), order.end(), [this](size_t a, size_t b) { return entries[a].region.height > entries[b].region.height; });
+
+	std::vector<SkylineNode> skyline;
+	SkylineNode first = { 0, 0, width };
+	skyline.push_back(first);
+
+	for (size_t i = 0; i < order.size(); ++i)
+	{
+		Region &region = entries[order[i]].region;
+
+		// Allocation includes gutters on both sides and is rounded up to the alignment
+		int allocWidth = (region.width + 2 * gutter + alignment - 1) / alignment * alignment;
+		int allocHeight = (region.height + 2 * gutter + alignment - 1) / alignment * alignment;
+
+		size_t node;
+		int x, y;
+		if (!findPosition(skyline, allocWidth, allocHeight, width, height, node, x, y))
+			return false;
+
+		region.x = x + gutter;
+		region.y = y + gutter;
+
+		// Raise the skyline under the new allocation
+		SkylineNode raised = { x, y + allocHeight, allocWidth };
+		skyline.insert(skyline.begin() + node, raised);
+
+		for (size_t j = node + 1; j < skyline.size(); )
+		{
+			int overlap = raised.x + raised.width - skyline[j].x;
+			if (overlap <= 0)
+				break;
+
+			if (overlap >= skyline[j].width)
+			{
+				skyline.erase(skyline.begin() + j);
+				continue;
+			}
+
+			skyline[j].x += overlap;
+			skyline[j].width -= overlap;
+			break;
+		}
+
+		// Merge neighbours at the same height
+		for (size_t j = 0; j + 1 < skyline.size(); )
+		{
+			if (skyline[j].y == skyline[j + 1].y)
+			{
+				skyline[j].width += skyline[j + 1].width;
+				skyline.erase(skyline.begin() + j + 1);
+			} else
+				++j;
+		}
+	}
+
+	return true;
+}
+
+/**
+ * \brief Copy image into atlas and fill its gutter by repeating edge texels
+ */
+void TextureAtlas::blit(SDL_Surface *atlas, const Entry &entry) const
+{
+	const Region &region = entry.region;
+	int gutter = getGutter();
+
+	for (int ay = region.y - gutter; ay < region.y + region.height + gutter; ++ay)
+	{
+		int sy = std::min(std::max(ay - region.y, 0), region.height - 1);
+		const Uint32 *src = reinterpret_cast<const Uint32 *>(static_cast<const Uint8 *>(entry.image->pixels) + sy * entry.image->pitch);
+		Uint32 *dst = reinterpret_cast<Uint32 *>(static_cast<Uint8 *>(atlas->pixels) + ay * atlas->pitch);
+
+		for (int ax = region.x - gutter; ax < region.x + region.width + gutter; ++ax)
+			dst[ax] = src[std::min(std::max(ax - region.x, 0), region.width - 1)];
+	}
+}
+
+/**
+ * \brief Pack added images and create the atlas texture
+ *
+ * Atlas size is the smallest power of two that fits all images, up to maxSize.
+ * Source images are released after a successful build, so the atlas can not be changed or built again afterwards.
+ * \return true if success
+ */
+bool TextureAtlas::build()
+{
+	if (texture)
+		return true;
+	if (entries.empty())
+		return false;
+
+	// Start from the total area and the largest single allocation
+	int gutter = getGutter();
+	long long area = 0;
+	int minSize = 1;
+	for (size_t i = 0; i < entries.size(); ++i)
+	{
+		int w = entries[i].region.width + 2 * gutter;
+		int h = entries[i].region.height + 2 * gutter;
+		area += static_cast<long long>(w) * h;
+		minSize = std::max(minSize, std::max(w, h));
+	}
+
+	int width = 1;
+	while (width < minSize || static_cast<long long>(width) * width < area)
+		width *= 2;
+	int height = width / 2 >= minSize && static_cast<long long>(width) * (width / 2) >= area ? width / 2 : width;
+
+	while (!pack(width, height))
+	{
+		// Grow alternately in height and width
+		if (height < width)
+			height *= 2;
+		else
+			width *= 2;
+
+		if (width > maxSize || height > maxSize)
+		{
+			std::cerr << "TextureAtlas::build(): Images do not fit into a " << maxSize << " x " << maxSize << " atlas" << std::endl;
+			return false;
+		}
+	}
+
+	SDL_Surface *atlas = SDL_CreateRGBSurface(0, width, height, 32, 0xff000000, 0x00ff0000, 0x0000ff00, 0x000000ff);
+	if (!atlas)
+	{
+		std::cerr << "TextureAtlas::build(): Unable to create atlas surface: " << SDL_GetError() << std::endl;
+		return false;
+	}
+
+	if (SDL_MUSTLOCK(atlas))
+		SDL_LockSurface(atlas);
+
+	for (size_t i = 0; i < entries.size(); ++i)
+	{
+		Entry &entry = entries[i];
+		blit(atlas, entry);
+
+		entry.region.uvScale = glm::vec2(static_cast<float>(entry.region.width) / width, static_cast<float>(entry.region.height) / height);
+		entry.region.uvOffset = glm::vec2(static_cast<float>(entry.region.x) / width, static_cast<float>(entry.region.y) / height);
+
+		SDL_FreeSurface(entry.image);
+		entry.image = 0;
+	}
+
+	if (SDL_MUSTLOCK(atlas))
+		SDL_UnlockSurface(atlas);
+
+	std::cout << "TextureAtlas::build(): Packed " << entries.size() << " images into " << width << " x " << height << std::endl;
+
+	// Texture owns the atlas surface from now on
+	texture = new Texture(atlas);
+
+	// Mipmap levels past the protected ones would mix neighbouring images
+	glBindTexture(GL_TEXTURE_2D, texture->getTextureId());
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, mipLevels);
+
+	return true;
+}
+
+/**
+ * \brief Get location of a named image
+ * \return true if image exists and atlas has been built
+ */
+bool TextureAtlas::getRegion(const std::string &name, Region &region) const
+{
+	std::map<std::string, size_t>::const_iterator it = entryIndex.find(name);
+	if (it == entryIndex.end() || !texture)
+		return false;
+
+	region = entries[it->second].region;
+	return true;
+}
+
+/**
+ * \brief Get texture coordinate transformation of a material's diffuse map
+ *
+ * Use this to transform coordinates in a shader (uv * uvScale + uvOffset) when vertex data should not be modified.
+ * \return true if material has a diffuse map in this atlas
+ */
+bool TextureAtlas::getMaterialTransform(const ObjParser &obj, const std::string &materialName, glm::vec2 &uvScale, glm::vec2 &uvOffset) const
+{
+	std::map<std::string, ObjParser::Material>::const_iterator mat_it = obj.matlib.find(materialName);
+	if (mat_it == obj.matlib.end())
+		return false;
+
+	std::string diffuse_texture;
+	Region region;
+	if (!mat_it->second.get("map_Kd", diffuse_texture) || !getRegion(diffuse_texture, region))
+		return false;
+
+	uvScale = region.uvScale;
+	uvOffset = region.uvOffset;
+	return true;
+}
+
+/**
+ * \brief Rewrite texture coordinates of an object to point into the atlas
+ *
+ * Every vertex used by a material with a diffuse map in the atlas is transformed into the map's region.
+ * ObjParser shares identical vertices between materials, so a vertex used by two different images is duplicated
+ * and the indices of the second material are updated to use the copy.
+ * \return Number of transformed vertices
+ */
+int TextureAtlas::remapTextureCoordinates(ObjParser &obj) const
+{
+	int count = 0;
+
+	std::map<std::string, ObjParser::VertexSet>::iterator obj_it;
+	for (obj_it = obj.objVertexSet.begin(); obj_it != obj.objVertexSet.end(); ++obj_it)
+	{
+		ObjParser::VertexSet &vset = obj_it->second;
+
+		// Original coordinates and the region each vertex was mapped to (-1 for not mapped yet)
+		std::vector<std::vector<glm::vec2> > original(vset.vertexBuffers.size());
+		std::vector<std::vector<int> > owner(vset.vertexBuffers.size());
+		for (size_t vb = 0; vb < vset.vertexBuffers.size(); ++vb)
+		{
+			original[vb] = vset.vertexBuffers[vb].texture;
+			owner[vb].resize(vset.vertexBuffers[vb].texture.size(), -1);
+		}
+
+		// Copies made for (vertex buffer, vertex, region)
+		std::map<std::pair<std::pair<unsigned int, unsigned int>, int>, unsigned int> copies;
+
+		ObjParser::VertexSet::group_type::iterator group_it;
+		for (group_it = vset.groupMaterialFaces.begin(); group_it != vset.groupMaterialFaces.end(); ++group_it)
+		{
+			ObjParser::VertexSet::material_type::iterator material_it;
+			for (material_it = group_it->second.begin(); material_it != group_it->second.end(); ++material_it)
+			{
+				std::map<std::string, ObjParser::Material>::const_iterator mat_it = obj.matlib.find(material_it->first);
+				std::string diffuse_texture;
+				if (mat_it == obj.matlib.end() || !mat_it->second.get("map_Kd", diffuse_texture))
+					continue;
+
+				std::map<std::string, size_t>::const_iterator entry_it = entryIndex.find(diffuse_texture);
+				if (entry_it == entryIndex.end() || !texture)
+					continue;
+
+				int regionId = static_cast<int>(entry_it->second);
+				const Region &region = entries[regionId].region;
+
+				ObjParser::VertexSet::faces_type::iterator face_range_it;
+				for (face_range_it = material_it->second.begin(); face_range_it != material_it->second.end(); ++face_range_it)
+				{
+					unsigned int vb = face_range_it->vbIndex;
+					ObjParser::VertexBuffer &vbuffer = vset.vertexBuffers[vb];
+					if (!vbuffer.hasTexture())
+						continue;
+
+					for (unsigned int i = face_range_it->startIndex; i < face_range_it->startIndex + face_range_it->length; ++i)
+					{
+						unsigned int v = vbuffer.indices[i];
+
+						if (owner[vb][v] == regionId)
+							continue;
+
+						if (owner[vb][v] < 0)
+						{
+							vbuffer.texture[v] = original[vb][v] * region.uvScale + region.uvOffset;
+							owner[vb][v] = regionId;
+							++count;
+							continue;
+						}
+
+						// Vertex belongs to another image already. Use (or create) a copy for this one.
+						std::pair<std::pair<unsigned int, unsigned int>, int> key(std::make_pair(vb, v), regionId);
+						std::map<std::pair<std::pair<unsigned int, unsigned int>, int>, unsigned int>::iterator copy_it = copies.find(key);
+						if (copy_it == copies.end())
+						{
+							unsigned int copy = static_cast<unsigned int>(vbuffer.pos.size());
+							vbuffer.pos.push_back(vbuffer.pos[v]);
+							vbuffer.texture.push_back(original[vb][v] * region.uvScale + region.uvOffset);
+							if (vbuffer.hasNormal())
+								vbuffer.normal.push_back(vbuffer.normal[v]);
+							original[vb].push_back(original[vb][v]);
+							owner[vb].push_back(regionId);
+							copy_it = copies.insert(std::make_pair(key, copy)).first;
+							++count;
+						}
+						vbuffer.indices[i] = copy_it->second;
+					}
+				}
+			}
+		}
+	}
+
+	return count;
+}
@@ -0,0 +1,91 @@
+/**
+ * \brief Texture atlas builder interface
+ * \file
+ */
+#ifndef TEXTUREATLAS_H_
+#define TEXTUREATLAS_H_
+
+#include <string>
+#include <vector>
+#include <map>
+#include <glm/glm.hpp>
+#include "texture.h"
+#include "objparser.h"
+
+/**
+ * \brief Packs many small images into a single Texture
+ *
+ * Images are packed with a skyline bottom-left packer. Every image gets a gutter of repeated edge texels around it
+ * so that bilinear filtering and the first mipmap levels do not sample neighbouring images.
+ *
+ * Texture coordinates of an image are mapped into the atlas with uv * scale + offset. This can be done either in a
+ * shader with getRegion() / getMaterialTransform() or by rewriting ObjParser texture coordinates with remapTextureCoordinates().
+ * Repeating texture coordinates (outside [0, 1]) can not be represented in an atlas.
+ */
+class TextureAtlas
+{
+public:
+	/**
+	 * \brief Location of a single image inside the atlas
+	 */
+	struct Region
+	{
+		int x, y;           ///< Lower left corner in atlas texels (OpenGL orientation)
+		int width, height;  ///< Image size in texels without gutters
+		glm::vec2 uvScale;  ///< Scale for original texture coordinates
+		glm::vec2 uvOffset; ///< Offset added after scaling
+	};
+
+private:
+	struct Entry
+	{
+		std::string name;
+		SDL_Surface *image; // RGBA8888 image in OpenGL row order. Released after build(), so add() is rejected from then on.
+		Region region;
+	};
+
+	struct SkylineNode
+	{
+		int x, y, width;
+	};
+
+	int maxSize;   // Maximum atlas width and height
+	int padding;   // Gutter texels that remain at the smallest protected mipmap level
+	int mipLevels; // Number of mipmap levels protected from bleeding
+	std::vector<Entry> entries;
+	std::map<std::string, size_t> entryIndex;
+	Texture *texture;
+
+	bool pack(int width, int height);
+	bool findPosition(const std::vector<SkylineNode> &skyline, int width, int height, int atlasWidth, int atlasHeight, size_t &node, int &x, int &y) const;
+	void blit(SDL_Surface *atlas, const Entry &entry) const;
+	int getGutter() const;
+	int getAlignment() const;
+
+	TextureAtlas(const TextureAtlas &);
+	TextureAtlas &operator=(const TextureAtlas &);
+public:
+	TextureAtlas(int maxSize = 4096, int padding = 1, int mipLevels = 2);
+	~TextureAtlas();
+
+	bool add(const std::string &name, const std::string &filename);
+	bool add(const std::string &name, SDL_Surface *image);
+	int addMaterials(const ObjParser &obj);
+
+	bool build();
+
+	bool getRegion(const std::string &name, Region &region) const;
+	bool getMaterialTransform(const ObjParser &obj, const std::string &materialName, glm::vec2 &uvScale, glm::vec2 &uvOffset) const;
+	int remapTextureCoordinates(ObjParser &obj) const;
+
+	/**
+	 * \brief Get the packed texture
+	 * \return Atlas texture or 0 if build() has not succeeded
+	 */
+	Texture *getTexture() const
+	{
+		return texture;
+	}
+};
+
+#endif
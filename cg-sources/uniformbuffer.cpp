@@ -0,0 +1,226 @@
+/**
+ * \brief Uniform buffer object implementation
+ * \file
+ */
+#include <iostream>
+#include <cstring>
+#include "uniformbuffer.h"
+
+/**
+ * \brief Create a buffer of size bytes and bind it to a binding point
+ */
+UniformBuffer::UniformBuffer(GLuint binding, GLsizeiptr size) :
+	buffer(0),
+	binding(binding),
+	size(size)
+{
+	glGenBuffers(1, &buffer);
+	glBindBufferBase(GL_UNIFORM_BUFFER, binding, buffer);
+	glBufferData(GL_UNIFORM_BUFFER, size, 0, GL_STREAM_DRAW);
+}
+
+UniformBuffer::~UniformBuffer()
+{
+	glDeleteBuffers(1, &buffer);
+}
+
+/**
+ * \brief Replace the whole contents of the buffer, typically once per frame
+ *
+ * Storage is orphaned so the update never waits for draws of the previous frame that still read the old data.
+ * \param data size bytes given to the constructor
+ */
+void UniformBuffer::update(const void *data)
+{
+	glBindBufferBase(GL_UNIFORM_BUFFER, binding, buffer);
+	glBufferData(GL_UNIFORM_BUFFER, size, data, GL_STREAM_DRAW);
+}
+
+/**
+ * \brief Bind the buffer to its binding point again, needed only if other code has used the same binding point
+ */
+void UniformBuffer::bind() const
+{
+	glBindBufferBase(GL_UNIFORM_BUFFER, binding, buffer);
+}
+
+/**
+ * \brief Binding point of a shared uniform block
+ * \return GL_INVALID_INDEX if blockName is not one of the shared blocks
+ */
+GLuint UniformBuffer::getBlockBinding(const std::string &blockName)
+{
+	if (blockName == "FrameData")
+		return FRAME_BINDING;
+	if (blockName == "ObjectData")
+		return OBJECT_BINDING;
+	return GL_INVALID_INDEX;
+}
+
+/**
+ * \brief Allocate the ring
+ * \param binding Binding point used by bind()
+ * \param regionSize Maximum bytes pushed during one frame
+ * \param regionCount Number of frames that may be in flight at the same time
+ */
+UniformBufferRing::UniformBufferRing(GLuint binding, GLsizeiptr regionSize, unsigned int regionCount) :
+	buffer(0),
+	binding(binding),
+	regionSize(regionSize),
+	alignment(256),
+	current(0),
+	used(0),
+	persistent(GLEW_ARB_buffer_storage != 0),
+	persistentPointer(0),
+	fences(regionCount < 1 ? 1 : regionCount, static_cast<GLsync>(0))
+{
+	glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &alignment);
+	if (alignment < 1)
+		alignment = 256;
+
+	// Every region has to start at a valid offset for glBindBufferRange()
+	this->regionSize = (regionSize + alignment - 1) / alignment * alignment;
+
+	glGenBuffers(1, &buffer);
+	glBindBuffer(GL_UNIFORM_BUFFER, buffer);
+
+	if (persistent)
+	{
+		const GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+		GLsizeiptr total = this->regionSize * static_cast<GLsizeiptr>(fences.size());
+		glBufferStorage(GL_UNIFORM_BUFFER, total, 0, flags);
+		persistentPointer = glMapBufferRange(GL_UNIFORM_BUFFER, 0, total, flags);
+
+		if (!persistentPointer)
+		{
+			std::cerr << "UniformBufferRing: Unable to map buffer persistently, falling back to orphaning" << std::endl;
+			glBindBuffer(GL_UNIFORM_BUFFER, 0);
+			glDeleteBuffers(1, &buffer);
+			glGenBuffers(1, &buffer);
+			glBindBuffer(GL_UNIFORM_BUFFER, buffer);
+			persistent = false;
+		}
+	}
+
+	if (!persistent)
+	{
+		staging.resize(this->regionSize);
+		glBufferData(GL_UNIFORM_BUFFER, this->regionSize, 0, GL_STREAM_DRAW);
+	}
+
+	glBindBuffer(GL_UNIFORM_BUFFER, 0);
+}
+
+UniformBufferRing::~UniformBufferRing()
+{
+	for (size_t i = 0; i < fences.size(); ++i)
+	{
+		if (fences[i])
+			glDeleteSync(fences[i]);
+	}
+
+	if (persistent)
+	{
+		glBindBuffer(GL_UNIFORM_BUFFER, buffer);
+		glUnmapBuffer(GL_UNIFORM_BUFFER);
+		glBindBuffer(GL_UNIFORM_BUFFER, 0);
+	}
+
+	glDeleteBuffers(1, &buffer);
+}
+
+/**
+ * \brief Block until the GPU has finished the frame that last used a region
+ */
+void UniformBufferRing::waitFence(unsigned int region)
+{
+	if (!fences[region])
+		return;
+
+	GLbitfield flags = GL_SYNC_FLUSH_COMMANDS_BIT;
+	for (;;)
+	{
+		GLenum result = glClientWaitSync(fences[region], flags, 1000000); // 1 ms
+		if (result == GL_ALREADY_SIGNALED || result == GL_CONDITION_SATISFIED || result == GL_WAIT_FAILED)
+			break;
+		flags = 0;
+	}
+
+	glDeleteSync(fences[region]);
+	fences[region] = 0;
+}
+
+/**
+ * \brief Start pushing data for a new frame into the next region
+ */
+void UniformBufferRing::beginFrame()
+{
+	current = (current + 1) % fences.size();
+	used = 0;
+
+	if (persistent)
+		waitFence(current);
+}
+
+/**
+ * \brief Copy data for one draw call into the current region
+ * \return Offset for bind() or -1 if the region is full
+ */
+GLintptr UniformBufferRing::push(const void *data, GLsizeiptr bytes)
+{
+	if (used + bytes > regionSize)
+	{
+		std::cerr << "UniformBufferRing::push(): Region of " << regionSize << " bytes is full" << std::endl;
+		return -1;
+	}
+
+	GLintptr offset = used;
+	used += (bytes + alignment - 1) / alignment * alignment;
+
+	if (persistent)
+	{
+		offset += regionSize * current;
+		std::memcpy(static_cast<unsigned char *>(persistentPointer) + offset, data, bytes);
+		return offset;
+	}
+
+	std::memcpy(&staging[offset], data, bytes);
+	return offset;
+}
+
+/**
+ * \brief Make pushed data visible to the GPU. Call after the last push() and before the first draw of the frame.
+ *
+ * Does nothing with persistent mapping, as coherent writes are visible to later draws automatically.
+ */
+void UniformBufferRing::flush()
+{
+	if (persistent || used == 0)
+		return;
+
+	// Orphaning lets the driver hand out fresh memory while draws of the previous frame still read the old data
+	glBindBuffer(GL_UNIFORM_BUFFER, buffer);
+	glBufferData(GL_UNIFORM_BUFFER, used, &staging[0], GL_STREAM_DRAW);
+	glBindBuffer(GL_UNIFORM_BUFFER, 0);
+}
+
+/**
+ * \brief Select data returned by push() for the following draw calls
+ */
+void UniformBufferRing::bind(GLintptr offset, GLsizeiptr bytes) const
+{
+	glBindBufferRange(GL_UNIFORM_BUFFER, binding, buffer, offset, bytes);
+}
+
+/**
+ * \brief Mark the end of draws using the current region
+ */
+void UniformBufferRing::endFrame()
+{
+	if (!persistent)
+		return;
+
+	if (fences[current])
+		glDeleteSync(fences[current]);
+	fences[current] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+}
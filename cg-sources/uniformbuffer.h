@@ -0,0 +1,146 @@
+/**
+ * \brief Uniform buffer objects for per-frame and per-object shader data
+ * \file
+ */
+#ifndef UNIFORMBUFFER_H_
+#define UNIFORMBUFFER_H_
+
+#include <string>
+#include <vector>
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+
+/**
+ * \brief Data shared by every program during a frame, uniform block FrameData in the shaders
+ *
+ * Layout follows std140 rules, so members must stay 16-byte aligned vec4/mat4 or be grouped into full vec4s.
+ * Matching GLSL declaration:
+ * \code
+ * layout(std140) uniform FrameData
+ * {
+ *     mat4 viewMatrix;
+ *     mat4 projectionMatrix;
+ *     vec4 lightPosition[4]; // In view coordinate frame!
+ *     vec4 lightColor[4];
+ *     int lightCount;
+ *     float time;
+ * };
+ * \endcode
+ */
+struct FrameUniforms
+{
+	static const int MAX_LIGHTS = 4;
+
+	glm::mat4 view;
+	glm::mat4 projection;
+	glm::vec4 lightPosition[MAX_LIGHTS];
+	glm::vec4 lightColor[MAX_LIGHTS];
+	GLint lightCount;
+	GLfloat time;
+	GLfloat padding[2];
+};
+
+/**
+ * \brief Transformations of one object, uniform block ObjectData in the shaders
+ *
+ * \code
+ * layout(std140) uniform ObjectData
+ * {
+ *     mat4 modelMatrix;
+ *     mat4 modelViewMatrix;
+ *     mat4 mvpMatrix;
+ * };
+ * \endcode
+ */
+struct ObjectUniforms
+{
+	glm::mat4 model;
+	glm::mat4 modelView;
+	glm::mat4 mvp;
+};
+
+static_assert(sizeof(FrameUniforms) == 2 * 64 + 2 * FrameUniforms::MAX_LIGHTS * 16 + 16, "FrameUniforms does not match std140 layout");
+static_assert(sizeof(ObjectUniforms) == 3 * 64, "ObjectUniforms does not match std140 layout");
+
+/**
+ * \brief Uniform buffer bound to a fixed binding point
+ *
+ * Programs loaded with ShaderProgram get their FrameData and ObjectData blocks connected to FRAME_BINDING and
+ * OBJECT_BINDING, so updating the buffer once makes the data visible to every program without glUniform*() calls.
+ */
+class UniformBuffer
+{
+	GLuint buffer;
+	GLuint binding;
+	GLsizeiptr size;
+
+	UniformBuffer(const UniformBuffer &);
+	UniformBuffer &operator=(const UniformBuffer &);
+public:
+	/**
+	 * \brief Binding points reserved for the shared uniform blocks
+	 */
+	enum Binding
+	{
+		FRAME_BINDING = 0,  ///< FrameData, see FrameUniforms
+		OBJECT_BINDING = 1  ///< ObjectData, see ObjectUniforms
+	};
+
+	UniformBuffer(GLuint binding, GLsizeiptr size);
+	~UniformBuffer();
+
+	void update(const void *data);
+	void bind() const;
+
+	static GLuint getBlockBinding(const std::string &blockName);
+};
+
+/**
+ * \brief Ring of uniform buffer regions for data that changes for every draw call
+ *
+ * Data of every object drawn during a frame is packed into one region and each draw selects its part with
+ * glBindBufferRange(). Regions of the previous frames are not touched while the GPU may still read them.
+ *
+ * With ARB_buffer_storage the buffer is mapped persistently and push() writes straight into it. Otherwise
+ * push() writes into system memory and flush() uploads the whole frame with a single orphaning glBufferData().
+ *
+ * Usage for each frame:
+ * \code
+ * ring.beginFrame();
+ * GLintptr a = ring.push(&objectA, sizeof(objectA));
+ * GLintptr b = ring.push(&objectB, sizeof(objectB));
+ * ring.flush();
+ * ring.bind(a, sizeof(objectA)); draw A
+ * ring.bind(b, sizeof(objectB)); draw B
+ * ring.endFrame();
+ * \endcode
+ */
+class UniformBufferRing
+{
+	GLuint buffer;
+	GLuint binding;
+	GLsizeiptr regionSize;     // Bytes available for one frame
+	GLint alignment;           // GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT
+	unsigned int current;      // Region of the current frame
+	GLsizeiptr used;           // Bytes pushed during the current frame
+	bool persistent;           // True if buffer is persistently mapped
+	void *persistentPointer;   // Start of the persistently mapped buffer
+	std::vector<unsigned char> staging; // Data of the current frame without persistent mapping
+	std::vector<GLsync> fences;         // Fence of the last frame using each region
+
+	void waitFence(unsigned int region);
+
+	UniformBufferRing(const UniformBufferRing &);
+	UniformBufferRing &operator=(const UniformBufferRing &);
+public:
+	UniformBufferRing(GLuint binding, GLsizeiptr regionSize, unsigned int regionCount = 3);
+	~UniformBufferRing();
+
+	void beginFrame();
+	GLintptr push(const void *data, GLsizeiptr bytes);
+	void flush();
+	void bind(GLintptr offset, GLsizeiptr bytes) const;
+	void endFrame();
+};
+
+#endif
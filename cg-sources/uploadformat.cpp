@@ -0,0 +1,245 @@
+/**
+ * \brief Texture upload format negotiation implementation
+ * \file
+ */
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <algorithm>
+#include "uploadformat.h"
+
+// SSE2 is always available on x86-64
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define UPLOADFORMAT_SSE2
+#endif
+
+bool UploadFormat::queried = false;
+UploadFormat UploadFormat::preferred;
+std::vector<Uint32> UploadFormat::scratch;
+
+namespace
+{
+	inline Uint32 reverseBytes(Uint32 c)
+	{
+		return (c << 24) | ((c << 8) & 0x00ff0000) | ((c >> 8) & 0x0000ff00) | (c >> 24);
+	}
+
+	inline Uint32 rotateAlpha(Uint32 c)
+	{
+		return (c >> 8) | (c << 24);
+	}
+
+	const char *getEnumName(GLenum value)
+	{
+		switch (value)
+		{
+		case GL_RGBA: return "GL_RGBA";
+		case GL_BGRA: return "GL_BGRA";
+		case GL_UNSIGNED_BYTE: return "GL_UNSIGNED_BYTE";
+		case GL_UNSIGNED_INT_8_8_8_8: return "GL_UNSIGNED_INT_8_8_8_8";
+		case GL_UNSIGNED_INT_8_8_8_8_REV: return "GL_UNSIGNED_INT_8_8_8_8_REV";
+		default: return "?";
+		}
+	}
+
+	/**
+	 * \brief Megabytes per second for bytes processed in a time measured with SDL_GetPerformanceCounter()
+	 */
+	double getRate(size_t bytes, Uint64 ticks)
+	{
+		double seconds = static_cast<double>(ticks) / SDL_GetPerformanceFrequency();
+		return seconds > 0.0 ? bytes / (1024.0 * 1024.0) / seconds : 0.0;
+	}
+}
+
+/**
+ * \brief Select the conversion needed for a format and type combination
+ * \param format GL_RGBA or GL_BGRA
+ * \param type GL_UNSIGNED_BYTE, GL_UNSIGNED_INT_8_8_8_8 or GL_UNSIGNED_INT_8_8_8_8_REV
+ */
+UploadFormat::UploadFormat(GLenum format, GLenum type) :
+	format(format),
+	type(type),
+	swizzle(SWIZZLE_NONE),
+	valid(true)
+{
+	// Byte types are stored in memory order, packed types as 32-bit values
+	bool bigEndian = SDL_BYTEORDER == SDL_BIG_ENDIAN;
+
+	if (format == GL_RGBA && type == GL_UNSIGNED_INT_8_8_8_8)
+		swizzle = SWIZZLE_NONE;
+	else
+	if (format == GL_RGBA && type == GL_UNSIGNED_INT_8_8_8_8_REV)
+		swizzle = SWIZZLE_REVERSE;
+	else
+	if (format == GL_RGBA && type == GL_UNSIGNED_BYTE)
+		swizzle = bigEndian ? SWIZZLE_NONE : SWIZZLE_REVERSE;
+	else
+	if (format == GL_BGRA && type == GL_UNSIGNED_INT_8_8_8_8_REV)
+		swizzle = SWIZZLE_ROTATE;
+	else
+	if (format == GL_BGRA && type == GL_UNSIGNED_BYTE && !bigEndian)
+		swizzle = SWIZZLE_ROTATE;
+	else
+		valid = false;
+}
+
+/**
+ * \brief Convert RGBA8888 pixels to this layout
+ *
+ * src and dst may be the same buffer. dst can be write-only memory such as a mapped pixel buffer.
+ */
+void UploadFormat::convert(const void *src, void *dst, size_t pixels) const
+{
+	const Uint32 *in = static_cast<const Uint32 *>(src);
+	Uint32 *out = static_cast<Uint32 *>(dst);
+	size_t i = 0;
+
+	if (swizzle == SWIZZLE_NONE)
+	{
+		if (in != out)
+			std::copy(in, in + pixels, out);
+		return;
+	}
+
+#ifdef UPLOADFORMAT_SSE2
+	if (swizzle == SWIZZLE_REVERSE)
+	{
+		const __m128i mask1 = _mm_set1_epi32(0x00ff0000);
+		const __m128i mask2 = _mm_set1_epi32(0x0000ff00);
+		for (; i + 4 <= pixels; i += 4)
+		{
+			__m128i c = _mm_loadu_si128(reinterpret_cast<const __m128i *>(in + i));
+			__m128i outer = _mm_or_si128(_mm_slli_epi32(c, 24), _mm_srli_epi32(c, 24));
+			__m128i inner = _mm_or_si128(_mm_and_si128(_mm_slli_epi32(c, 8), mask1), _mm_and_si128(_mm_srli_epi32(c, 8), mask2));
+			_mm_storeu_si128(reinterpret_cast<__m128i *>(out + i), _mm_or_si128(outer, inner));
+		}
+	} else
+	{
+		for (; i + 4 <= pixels; i += 4)
+		{
+			__m128i c = _mm_loadu_si128(reinterpret_cast<const __m128i *>(in + i));
+			_mm_storeu_si128(reinterpret_cast<__m128i *>(out + i), _mm_or_si128(_mm_srli_epi32(c, 8), _mm_slli_epi32(c, 24)));
+		}
+	}
+#endif
+
+	// Remaining pixels, or all without SSE2
+	if (swizzle == SWIZZLE_REVERSE)
+	{
+		for (; i < pixels; ++i)
+			out[i] = reverseBytes(in[i]);
+	} else
+	{
+		for (; i < pixels; ++i)
+			out[i] = rotateAlpha(in[i]);
+	}
+}
+
+/**
+ * \brief Pixels ready to upload in this layout, either the given ones or a converted copy
+ *
+ * The copy is kept in a buffer shared by all uploads that only grows, so converting allocates nothing after the
+ * largest upload has been seen. It is valid until the next prepare(). Call from the OpenGL thread only.
+ */
+const void *UploadFormat::prepare(const void *pixels, size_t count) const
+{
+	if (swizzle == SWIZZLE_NONE)
+		return pixels;
+
+	if (scratch.size() < count)
+		scratch.resize(count);
+	convert(pixels, &scratch[0], count);
+	return &scratch[0];
+}
+
+/**
+ * \brief Get the layout the driver prefers for GL_RGBA8 textures
+ *
+ * Queried once. Falls back to GL_RGBA / GL_UNSIGNED_INT_8_8_8_8 without ARB_internalformat_query2 or if the driver
+ * prefers a layout that RGBA8888 can not be converted to.
+ */
+const UploadFormat &UploadFormat::getPreferred()
+{
+	if (queried)
+		return preferred;
+	queried = true;
+
+	if (!GLEW_ARB_internalformat_query2)
+		return preferred;
+
+	GLint format = 0;
+	GLint type = 0;
+	glGetInternalformativ(GL_TEXTURE_2D, GL_RGBA8, GL_TEXTURE_IMAGE_FORMAT, 1, &format);
+	glGetInternalformativ(GL_TEXTURE_2D, GL_RGBA8, GL_TEXTURE_IMAGE_TYPE, 1, &type);
+
+	UploadFormat candidate(format, type);
+	if (candidate.isValid())
+		preferred = candidate;
+	else
+		std::cerr << "UploadFormat: Driver prefers unsupported layout " << std::hex << format << " / " << type << std::dec << std::endl;
+
+	return preferred;
+}
+
+/**
+ * \brief Print upload speeds of every supported layout to std::cout
+ *
+ * Every layout is uploaded to a GL_RGBA8 texture of the given size. Upload time includes glFinish() so that
+ * drivers that copy asynchronously are measured fully. Swizzle time is our conversion from RGBA8888.
+ * Needs a current OpenGL context.
+ */
+void UploadFormat::benchmark(int width, int height, int iterations)
+{
+	static const GLenum formats[] = {GL_RGBA, GL_BGRA};
+	static const GLenum types[] = {GL_UNSIGNED_BYTE, GL_UNSIGNED_INT_8_8_8_8, GL_UNSIGNED_INT_8_8_8_8_REV};
+
+	size_t pixels = static_cast<size_t>(width) * height;
+	size_t bytes = pixels * 4 * iterations;
+	std::vector<Uint32> source(pixels);
+	std::vector<Uint32> converted(pixels);
+	for (size_t i = 0; i < pixels; ++i)
+		source[i] = static_cast<Uint32>(i * 2654435761u);
+
+	GLuint texture;
+	glGenTextures(1, &texture);
+	glBindTexture(GL_TEXTURE_2D, texture);
+	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, width, height, 0, GL_RGBA, GL_UNSIGNED_INT_8_8_8_8, 0);
+
+	const UploadFormat &best = getPreferred();
+	std::cout << "Texture upload benchmark, " << width << " x " << height << " GL_RGBA8, " << iterations << " uploads" << std::endl;
+
+	for (size_t f = 0; f < sizeof(formats) / sizeof(formats[0]); ++f)
+	{
+		for (size_t t = 0; t < sizeof(types) / sizeof(types[0]); ++t)
+		{
+			UploadFormat layout(formats[f], types[t]);
+			if (!layout.isValid())
+				continue;
+
+			Uint64 start = SDL_GetPerformanceCounter();
+			for (int i = 0; i < iterations; ++i)
+				layout.convert(&source[0], &converted[0], pixels);
+			Uint64 swizzleTicks = SDL_GetPerformanceCounter() - start;
+
+			// First upload can include allocation and format changes
+			glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, width, height, layout.format, layout.type, &converted[0]);
+			glFinish();
+
+			start = SDL_GetPerformanceCounter();
+			for (int i = 0; i < iterations; ++i)
+				glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, width, height, layout.format, layout.type, &converted[0]);
+			glFinish();
+			Uint64 uploadTicks = SDL_GetPerformanceCounter() - start;
+
+			std::cout << std::left << std::setw(8) << getEnumName(layout.format) << std::setw(28) << getEnumName(layout.type) << std::right << std::fixed << std::setprecision(0)
+			          << " upload " << std::setw(6) << getRate(bytes, uploadTicks) << " MB/s"
+			          << ", swizzle " << std::setw(6) << (layout.swizzle == SWIZZLE_NONE ? 0.0 : getRate(bytes, swizzleTicks)) << " MB/s"
+			          << ", total " << std::setw(6) << getRate(bytes, uploadTicks + (layout.swizzle == SWIZZLE_NONE ? 0 : swizzleTicks)) << " MB/s"
+			          << (layout.format == best.format && layout.type == best.type ? "  (preferred)" : "") << std::endl;
+		}
+	}
+
+	glDeleteTextures(1, &texture);
+}
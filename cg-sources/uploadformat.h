@@ -0,0 +1,65 @@
+/**
+ * \brief Texture upload format negotiation interface
+ * \file
+ */
+#ifndef UPLOADFORMAT_H_
+#define UPLOADFORMAT_H_
+
+#include <cstddef>
+#include <vector>
+#include <GL/glew.h>
+#include <SDL.h>
+
+/**
+ * \brief Pixel layout used for transferring 32-bit RGBA texels to GL_RGBA8 textures
+ *
+ * Texture surfaces are SDL_PIXELFORMAT_RGBA8888, which matches GL_RGBA with GL_UNSIGNED_INT_8_8_8_8. Many drivers
+ * store textures as BGRA bytes internally and swizzle every other layout on the CPU inside the glTexSubImage2D() call,
+ * often with slow generic code. getPreferred() asks the driver for its native layout with glGetInternalformativ()
+ * (ARB_internalformat_query2) and convert() does the swizzle once on our side with SSE2, typically while copying
+ * into a pixel buffer anyway.
+ *
+ * Run the program with --upload-benchmark to print upload speeds of every layout on the current driver.
+ */
+class UploadFormat
+{
+public:
+	/**
+	 * \brief Conversion of RGBA8888 pixels (red in the most significant byte) to the upload layout
+	 */
+	enum Swizzle
+	{
+		SWIZZLE_NONE,    ///< Upload as is
+		SWIZZLE_REVERSE, ///< Reverse byte order of every pixel
+		SWIZZLE_ROTATE   ///< Move alpha from the least to the most significant byte
+	};
+
+	GLenum format; ///< Format parameter of glTexSubImage2D()
+	GLenum type;   ///< Type parameter of glTexSubImage2D()
+	Swizzle swizzle;
+
+	UploadFormat(GLenum format = GL_RGBA, GLenum type = GL_UNSIGNED_INT_8_8_8_8);
+
+	/**
+	 * \brief False if RGBA8888 pixels can not be converted to this layout
+	 */
+	bool isValid() const
+	{
+		return valid;
+	}
+
+	void convert(const void *src, void *dst, size_t pixels) const;
+	const void *prepare(const void *pixels, size_t count) const;
+
+	static const UploadFormat &getPreferred();
+	static void benchmark(int width = 2048, int height = 2048, int iterations = 20);
+
+private:
+	bool valid;
+
+	static bool queried;
+	static UploadFormat preferred;
+	static std::vector<Uint32> scratch; // Converted pixels of the latest prepare()
+};
+
+#endif
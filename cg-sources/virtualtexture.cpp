@@ -0,0 +1,613 @@
+/**
+ * \brief Tiled virtual texture implementation
+ * \file
+ */
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <algorithm>
+#include <functional>
+#include <cmath>
+#include "virtualtexture.h"
+#include "uploadformat.h"
+#include "texture.h"
+#include "ddsfile.h"
+#include "sampler.h"
+
+#ifdef _WIN32
+#include <direct.h>
+#else
+#include <sys/stat.h>
+#endif
+
+namespace
+{
+	/**
+	 * \brief Tile file of a given level and tile position. Tile rows are counted from the bottom of the image.
+	 */
+	std::string tilePath(const std::string &directory, int level, int x, int y)
+	{
+		std::ostringstream path;
+		path << directory << "/" << level << "_" << x << "_" << y << ".dds";
+		return path.str();
+	}
+
+	std::string infoPath(const std::string &directory)
+	{
+		return directory + "/info.txt";
+	}
+}
+
+/**
+ * \brief Create an empty virtual texture
+ * \param cacheTiles Cache holds cacheTiles x cacheTiles tiles
+ * \param feedbackDivisor Feedback buffer resolution is the window size divided by this
+ */
+VirtualTexture::VirtualTexture(int cacheTiles, int feedbackDivisor) :
+	width(0),
+	height(0),
+	tileSize(0),
+	border(0),
+	levelCount(0),
+	cacheTiles(std::min(std::max(2, cacheTiles), 255)), // Slot coordinates are stored in 8 bits
+	cacheTexture(0),
+	indirectionTexture(0),
+	indirectionDirty(false),
+	frame(0),
+	feedbackDivisor(std::max(1, feedbackDivisor)),
+	feedbackWidth(0),
+	feedbackHeight(0),
+	feedbackFramebuffer(0),
+	feedbackColor(0),
+	feedbackDepth(0),
+	feedbackIndex(0),
+	savedFramebuffer(0)
+{
+	feedbackBuffers[0] = feedbackBuffers[1] = 0;
+	feedbackPending[0] = feedbackPending[1] = false;
+}
+
+VirtualTexture::~VirtualTexture()
+{
+	release();
+
+	if (feedbackFramebuffer)
+	{
+		glDeleteFramebuffers(1, &feedbackFramebuffer);
+		glDeleteRenderbuffers(1, &feedbackColor);
+		glDeleteRenderbuffers(1, &feedbackDepth);
+		glDeleteBuffers(2, feedbackBuffers);
+	}
+}
+
+/**
+ * \brief Release cache and indirection textures
+ */
+void VirtualTexture::release()
+{
+	if (cacheTexture)
+		glDeleteTextures(1, &cacheTexture);
+	if (indirectionTexture)
+		glDeleteTextures(1, &indirectionTexture);
+	cacheTexture = 0;
+	indirectionTexture = 0;
+
+	residents.clear();
+	lruTiles.clear();
+	freeSlots.clear();
+	failedTiles.clear();
+	indirection.clear();
+	levelCount = 0;
+}
+
+/**
+ * \brief Calculate level sizes and indirection texture layout from the image size
+ *
+ * Level sizes follow the same rounding as Texture::downsample() which was used for creating the tiles.
+ */
+void VirtualTexture::computeLayout()
+{
+	int w = width;
+	int h = height;
+	int row = 0;
+
+	for (int level = 0; level < levelCount; ++level)
+	{
+		levelWidth[level] = w;
+		levelHeight[level] = h;
+		tilesX[level] = (w + tileSize - 1) / tileSize;
+		tilesY[level] = (h + tileSize - 1) / tileSize;
+		levelRow[level] = row;
+		row += tilesY[level];
+
+		w = std::max(1, w / 2);
+		h = std::max(1, h / 2);
+	}
+}
+
+/**
+ * \brief Split an image into a tile pyramid
+ *
+ * Every level is half the size of the previous one until the whole image fits in a single tile.
+ * Each tile is stored as an uncompressed DDS file including border texels copied from its neighbours.
+ * Edges of the image are clamped.
+ * \param directory Directory to create for the tiles
+ * \param image SDL_PIXELFORMAT_RGBA8888 surface in OpenGL row order
+ * \param tileSize Tile size in texels without borders
+ * \param border Border width in texels
+ * \return true if success
+ */
+bool VirtualTexture::writeTiles(const std::string &directory, const SDL_Surface *image, int tileSize, int border)
+{
+	if (!image || image->format->format != SDL_PIXELFORMAT_RGBA8888)
+	{
+		std::cerr << "VirtualTexture::writeTiles(): Image must be an RGBA8888 surface" << std::endl;
+		return false;
+	}
+
+	if (tileSize < 1 || border < 0 || border >= tileSize)
+	{
+		std::cerr << "VirtualTexture::writeTiles(): Invalid tile size " << tileSize << " or border " << border << std::endl;
+		return false;
+	}
+
+	// Existing directory is fine, files are overwritten
+#ifdef _WIN32
+	_mkdir(directory.c_str());
+#else
+	mkdir(directory.c_str(), 0755);
+#endif
+
+	int w = image->w;
+	int h = image->h;
+	std::vector<Uint32> level(static_cast<size_t>(w) * h), nextLevel;
+	for (int y = 0; y < h; ++y)
+	{
+		const Uint32 *src = reinterpret_cast<const Uint32 *>(static_cast<const Uint8 *>(image->pixels) + y * image->pitch);
+		std::copy(src, src + w, level.begin() + static_cast<size_t>(y) * w);
+	}
+
+	int padded = tileSize + 2 * border;
+	std::vector<std::vector<Uint8> > tile(1, std::vector<Uint8>(static_cast<size_t>(padded) * padded * 4));
+	Uint32 *dst = reinterpret_cast<Uint32 *>(&tile[0][0]);
+
+	int levels = 0;
+	for (;;)
+	{
+		if (levels == MAX_LEVELS)
+		{
+			std::cerr << "VirtualTexture::writeTiles(): Image needs more than " << MAX_LEVELS << " levels, use larger tiles" << std::endl;
+			return false;
+		}
+
+		for (int ty = 0; ty < (h + tileSize - 1) / tileSize; ++ty)
+		{
+			for (int tx = 0; tx < (w + tileSize - 1) / tileSize; ++tx)
+			{
+				for (int py = 0; py < padded; ++py)
+				{
+					int sy = std::min(std::max(ty * tileSize - border + py, 0), h - 1);
+					for (int px = 0; px < padded; ++px)
+					{
+						int sx = std::min(std::max(tx * tileSize - border + px, 0), w - 1);
+						dst[py * padded + px] = level[static_cast<size_t>(sy) * w + sx];
+					}
+				}
+
+				if (!DDSFile::write(tilePath(directory, levels, tx, ty), DDSFile::RGBA8888, padded, padded, tile))
+					return false;
+			}
+		}
+		++levels;
+
+		if (w <= tileSize && h <= tileSize)
+			break;
+
+		Texture::downsample(&level[0], w, h, w * 4, nextLevel);
+		level.swap(nextLevel);
+		w = std::max(1, w / 2);
+		h = std::max(1, h / 2);
+	}
+
+	std::ofstream info(infoPath(directory).c_str());
+	info << image->w << " " << image->h << " " << tileSize << " " << border << " " << levels << std::endl;
+	if (!info)
+	{
+		std::cerr << "VirtualTexture::writeTiles(): Unable to write " << infoPath(directory) << std::endl;
+		return false;
+	}
+
+	return true;
+}
+
+/**
+ * \brief Open a tile directory created with writeTiles()
+ *
+ * Allocates the cache and indirection textures and loads the coarsest level.
+ * \param directory Tile directory
+ * \return true if success
+ */
+bool VirtualTexture::open(const std::string &directory)
+{
+	release();
+
+	std::ifstream info(infoPath(directory).c_str());
+	int levels = 0;
+	if (!(info >> width >> height >> tileSize >> border >> levels) || width < 1 || height < 1 || tileSize < 1 || border < 0 || levels < 1 || levels > MAX_LEVELS)
+	{
+		std::cerr << "VirtualTexture::open(): Unable to read " << infoPath(directory) << std::endl;
+		return false;
+	}
+
+	this->directory = directory;
+	levelCount = levels;
+	computeLayout();
+
+	if (tilesX[levelCount - 1] != 1 || tilesY[levelCount - 1] != 1 || tilesX[0] > 4096 || levelRow[levelCount - 1] + 1 > 4096)
+	{
+		std::cerr << "VirtualTexture::open(): " << infoPath(directory) << " does not describe a valid tile pyramid" << std::endl;
+		levelCount = 0;
+		return false;
+	}
+
+	int padded = tileSize + 2 * border;
+	GLint maxSize = 0;
+	glGetIntegerv(GL_MAX_TEXTURE_SIZE, &maxSize);
+	cacheTiles = std::min(cacheTiles, static_cast<int>(maxSize / padded));
+
+	// Physical cache has no mipmaps, tiles of each level are separate entries.
+	// Border texels let bilinear filtering read across tile edges.
+	glGenTextures(1, &cacheTexture);
+	glBindTexture(GL_TEXTURE_2D, cacheTexture);
+	if (GLEW_ARB_texture_storage)
+		glTexStorage2D(GL_TEXTURE_2D, 1, GL_RGBA8, cacheTiles * padded, cacheTiles * padded);
+	else
+		glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, cacheTiles * padded, cacheTiles * padded, 0, UploadFormat::getPreferred().format, UploadFormat::getPreferred().type, 0);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, 0);
+	Sampler::applyToTexture(GL_TEXTURE_2D, Sampler::Parameters(GL_LINEAR, GL_LINEAR, GL_CLAMP_TO_EDGE, GL_CLAMP_TO_EDGE));
+
+	// One texel per tile. Red and green are the cache slot, blue is the level of the tile in the slot and alpha is 255 if the entry is valid.
+	int rows = levelRow[levelCount - 1] + 1;
+	indirection.assign(static_cast<size_t>(tilesX[0]) * rows * 4, 0);
+	glGenTextures(1, &indirectionTexture);
+	glBindTexture(GL_TEXTURE_2D, indirectionTexture);
+	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8UI, tilesX[0], rows, 0, GL_RGBA_INTEGER, GL_UNSIGNED_BYTE, 0);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, 0);
+	Sampler::applyToTexture(GL_TEXTURE_2D, Sampler::Parameters(GL_NEAREST, GL_NEAREST, GL_CLAMP_TO_EDGE, GL_CLAMP_TO_EDGE));
+
+	for (int slot = cacheTiles * cacheTiles - 1; slot >= 0; --slot)
+		freeSlots.push_back(slot);
+
+	// Coarsest level is never evicted so there is always something to draw
+	if (!loadTile(tileKey(levelCount - 1, 0, 0)))
+	{
+		release();
+		return false;
+	}
+	lruTiles.erase(residents.begin()->second.lru);
+	residents.begin()->second.lru = lruTiles.end();
+
+	updateIndirection();
+	return true;
+}
+
+/**
+ * \brief Load a tile into a free cache slot, evicting the least recently used tile if necessary
+ * \return true if tile was loaded
+ */
+bool VirtualTexture::loadTile(Uint32 key)
+{
+	if (freeSlots.empty())
+	{
+		// Don't evict tiles that are visible in the current frame, the cache is simply too small then
+		if (lruTiles.empty() || residents[lruTiles.back()].lastUsed == frame)
+			return false;
+
+		std::map<Uint32, Resident>::iterator victim = residents.find(lruTiles.back());
+		freeSlots.push_back(victim->second.slot);
+		residents.erase(victim);
+		lruTiles.pop_back();
+		indirectionDirty = true;
+	}
+
+	int level = static_cast<int>(key >> 24);
+	int x = static_cast<int>(key & 0xfff);
+	int y = static_cast<int>((key >> 12) & 0xfff);
+	int padded = tileSize + 2 * border;
+
+	DDSFile file;
+	if (!file.open(tilePath(directory, level, x, y)) || file.getFormat() != DDSFile::RGBA8888 ||
+		file.getLevel(0).width != padded || file.getLevel(0).height != padded)
+	{
+		std::cerr << "VirtualTexture: Unable to load tile " << tilePath(directory, level, x, y) << std::endl;
+		failedTiles.insert(key);
+		return false;
+	}
+
+	int slot = freeSlots.back();
+	freeSlots.pop_back();
+
+	// Tiles are streamed every frame, so they are swizzled to the driver's layout like other uploads
+	const UploadFormat &layout = UploadFormat::getPreferred();
+	const void *pixels = layout.prepare(file.getLevel(0).data, static_cast<size_t>(padded) * padded);
+	glBindTexture(GL_TEXTURE_2D, cacheTexture);
+	glTexSubImage2D(GL_TEXTURE_2D, 0, (slot % cacheTiles) * padded, (slot / cacheTiles) * padded, padded, padded, layout.format, layout.type, pixels);
+
+	lruTiles.push_front(key);
+	Resident &resident = residents[key];
+	resident.slot = slot;
+	resident.lru = lruTiles.begin();
+	resident.lastUsed = frame;
+	indirectionDirty = true;
+	return true;
+}
+
+/**
+ * \brief Mark a loaded tile used in the current frame
+ */
+void VirtualTexture::touchTile(Uint32 key)
+{
+	Resident &resident = residents[key];
+	resident.lastUsed = frame;
+
+	// Coarsest tile is not in the list
+	if (resident.lru != lruTiles.end())
+		lruTiles.splice(lruTiles.begin(), lruTiles, resident.lru);
+}
+
+/**
+ * \brief Rebuild and upload the indirection texture
+ *
+ * Entries of missing tiles point to the same slot as their parent tile, so the nearest loaded coarser level is used.
+ */
+void VirtualTexture::updateIndirection()
+{
+	int stride = tilesX[0] * 4;
+
+	for (int level = levelCount - 1; level >= 0; --level)
+	{
+		for (int y = 0; y < tilesY[level]; ++y)
+		{
+			for (int x = 0; x < tilesX[level]; ++x)
+			{
+				Uint8 *entry = &indirection[(levelRow[level] + y) * stride + x * 4];
+
+				std::map<Uint32, Resident>::const_iterator it = residents.find(tileKey(level, x, y));
+				if (it != residents.end())
+				{
+					entry[0] = static_cast<Uint8>(it->second.slot % cacheTiles);
+					entry[1] = static_cast<Uint8>(it->second.slot / cacheTiles);
+					entry[2] = static_cast<Uint8>(level);
+					entry[3] = 255;
+				} else
+				if (level + 1 < levelCount)
+				{
+					int px = std::min(x / 2, tilesX[level + 1] - 1);
+					int py = std::min(y / 2, tilesY[level + 1] - 1);
+					const Uint8 *parent = &indirection[(levelRow[level + 1] + py) * stride + px * 4];
+					std::copy(parent, parent + 4, entry);
+				}
+			}
+		}
+	}
+
+	glBindTexture(GL_TEXTURE_2D, indirectionTexture);
+	glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, tilesX[0], levelRow[levelCount - 1] + 1, GL_RGBA_INTEGER, GL_UNSIGNED_BYTE, &indirection[0]);
+	indirectionDirty = false;
+}
+
+/**
+ * \brief Resize the feedback buffer to match the window
+ */
+void VirtualTexture::resize(GLsizei width, GLsizei height)
+{
+	feedbackWidth = std::max(1, static_cast<int>(width) / feedbackDivisor);
+	feedbackHeight = std::max(1, static_cast<int>(height) / feedbackDivisor);
+
+	if (!feedbackFramebuffer)
+	{
+		glGenFramebuffers(1, &feedbackFramebuffer);
+		glGenRenderbuffers(1, &feedbackColor);
+		glGenRenderbuffers(1, &feedbackDepth);
+		glGenBuffers(2, feedbackBuffers);
+	}
+
+	glBindRenderbuffer(GL_RENDERBUFFER, feedbackColor);
+	glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA16UI, feedbackWidth, feedbackHeight);
+	glBindRenderbuffer(GL_RENDERBUFFER, feedbackDepth);
+	glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, feedbackWidth, feedbackHeight);
+	glBindRenderbuffer(GL_RENDERBUFFER, 0);
+
+	GLint previous = 0;
+	glGetIntegerv(GL_DRAW_FRAMEBUFFER_BINDING, &previous);
+	glBindFramebuffer(GL_FRAMEBUFFER, feedbackFramebuffer);
+	glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, feedbackColor);
+	glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, feedbackDepth);
+	if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+		std::cerr << "VirtualTexture::resize(): Feedback framebuffer is not complete" << std::endl;
+	glBindFramebuffer(GL_FRAMEBUFFER, previous);
+
+	for (int i = 0; i < 2; ++i)
+	{
+		glBindBuffer(GL_PIXEL_PACK_BUFFER, feedbackBuffers[i]);
+		glBufferData(GL_PIXEL_PACK_BUFFER, static_cast<GLsizeiptr>(feedbackWidth) * feedbackHeight * 4 * sizeof(GLushort), 0, GL_STREAM_READ);
+		feedbackPending[i] = false;
+	}
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+}
+
+/**
+ * \brief Start drawing the feedback pass
+ *
+ * Objects using this texture should be drawn with the feedback shader until endFeedback().
+ * Blending should be disabled; it has no effect on the integer feedback buffer anyway.
+ */
+void VirtualTexture::beginFeedback()
+{
+	glGetIntegerv(GL_VIEWPORT, savedViewport);
+	glGetIntegerv(GL_DRAW_FRAMEBUFFER_BINDING, &savedFramebuffer);
+
+	glBindFramebuffer(GL_FRAMEBUFFER, feedbackFramebuffer);
+	glViewport(0, 0, feedbackWidth, feedbackHeight);
+
+	// Alpha 0 marks pixels that don't request any tile
+	const GLuint clearColor[4] = { 0, 0, 0, 0 };
+	glClearBufferuiv(GL_COLOR, 0, clearColor);
+	glClear(GL_DEPTH_BUFFER_BIT);
+}
+
+/**
+ * \brief Finish the feedback pass and queue reading it back
+ *
+ * Read back goes to a pixel buffer object and is processed by update() a frame later so that the CPU never waits for the GPU.
+ */
+void VirtualTexture::endFeedback()
+{
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, feedbackBuffers[feedbackIndex]);
+	glReadBuffer(GL_COLOR_ATTACHMENT0);
+	glReadPixels(0, 0, feedbackWidth, feedbackHeight, GL_RGBA_INTEGER, GL_UNSIGNED_SHORT, 0);
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+	feedbackPending[feedbackIndex] = true;
+	feedbackIndex ^= 1;
+
+	glBindFramebuffer(GL_FRAMEBUFFER, savedFramebuffer);
+	glViewport(savedViewport[0], savedViewport[1], savedViewport[2], savedViewport[3]);
+}
+
+/**
+ * \brief Stream in tiles requested by the feedback pass
+ *
+ * Parents of requested tiles are requested as well so that quality degrades gradually when the cache is full.
+ * Coarser tiles are loaded first.
+ * \param maxUploads Maximum number of tiles to load during this call
+ */
+void VirtualTexture::update(unsigned int maxUploads)
+{
+	if (!levelCount)
+		return;
+
+	++frame;
+
+	// Oldest feedback buffer is the one that will be written next
+	int index = feedbackIndex;
+	if (!feedbackPending[index])
+		return;
+	feedbackPending[index] = false;
+
+	std::vector<Uint32> requests;
+	size_t bytes = static_cast<size_t>(feedbackWidth) * feedbackHeight * 4 * sizeof(GLushort);
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, feedbackBuffers[index]);
+	const GLushort *pixels = static_cast<const GLushort *>(glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, bytes, GL_MAP_READ_BIT));
+	if (pixels)
+	{
+		for (size_t i = 0; i < bytes / sizeof(GLushort); i += 4)
+		{
+			int x = pixels[i], y = pixels[i + 1], level = pixels[i + 2];
+			if (pixels[i + 3] && level < levelCount && x < tilesX[level] && y < tilesY[level])
+				requests.push_back(tileKey(level, x, y));
+		}
+		glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+	}
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+	std::sort(requests.begin(), requests.end());
+	requests.erase(std::unique(requests.begin(), requests.end()), requests.end());
+
+	size_t count = requests.size();
+	for (size_t i = 0; i < count; ++i)
+	{
+		int level = static_cast<int>(requests[i] >> 24);
+		int x = static_cast<int>(requests[i] & 0xfff);
+		int y = static_cast<int>((requests[i] >> 12) & 0xfff);
+		while (++level < levelCount)
+		{
+			x = std::min(x / 2, tilesX[level] - 1);
+			y = std::min(y / 2, tilesY[level] - 1);
+			requests.push_back(tileKey(level, x, y));
+		}
+	}
+
+	// Descending keys put coarse levels first
+	std::sort(requests.begin(), requests.end(), std::greater<Uint32>());
+	requests.erase(std::unique(requests.begin(), requests.end()), requests.end());
+
+	std::vector<Uint32> missing;
+	for (size_t i = 0; i < requests.size(); ++i)
+	{
+		if (residents.count(requests[i]))
+			touchTile(requests[i]);
+		else
+		if (!failedTiles.count(requests[i]))
+			missing.push_back(requests[i]);
+	}
+
+	for (size_t i = 0; i < missing.size() && i < maxUploads; ++i)
+	{
+		if (!loadTile(missing[i]) && freeSlots.empty())
+			break;
+	}
+
+	if (indirectionDirty)
+		updateIndirection();
+}
+
+/**
+ * \brief Bind cache and indirection textures
+ *
+ * Sampler objects are unbound from both units as the textures rely on their own filtering parameters.
+ */
+void VirtualTexture::bind(GLuint cacheUnit, GLuint indirectionUnit)
+{
+	glActiveTexture(GL_TEXTURE0 + cacheUnit);
+	glBindTexture(GL_TEXTURE_2D, cacheTexture);
+	if (Sampler::isSupported())
+		glBindSampler(cacheUnit, 0);
+	Texture::countBind();
+
+	glActiveTexture(GL_TEXTURE0 + indirectionUnit);
+	glBindTexture(GL_TEXTURE_2D, indirectionTexture);
+	if (Sampler::isSupported())
+		glBindSampler(indirectionUnit, 0);
+	Texture::countBind();
+}
+
+/**
+ * \brief Set vt_* uniforms used by data/virtualtexture.fs and data/virtualtexture_feedback.fs
+ *
+ * Program must be in use. Uniforms missing from the program are skipped.
+ * \param program Shader program
+ * \param cacheUnit Texture unit of the cache texture given to bind()
+ * \param indirectionUnit Texture unit of the indirection texture given to bind()
+ * \param feedback True for the feedback shader drawn into the smaller feedback buffer
+ */
+void VirtualTexture::setUniforms(GLuint program, GLuint cacheUnit, GLuint indirectionUnit, bool feedback) const
+{
+	GLfloat levelSize[2 * MAX_LEVELS];
+	for (int i = 0; i < levelCount; ++i)
+	{
+		levelSize[2 * i] = static_cast<GLfloat>(levelWidth[i]);
+		levelSize[2 * i + 1] = static_cast<GLfloat>(levelHeight[i]);
+	}
+
+	GLint location;
+	if ((location = glGetUniformLocation(program, "vt_cache")) >= 0)
+		glUniform1i(location, cacheUnit);
+	if ((location = glGetUniformLocation(program, "vt_indirection")) >= 0)
+		glUniform1i(location, indirectionUnit);
+	if ((location = glGetUniformLocation(program, "vt_levelSize")) >= 0)
+		glUniform2fv(location, levelCount, levelSize);
+	if ((location = glGetUniformLocation(program, "vt_levelRow")) >= 0)
+		glUniform1iv(location, levelCount, levelRow);
+	if ((location = glGetUniformLocation(program, "vt_levelCount")) >= 0)
+		glUniform1i(location, levelCount);
+	if ((location = glGetUniformLocation(program, "vt_tileSize")) >= 0)
+		glUniform1f(location, static_cast<GLfloat>(tileSize));
+	if ((location = glGetUniformLocation(program, "vt_border")) >= 0)
+		glUniform1f(location, static_cast<GLfloat>(border));
+	if ((location = glGetUniformLocation(program, "vt_cacheSize")) >= 0)
+		glUniform1f(location, static_cast<GLfloat>(cacheTiles * (tileSize + 2 * border)));
+
+	// Level selection uses screen space derivatives which are feedbackDivisor times larger in the feedback buffer
+	if ((location = glGetUniformLocation(program, "vt_lodBias")) >= 0)
+		glUniform1f(location, feedback ? -std::log(static_cast<float>(feedbackDivisor)) / std::log(2.0f) : 0.0f);
+}
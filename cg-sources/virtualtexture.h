@@ -0,0 +1,124 @@
+/**
+ * \brief Tiled virtual texture interface
+ * \file
+ */
+#ifndef VIRTUALTEXTURE_H_
+#define VIRTUALTEXTURE_H_
+
+#include <string>
+#include <vector>
+#include <list>
+#include <map>
+#include <set>
+#include <GL/glew.h>
+#include <SDL.h>
+
+/**
+ * \brief Texture of any size rendered from a fixed size cache of tiles
+ *
+ * Source image is split offline into a mipmap pyramid of square tiles (see writeTiles()) so that it never has to fit
+ * in memory as a whole. While rendering only tiles that are actually visible are kept in a physical cache texture:
+ *
+ * 1. Scene is drawn into a small feedback buffer between beginFeedback() and endFeedback() using
+ *    data/virtualtexture_feedback.fs. Every pixel records the tile and mipmap level it would sample.
+ * 2. update() reads the feedback of the previous frame, loads missing tiles from disk into free cache slots
+ *    and evicts the least recently used tiles when the cache is full.
+ * 3. Scene is drawn with data/virtualtexture.fs, which looks up the cache location of a tile from an indirection
+ *    texture. Tiles that are not loaded yet are replaced with the nearest loaded coarser level.
+ *
+ * The coarsest level is a single tile that always stays in the cache, so every part of the texture can be drawn.
+ * Memory use is bounded by the cache size regardless of the size of the source image.
+ */
+class VirtualTexture
+{
+public:
+	static const int MAX_LEVELS = 16; ///< Must match the uniform array sizes in the shaders
+
+private:
+	/**
+	 * \brief Cache slot of a loaded tile
+	 */
+	struct Resident
+	{
+		int slot;
+		std::list<Uint32>::iterator lru; // Position in lruTiles
+		unsigned int lastUsed;           // Frame in which the tile was last requested
+	};
+
+	std::string directory; // Directory with tile files
+	int width;             // Size of the full resolution image
+	int height;
+	int tileSize;          // Tile size without borders
+	int border;            // Texels copied from neighbouring tiles on each side for filtering
+	int levelCount;
+	int levelWidth[MAX_LEVELS];
+	int levelHeight[MAX_LEVELS];
+	int tilesX[MAX_LEVELS]; // Number of tiles on each level
+	int tilesY[MAX_LEVELS];
+	int levelRow[MAX_LEVELS]; // First row of each level in the indirection texture
+
+	int cacheTiles;        // Cache is cacheTiles x cacheTiles slots
+	GLuint cacheTexture;   // Physical tile cache
+	GLuint indirectionTexture; // Cache slot of every tile, levels stacked vertically
+	std::vector<Uint8> indirection; // RGBA8UI copy of indirectionTexture
+	bool indirectionDirty;
+
+	std::map<Uint32, Resident> residents; // Loaded tiles by tile key
+	std::list<Uint32> lruTiles;           // Most recently used first
+	std::vector<int> freeSlots;
+	std::set<Uint32> failedTiles;         // Tiles that could not be loaded are not requested again
+	unsigned int frame;
+
+	int feedbackDivisor;   // Feedback buffer is this many times smaller than the window
+	int feedbackWidth;
+	int feedbackHeight;
+	GLuint feedbackFramebuffer;
+	GLuint feedbackColor;
+	GLuint feedbackDepth;
+	GLuint feedbackBuffers[2]; // Pixel pack buffers for reading feedback without waiting for the GPU
+	bool feedbackPending[2];
+	int feedbackIndex;
+	GLint savedViewport[4];
+	GLint savedFramebuffer;
+
+	static Uint32 tileKey(int level, int x, int y)
+	{
+		return (static_cast<Uint32>(level) << 24) | (static_cast<Uint32>(y) << 12) | static_cast<Uint32>(x);
+	}
+
+	void computeLayout();
+	bool loadTile(Uint32 key);
+	void touchTile(Uint32 key);
+	void updateIndirection();
+	void release();
+
+	VirtualTexture(const VirtualTexture &);
+	VirtualTexture &operator=(const VirtualTexture &);
+public:
+	VirtualTexture(int cacheTiles = 16, int feedbackDivisor = 8);
+	~VirtualTexture();
+
+	bool open(const std::string &directory);
+	static bool writeTiles(const std::string &directory, const SDL_Surface *image, int tileSize = 128, int border = 4);
+
+	void resize(GLsizei width, GLsizei height);
+	void beginFeedback();
+	void endFeedback();
+	void update(unsigned int maxUploads = 16);
+
+	void bind(GLuint cacheUnit, GLuint indirectionUnit);
+	void setUniforms(GLuint program, GLuint cacheUnit, GLuint indirectionUnit, bool feedback) const;
+
+	/**
+	 * \brief Number of tiles currently in the cache
+	 */
+	size_t getResidentTileCount() const
+	{
+		return residents.size();
+	}
+
+	int getWidth() const { return width; }
+	int getHeight() const { return height; }
+};
+
+#endif
@@ -0,0 +1,147 @@
+/**
+ * \brief Generate the table of embedded shaders for embeddedshaders.cpp
+ *
+ * Usage: embedshaders output.inc file...
+ *
+ * File names are stored as given, so run the tool in cg-sources with paths such as data/land.fs to match the names
+ * ShaderProgram::load() is called with. The output defines EMBEDDED_SHADERS as a constexpr array of EmbeddedShader
+ * sorted by name and EMBEDDED_SHADER_COUNT.
+ * \file
+ */
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <iomanip>
+#include <string>
+#include <vector>
+#include <algorithm>
+
+namespace
+{
+	struct ShaderFile
+	{
+		std::string name;
+		std::string source;
+
+		bool operator<(const ShaderFile &other) const
+		{
+			return name < other.name;
+		}
+	};
+
+	/**
+	 * \brief 64-bit FNV-1a hash, same as ProgramBinaryCache uses
+	 */
+	unsigned long long hashString(const std::string &text)
+	{
+		unsigned long long hash = 14695981039346656037ULL;
+		for (size_t i = 0; i < text.size(); ++i)
+		{
+			hash ^= static_cast<unsigned char>(text[i]);
+			hash *= 1099511628211ULL;
+		}
+		return hash;
+	}
+
+	/**
+	 * \brief Write text as C++ string literals, one per source line
+	 */
+	void writeLiteral(std::ostream &os, const std::string &text)
+	{
+		if (text.empty())
+		{
+			os << "\t\t\"\"\n";
+			return;
+		}
+
+		bool lineStart = true;
+		for (size_t i = 0; i < text.size(); ++i)
+		{
+			if (lineStart)
+				os << "\t\t\"";
+			lineStart = false;
+
+			unsigned char c = static_cast<unsigned char>(text[i]);
+			if (c == '\n')
+			{
+				os << "\\n\"\n";
+				lineStart = true;
+			} else
+			if (c == '\\' || c == '"')
+				os << '\\' << c;
+			else
+			if (c == '\t')
+				os << "\\t";
+			else
+			if (c == '?')
+				os << "\\?"; // Avoid trigraphs
+			else
+			if (c < 32 || c >= 127)
+				os << '\\' << std::oct << std::setw(3) << std::setfill('0') << static_cast<int>(c) << std::dec;
+			else
+				os << c;
+		}
+
+		if (!lineStart)
+			os << "\"\n";
+	}
+}
+
+int main(int argc, char *argv[])
+{
+	if (argc < 2)
+	{
+		std::cerr << "Usage: embedshaders output.inc file..." << std::endl;
+		return 1;
+	}
+
+	std::vector<ShaderFile> files;
+	for (int i = 2; i < argc; ++i)
+	{
+		std::ifstream is(argv[i], std::ifstream::binary);
+		if (!is.is_open())
+		{
+			std::cerr << "embedshaders: Unable to open '" << argv[i] << "' for reading." << std::endl;
+			return 1;
+		}
+
+		std::ostringstream contents;
+		contents << is.rdbuf();
+
+		ShaderFile file;
+		file.name = argv[i];
+		std::replace(file.name.begin(), file.name.end(), '\\', '/');
+		file.source = contents.str();
+		files.push_back(file);
+	}
+
+	// EmbeddedShaders::find() does a binary search
+	std::sort(files.begin(), files.end());
+
+	std::ostringstream os;
+	os << "// Generated by tools/embedshaders.cpp, do not edit\n\n";
+	os << "constexpr size_t EMBEDDED_SHADER_COUNT = " << files.size() << ";\n\n";
+	os << "constexpr EmbeddedShader EMBEDDED_SHADERS[] =\n{\n";
+	for (size_t i = 0; i < files.size(); ++i)
+	{
+		os << "\t{\n";
+		os << "\t\t\"" << files[i].name << "\",\n";
+		writeLiteral(os, files[i].source);
+		os << "\t\t, " << files[i].source.size() << ", 0x" << std::hex << std::setw(16) << std::setfill('0') << hashString(files[i].source) << std::dec << "ULL\n";
+		os << "\t},\n";
+	}
+	if (files.empty())
+		os << "\t{ \"\", \"\", 0, 0 }\n";
+	os << "};\n";
+
+	std::ofstream out(argv[1], std::ofstream::binary);
+	out << os.str();
+	if (!out.good())
+	{
+		std::cerr << "embedshaders: Unable to write '" << argv[1] << "'." << std::endl;
+		return 1;
+	}
+
+	std::cout << "Embedded " << files.size() << " shader files into " << argv[1] << std::endl;
+	return 0;
+}
@@ -0,0 +1,95 @@
+/**
+ * \brief Convert images to DDS files that Texture can load without decoding
+ *
+ * Usage: texconvert [-bc1 | -bc3 | -rgba] [-fast | -normal | -high] [-tiles SIZE] image...
+ *
+ * Every image is written next to the original with the extension replaced by .dds.
+ * Files are stored in OpenGL row order with a full mipmap chain.
+ *
+ * With -tiles images are split into a VirtualTexture tile directory with the extension replaced by .tiles instead.
+ * \file
+ */
+#include <iostream>
+#include <string>
+#include <cstdlib>
+#include <SDL.h>
+#include <SDL_image.h>
+#include "texture.h"
+#include "virtualtexture.h"
+
+static void usage()
+{
+	std::cerr << "Usage: texconvert [-bc1 | -bc3 | -rgba] [-fast | -normal | -high] [-tiles SIZE] image..." << std::endl;
+	std::cerr << "  -bc1     DXT1 compression, no alpha channel" << std::endl;
+	std::cerr << "  -bc3     DXT5 compression (default)" << std::endl;
+	std::cerr << "  -rgba    Uncompressed 32-bit RGBA" << std::endl;
+	std::cerr << "  -fast, -normal, -high  Compression quality (default -normal)" << std::endl;
+	std::cerr << "  -tiles SIZE  Split into virtual texture tiles of SIZE x SIZE texels" << std::endl;
+}
+
+int main(int argc, char *argv[])
+{
+	Texture::Compression compression = Texture::COMPRESSED_BC3;
+	BlockCompressor::Quality quality = BlockCompressor::NORMAL;
+	int tileSize = 0;
+	int converted = 0;
+	int failed = 0;
+
+	for (int i = 1; i < argc; ++i)
+	{
+		std::string arg = argv[i];
+		if (arg == "-bc1")
+			compression = Texture::COMPRESSED_BC1;
+		else
+		if (arg == "-bc3")
+			compression = Texture::COMPRESSED_BC3;
+		else
+		if (arg == "-rgba")
+			compression = Texture::UNCOMPRESSED;
+		else
+		if (arg == "-fast")
+			quality = BlockCompressor::FAST;
+		else
+		if (arg == "-normal")
+			quality = BlockCompressor::NORMAL;
+		else
+		if (arg == "-high")
+			quality = BlockCompressor::HIGH;
+		else
+		if (arg == "-tiles" && i + 1 < argc)
+			tileSize = atoi(argv[++i]);
+		else
+		if (arg[0] == '-')
+		{
+			usage();
+			return 1;
+		} else
+		{
+			std::string output = arg.substr(0, arg.find_last_of('.')) + (tileSize ? ".tiles" : ".dds");
+
+			SDL_Surface *image = Texture::loadSurface(arg);
+			bool ok = false;
+			if (image)
+				ok = tileSize ? VirtualTexture::writeTiles(output, image, tileSize) : Texture::writeContainer(output, image, compression, quality);
+
+			if (ok)
+			{
+				std::cout << arg << " -> " << output << std::endl;
+				++converted;
+			} else
+				++failed;
+
+			if (image)
+				SDL_FreeSurface(image);
+		}
+	}
+
+	if (converted + failed == 0)
+	{
+		usage();
+		return 1;
+	}
+
+	IMG_Quit();
+	return failed ? 1 : 0;
+}